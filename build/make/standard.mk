@@ -96,6 +96,19 @@ CXXFLAGS += -fPIC
 CXXFLAGS +=  $(DEBUGFLAGS) $(OPTIMFLAGS) -Wno-deprecated
 CXXFLAGS += -D_LARGEFILE_SOURCE  -D_LARGEFILE64_SOURCE -D_FILE_OFFSET_BITS=64
 
+# Threads are used for background file prefetching
+LIBRARIES += -lpthread
+
+# Linux io_uring is used for batched and asynchronous file I/O if enabled (no extra library is needed)
+ifeq ($(IO_URING),1)
+	CXXFLAGS += -DHAVE_IO_URING
+endif
+
+# I/O, allocation and timing counters are removed from the library if disabled
+ifeq ($(NO_STATS),1)
+	CXXFLAGS += -DMXFLIB_NO_STATS
+endif
+
 ifeq ($(UUID),1)
 	LIBUUID := -luuid
 	LIBRARIES += $(LIBUUID)
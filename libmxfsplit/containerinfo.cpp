@@ -39,12 +39,17 @@ ContainerInfo* ContainerInfo::CreateAndBuild(MXFFilePtr &File)
 	ContainerInfo* Ret = new ContainerInfo;
 
 	// Get the master metadata set (or the header if we must)
-	PartitionPtr MasterPartition = File->ReadMasterPartition();
+	// DRAGONS: The footer of a file being followed is not yet written, and looking for it would wait for the writer to finish
+	PartitionPtr MasterPartition;
+	if(!File->IsFollowing()) MasterPartition = File->ReadMasterPartition();
 	if(!MasterPartition)
 	{
 		File->Seek(0);
 		MasterPartition = File->ReadPartition();
-		warning("File %s does not contain a closed copy of header metadata - using the open copy in the file header\n", File->Name.c_str());
+
+		// Only the header can be read from a stream, or from a file still being written, so this is expected
+		if(File->IsStreaming() || File->IsFollowing()) debug("Using the header metadata of %s, which may be open\n", File->Name.c_str());
+		else warning("File %s does not contain a closed copy of header metadata - using the open copy in the file header\n", File->Name.c_str());
 	}
 
 	if(!MasterPartition) 
@@ -84,6 +89,8 @@ ContainerInfo* ContainerInfo::CreateAndBuild(MXFFilePtr &File)
 			EssenceTrackDescriptorPtr NewEI = new EssenceTrackDescriptor;
 			NewEI->PackageID = new UMID(PackageID->PutData()->Data);
 
+			NewEI->IndexSID = ThisECDSet->GetUInt(IndexSID_UL);
+
 			// Insert the basic essence info - but not if this is external essence (BodySID == 0)
 			UInt32 BodySID = ThisECDSet->GetUInt(BodySID_UL);
 			if(BodySID) Ret->Lookup[BodySID] = NewEI;
@@ -45,12 +45,15 @@ namespace mxflib
 		UMIDPtr PackageID;									//!< The UMID for this BodySID
 		PackagePtr Package;									//!< The package for this BodySID
 		MDObjectPtr Descriptor;								//!< The main descriptor for this package (could be a multiple descriptor)
+		UInt32 IndexSID;									//!< The IndexSID of the index table for this BodySID, or 0 if not indexed
 
 		TrackDescriptorMap TrackNumDescriptors;				//!< Map of descriptors for each TrackNumber
 		TrackDescriptorMap TrackIDDescriptors;				//!< Map of descriptors for each TrackID - will create dummies if necessary
 
 		EssenceSinkMap TrackNumSinks;						//!< Map of EssenceSinks for each TrackNumber
 
+		EssenceTrackDescriptor() : IndexSID(0) {}
+
 		//! Get the descriptor for a given track number - or the main descriptor if the track number is not associated with a descriptor
 		MDObjectPtr GetDescriptor(UInt32 TrackNumber)
 		{
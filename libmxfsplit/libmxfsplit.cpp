@@ -43,6 +43,9 @@ int SplitProcessor::Initialize()
 	// the Body Reader used to read the file
 	if( !_Reader ) _Reader = new BodyReader(_File);
 
+	// A stream can't be read back to the header partition, so start from the copy read for the metadata
+	if( _File->IsStreaming() && _ContainerInfo && _ContainerInfo->HMeta ) _Reader->SetStartPartition( _ContainerInfo->HMeta->Partition );
+
 	return _ContainerInfo->Lookup.size();
 };
 
@@ -66,6 +69,14 @@ int SplitProcessor::Discover( const int Ix /* = 0 */ )
 	_BodySID = (*it).first;
 	_Reader->MakeGCReader( _BodySID );
 
+	// Build the index table from the segments in each partition as it is read, so that it is available without seeking
+	if( _Container->IndexSID )
+	{
+		IndexTablePtr Index = new IndexTable;
+		_IndexMap[_Container->IndexSID] = Index;
+		_Reader->SetIndexTable( _Container->IndexSID, Index );
+	}
+
 	Ret = (int) _Container->TrackNumDescriptors.size();
 
 	if( Ret )
@@ -103,6 +114,17 @@ int SplitProcessor::Discover( const int Ix /* = 0 */ )
 	return Ret;
 };
 
+//! Get the index table of the chosen Container
+IndexTablePtr SplitProcessor::GetIndexTable()
+{
+	if( !_Container || !_Container->IndexSID ) return NULL;
+
+	std::map<UInt32, IndexTablePtr>::iterator it = _IndexMap.find( _Container->IndexSID );
+	if( it == _IndexMap.end() ) return NULL;
+
+	return (*it).second;
+};
+
 //! Choose a Descriptor (no default) for the chosen Container
 DescriptorPtr SplitProcessor::GetDescriptor( const int Ix )
 {
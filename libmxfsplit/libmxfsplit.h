@@ -88,6 +88,14 @@ namespace mxflib
 		 */
 		Position GetLength() { return _Length; }
 
+		//! Get the index table of the chosen Container
+		/*! 
+		 *  \return Smart Pointer to the IndexTable, or NULL if the Container is not indexed
+		 *	\note	The table is extended from the index table segments of each partition as it is read by Next(),
+		 *			so for a stream it only covers the edit units whose segments have been read so far
+		 */
+		IndexTablePtr GetIndexTable();
+
 		//! Choose a Descriptor (no default) for the chosen Container
 		/*! 
 		 *	\param	Ix The (zero-based) index of the Descriptor
@@ -52,7 +52,13 @@ int Simple( const char *file, const unsigned firstFrame, const unsigned nFrames,
 	if( !MDOType::IsDictLoaded() ) error("MXFLib Dictionaries not loaded\n");
 
 	MXFFilePtr F = new MXFFile;
-	if( !F->Open( file, true ) ) error("File %s failed to open\n", file );
+	if( strcmp( file, "-" ) == 0 )
+	{
+		// Read standard input, which is read forwards only if it is a pipe
+		if( !F->OpenFromHandle( FileStdIn() ) ) error("Standard input failed to open\n" );
+		F->Name = "standard input";
+	}
+	else if( !F->Open( file, true ) ) error("File %s failed to open\n", file );
 
 	SplitProcessorPtr sp = SplitProcessor::Create( F );
 	if ( !sp ) error("SplitProcessor failed to Create\n" );
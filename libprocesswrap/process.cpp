@@ -337,6 +337,185 @@ Length ProcessEssence(int OutFileNum,
 #include "process_metadata.h"
 
 
+//! Find the wrapping configurations that share a parser - sub-streams being wrapped and their master streams
+void FindSharedParsers(EssenceParser::WrappingConfigList &WrapCfgList, std::map<EssenceParser::WrappingConfig *, bool> &SharedParser)
+{
+	EssenceParser::WrappingConfigList::iterator WrapCfgList_it = WrapCfgList.begin();
+	while(WrapCfgList_it != WrapCfgList.end())
+	{
+		EssenceParser::WrappingConfigList::iterator Sub_it = (*WrapCfgList_it)->SubStreams.begin();
+		while(Sub_it != (*WrapCfgList_it)->SubStreams.end())
+		{
+			EssenceParser::WrappingConfigList::iterator Find_it = WrapCfgList.begin();
+			while(Find_it != WrapCfgList.end())
+			{
+				if((*Find_it) == (*Sub_it))
+				{
+					SharedParser[(*WrapCfgList_it).GetPtr()] = true;
+					SharedParser[(*Sub_it).GetPtr()] = true;
+				}
+				Find_it++;
+			}
+			Sub_it++;
+		}
+		WrapCfgList_it++;
+	}
+}
+
+
+//! Estimate the size of an output file, so that disk space may be reserved for it
+/*! The estimate from the constant bit rates and durations of the streams is used if possible. Otherwise the total size of
+ *  the input files written to this file is used. This over-estimates when only part of an input file is written, such as
+ *  one channel of an audio file, but any space not used is released once the file is complete.
+ *  \return The estimated size in bytes, or -1 if not known
+ */
+Length EstimateFileSize(int OutFileNum,
+						ProcessOptions    *pOpt,
+						EssenceSourcePair *Source,
+						EssenceParser::WrappingConfigList &WrapCfgList,
+						BodyWriterPtr      Writer)
+{
+	Length Ret = Writer->EstimateSize();
+	if(Ret >= 0) return Ret;
+
+	// Each input file is only counted once, even if it holds several streams
+	std::map<FileHandle, Length> InputSizes;
+
+	/* DRAGONS: This code MUST be kept in step with the logic of the loop in ProcessMetadata() */
+
+	int PreviousFP = -1;								// The index of the previous file package used - allows us to know if we treat this is a sub-stream
+	int iStream = -1;									// Stream index (note that it will be incremented to 0 in the first iteration)
+	int iTrack = 0;
+	EssenceParser::WrappingConfigList::iterator WrapCfgList_it = WrapCfgList.begin();
+	while(WrapCfgList_it != WrapCfgList.end())
+	{
+		// Move on to a new stream if we are starting a new file package
+		if(Source[iTrack].first != PreviousFP) iStream++;
+
+		// Only sources written to this file are counted
+		bool WriteFP = (!pOpt->OPAtom) || (iStream == OutFileNum);
+
+		if(WriteFP && (!(*WrapCfgList_it)->IsExternal) && FileValid((*WrapCfgList_it)->GetFile()))
+		{
+			Length Size = FileSize((*WrapCfgList_it)->GetFile());
+			if(Size <= 0) return -1;
+
+			InputSizes[(*WrapCfgList_it)->GetFile()] = Size;
+		}
+
+		// Record the file package index used this time
+		PreviousFP = Source[iTrack].first;
+
+		WrapCfgList_it++;
+		iTrack++;
+	}
+
+	if(InputSizes.empty()) return -1;
+
+	Ret = BodyWriter::EstimateOverhead;
+	std::map<FileHandle, Length>::iterator it = InputSizes.begin();
+	while(it != InputSizes.end())
+	{
+		Ret += (*it).second;
+		it++;
+	}
+
+	return Ret;
+}
+
+
+//! Estimate the number of bytes in each body partition of an output file
+/*! \return The estimated size in bytes, or -1 if not known, such as when partitioning by duration with essence that is not
+ *          constant bit rate
+ */
+Length EstimatePartitionSize(int OutFileNum,
+							 ProcessOptions    *pOpt,
+							 EssenceSourcePair *Source,
+							 EssenceParser::WrappingConfigList &WrapCfgList)
+{
+	if(pOpt->BodyMode == Body_Size) return pOpt->BodyRate;
+	if(pOpt->BodyMode != Body_Duration) return -1;
+
+	Length BytesPerEditUnit = 0;
+
+	/* DRAGONS: This code MUST be kept in step with the logic of the loop in ProcessMetadata() */
+
+	int PreviousFP = -1;								// The index of the previous file package used - allows us to know if we treat this is a sub-stream
+	int iStream = -1;									// Stream index (note that it will be incremented to 0 in the first iteration)
+	int iTrack = 0;
+	EssenceParser::WrappingConfigList::iterator WrapCfgList_it = WrapCfgList.begin();
+	while(WrapCfgList_it != WrapCfgList.end())
+	{
+		// Move on to a new stream if we are starting a new file package
+		if(Source[iTrack].first != PreviousFP) iStream++;
+
+		// Only sources written to this file are counted
+		bool WriteFP = (!pOpt->OPAtom) || (iStream == OutFileNum);
+
+		if(WriteFP && (!(*WrapCfgList_it)->IsExternal))
+		{
+			UInt32 Bytes = Source[iTrack].second ? Source[iTrack].second->GetBytesPerEditUnit(pOpt->KAGSize) : 0;
+			if(Bytes == 0) return -1;
+
+			BytesPerEditUnit += Bytes;
+		}
+
+		// Record the file package index used this time
+		PreviousFP = Source[iTrack].first;
+
+		WrapCfgList_it++;
+		iTrack++;
+	}
+
+	return BytesPerEditUnit * pOpt->BodyRate;
+}
+
+
+//! Wrap each frame-wrapped source written to this file in a ParseAheadSource, so that it is parsed on its own thread
+/*! Sources that share a parser with another source, such as sub-streams and de-multiplexed audio channels, are not
+ *  wrapped as they can't safely be read on separate threads.
+ */
+void UseParseAhead(int OutFileNum,
+				   ProcessOptions    *pOpt,
+				   EssenceSourcePair *Source,
+				   EssenceParser::WrappingConfigList &WrapCfgList)
+{
+	EssenceParser::WrappingConfigList::iterator WrapCfgList_it;
+
+	std::map<EssenceParser::WrappingConfig *, bool> SharedParser;
+	FindSharedParsers(WrapCfgList, SharedParser);
+
+	/* DRAGONS: This code MUST be kept in step with the logic of the loop in ProcessMetadata() */
+
+	int PreviousFP = -1;								// The index of the previous file package used - allows us to know if we treat this is a sub-stream
+	int iStream = -1;									// Stream index (note that it will be incremented to 0 in the first iteration)
+	int iTrack = 0;
+	WrapCfgList_it = WrapCfgList.begin();
+	while(WrapCfgList_it != WrapCfgList.end())
+	{
+		// Move on to a new stream if we are starting a new file package
+		if(Source[iTrack].first != PreviousFP) iStream++;
+
+		// Only sources written to this file are read
+		bool WriteFP = (!pOpt->OPAtom) || (iStream == OutFileNum);
+
+		if(WriteFP && (!(*WrapCfgList_it)->IsExternal) && ((*WrapCfgList_it)->WrapOpt->ThisWrapType == WrappingOption::Frame)
+		   && Source[iTrack].second && (SharedParser.find((*WrapCfgList_it).GetPtr()) == SharedParser.end())
+		   && (!dynamic_cast<EssenceSubSource *>(Source[iTrack].second.GetPtr()))
+		   && (!dynamic_cast<AudioDemuxSource *>(Source[iTrack].second.GetPtr())))
+		{
+			Source[iTrack].second = new ParseAheadSource(Source[iTrack].second, pOpt->ParseAhead);
+		}
+
+		// Record the file package index used this time
+		PreviousFP = Source[iTrack].first;
+
+		WrapCfgList_it++;
+		iTrack++;
+	}
+}
+
+
 //! Process an output file
 Length Process(
 			   int					OutFileNum,
@@ -348,10 +527,14 @@ Length Process(
 			   UMIDPtr				MPUMID,
 			   UMIDPtr				*FPUMID,
 			   UMIDPtr				*SPUMID,
-			   bool				*pReadyForEssenceFlag  /* =NULL */
+			   bool				*pReadyForEssenceFlag, /* =NULL */
+			   Mutex				*pSetupLock  /* =NULL */
 			   )
 
 {
+	// Build the metadata for this file while other files of the set are not doing the same
+	if(pSetupLock) pSetupLock->Lock();
+
 	TimecodeComponentPtr MPTimecodeComponent ;
 
 	Length Ret = 0;
@@ -392,6 +575,17 @@ Length Process(
 
 
 
+	// Parse sources ahead of the writer if requested
+	// DRAGONS: The caller's array of sources is used for every output file, so the filters are added to a copy
+	std::vector<EssenceSourcePair> ParseAheadSources;
+	if((pOpt->ParseAhead > 0) && (!WrapCfgList.empty()))
+	{
+		ParseAheadSources.assign(Source, Source + WrapCfgList.size());
+		Source = &ParseAheadSources[0];
+
+		UseParseAhead(OutFileNum, pOpt, Source, WrapCfgList);
+	}
+
 	// Process Metadata
 
 		ProcessMetadata( OutFileNum, pOpt,
@@ -462,6 +656,28 @@ Length Process(
 	}
 	else DynamicOffset -= Stream0->GetBERSize();
 
+		// Reserve disk space for the file, and align body partitions to file system extents, if requested
+		// DRAGONS: Each body partition is padded to a whole extent, so alignment is skipped when partitions are expected
+		//          to fill less than a quarter of an extent, rather than the file being mostly filler
+		if(pOpt->ExtentSize)
+		{
+			Length PartitionSize = EstimatePartitionSize(OutFileNum, pOpt, Source, WrapCfgList);
+			if((PartitionSize > 0) && (PartitionSize < (pOpt->ExtentSize / 4)))
+			{
+				warning("Body partitions of \"%s\" are expected to be about %s bytes, well below the extent size of %u bytes - "
+						"they will not be aligned to extents as each would be padded to a whole extent\n",
+						Out->Name.c_str(), Int64toString(PartitionSize).c_str(), (unsigned int)pOpt->ExtentSize);
+			}
+			else Writer->SetExtentSize(pOpt->ExtentSize);
+		}
+		if(pOpt->Preallocate > 0) Writer->SetPreallocate(pOpt->Preallocate);
+		else if(pOpt->Preallocate < 0)
+		{
+			Length Size = EstimateFileSize(OutFileNum, pOpt, Source, WrapCfgList, Writer);
+			if(Size < 0) warning("Unable to estimate the size of \"%s\" - disk space will not be reserved\n", Out->Name.c_str());
+			else Writer->SetPreallocate(Size);
+		}
+
 		if( pOpt->BlockSize )
 		{
 			// set dynamic default if -ko=-1000
@@ -498,6 +714,8 @@ Length Process(
 		if(pReadyForEssenceFlag)
 			*pReadyForEssenceFlag=true;
 
+		if(pSetupLock) pSetupLock->Unlock();
+
 		Ret=ProcessEssence(OutFileNum,pOpt,Source,WrapCfgList,
 			Writer,EditRate, MData,EssStrInf,MPTimecodeComponent
 			);
@@ -521,6 +739,9 @@ Length Process(
 		if(pOpt->OPAtom) Writer->WriteFooter(false);
 		else Writer->WriteFooter(true, true);
 
+		// A stream can't go back to update the header, which was left open and incomplete
+		if(Out->IsStreaming()) return Ret;
+
 		//
 		// ** Update the header ** 
 		//
@@ -646,3 +867,107 @@ Length Process(
 
 		return Ret;
 }
+
+
+//! Worker thread that writes one file of an OP-Atom set by calling Process()
+class AtomFileWriter : public Thread
+{
+protected:
+	int OutFileNum;
+	MXFFilePtr Out;
+	ProcessOptions Opt;								//!< Copy of the options, as Process() may update them
+	EssenceParser::WrappingConfigList WrapCfgList;
+	EssenceSourcePair *Source;
+	Rational EditRate;
+	UMIDPtr MPUMID;
+	UMIDPtr *FPUMID;
+	UMIDPtr *SPUMID;
+	Mutex *SetupLock;
+	Length Duration;								//!< The duration written, once joined
+
+public:
+	AtomFileWriter(int OutFileNum, MXFFilePtr Out, ProcessOptions *pOpt, EssenceParser::WrappingConfigList &WrapCfgList,
+				   EssenceSourcePair *Source, Rational EditRate, UMIDPtr MPUMID, UMIDPtr *FPUMID, UMIDPtr *SPUMID, Mutex *SetupLock)
+		: OutFileNum(OutFileNum), Out(Out), Opt(*pOpt), WrapCfgList(WrapCfgList), Source(Source), EditRate(EditRate),
+		  MPUMID(MPUMID), FPUMID(FPUMID), SPUMID(SPUMID), SetupLock(SetupLock), Duration(0) {}
+
+	//! Write the file on this thread, if a new thread could not be started
+	void RunHere(void) { Run(); }
+
+	//! Get the duration written
+	Length GetDuration(void) const { return Duration; }
+
+protected:
+	virtual void Run(void)
+	{
+		Duration = Process(OutFileNum, Out, &Opt, WrapCfgList, Source, EditRate, MPUMID, FPUMID, SPUMID, NULL, SetupLock);
+	}
+};
+
+
+//! Process all the files of an OP-Atom set at once, with each file written by Process() on its own thread
+bool ProcessAtomSet(int					OutFileCount,
+					MXFFilePtr			*Out,
+					ProcessOptions		*pOpt,
+					EssenceParser::WrappingConfigList WrapCfgList,
+					EssenceSourcePair	*Source,
+					Rational			EditRate,
+					UMIDPtr				MPUMID,
+					UMIDPtr				*FPUMID,
+					UMIDPtr				*SPUMID,
+					Length				*Durations
+					)
+{
+	// Sources sharing a parser are read by the thread writing each one's file, which only a demultiplexer allows for
+	bool Shared = false;
+
+	std::map<EssenceParser::WrappingConfig *, bool> SharedParser;
+	FindSharedParsers(WrapCfgList, SharedParser);
+	if(!SharedParser.empty()) Shared = true;
+
+	size_t iTrack;
+	for(iTrack = 0; iTrack < WrapCfgList.size(); iTrack++)
+	{
+		if(dynamic_cast<EssenceSubSource *>(Source[iTrack].second.GetPtr())) Shared = true;
+	}
+
+	if(Shared)
+	{
+		warning("Some essence streams share a parser, so OP-Atom files will be written one at a time\n");
+
+		int OutFileNum;
+		for(OutFileNum = 0; OutFileNum < OutFileCount; OutFileNum++)
+		{
+			Durations[OutFileNum] = Process(OutFileNum, Out[OutFileNum], pOpt, WrapCfgList, Source, EditRate, MPUMID, FPUMID, SPUMID);
+		}
+
+		return false;
+	}
+
+	Mutex SetupLock;
+	std::vector<AtomFileWriter *> Writers;
+
+	int OutFileNum;
+	for(OutFileNum = 0; OutFileNum < OutFileCount; OutFileNum++)
+	{
+		AtomFileWriter *ThisWriter = new AtomFileWriter(OutFileNum, Out[OutFileNum], pOpt, WrapCfgList, Source, EditRate, MPUMID, FPUMID, SPUMID, &SetupLock);
+		Writers.push_back(ThisWriter);
+
+		if(!ThisWriter->Start())
+		{
+			// DRAGONS: Writing this file here may need a demultiplexer to buffer all data read for other files until they catch up
+			warning("Unable to start a thread to write \"%s\" - writing it before continuing\n", pOpt->OutFilename[OutFileNum]);
+			ThisWriter->RunHere();
+		}
+	}
+
+	for(OutFileNum = 0; OutFileNum < OutFileCount; OutFileNum++)
+	{
+		Writers[OutFileNum]->Join();
+		Durations[OutFileNum] = Writers[OutFileNum]->GetDuration();
+
+		delete Writers[OutFileNum];
+	}
+
+	return true;
+}
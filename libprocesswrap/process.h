@@ -163,6 +163,7 @@ public:
 
 	bool Stats;				//!< enable basic Sdats output at final exit
 	bool ShowTiming;			//!< Show timing 
+	bool ShowIOStats;			//!< Show I/O and allocation counts for each output file and the whole run
 
 	/*********************************************************
 	***
@@ -171,6 +172,7 @@ public:
 	**********************************************************/
 	bool OPAtom;				//!< Is OP-Atom mode being forced?
 	bool OPAtom2Part;			//!< Has a 2-partition OP-Atom file been requested (only works for VBR)
+	bool OPAtomConcurrent;		//!< Write all files of an OP-Atom set at once, each on its own thread
 
 
 	/*********************************************************
@@ -248,6 +250,10 @@ public:
 	PartitionMode BodyMode;					//!< The mode of body partition insertion
 	UInt32 BodyRate;						//!< The rate of body partition insertion
 	bool EditAlign ;						//!< Start new body partitions only at the start of a GOP
+	Length Preallocate;						//!< Bytes of disk space to reserve for each output file, -1 to estimate, or 0 for none
+	UInt32 ExtentSize;						//!< File system extent size to align body partitions to, or 0 for none
+	UInt32 DirectWrites;					//!< Block size for writing output files with direct I/O, bypassing the page cache, or 0 for normal writes
+	bool AsyncWrites;						//!< Queue large essence writes to output files asynchronously, if the library has io_uring support
 
 
 	Rational ForceEditRate;					//!< Edit rate to try and force
@@ -305,6 +311,9 @@ public:
 	***
 	************************************************************************/
 
+	int PrefetchFiles;						//!< Number of files of a numbered input sequence to open ahead in the background (0 = none)
+	int ParseAhead;							//!< Number of edit units to parse ahead of the writer on a thread per source (0 = parse in the writer)
+
 
 
 
@@ -321,6 +330,7 @@ public:
 		DebugMode = false;
 		Stats = false;
 		ShowTiming = true;
+		ShowIOStats = false;
 
 		SelectedWrappingOption=-1;
 
@@ -342,6 +352,7 @@ public:
 
 		OPAtom=false;		
 		OPAtom2Part=false;	
+		OPAtomConcurrent=false;
 		FrameGroup=false;
 		ZeroPad = false;
 		StreamMode=false;
@@ -364,6 +375,10 @@ public:
 		AudioEditRate = Rational(0,1);
 
 		BodyRate=0;
+		Preallocate=0;
+		ExtentSize=0;
+		DirectWrites=0;
+		AsyncWrites=false;
 		BodyMode=Body_None;
 
 
@@ -387,6 +402,9 @@ public:
 		AudioBits=0;
 		ExtractAudio=false;                     //Will only be valid if using compressed audio
 
+		PrefetchFiles=0;
+		ParseAhead=0;
+
 
 	}
 
@@ -429,7 +447,30 @@ Length Process(
 				UMIDPtr				MPUMID,     //!< The UMID for the master package
 				UMIDPtr				*FPUMID,    //!< An array of UMIDs for each file package. There should be as many UMIDs as there are stream of essence to wrap
 				UMIDPtr				*SPUMID,    //!< An pair of UMIDs for the source packages.
-				bool				*pReadyForEssenceFlag=NULL  //!A pointer to a common flag used to synchronize multiple wrapping threads
+				bool				*pReadyForEssenceFlag=NULL,  //!A pointer to a common flag used to synchronize multiple wrapping threads
+				Mutex				*pSetupLock=NULL	//!< If not NULL, held while the header metadata is built and released once ready for essence
+												//!< so that threads writing the files of a set don't build metadata from the shared descriptors at the same time
+			);
+
+/*!
+Process all the files of an OP-Atom set at once, with each file written by Process() on its own thread.
+Essence is read once, as it is written to its atom file, so sources that share a demultiplexer are read
+together rather than one file at a time. If any sources share a parser that can't be read from more than
+one thread, the files are written one at a time instead.
+DRAGONS: The dictionary must have been frozen with FreezeDictionary() before calling this function
+\return true if the files were written concurrently, false if they were written one at a time
+*/
+bool ProcessAtomSet(
+				int					OutFileCount, //!< The number of files in the set, one per essence stream
+				MXFFilePtr			*Out,		//!< An array of the open MXF file objects, one for each output file
+				ProcessOptions		*pOpt,     //!< A pointer to the options that are required for these output files (each thread uses a copy)
+				EssenceParser::WrappingConfigList WrappingList,  //!< A List of the wrapping options for the essence being wrapped
+				EssenceSourcePair	*Source,    //!< An array of pairs ( file package index and a source to insert into that file package).
+				Rational			EditRate,   //!< The edit rate that is right for the master package.
+				UMIDPtr				MPUMID,     //!< The UMID for the master package
+				UMIDPtr				*FPUMID,    //!< An array of UMIDs for each file package
+				UMIDPtr				*SPUMID,    //!< An pair of UMIDs for the source packages.
+				Length				*Durations	//!< An array to receive the duration written to each output file
 			);
 
 #endif //_PROCESS_H_
@@ -0,0 +1,1868 @@
+/*! \file	mxfbench.cpp
+ *	\brief	Performance benchmarks for MXFLib, with a generator for large synthetic test files
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#include "mxflib/mxflib.h"
+using namespace mxflib;
+
+// include the autogenerated dictionary
+#include "mxflib/dict.h"
+
+#ifdef HAVE_OPENSSL
+#include "crypto_asdcp.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <list>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// Product GUID and version text for this release
+UInt8 ProductGUID_Data[16] = { 0x5e, 0x1b, 0x7c, 0x93, 0x2a, 0x44, 0x4d, 0x0f, 0x9b, 0x61, 0x30, 0xd8, 0x7e, 0x05, 0xa2, 0xc4 };
+string CompanyName = "freeMXF.org";
+string ProductName = "mxfbench benchmark file generator";
+string ProductVersion = "Based on " + LibraryVersion();
+
+//! Debug flag for MXFLib
+static bool DebugMode = false;
+
+
+namespace
+{
+	//! A layout of generated file, covering the combinations of operational pattern, bit rate, wrapping and index placement
+	struct FileLayout
+	{
+		const char *Name;					//!< Name of the layout, used for the file name and in the results
+		bool OPAtom;						//!< True for OP-Atom, false for OP1a
+		bool VBR;							//!< True for variable size frames with a long-GOP style index, false for fixed size frames
+		bool ClipWrap;						//!< True for clip wrapping, false for frame wrapping
+		bool Sprinkled;						//!< True to index each body partition, false for an index in the footer only
+		bool JP2K;							//!< True for frames that are JPEG 2000 codestreams, only used with fixed size frames
+	};
+
+	//! The layouts that can be generated
+	/*! DRAGONS: Clip wrapped essence is all in one partition, so is only indexed in the footer */
+	const FileLayout Layouts[] =
+	{
+		{ "op1a-cbr-frame-sprinkled",	false,	false,	false,	true,	false },
+		{ "op1a-vbr-frame-sprinkled",	false,	true,	false,	true,	false },
+		{ "op1a-vbr-frame-footer",		false,	true,	false,	false,	false },
+		{ "op1a-cbr-clip-footer",		false,	false,	true,	false,	false },
+		{ "opatom-cbr-clip-footer",		true,	false,	true,	false,	false },
+		{ "opatom-vbr-clip-footer",		true,	true,	true,	false,	false },
+		{ "op1a-jp2k-frame-sprinkled",	false,	false,	false,	true,	true },
+	};
+
+	//! Number of entries in Layouts
+	const int LayoutCount = sizeof(Layouts) / sizeof(Layouts[0]);
+
+	//! Names of the scenarios that can be run, in the order they are run
+	const char *Scenarios[] = { "crypto", "live", "wrap", "header", "footer", "index", "demux", "seek", "jp2k", "parallel" };
+
+	//! Number of entries in Scenarios
+	const int ScenarioCount = sizeof(Scenarios) / sizeof(Scenarios[0]);
+
+	//! BodySID of the essence in generated files
+	const UInt32 BenchBodySID = 1;
+
+	//! IndexSID of the index table in generated files
+	const UInt32 BenchIndexSID = 129;
+
+	//! Number of frames in each synthetic GOP
+	const int GOPSize = 12;
+
+	//! Largest number of bytes read from a KLV value at once when demultiplexing
+	const size_t DemuxChunkSize = 16 * 1024 * 1024;
+
+	//! Number of frames ahead of each request that the seek scenario hints will be needed
+	const int SeekHintDepth = 4;
+
+	//! Number of components in each synthetic JPEG 2000 codestream
+	const int JP2KComponents = 3;
+
+	//! Number of decomposition levels in each synthetic JPEG 2000 codestream, giving one more resolution level
+	const int JP2KLevels = 3;
+
+	//! Number of quality layers in each synthetic JPEG 2000 codestream
+	const int JP2KLayers = 2;
+
+	//! Number of resolution levels in each tile-part of a synthetic JPEG 2000 codestream
+	const int JP2KTilePartLevels = 2;
+
+	//! Number of bytes of each synthetic JPEG 2000 codestream left for headers, the rest holds packets
+	const size_t JP2KHeaderSpace = 512;
+
+	//! Number of distinct frames cycled through by the crypto scenario
+	const int CryptoFrames = 16;
+
+	//! Number of different frame sizes, and starting offsets into the fill pattern, used by the live scenario
+	const int LiveFrameVariants = 7;
+
+
+	//! Options set on the command line
+	struct BenchOptions
+	{
+		Length SizeMB;						//!< Size of the essence in each generated file, in megabytes
+		size_t FrameSize;					//!< Average size of each frame in bytes
+		Length PartitionDuration;			//!< Number of frames in each body partition of frame wrapped files
+		int Repeat;							//!< Number of times to repeat the header and footer scenarios, and the parses by each thread of the parallel scenario
+		int Threads;						//!< Number of threads in the parallel scenario
+		Length Lookups;						//!< Number of index table lookups to time
+		bool DropCache;						//!< Ask the operating system to drop cached file data before each read scenario
+		bool Keep;							//!< Keep the generated files after running
+		std::string WorkDir;				//!< Directory to hold the generated files
+		std::string OutFile;				//!< File to write the results to, or empty for stdout
+		bool LayoutSelected[LayoutCount];	//!< True for each layout to generate
+		bool ScenarioSelected[ScenarioCount];	//!< True for each scenario to run
+	};
+
+	//! The result of timing one scenario
+	struct BenchResult
+	{
+		std::string Scenario;				//!< Name of the scenario
+		std::string Layout;					//!< Name of the file layout, or empty if not file based
+		Length Operations;					//!< Number of operations timed (frames, parses or lookups)
+		Length Bytes;						//!< Number of bytes processed, or 0 if not relevant
+		double Seconds;						//!< Time taken
+	};
+
+	//! List of results, in the order they were run
+	typedef std::list<BenchResult> BenchResultList;
+
+
+	//! Get a wall clock time in seconds, for timing scenarios
+	double BenchTime(void)
+	{
+#ifdef _WIN32
+		LARGE_INTEGER Now;
+		LARGE_INTEGER Freq;
+		QueryPerformanceCounter(&Now);
+		QueryPerformanceFrequency(&Freq);
+		return static_cast<double>(Now.QuadPart) / static_cast<double>(Freq.QuadPart);
+#else
+		struct timeval Now;
+		gettimeofday(&Now, NULL);
+		return static_cast<double>(Now.tv_sec) + static_cast<double>(Now.tv_usec) / 1000000.0;
+#endif
+	}
+
+
+	//! Add a result to the list
+	void AddResult(BenchResultList &Results, const char *Scenario, const char *Layout, Length Operations, Length Bytes, double Seconds)
+	{
+		BenchResult Result;
+		Result.Scenario = Scenario;
+		if(Layout) Result.Layout = Layout;
+		Result.Operations = Operations;
+		Result.Bytes = Bytes;
+		Result.Seconds = Seconds;
+
+		Results.push_back(Result);
+
+		fprintf(stderr, "  %-12s %-26s %10s ops %12s bytes in %.3fs\n", Scenario, Layout ? Layout : "",
+				Int64toString(Operations).c_str(), Int64toString(Bytes).c_str(), Seconds);
+	}
+
+
+	//! Append a marker segment to a codestream
+	void AppendMarker(DataChunk &Out, UInt8 Marker, const UInt8 *Body, size_t Size)
+	{
+		UInt8 Buffer[4] = { 0xff, Marker };
+		PutU16(static_cast<UInt16>(Size + 2), &Buffer[2]);
+		Out.Append(4, Buffer);
+		Out.Append(Size, Body);
+	}
+
+
+	//! Build a synthetic JPEG 2000 codestream, or the codestream JP2KFrameReader should return for it when reading less
+	/*! The codestream is exactly Size bytes, with one tile of three components coded in RLCP order. Each tile-part holds
+	 *  JP2KTilePartLevels resolution levels and signals its packet lengths with a PLT marker. A COM marker in the main header
+	 *  pads it to size. The packet bytes are taken from Fill and are not decodable.
+	 *
+	 *  If Reduce or Layers would leave out any packets the result is the codestream truncated after the last packet needed,
+	 *  as JP2KFrameReader builds it: tile-parts after that packet are dropped, the rest lose their PLT markers and have Psot
+	 *  updated and TNsot set to zero, and an EOC marker is added.
+	 */
+	void BuildCodestream(const UInt8 *Fill, size_t Size, int Reduce, int Layers, DataChunk &Out)
+	{
+		const int Resolutions = JP2KLevels + 1;
+		const int TileParts = Resolutions / JP2KTilePartLevels;
+		const int TilePartPackets = JP2KTilePartLevels * JP2KLayers * JP2KComponents;
+		const int Packets = TileParts * TilePartPackets;
+
+		// Share out the packet bytes in RLCP order, with each resolution level having twice the bytes of the one below
+		size_t PacketBytes = Size - JP2KHeaderSpace;
+		size_t Weights = ((1 << Resolutions) - 1) * JP2KLayers * JP2KComponents;
+		std::vector<size_t> PacketLengths(Packets);
+		size_t Shared = 0;
+		for(int i = 0; i < Packets; i++)
+		{
+			int r = i / (JP2KLayers * JP2KComponents);
+			PacketLengths[i] = (i == Packets - 1) ? (PacketBytes - Shared) : std::max(static_cast<size_t>(1), (PacketBytes << r) / Weights);
+			Shared += PacketLengths[i];
+		}
+
+		// Find the last packet needed, keeping all packets before it
+		int MaxRes = std::max(JP2KLevels - Reduce, 0);
+		int MaxLayers = (Layers > 0) ? Layers : JP2KLayers;
+		int LastNeeded = -1;
+		for(int i = 0; i < Packets; i++)
+		{
+			int r = i / (JP2KLayers * JP2KComponents);
+			int l = (i / JP2KComponents) % JP2KLayers;
+			if((r <= MaxRes) && (l < MaxLayers)) LastNeeded = i;
+		}
+		bool Whole = (LastNeeded == Packets - 1);
+
+		// Build the PLT marker segment body for each tile-part, 7 bits per byte with the top bit set on all but the last byte
+		std::vector<DataChunk> PLT(TileParts);
+		size_t TilePartBytes = 0;
+		for(int t = 0; t < TileParts; t++)
+		{
+			UInt8 Zplt = static_cast<UInt8>(t);
+			PLT[t].Append(1, &Zplt);
+			for(int i = t * TilePartPackets; i < (t + 1) * TilePartPackets; i++)
+			{
+				UInt8 Coded[5];
+				int Bytes = 0;
+				size_t Remaining = PacketLengths[i];
+				do
+				{
+					Coded[4 - Bytes] = static_cast<UInt8>((Remaining & 0x7f) | (Bytes ? 0x80 : 0));
+					Remaining >>= 7;
+					Bytes++;
+				} while(Remaining);
+				PLT[t].Append(Bytes, &Coded[5 - Bytes]);
+			}
+
+			TilePartBytes += 12 + 4 + PLT[t].Size + 2;
+		}
+
+		/* Main header */
+
+		UInt8 SIZ[36 + 3 * JP2KComponents];
+		memset(SIZ, 0, sizeof(SIZ));
+		PutU32(1920, &SIZ[2]);
+		PutU32(1080, &SIZ[6]);
+		PutU32(1920, &SIZ[18]);
+		PutU32(1080, &SIZ[22]);
+		PutU16(JP2KComponents, &SIZ[34]);
+		for(int c = 0; c < JP2KComponents; c++)
+		{
+			SIZ[36 + c * 3] = 7;
+			SIZ[37 + c * 3] = (c == 0) ? 1 : 2;
+			SIZ[38 + c * 3] = 1;
+		}
+
+		// No user-defined precincts, so one precinct per resolution level, reversible 5/3 transform
+		const UInt8 COD[10] = { 0x00, 0x01, 0x00, JP2KLayers, 0x00, JP2KLevels, 0x04, 0x04, 0x00, 0x01 };
+
+		// No quantization, with the same exponent for every sub-band
+		UInt8 QCD[1 + 3 * JP2KLevels + 1];
+		memset(QCD, 0x48, sizeof(QCD));
+		QCD[0] = 0x40;
+
+		// Pad the main header with a comment so that the codestream is exactly Size bytes
+		size_t MainHeaderBytes = 2 + (4 + sizeof(SIZ)) + (4 + sizeof(COD)) + (4 + sizeof(QCD));
+		size_t CommentBytes = Size - (MainHeaderBytes + 4 + TilePartBytes + PacketBytes + 2);
+		DataChunk COM;
+		COM.Set(CommentBytes, static_cast<UInt8>(0));
+
+		const UInt8 SOC[2] = { 0xff, 0x4f };
+		const UInt8 SOD[2] = { 0xff, 0x93 };
+		const UInt8 EOC[2] = { 0xff, 0xd9 };
+
+		Out.Resize(0);
+		Out.Append(2, SOC);
+		AppendMarker(Out, 0x51, SIZ, sizeof(SIZ));
+		AppendMarker(Out, 0x52, COD, sizeof(COD));
+		AppendMarker(Out, 0x5c, QCD, sizeof(QCD));
+		AppendMarker(Out, 0x64, COM.Data, COM.Size);
+
+		/* Tile-parts */
+
+		size_t FillOffset = 0;
+		for(int t = 0; t < TileParts; t++)
+		{
+			int First = t * TilePartPackets;
+			int Last = First + TilePartPackets - 1;
+			if(!Whole && (Last > LastNeeded)) Last = LastNeeded;
+			if(Last < First) break;
+
+			size_t DataBytes = 0;
+			for(int i = First; i <= Last; i++) DataBytes += PacketLengths[i];
+
+			UInt8 SOT[8];
+			PutU16(0, &SOT[0]);
+			PutU32(static_cast<UInt32>(12 + (Whole ? (4 + PLT[t].Size) : 0) + 2 + DataBytes), &SOT[2]);
+			SOT[6] = static_cast<UInt8>(t);
+			SOT[7] = Whole ? static_cast<UInt8>(TileParts) : 0;
+
+			AppendMarker(Out, 0x90, SOT, sizeof(SOT));
+			if(Whole) AppendMarker(Out, 0x58, PLT[t].Data, PLT[t].Size);
+			Out.Append(2, SOD);
+			Out.Append(DataBytes, &Fill[FillOffset]);
+
+			FillOffset += DataBytes;
+		}
+
+		Out.Append(2, EOC);
+	}
+
+
+	//! Synthetic picture essence, with fixed size frames or long-GOP style variable size frames
+	/*! The frame bytes are pseudo-random and are not decodable, only the sizes, GOP structure and
+	 *  wrapping match real essence. Each call to GetEssenceData() returns at most one frame, so VBR
+	 *  clip wrapped essence can be indexed. Fixed size frames may instead be JPEG 2000 codestreams,
+	 *  with valid headers but pseudo-random packets, see BuildCodestream().
+	 */
+	class SyntheticSource : public EssenceSource
+	{
+	protected:
+		Length Duration;					//!< Number of frames to generate
+		size_t FrameSize;					//!< Size of a CBR frame, or the average size of a VBR frame
+		bool VBR;							//!< True if frame sizes vary
+		bool ClipWrap;						//!< True if clip wrapping
+		bool JP2K;							//!< True if each frame is a JPEG 2000 codestream
+		Position Current;					//!< The frame being returned
+		size_t FrameOffset;					//!< Number of bytes of the current frame already returned
+		Length Remaining;					//!< Number of bytes of the clip not yet returned
+		bool AtEndOfItem;					//!< True if the last call to GetEssenceData() ended a wrapping unit
+		DataChunk Fill;						//!< Pseudo-random bytes from which each frame is taken
+		DataChunk Frame;					//!< The current JPEG 2000 frame
+
+	public:
+		//! Construct a source of a given number of frames
+		SyntheticSource(Length Duration, size_t FrameSize, bool VBR, bool ClipWrap, bool JP2K = false)
+			: Duration(Duration), FrameSize(FrameSize), VBR(VBR), ClipWrap(ClipWrap), JP2K(JP2K)
+		{
+			Current = 0;
+			FrameOffset = 0;
+			AtEndOfItem = false;
+
+			Remaining = TotalBytes();
+
+			// Allow each frame to start at any of 256 offsets into the fill, so that successive frames differ
+			size_t FillSize = VBR ? (FrameSize * 4) : FrameSize;
+			FillSize += 256 * 64;
+
+			Fill.Resize(FillSize);
+			UInt32 Seed = 0x2545f491;
+			for(size_t i = 0; i < FillSize; i++)
+			{
+				Seed = Seed * 1103515245 + 12345;
+				Fill.Data[i] = static_cast<UInt8>(Seed >> 23);
+			}
+		}
+
+		//! Get the size of a given frame
+		size_t FrameBytes(Position Frame) const
+		{
+			if(!VBR) return FrameSize;
+
+			// I frames are followed by pairs of B frames between P frames, which averages a little under FrameSize
+			int InGOP = static_cast<int>(Frame % GOPSize);
+			double Scale;
+			if(InGOP == 0) Scale = 3.0;
+			else if((InGOP % 3) == 0) Scale = 1.2;
+			else Scale = 0.65;
+
+			// Vary each frame by up to 10% either way
+			UInt32 Hash = static_cast<UInt32>(Frame) * 2654435761U;
+			double Jitter = 0.9 + 0.2 * static_cast<double>(Hash >> 16) / 65535.0;
+
+			return static_cast<size_t>(static_cast<double>(FrameSize) * Scale * Jitter);
+		}
+
+		//! Build a JPEG 2000 frame, or the codestream JP2KFrameReader should return for it when reading less
+		void BuildFrame(Position Frame, int Reduce, int Layers, DataChunk &Out) const
+		{
+			BuildCodestream(&Fill.Data[(Frame & 0xff) * 64], FrameSize, Reduce, Layers, Out);
+		}
+
+		//! Get the total number of essence bytes
+		Length TotalBytes(void) const
+		{
+			Length Ret = 0;
+			for(Position i = 0; i < Duration; i++) Ret += FrameBytes(i);
+			return Ret;
+		}
+
+		//! Get the size of the next "installment" of essence data in bytes
+		virtual size_t GetEssenceDataSize(void)
+		{
+			if(ClipWrap) return static_cast<size_t>(Remaining);
+			if(Current >= Duration) return 0;
+			return FrameBytes(Current) - FrameOffset;
+		}
+
+		//! Get the next "installment" of essence data
+		virtual DataChunkPtr GetEssenceData(size_t Size = 0, size_t MaxSize = 0)
+		{
+			if(Current >= Duration) return NULL;
+
+			size_t ThisFrame = FrameBytes(Current);
+			size_t Bytes = ThisFrame - FrameOffset;
+			if(Size && (Bytes > Size)) Bytes = Size;
+			if(MaxSize && (Bytes > MaxSize)) Bytes = MaxSize;
+
+			// Index the frame as it starts, with each frame keyed from the start of its GOP
+			if(VBR && (FrameOffset == 0) && IndexMan)
+			{
+				int InGOP = static_cast<int>(Current % GOPSize);
+				int Flags;
+				if(InGOP == 0) Flags = 0xc0;
+				else if((InGOP % 3) == 0) Flags = 0x22;
+				else Flags = 0x33;
+
+				IndexMan->OfferEditUnit(IndexStreamID, Current, -InGOP, Flags);
+			}
+
+			DataChunkPtr Ret;
+			if(JP2K)
+			{
+				if(FrameOffset == 0) BuildFrame(Current, 0, 0, Frame);
+				Ret = new DataChunk(Bytes, &Frame.Data[FrameOffset]);
+			}
+			else
+			{
+				size_t Start = static_cast<size_t>((Current & 0xff) * 64) + FrameOffset;
+				Ret = new DataChunk(Bytes, &Fill.Data[Start]);
+			}
+
+			FrameOffset += Bytes;
+			Remaining -= Bytes;
+
+			if(FrameOffset == ThisFrame)
+			{
+				Current++;
+				FrameOffset = 0;
+				AtEndOfItem = !ClipWrap || (Current >= Duration);
+			}
+			else AtEndOfItem = false;
+
+			return Ret;
+		}
+
+		//! Did the last call to GetEssenceData() return the end of a wrapping item
+		virtual bool EndOfItem(void) { return AtEndOfItem; }
+
+		//! Is all data exhasted?
+		virtual bool EndOfData(void) { return Current >= Duration; }
+
+		//! Get the GCEssenceType to use when wrapping this essence in a Generic Container
+		virtual UInt8 GetGCEssenceType(void) { return 0x15; }
+
+		//! Get the GCEssenceType to use when wrapping this essence in a Generic Container
+		virtual UInt8 GetGCElementType(void)
+		{
+			if(JP2K) return ClipWrap ? 0x09 : 0x08;
+			return ClipWrap ? 0x06 : 0x05;
+		}
+
+		//! Get the edit rate of this wrapping of the essence
+		virtual Rational GetEditRate(void) { return Rational(25, 1); }
+
+		//! Get the current position in GetEditRate() sized edit units
+		virtual Position GetCurrentPosition(void) { return Current; }
+
+		//! Get BytesPerEditUnit if Constant, else 0
+		virtual UInt32 GetBytesPerEditUnit(UInt32 KAGSize = 1)
+		{
+			if(VBR) return 0;
+			if(ClipWrap) return static_cast<UInt32>(FrameSize);
+
+			// DRAGONS: This assumes that 4-byte BER coding is used, which the writer is set to force
+			UInt32 Ret = static_cast<UInt32>(FrameSize) + 16 + 4;
+
+			// Round up to a whole number of KAGs, leaving space for a filler
+			if(KAGSize > 1)
+			{
+				UInt32 Remainder = Ret % KAGSize;
+				if(Remainder) Remainder = KAGSize - Remainder;
+				Ret += Remainder;
+
+				while((Remainder > 0) && (Remainder < 17))
+				{
+					Ret += KAGSize;
+					Remainder += KAGSize;
+				}
+			}
+
+			return Ret;
+		}
+
+		//! Can this stream provide indexing
+		virtual bool CanIndex() { return VBR; }
+
+		//! Enable VBR indexing, even in clip-wrap mode - each frame is always returned by its own call
+		virtual bool EnableVBRIndexMode(void) { return true; }
+
+		//! Get the preferred BER length size for essence KLVs written from this source
+		virtual int GetBERSize(void) { return ClipWrap ? 8 : 4; }
+
+		//! Get the name of this essence source (used for error messeges)
+		virtual std::string Name(void) { return "Synthetic benchmark essence"; }
+	};
+
+
+	//! Read handler that reads the whole value of each KLV, as an essence extractor would
+	class DemuxHandler : public GCReadHandler_Base
+	{
+	public:
+		Length Items;						//!< Number of KLVs read
+		Length Bytes;						//!< Number of value bytes read
+
+	public:
+		DemuxHandler() : Items(0), Bytes(0) {}
+
+		//! Handle a "chunk" of data that has been read from the file
+		virtual bool HandleData(GCReaderPtr Caller, KLVObjectPtr Object)
+		{
+			Length Size = Object->GetLength();
+			Position Offset = 0;
+			while(Offset < Size)
+			{
+				size_t Chunk = DemuxChunkSize;
+				if(static_cast<Length>(Chunk) > (Size - Offset)) Chunk = static_cast<size_t>(Size - Offset);
+
+				size_t Read = Object->ReadDataFrom(Offset, Chunk);
+				if(Read == 0) return false;
+
+				Offset += Read;
+			}
+
+			Items++;
+			Bytes += Size;
+
+			return true;
+		}
+	};
+
+
+	//! Thread that repeatedly opens a file and parses its header metadata, for the parallel scenario
+	class ParseThread : public Thread
+	{
+	public:
+		std::string FileName;				//!< The file to parse
+		int Repeat;							//!< Number of times to open and parse the file
+		size_t Expected;					//!< Number of header metadata sets each parse should find
+		int Failures;						//!< Number of parses that failed or found a different number of sets
+		Length Bytes;						//!< Number of header metadata bytes parsed
+
+	public:
+		ParseThread() : Repeat(0), Expected(0), Failures(0), Bytes(0) {}
+
+	protected:
+		//! Open and parse the file Repeat times
+		virtual void Run(void)
+		{
+			for(int i = 0; i < Repeat; i++)
+			{
+				MXFFilePtr File = new MXFFile;
+				if(!File->Open(FileName, true))
+				{
+					Failures++;
+					continue;
+				}
+
+				PartitionPtr Header = File->ReadPartition();
+				if(!Header || (Header->ReadMetadata() <= 0) || !Header->ParseMetadata() || (Header->AllMetadata.size() != Expected)) Failures++;
+				else Bytes += Header->GetInt64(HeaderByteCount_UL);
+
+				File->Close();
+			}
+		}
+	};
+
+	//! Get the size of a frame pushed by the live scenario
+	size_t LiveFrameSize(size_t FrameSize, Length Frame)
+	{
+		return FrameSize - static_cast<size_t>(Frame % LiveFrameVariants);
+	}
+
+
+	//! Thread that pushes numbered frames into a LiveEssenceSource as a capture card would, for the live scenario
+	/*! Each frame starts with its number, followed by bytes from a fill pattern at an offset set by the number */
+	class LiveProducer : public Thread
+	{
+	public:
+		LiveEssenceSource *Source;			//!< The source to push frames into
+		Length Frames;						//!< Number of frames to push
+		size_t FrameSize;					//!< Largest frame size
+		const UInt8 *Pattern;				//!< Fill pattern, at least FrameSize + LiveFrameVariants bytes
+		Length FullWaits;					//!< Number of times the ring was checked and found full
+
+	public:
+		LiveProducer() : Source(NULL), Frames(0), FrameSize(0), Pattern(NULL), FullWaits(0) {}
+
+	protected:
+		//! Push all frames then end the input
+		/*! DRAGONS: A real capture thread can't wait and would drop the frame, but here each frame waits for space
+		 *           so that the consumer can check that every frame arrives in order
+		 */
+		virtual void Run(void)
+		{
+			UInt8 *Frame = new UInt8[FrameSize];
+
+			for(Length i = 0; i < Frames; i++)
+			{
+				size_t Size = LiveFrameSize(FrameSize, i);
+				PutU64(static_cast<UInt64>(i), Frame);
+				memcpy(&Frame[8], &Pattern[i % LiveFrameVariants], Size - 8);
+
+				// Only this thread adds frames, so once there is space the push can't fail
+				while(Source->GetFillLevel() >= Source->GetCapacity()) FullWaits++;
+				Source->PushFrame(Frame, Size);
+			}
+
+			Source->EndOfInput();
+
+			delete[] Frame;
+		}
+	};
+}
+
+
+//! Parse a comma separated list of names, setting a flag for each one found
+static bool ParseNameList(const char *List, const char *Names[], int NameCount, bool *Selected)
+{
+	for(int i = 0; i < NameCount; i++) Selected[i] = false;
+
+	std::string Remaining = List;
+	while(!Remaining.empty())
+	{
+		std::string::size_type Comma = Remaining.find(',');
+		std::string Name = Remaining.substr(0, Comma);
+		Remaining = (Comma == std::string::npos) ? "" : Remaining.substr(Comma + 1);
+
+		int i;
+		for(i = 0; i < NameCount; i++)
+		{
+			if(Name == Names[i])
+			{
+				Selected[i] = true;
+				break;
+			}
+		}
+
+		if(i == NameCount)
+		{
+			fprintf(stderr, "Unknown name \"%s\"\n", Name.c_str());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+//! Is a given scenario selected?
+static bool Selected(const BenchOptions &Options, const char *Scenario)
+{
+	for(int i = 0; i < ScenarioCount; i++)
+	{
+		if(strcmp(Scenarios[i], Scenario) == 0) return Options.ScenarioSelected[i];
+	}
+
+	return false;
+}
+
+
+//! Generate a test file with a given layout
+/*! \return The number of essence bytes written, or -1 on error */
+static Length GenerateFile(const BenchOptions &Options, const FileLayout &Layout, std::string FileName, Length &Frames)
+{
+	// Work out the number of frames needed to give the requested essence size
+	SyntheticSource *Probe = new SyntheticSource(GOPSize, Options.FrameSize, Layout.VBR, Layout.ClipWrap, Layout.JP2K);
+	Length GOPBytes = Probe->TotalBytes();
+	delete Probe;
+
+	Frames = (Options.SizeMB * 1024 * 1024 * GOPSize) / GOPBytes;
+	if(Frames < 1) Frames = 1;
+
+	SyntheticSource *pSource = new SyntheticSource(Frames, Options.FrameSize, Layout.VBR, Layout.ClipWrap, Layout.JP2K);
+	EssenceSourcePtr Source = pSource;
+	Length EssenceBytes = pSource->TotalBytes();
+
+	// FastClipWrap is safe as the output is a file
+	SetFastClipWrap(true);
+
+	MXFFilePtr OutFile = new MXFFile;
+	if(!OutFile->OpenNew(FileName))
+	{
+		error("Couldn't open output file %s\n", FileName.c_str());
+		return -1;
+	}
+
+	BodyStreamPtr Stream = new BodyStream(BenchBodySID, Source);
+	Stream->SetWrapType(Layout.ClipWrap ? BodyStream::StreamWrapClip : BodyStream::StreamWrapFrame);
+
+	// Index as mxfwrap does, with CBR essence also indexed in the header
+	if(Layout.VBR)
+	{
+		Stream->SetIndexType(Layout.Sprinkled ? BodyStream::StreamIndexSprinkled : BodyStream::StreamIndexFullFooter);
+	}
+	else
+	{
+		if(Layout.Sprinkled) Stream->SetIndexType( (BodyStream::IndexType) ( BodyStream::StreamIndexCBRHeader
+			| BodyStream::StreamIndexCBRBody | BodyStream::StreamIndexCBRFooter) );
+		else Stream->SetIndexType( (BodyStream::IndexType) ( BodyStream::StreamIndexCBRHeader | BodyStream::StreamIndexCBRFooter) );
+	}
+	Stream->SetIndexSID(BenchIndexSID);
+
+	BodyWriterPtr Writer = new BodyWriter(OutFile);
+	Writer->SetKAG(1);
+	Writer->SetForceBER4(true);
+
+	// OP-Atom keeps the header metadata on its own so that it can be re-written once complete
+	if(Layout.OPAtom) Writer->SetMetadataSharing(false, false);
+	else Writer->SetMetadataSharing(true, true);
+
+	Writer->AddStream(Stream);
+
+
+	/* Build the header metadata */
+
+	MetadataPtr MData = new Metadata();
+
+	const UInt8 OP1a_Data[16] = { 0x06, 0x0e, 0x2b, 0x34, 0x04, 0x01, 0x01, 0x01, 0x0d, 0x01, 0x02, 0x01, 0x01, 0x01, 0x01, 0x00 };
+	const UInt8 OPAtom_Data[16] = { 0x06, 0x0e, 0x2b, 0x34, 0x04, 0x01, 0x01, 0x02, 0x0d, 0x01, 0x02, 0x01, 0x10, 0x00, 0x00, 0x00 };
+	ULPtr OPUL = new UL(Layout.OPAtom ? OPAtom_Data : OP1a_Data);
+	MData->SetOP(OPUL);
+
+	Rational EditRate = Source->GetEditRate();
+
+	PackagePtr MaterialPackage = MData->AddMaterialPackage(MakeUMID(0x01));
+	PackagePtr FilePackage = MData->AddFilePackage(BenchBodySID, MakeUMID(0x01));
+
+	TrackPtr MPTimecodeTrack = MaterialPackage->AddTimecodeTrack(EditRate);
+	TimecodeComponentPtr MPTimecodeComponent = MPTimecodeTrack->AddTimecodeComponent();
+	TrackPtr FPTimecodeTrack = FilePackage->AddTimecodeTrack(EditRate);
+	TimecodeComponentPtr FPTimecodeComponent = FPTimecodeTrack->AddTimecodeComponent();
+
+	TrackPtr MPEssenceTrack = MaterialPackage->AddPictureTrack(EditRate);
+	TrackPtr FPEssenceTrack = FilePackage->AddPictureTrack(Stream->GetTrackNumber(), EditRate);
+
+	SourceClipPtr MPClip = MPEssenceTrack->AddSourceClip();
+	SourceClipPtr FPClip = FPEssenceTrack->AddSourceClip();
+	MPClip->MakeLink(FPEssenceTrack, 0);
+
+	// The payload is not real MPEG-2, but the MPEG-2 long-GOP mapping gives the same wrapping and index structure
+	UInt8 WrappingUL_Data[16] = { 0x06, 0x0e, 0x2b, 0x34, 0x04, 0x01, 0x01, 0x02, 0x0d, 0x01, 0x03, 0x01, 0x02, 0x04, 0x60, 0x01 };
+	if(Layout.ClipWrap) WrappingUL_Data[15] = 0x02;
+
+	// JPEG 2000 frames use the JPEG 2000 mapping
+	const UInt8 JP2KWrappingUL_Data[16] = { 0x06, 0x0e, 0x2b, 0x34, 0x04, 0x01, 0x01, 0x07, 0x0d, 0x01, 0x03, 0x01, 0x02, 0x0c, 0x01, 0x00 };
+	if(Layout.JP2K) memcpy(WrappingUL_Data, JP2KWrappingUL_Data, 16);
+	if(Layout.JP2K && Layout.ClipWrap) WrappingUL_Data[14] = 0x02;
+
+	ULPtr WrappingUL = new UL(WrappingUL_Data);
+
+	MDObjectPtr Descriptor = new MDObject(CDCIEssenceDescriptor_UL);
+	Descriptor->SetString(SampleRate_UL, "25/1");
+	Descriptor->SetValue(EssenceContainer_UL, DataChunk(16, WrappingUL_Data));
+	Descriptor->SetInt(FrameLayout_UL, 0);
+	Descriptor->SetUInt(StoredWidth_UL, 1920);
+	Descriptor->SetUInt(StoredHeight_UL, 1080);
+	Descriptor->SetString(AspectRatio_UL, "16/9");
+	Descriptor->SetUInt(ComponentDepth_UL, 8);
+	Descriptor->SetUInt(HorizontalSubsampling_UL, 2);
+	Descriptor->SetUInt(VerticalSubsampling_UL, 1);
+	Descriptor->SetUInt(LinkedTrackID_UL, FPEssenceTrack->GetUInt(TrackID_UL));
+	FilePackage->AddChild(Descriptor_UL)->MakeLink(Descriptor);
+
+	MData->AddEssenceType(WrappingUL);
+
+	// The primary package of OP-Atom is the file package
+	if(Layout.OPAtom) MData->SetPrimaryPackage(FilePackage);
+	else MData->SetPrimaryPackage(MaterialPackage);
+
+	MDObjectPtr Ident = new MDObject(Identification_UL);
+	Ident->SetString(CompanyName_UL, CompanyName);
+	Ident->SetString(ProductName_UL, ProductName);
+	Ident->SetString(VersionString_UL, ProductVersion);
+	Ident->SetString(ToolkitVersion_UL, LibraryProductVersion());
+	Ident->SetString(Platform_UL, PlatformName());
+	Ident->SetValue(ProductUID_UL, DataChunk(16, ProductGUID_Data));
+
+	MData->UpdateGenerations(Ident);
+
+	PartitionPtr ThisPartition = new Partition(OpenHeader_UL);
+	ThisPartition->SetKAG(1);
+	ThisPartition->SetUInt(BodySID_UL, BenchBodySID);
+	ThisPartition->AddMetadata(MData);
+	Writer->SetPartition(ThisPartition);
+
+
+	/* Write the file */
+
+	// Leave space in the OP-Atom header for the updated metadata
+	if(Layout.OPAtom) Writer->SetPartitionFiller(4096);
+
+	Writer->WriteHeader(false, false);
+
+	while(!Writer->BodyDone())
+	{
+		Writer->WritePartition(Options.PartitionDuration, 0);
+	}
+
+	Length EssenceDuration = static_cast<Length>(Source->GetCurrentPosition());
+	MPTimecodeComponent->SetDuration(EssenceDuration);
+	MPClip->SetDuration(EssenceDuration);
+	FPTimecodeComponent->SetDuration(EssenceDuration);
+	FPClip->SetDuration(EssenceDuration);
+	Descriptor->SetInt64(ContainerDuration_UL, EssenceDuration);
+
+	MData->SetTime();
+	MData->UpdateGenerations(Ident);
+	ThisPartition->UpdateMetadata(MData);
+
+	// OP-Atom has no metadata in the footer, the header is re-written instead
+	if(Layout.OPAtom) Writer->WriteFooter(false);
+	else Writer->WriteFooter(true, true);
+
+	UInt64 FooterPos = ThisPartition->GetUInt64(FooterPartition_UL);
+	OutFile->Seek(0);
+
+	if(Layout.OPAtom)
+	{
+		PartitionPtr OldHeader = OutFile->ReadPartition();
+
+		ThisPartition->ChangeType(ClosedCompleteHeader_UL);
+		ThisPartition->SetUInt64(FooterPartition_UL, FooterPos);
+		ThisPartition->SetKAG(OldHeader->GetUInt(KAGSize_UL));
+		ThisPartition->SetUInt(IndexSID_UL, OldHeader->GetUInt(IndexSID_UL));
+		ThisPartition->SetUInt64(BodySID_UL, OldHeader->GetUInt(BodySID_UL));
+
+		OutFile->Seek(0);
+		if(!OutFile->ReWritePartition(ThisPartition))
+		{
+			error("Failed to re-write the header of %s\n", FileName.c_str());
+			OutFile->Close();
+			return -1;
+		}
+	}
+	else
+	{
+		// Point the header at the footer
+		PartitionPtr Header = OutFile->ReadPartition();
+		Header->SetUInt64(FooterPartition_UL, FooterPos);
+		OutFile->Seek(0);
+		OutFile->WritePartitionPack(Header);
+	}
+
+	OutFile->Close();
+
+	return EssenceBytes;
+}
+
+
+//! Ask the operating system to drop any cached data for a file, so that it is read from the storage
+static void DropCachedData(std::string FileName)
+{
+	MXFFilePtr File = new MXFFile;
+	if(!File->Open(FileName, true)) return;
+
+	File->DontNeed(0, File->Size());
+	File->Close();
+}
+
+
+//! Time parsing of the header metadata
+static bool BenchHeader(const BenchOptions &Options, const FileLayout &Layout, std::string FileName, BenchResultList &Results)
+{
+	if(Options.DropCache) DropCachedData(FileName);
+
+	Length Bytes = 0;
+	double Start = BenchTime();
+
+	for(int i = 0; i < Options.Repeat; i++)
+	{
+		MXFFilePtr File = new MXFFile;
+		if(!File->Open(FileName, true))
+		{
+			error("Couldn't open %s\n", FileName.c_str());
+			return false;
+		}
+
+		PartitionPtr Header = File->ReadPartition();
+		if(!Header || (Header->ReadMetadata() <= 0) || !Header->ParseMetadata())
+		{
+			error("Failed to read the header metadata of %s\n", FileName.c_str());
+			return false;
+		}
+
+		Bytes += Header->GetInt64(HeaderByteCount_UL);
+		File->Close();
+	}
+
+	AddResult(Results, "header", Layout.Name, Options.Repeat, Bytes, BenchTime() - Start);
+
+	return true;
+}
+
+
+//! Time opening a file from the end: reading the RIP, the footer partition and any footer metadata
+static bool BenchFooter(const BenchOptions &Options, const FileLayout &Layout, std::string FileName, BenchResultList &Results)
+{
+	if(Options.DropCache) DropCachedData(FileName);
+
+	Length Bytes = 0;
+	double Start = BenchTime();
+
+	for(int i = 0; i < Options.Repeat; i++)
+	{
+		MXFFilePtr File = new MXFFile;
+		if(!File->Open(FileName, true))
+		{
+			error("Couldn't open %s\n", FileName.c_str());
+			return false;
+		}
+
+		if(!File->GetRIP())
+		{
+			error("Failed to read the RIP of %s\n", FileName.c_str());
+			return false;
+		}
+
+		PartitionPtr Footer = File->ReadFooterPartition();
+		if(!Footer)
+		{
+			error("Failed to read the footer of %s\n", FileName.c_str());
+			return false;
+		}
+
+		Length MetadataSize = Footer->GetInt64(HeaderByteCount_UL);
+		if(MetadataSize > 0)
+		{
+			if((Footer->ReadMetadata() <= 0) || !Footer->ParseMetadata())
+			{
+				error("Failed to read the footer metadata of %s\n", FileName.c_str());
+				return false;
+			}
+
+			Bytes += MetadataSize;
+		}
+
+		File->Close();
+	}
+
+	AddResult(Results, "footer", Layout.Name, Options.Repeat, Bytes, BenchTime() - Start);
+
+	return true;
+}
+
+
+//! Load the index table segments from every partition of a file
+/*! \return The number of segments loaded */
+static Length LoadIndex(MXFFilePtr &File, IndexTablePtr &Index)
+{
+	File->GetRIP();
+
+	Length Segments = 0;
+
+	RIP::iterator it;
+	for(it = File->FileRIP.begin(); it != File->FileRIP.end(); it++)
+	{
+		File->Seek((*it).second->GetByteOffset());
+		PartitionPtr ThisPartition = File->ReadPartition();
+		if(!ThisPartition) continue;
+
+		MDObjectListPtr SegmentList = ThisPartition->ReadIndex();
+		MDObjectList::iterator Seg_it;
+		for(Seg_it = SegmentList->begin(); Seg_it != SegmentList->end(); Seg_it++)
+		{
+			Index->AddSegment(*Seg_it);
+			Segments++;
+		}
+	}
+
+	return Segments;
+}
+
+
+//! Time loading the index table from every partition, then random lookups in it
+static bool BenchIndex(const BenchOptions &Options, const FileLayout &Layout, std::string FileName, Length Frames, BenchResultList &Results)
+{
+	if(Options.DropCache) DropCachedData(FileName);
+
+	double Start = BenchTime();
+
+	MXFFilePtr File = new MXFFile;
+	if(!File->Open(FileName, true))
+	{
+		error("Couldn't open %s\n", FileName.c_str());
+		return false;
+	}
+
+	IndexTablePtr Index = new IndexTable;
+	Length Segments = LoadIndex(File, Index);
+
+	File->Close();
+
+	AddResult(Results, "index-load", Layout.Name, Segments, 0, BenchTime() - Start);
+
+	if(Segments == 0)
+	{
+		error("No index table found in %s\n", FileName.c_str());
+		return false;
+	}
+
+	// Random lookups, as from seeking playback
+	UInt32 Seed = 0x1f123bb5;
+	Length Inexact = 0;
+
+	Start = BenchTime();
+
+	for(Length i = 0; i < Options.Lookups; i++)
+	{
+		Seed = Seed * 1103515245 + 12345;
+		Position EditUnit = static_cast<Position>((static_cast<UInt64>(Seed) * static_cast<UInt64>(Frames)) >> 32);
+
+		IndexPosPtr Pos = Index->Lookup(EditUnit);
+		if(!Pos->Exact) Inexact++;
+	}
+
+	AddResult(Results, "index-lookup", Layout.Name, Options.Lookups, 0, BenchTime() - Start);
+
+	if(Inexact) warning("%s of %s index lookups in %s were not exact\n", Int64toString(Inexact).c_str(), Int64toString(Options.Lookups).c_str(), FileName.c_str());
+
+	return true;
+}
+
+
+//! Time reading all the essence with a BodyReader
+static bool BenchDemux(const BenchOptions &Options, const FileLayout &Layout, std::string FileName, BenchResultList &Results)
+{
+	if(Options.DropCache) DropCachedData(FileName);
+
+	double Start = BenchTime();
+
+	MXFFilePtr File = new MXFFile;
+	if(!File->Open(FileName, true))
+	{
+		error("Couldn't open %s\n", FileName.c_str());
+		return false;
+	}
+
+	File->SetAccessMode(MXFFile::AccessSequential);
+
+	DemuxHandler *pHandler = new DemuxHandler;
+	GCReadHandlerPtr Handler = pHandler;
+
+	BodyReaderPtr Reader = new BodyReader(File);
+	Reader->MakeGCReader(BenchBodySID, Handler);
+
+	while(!Reader->Eof())
+	{
+		// A failed read restarts at the next partition, so only stop if no progress is made
+		Position Before = File->Tell();
+		if(!Reader->ReadFromFile() && (File->Tell() == Before)) break;
+	}
+
+	File->Close();
+
+	AddResult(Results, "demux", Layout.Name, pHandler->Items, pHandler->Bytes, BenchTime() - Start);
+
+	return true;
+}
+
+
+//! Build the edit units requested by jog, shuttle and scrub playback of a file with a given number of frames
+/*! Playback jogs forwards, shuttles forwards at 4x, plays in reverse, shuttles back at 2x, then jumps to
+ *  pseudo-random points and plays a few frames from each. The last frame is not used, as its size can't be
+ *  found from the index table alone.
+ */
+static void BuildSeekPattern(Length Frames, std::vector<Position> &Pattern, std::vector<Length> &Steps)
+{
+	static const Length Speeds[] = { 1, 4, -1, -2 };
+	static const int SpeedRequests = 100;
+	static const int Jumps = 20;
+	static const int JumpRequests = 10;
+
+	Position Last = Frames - 2;
+	if(Last < 0) return;
+
+	Position EditUnit = 0;
+	for(int i = 0; i < static_cast<int>(sizeof(Speeds) / sizeof(Speeds[0])); i++)
+	{
+		for(int j = 0; j < SpeedRequests; j++)
+		{
+			Pattern.push_back(EditUnit);
+			Steps.push_back(Speeds[i]);
+
+			if(((EditUnit + Speeds[i]) < 0) || ((EditUnit + Speeds[i]) > Last)) break;
+			EditUnit += Speeds[i];
+		}
+	}
+
+	UInt32 Seed = 0x2b7e1516;
+	for(int i = 0; i < Jumps; i++)
+	{
+		Seed = Seed * 1103515245 + 12345;
+		EditUnit = static_cast<Position>((static_cast<UInt64>(Seed) * static_cast<UInt64>(Last + 1)) >> 32);
+
+		for(int j = 0; (j < JumpRequests) && (EditUnit <= Last); j++)
+		{
+			Pattern.push_back(EditUnit++);
+			Steps.push_back(1);
+		}
+	}
+}
+
+
+//! Read one edit unit of the benchmark essence with a blocking read, using the index table and a BodyReader to locate it
+static DataChunkPtr ReadEditUnit(MXFFilePtr &File, BodyReaderPtr &Reader, IndexTablePtr &Index, Position EditUnit)
+{
+	IndexPosPtr Pos = Index->Lookup(EditUnit, 0, false);
+	IndexPosPtr Next = Index->Lookup(EditUnit + 1, 0, false);
+	if(!Pos || !Next || !Pos->Exact || !Next->Exact || (Next->Location <= Pos->Location)) return NULL;
+
+	// The BodyReader leaves the file at the start of the edit unit
+	if(Reader->Seek(BenchBodySID, Pos->Location) < 0) return NULL;
+
+	DataChunkPtr Data = File->Read(static_cast<size_t>(Next->Location - Pos->Location));
+	if(!Data || (Data->Size != static_cast<size_t>(Next->Location - Pos->Location))) return NULL;
+
+	return Data;
+}
+
+
+//! Time jog, shuttle and scrub playback with blocking reads of each frame, then with read-ahead hints, then with a FramePrefetcher
+/*! Every frame read with hints, or returned by the prefetcher, must match the frame read directly */
+static bool BenchSeek(const BenchOptions &Options, const FileLayout &Layout, std::string FileName, Length Frames, BenchResultList &Results)
+{
+	std::vector<Position> Pattern;
+	std::vector<Length> Steps;
+	BuildSeekPattern(Frames, Pattern, Steps);
+
+	std::vector<DataChunkPtr> Expected(Pattern.size());
+
+	if(Options.DropCache) DropCachedData(FileName);
+
+	MXFFilePtr File = new MXFFile;
+	if(!File->Open(FileName, true))
+	{
+		error("Couldn't open %s\n", FileName.c_str());
+		return false;
+	}
+
+	IndexTablePtr Index = new IndexTable;
+	if(LoadIndex(File, Index) == 0)
+	{
+		error("No index table found in %s\n", FileName.c_str());
+		return false;
+	}
+
+	File->SetAccessMode(MXFFile::AccessRandom);
+	BodyReaderPtr Reader = new BodyReader(File);
+
+	Length Bytes = 0;
+	double Start = BenchTime();
+
+	size_t i;
+	for(i = 0; i < Pattern.size(); i++)
+	{
+		Expected[i] = ReadEditUnit(File, Reader, Index, Pattern[i]);
+		if(!Expected[i])
+		{
+			error("Failed to read edit unit %s of %s\n", Int64toString(Pattern[i]).c_str(), FileName.c_str());
+			return false;
+		}
+
+		Bytes += Expected[i]->Size;
+	}
+
+	AddResult(Results, "seek-direct", Layout.Name, static_cast<Length>(Pattern.size()), Bytes, BenchTime() - Start);
+
+	Reader = NULL;
+	File->Close();
+
+	// Blocking reads again, with the operating system asked to read the next frames at the current speed ahead of each request
+	if(Options.DropCache) DropCachedData(FileName);
+
+	File = new MXFFile;
+	if(!File->Open(FileName, true))
+	{
+		error("Couldn't open %s\n", FileName.c_str());
+		return false;
+	}
+
+	File->SetAccessMode(MXFFile::AccessRandom);
+	Reader = new BodyReader(File);
+
+	Length Mismatches = 0;
+	Length Hints = 0;
+	Start = BenchTime();
+
+	for(i = 0; i < Pattern.size(); i++)
+	{
+		// After a jump or a change of speed all the hinted frames are new, otherwise only the furthest one is
+		bool Continuing = (i > 0) && (Steps[i] == Steps[i - 1]) && (Pattern[i] == (Pattern[i - 1] + Steps[i]));
+		for(int j = Continuing ? SeekHintDepth : 1; j <= SeekHintDepth; j++)
+		{
+			if(Reader->WillNeed(BenchBodySID, Index, Pattern[i] + Steps[i] * j)) Hints++;
+		}
+
+		DataChunkPtr Frame = ReadEditUnit(File, Reader, Index, Pattern[i]);
+		if(!Frame || (*Frame != *Expected[i])) Mismatches++;
+	}
+
+	AddResult(Results, "seek-hinted", Layout.Name, static_cast<Length>(Pattern.size()), Bytes, BenchTime() - Start);
+	debug("%s read-ahead hints were given for %s\n", Int64toString(Hints).c_str(), FileName.c_str());
+
+	Reader = NULL;
+	File->Close();
+
+	if(Options.DropCache) DropCachedData(FileName);
+
+	File = new MXFFile;
+	if(!File->Open(FileName, true))
+	{
+		error("Couldn't open %s\n", FileName.c_str());
+		return false;
+	}
+
+	File->SetAccessMode(MXFFile::AccessRandom);
+
+	Start = BenchTime();
+
+	FramePrefetcherPtr Prefetcher = new FramePrefetcher(File, Index, BenchBodySID);
+	for(i = 0; i < Pattern.size(); i++)
+	{
+		DataChunkPtr Frame = Prefetcher->GetFrame(Pattern[i]);
+		if(!Frame || (*Frame != *Expected[i])) Mismatches++;
+	}
+
+	double Seconds = BenchTime() - Start;
+	UInt64 Hits = Prefetcher->GetHits();
+	Prefetcher = NULL;
+
+	AddResult(Results, "seek-prefetch", Layout.Name, static_cast<Length>(Pattern.size()), Bytes, Seconds);
+	debug("%s of %s frames of %s were prefetched\n", UInt64toString(Hits).c_str(), Int64toString(static_cast<Length>(Pattern.size())).c_str(), FileName.c_str());
+
+	File->Close();
+
+	if(Mismatches)
+	{
+		error("%s of %s frames read with hints or from the prefetcher did not match those read directly from %s\n",
+			  Int64toString(Mismatches).c_str(), Int64toString(static_cast<Length>(Pattern.size())).c_str(), FileName.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+
+//! Time reading every JPEG 2000 frame with a JP2KFrameReader, in full and at reduced resolution and quality
+/*! Every frame read must match the codestream written, or the truncated codestream expected for it */
+static bool BenchJP2K(const BenchOptions &Options, const FileLayout &Layout, std::string FileName, Length Frames, BenchResultList &Results)
+{
+	//! A way of reading the frames
+	struct ReadMode
+	{
+		const char *Scenario;				//!< The name of the result
+		int Reduce;							//!< Number of resolution levels to discard
+		int Layers;							//!< Number of quality layers to keep, 0 for all
+	};
+
+	const ReadMode Modes[] =
+	{
+		{ "jp2k-full",		0,	0 },
+		{ "jp2k-reduce-1",	1,	0 },
+		{ "jp2k-reduce-3",	3,	0 },
+		{ "jp2k-layers-1",	0,	1 },
+	};
+
+	// Used to build the expected frames
+	SyntheticSource *Builder = new SyntheticSource(Frames, Options.FrameSize, false, false, true);
+
+	bool OK = true;
+	for(size_t m = 0; m < sizeof(Modes) / sizeof(Modes[0]); m++)
+	{
+		if(Options.DropCache) DropCachedData(FileName);
+
+		MXFFilePtr File = new MXFFile;
+		if(!File->Open(FileName, true))
+		{
+			error("Couldn't open %s\n", FileName.c_str());
+			OK = false;
+			break;
+		}
+
+		IndexTablePtr Index = new IndexTable;
+		if(LoadIndex(File, Index) == 0)
+		{
+			error("No index table found in %s\n", FileName.c_str());
+			OK = false;
+			break;
+		}
+
+		File->SetAccessMode(MXFFile::AccessRandom);
+		JP2KFrameReaderPtr Reader = new JP2KFrameReader(File, Index, BenchBodySID);
+
+		Length Bytes = 0;
+		Length Mismatches = 0;
+		DataChunk Expected;
+		double Start = BenchTime();
+
+		for(Position i = 0; i < Frames; i++)
+		{
+			DataChunkPtr Data = Reader->ReadFrame(i, Modes[m].Reduce, Modes[m].Layers);
+			Bytes += Reader->GetBytesRead();
+
+			Builder->BuildFrame(i, Modes[m].Reduce, Modes[m].Layers, Expected);
+			if(!Data || (Data->Size != Expected.Size) || (memcmp(Data->Data, Expected.Data, Expected.Size) != 0)) Mismatches++;
+		}
+
+		// The bytes given are those read from the file, so the saving from reading less can be seen
+		AddResult(Results, Modes[m].Scenario, Layout.Name, Frames, Bytes, BenchTime() - Start);
+
+		File->Close();
+
+		if(Mismatches)
+		{
+			error("%s of %s JPEG 2000 frames read by %s from %s did not match those expected\n", Int64toString(Mismatches).c_str(),
+				  Int64toString(Frames).c_str(), Modes[m].Scenario, FileName.c_str());
+			OK = false;
+		}
+	}
+
+	delete Builder;
+
+	return OK;
+}
+
+
+//! Time parsing of the header metadata by many threads at once, each opening the file many times
+/*! This checks that a frozen dictionary can be shared, as each parse must find the same sets as a parse on one thread */
+static bool BenchParallel(const BenchOptions &Options, const FileLayout &Layout, std::string FileName, BenchResultList &Results)
+{
+	if(Options.DropCache) DropCachedData(FileName);
+
+	// Count the sets found by a parse on this thread alone
+	size_t Expected;
+	{
+		MXFFilePtr File = new MXFFile;
+		if(!File->Open(FileName, true))
+		{
+			error("Couldn't open %s\n", FileName.c_str());
+			return false;
+		}
+
+		PartitionPtr Header = File->ReadPartition();
+		if(!Header || (Header->ReadMetadata() <= 0) || !Header->ParseMetadata())
+		{
+			error("Failed to read the header metadata of %s\n", FileName.c_str());
+			return false;
+		}
+
+		Expected = Header->AllMetadata.size();
+		File->Close();
+	}
+
+	ParseThread *Parsers = new ParseThread[Options.Threads];
+
+	double Start = BenchTime();
+
+	int Started = 0;
+	for(int i = 0; i < Options.Threads; i++)
+	{
+		Parsers[i].FileName = FileName;
+		Parsers[i].Repeat = Options.Repeat;
+		Parsers[i].Expected = Expected;
+
+		if(Parsers[i].Start()) Started++;
+		else error("Failed to start parsing thread %d\n", i);
+	}
+
+	int Failures = 0;
+	Length Bytes = 0;
+	for(int i = 0; i < Options.Threads; i++)
+	{
+		Parsers[i].Join();
+		Failures += Parsers[i].Failures;
+		Bytes += Parsers[i].Bytes;
+	}
+
+	delete[] Parsers;
+
+	AddResult(Results, "parallel", Layout.Name, static_cast<Length>(Started) * Options.Repeat, Bytes, BenchTime() - Start);
+
+	if(Failures || (Started != Options.Threads))
+	{
+		error("%d of %d parallel parses of %s failed or did not find the %u expected header metadata sets\n",
+			  Failures + (Options.Threads - Started) * Options.Repeat, Options.Threads * Options.Repeat, FileName.c_str(), (unsigned int)Expected);
+		return false;
+	}
+
+	return true;
+}
+
+
+//! Time frames passing from a capture thread through a LiveEssenceSource ring to this thread
+/*! This checks that every frame arrives whole and in order, that odd frames can be taken in pieces, and that
+ *  EndOfData() only becomes true once the input has ended and the last frame has been taken
+ */
+static bool BenchLive(const BenchOptions &Options, BenchResultList &Results)
+{
+	// Pass as much data as one generated file, up to 1GB
+	Length Total = Options.SizeMB * 1024 * 1024;
+	if(Total > 1024 * 1024 * 1024) Total = 1024 * 1024 * 1024;
+	Length Count = Total / Options.FrameSize;
+	if(Count < LiveFrameVariants) Count = LiveFrameVariants;
+
+	DataChunk Pattern(Options.FrameSize + LiveFrameVariants);
+	for(size_t i = 0; i < Pattern.Size; i++) Pattern.Data[i] = static_cast<UInt8>((i * 13) ^ (i >> 7));
+
+	LiveEssenceSource *Source = new LiveEssenceSource(Rational(25, 1), 0x15, 0x01);
+	EssenceSourcePtr SourcePtr = Source;
+
+	LiveProducer Producer;
+	Producer.Source = Source;
+	Producer.Frames = Count;
+	Producer.FrameSize = Options.FrameSize;
+	Producer.Pattern = Pattern.Data;
+
+	double Start = BenchTime();
+
+	if(!Producer.Start())
+	{
+		error("Failed to start live producer thread\n");
+		return false;
+	}
+
+	Length Received = 0;
+	Length Bytes = 0;
+	Length Mismatches = 0;
+	bool EndedEarly = false;
+	DataChunk Frame(Options.FrameSize);
+	for(;;)
+	{
+		// Take odd frames in pieces to check that a split frame is reassembled
+		size_t MaxSize = (Received & 1) ? (Options.FrameSize / 3) : 0;
+
+		Frame.Resize(0);
+		bool Ended = false;
+		for(;;)
+		{
+			DataChunkPtr Data = Source->GetEssenceData(0, MaxSize);
+			if(!Data)
+			{
+				Ended = true;
+				break;
+			}
+
+			Frame.Append(Data);
+			if(Source->EndOfItem()) break;
+		}
+
+		if(Ended)
+		{
+			if(Frame.Size) Mismatches++;
+			break;
+		}
+
+		size_t Size = LiveFrameSize(Options.FrameSize, Received);
+		if((Frame.Size != Size) || (GetU64(Frame.Data) != static_cast<UInt64>(Received))
+		   || (memcmp(&Frame.Data[8], &Pattern.Data[Received % LiveFrameVariants], Size - 8) != 0)) Mismatches++;
+
+		Received++;
+		Bytes += Frame.Size;
+
+		if((Received < Count) && Source->EndOfData()) EndedEarly = true;
+	}
+
+	Producer.Join();
+
+	AddResult(Results, "live", NULL, Received, Bytes, BenchTime() - Start);
+
+	debug("Live ring of %u frames peaked at %u, producer found it full %s times\n", (unsigned int)Source->GetCapacity(),
+		  (unsigned int)Source->GetPeakFill(), Int64toString(Producer.FullWaits).c_str());
+
+	if(Mismatches || EndedEarly || (Received != Count) || !Source->EndOfData() || (Source->GetCurrentPosition() != Count)
+	   || (static_cast<Length>(Source->GetFramesPushed()) != Count) || (Source->GetFramesDropped() != 0))
+	{
+		error("Live source returned %s of %s frames with %s mismatched%s%s\n", Int64toString(Received).c_str(), Int64toString(Count).c_str(),
+			  Int64toString(Mismatches).c_str(), EndedEarly ? ", reporting EndOfData() early" : "", Source->EndOfData() ? "" : ", not reporting EndOfData() at the end");
+		return false;
+	}
+
+	return true;
+}
+
+
+#ifdef HAVE_OPENSSL
+//! Time AES-128 CBC encryption and decryption of frame sized buffers, as used by mxfcrypt
+static bool BenchCrypto(const BenchOptions &Options, BenchResultList &Results)
+{
+	const UInt8 Key[16] = { 0x4a, 0x8f, 0x21, 0x07, 0xd3, 0x5e, 0x9c, 0x60, 0x11, 0xb4, 0x7a, 0xe2, 0x38, 0xc5, 0x0d, 0x96 };
+	UInt8 IV[16];
+
+	// Build a set of plaintext frames, rounded up to whole AES blocks
+	size_t BlockSize = ((Options.FrameSize + 15) / 16) * 16;
+	DataChunk Plaintext(BlockSize * CryptoFrames);
+	for(size_t i = 0; i < Plaintext.Size; i++) Plaintext.Data[i] = static_cast<UInt8>((i * 7) ^ (i >> 9));
+
+	DataChunkPtr Ciphertext[CryptoFrames];
+
+	// Process as much data as one generated file, up to 1GB
+	Length Total = Options.SizeMB * 1024 * 1024;
+	if(Total > 1024 * 1024 * 1024) Total = 1024 * 1024 * 1024;
+	Length Count = Total / BlockSize;
+	if(Count < CryptoFrames) Count = CryptoFrames;
+
+	AESEncrypt Encrypt;
+	Encrypt.SetKey(16, Key);
+
+	double Start = BenchTime();
+	for(Length i = 0; i < Count; i++)
+	{
+		int Frame = static_cast<int>(i % CryptoFrames);
+
+		memset(IV, 0, 16);
+		PutU64(i, IV);
+		Encrypt.SetIV(16, IV, true);
+		Ciphertext[Frame] = Encrypt.Encrypt(BlockSize, &Plaintext.Data[Frame * BlockSize]);
+	}
+	AddResult(Results, "aes-encrypt", NULL, Count, Count * BlockSize, BenchTime() - Start);
+
+	AESDecrypt Decrypt;
+	Decrypt.SetKey(16, Key);
+
+	bool Matched = true;
+	Start = BenchTime();
+	for(Length i = 0; i < Count; i++)
+	{
+		// The last CryptoFrames encrypted are the ones kept, so decrypt those in rotation
+		Length Encrypted = Count - CryptoFrames + (i % CryptoFrames);
+		int Frame = static_cast<int>(Encrypted % CryptoFrames);
+
+		memset(IV, 0, 16);
+		PutU64(Encrypted, IV);
+		Decrypt.SetIV(16, IV, true);
+		DataChunkPtr Result = Decrypt.Decrypt(BlockSize, Ciphertext[Frame]->Data);
+
+		if((i < CryptoFrames) && (!Result || (memcmp(Result->Data, &Plaintext.Data[Frame * BlockSize], BlockSize) != 0))) Matched = false;
+	}
+	AddResult(Results, "aes-decrypt", NULL, Count, Count * BlockSize, BenchTime() - Start);
+
+	if(!Matched)
+	{
+		error("AES decryption did not reproduce the plaintext\n");
+		return false;
+	}
+
+	return true;
+}
+#endif // HAVE_OPENSSL
+
+
+//! Write a string as a JSON string literal
+static void WriteJSONString(FILE *Out, const std::string &Value)
+{
+	fputc('"', Out);
+
+	std::string::const_iterator it;
+	for(it = Value.begin(); it != Value.end(); it++)
+	{
+		unsigned char c = static_cast<unsigned char>(*it);
+		if((c == '"') || (c == '\\')) fprintf(Out, "\\%c", c);
+		else if(c < 0x20) fprintf(Out, "\\u%04x", c);
+		else fputc(c, Out);
+	}
+
+	fputc('"', Out);
+}
+
+
+//! Write the results as JSON
+static void WriteResults(FILE *Out, const BenchOptions &Options, const BenchResultList &Results, bool Failed)
+{
+	fprintf(Out, "{\n  \"tool\": \"mxfbench\",\n  \"library\": ");
+	WriteJSONString(Out, LibraryVersion());
+	fprintf(Out, ",\n  \"platform\": ");
+	WriteJSONString(Out, PlatformName());
+	fprintf(Out, ",\n  \"options\": { \"size_mb\": %s, \"frame_size\": %s, \"partition_duration\": %s, \"repeat\": %d, \"threads\": %d, \"lookups\": %s, \"drop_cache\": %s },\n",
+			Int64toString(Options.SizeMB).c_str(), Int64toString(Options.FrameSize).c_str(), Int64toString(Options.PartitionDuration).c_str(),
+			Options.Repeat, Options.Threads, Int64toString(Options.Lookups).c_str(), Options.DropCache ? "true" : "false");
+	fprintf(Out, "  \"status\": \"%s\",\n", Failed ? "failed" : "ok");
+	fprintf(Out, "  \"results\": [");
+
+	BenchResultList::const_iterator it;
+	for(it = Results.begin(); it != Results.end(); it++)
+	{
+		double Seconds = (*it).Seconds > 0 ? (*it).Seconds : 1e-9;
+
+		fprintf(Out, "%s\n    { \"scenario\": ", (it == Results.begin()) ? "" : ",");
+		WriteJSONString(Out, (*it).Scenario);
+		fprintf(Out, ", \"layout\": ");
+		if((*it).Layout.empty()) fprintf(Out, "null");
+		else WriteJSONString(Out, (*it).Layout);
+		fprintf(Out, ", \"operations\": %s, \"bytes\": %s, \"seconds\": %.6f, \"ops_per_sec\": %.3f, \"mb_per_sec\": %.3f }",
+				Int64toString((*it).Operations).c_str(), Int64toString((*it).Bytes).c_str(), (*it).Seconds,
+				static_cast<double>((*it).Operations) / Seconds, static_cast<double>((*it).Bytes) / (1024.0 * 1024.0) / Seconds);
+	}
+
+	fprintf(Out, "\n  ]\n}\n");
+}
+
+
+//! Run the benchmarks
+int main(int argc, char *argv[])
+{
+	BenchOptions Options;
+	Options.SizeMB = 1024;
+	Options.FrameSize = 600000;
+	Options.PartitionDuration = 250;
+	Options.Repeat = 20;
+	Options.Threads = 16;
+	Options.Lookups = 1000000;
+	Options.DropCache = false;
+	Options.Keep = false;
+	Options.WorkDir = ".";
+	for(int i = 0; i < LayoutCount; i++) Options.LayoutSelected[i] = true;
+	for(int i = 0; i < ScenarioCount; i++) Options.ScenarioSelected[i] = true;
+
+	bool WorkDirSet = false;
+	bool ShowUsage = false;
+
+	for(int i=1; i<argc; i++)
+	{
+		if(argv[i][0] == '-')
+		{
+			char *p = &argv[i][1];					// The option less the '-'
+			char Opt = tolower(*p);					// The option itself (in lower case)
+
+			// Value for options that take one, either after '=' or ':' or in the next argument
+			const char *Value = NULL;
+			if((p[1] == '=') || (p[1] == ':')) Value = &p[2];
+			else if(strchr("sfplrjnto", Opt) && (argc > (i + 1))) Value = argv[++i];
+
+			if(Opt == 'v') DebugMode = true;
+			else if(Opt == 'c') Options.DropCache = true;
+			else if(Opt == 'k') Options.Keep = true;
+			else if(Opt == 'h') ShowUsage = true;
+			else if(Value && (Opt == 's')) Options.SizeMB = atoi(Value);
+			else if(Value && (Opt == 'f')) Options.FrameSize = atoi(Value);
+			else if(Value && (Opt == 'p')) Options.PartitionDuration = atoi(Value);
+			else if(Value && (Opt == 'r')) Options.Repeat = atoi(Value);
+			else if(Value && (Opt == 'j')) Options.Threads = atoi(Value);
+			else if(Value && (Opt == 'n')) Options.Lookups = atoi(Value);
+			else if(Value && (Opt == 'o')) Options.OutFile = Value;
+			else if(Value && (Opt == 'l'))
+			{
+				const char *Names[LayoutCount];
+				for(int j = 0; j < LayoutCount; j++) Names[j] = Layouts[j].Name;
+				if(!ParseNameList(Value, Names, LayoutCount, Options.LayoutSelected)) return 1;
+			}
+			else if(Value && (Opt == 't'))
+			{
+				if(!ParseNameList(Value, Scenarios, ScenarioCount, Options.ScenarioSelected)) return 1;
+			}
+			else
+			{
+				fprintf(stderr, "Unknown option %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else if(!WorkDirSet)
+		{
+			Options.WorkDir = argv[i];
+			WorkDirSet = true;
+		}
+		else
+		{
+			fprintf(stderr, "Too many directories\n");
+			return 1;
+		}
+	}
+
+	if(ShowUsage || (Options.SizeMB < 1) || (Options.FrameSize < 1024) || (Options.PartitionDuration < 1) || (Options.Repeat < 1) || (Options.Threads < 1) || (Options.Lookups < 1))
+	{
+		fprintf(stderr, "\nUsage: %s [options] [<workdir>]\n\n", argv[0]);
+
+		fprintf(stderr, "Generates synthetic MXF files in <workdir> (default current directory), times\n");
+		fprintf(stderr, "reading and writing them and writes the results as JSON. Progress is shown on\n");
+		fprintf(stderr, "stderr so that stdout only holds the results\n\n");
+
+		fprintf(stderr, "Where: -s=<mb>     Essence size of each generated file in megabytes (default 1024)\n");
+		fprintf(stderr, "       -f=<bytes>  Average frame size (default 600000)\n");
+		fprintf(stderr, "       -p=<frames> Body partition duration of frame wrapped files (default 250)\n");
+		fprintf(stderr, "       -r=<count>  Repeat count for the header and footer scenarios, and for each\n");
+		fprintf(stderr, "                   thread of the parallel scenario (default 20)\n");
+		fprintf(stderr, "       -j=<count>  Number of threads in the parallel scenario (default 16)\n");
+		fprintf(stderr, "       -n=<count>  Number of index table lookups to time (default 1000000)\n");
+		fprintf(stderr, "       -l=<list>   Comma separated file layouts to generate (default all):\n");
+		for(int i = 0; i < LayoutCount; i++) fprintf(stderr, "                      %s\n", Layouts[i].Name);
+		fprintf(stderr, "       -t=<list>   Comma separated scenarios to run (default all):\n");
+		fprintf(stderr, "                      crypto  AES encryption and decryption (if built with OpenSSL)\n");
+		fprintf(stderr, "                      live    Frames passed by a capture thread through a\n");
+		fprintf(stderr, "                              LiveEssenceSource ring\n");
+		fprintf(stderr, "                      wrap    BodyWriter wrapping of each layout\n");
+		fprintf(stderr, "                      header  Header metadata parsing\n");
+		fprintf(stderr, "                      footer  RIP, footer partition and footer metadata reading\n");
+		fprintf(stderr, "                      index   Index table loading and random IndexTable::Lookup()\n");
+		fprintf(stderr, "                      demux   BodyReader reading of all essence\n");
+		fprintf(stderr, "                      seek    Jog, shuttle and scrub playback, reading each frame when\n");
+		fprintf(stderr, "                              requested, then with BodyReader::WillNeed() hints for the\n");
+		fprintf(stderr, "                              following frames, then with a FramePrefetcher\n");
+		fprintf(stderr, "                      jp2k    JP2KFrameReader reading of the JPEG 2000 layout, in full\n");
+		fprintf(stderr, "                              and at reduced resolution and quality\n");
+		fprintf(stderr, "                      parallel  Header metadata parsing by many threads at once,\n");
+		fprintf(stderr, "                              sharing a frozen dictionary\n");
+		fprintf(stderr, "       -o=<file>   Write the JSON results to <file> rather than stdout\n");
+		fprintf(stderr, "       -c          Ask the OS to drop cached file data before each read scenario\n");
+		fprintf(stderr, "       -k          Keep the generated files\n");
+		fprintf(stderr, "       -v          Verbose mode (debug output)\n");
+
+		return 1;
+	}
+
+	LoadDictionary(DictData);
+
+	// The dictionary must be frozen before it is shared between threads, and it may still be used for writing once frozen
+	if(Selected(Options, "parallel")) FreezeDictionary();
+
+	BenchResultList Results;
+	bool Failed = false;
+
+	if(Selected(Options, "crypto"))
+	{
+#ifdef HAVE_OPENSSL
+		if(!BenchCrypto(Options, Results)) Failed = true;
+#else
+		warning("Skipping crypto scenario as mxfbench was built without OpenSSL\n");
+#endif
+	}
+
+	if(Selected(Options, "live"))
+	{
+		if(!BenchLive(Options, Results)) Failed = true;
+	}
+
+	// All other scenarios work on generated files
+	bool NeedFiles = false;
+	for(int i = 0; i < ScenarioCount; i++)
+	{
+		if(Options.ScenarioSelected[i] && (strcmp(Scenarios[i], "crypto") != 0) && (strcmp(Scenarios[i], "live") != 0)) NeedFiles = true;
+	}
+
+	for(int i = 0; NeedFiles && (i < LayoutCount); i++)
+	{
+		if(!Options.LayoutSelected[i]) continue;
+
+		const FileLayout &Layout = Layouts[i];
+		std::string FileName = Options.WorkDir + "/" + Layout.Name + ".mxf";
+
+		fprintf(stderr, "Generating %s\n", FileName.c_str());
+
+		// Generation is always needed, but only reported if the wrap scenario is selected
+		Length Frames;
+		double Start = BenchTime();
+		Length Bytes = GenerateFile(Options, Layout, FileName, Frames);
+		if(Bytes < 0)
+		{
+			Failed = true;
+			break;
+		}
+		if(Selected(Options, "wrap")) AddResult(Results, "wrap", Layout.Name, Frames, Bytes, BenchTime() - Start);
+
+		bool OK = true;
+		if(OK && Selected(Options, "header")) OK = BenchHeader(Options, Layout, FileName, Results);
+		if(OK && Selected(Options, "footer")) OK = BenchFooter(Options, Layout, FileName, Results);
+		if(OK && Selected(Options, "index")) OK = BenchIndex(Options, Layout, FileName, Frames, Results);
+		if(OK && Selected(Options, "demux")) OK = BenchDemux(Options, Layout, FileName, Results);
+		if(OK && Selected(Options, "seek")) OK = BenchSeek(Options, Layout, FileName, Frames, Results);
+		if(OK && Layout.JP2K && Selected(Options, "jp2k")) OK = BenchJP2K(Options, Layout, FileName, Frames, Results);
+		if(OK && Selected(Options, "parallel")) OK = BenchParallel(Options, Layout, FileName, Results);
+
+		if(!OK) Failed = true;
+
+		if(!Options.Keep) FileDelete(FileName.c_str());
+	}
+
+	if(Options.OutFile.empty()) WriteResults(stdout, Options, Results, Failed);
+	else
+	{
+		FILE *Out = fopen(Options.OutFile.c_str(), "w");
+		if(!Out)
+		{
+			error("Couldn't open results file %s\n", Options.OutFile.c_str());
+			return 1;
+		}
+
+		WriteResults(Out, Options, Results, Failed);
+		fclose(Out);
+	}
+
+	return Failed ? 1 : 0;
+}
+
+
+// Debug and error messages
+// DRAGONS: These all go to stderr so that stdout only holds the results
+
+#ifdef MXFLIB_DEBUG
+//! Display a general debug message
+void mxflib::debug(const char *Fmt, ...)
+{
+	if(!DebugMode) return;
+
+	va_list args;
+
+	va_start(args, Fmt);
+	vfprintf(stderr, Fmt, args);
+	va_end(args);
+}
+#endif // MXFLIB_DEBUG
+
+//! Display a warning message
+void mxflib::warning(const char *Fmt, ...)
+{
+	va_list args;
+
+	va_start(args, Fmt);
+	fprintf(stderr, "Warning: ");
+	vfprintf(stderr, Fmt, args);
+	va_end(args);
+}
+
+//! Display an error message
+void mxflib::error(const char *Fmt, ...)
+{
+	va_list args;
+
+	va_start(args, Fmt);
+	fprintf(stderr, "ERROR: ");
+	vfprintf(stderr, Fmt, args);
+	va_end(args);
+}
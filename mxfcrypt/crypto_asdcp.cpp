@@ -160,6 +160,20 @@ printf("\n");
 
 
 
+//! Set an encryption key
+/*! \return True if key is accepted
+ *  DRAGONS: This is not inline in the header so that files including it don't use the low-level AES calls that are
+ *           deprecated since OpenSSL 3, and only this file needs to be built with those warnings disabled
+ */
+bool AESEncrypt::SetKey(size_t KeySize, const UInt8 *Key)
+{
+	int Ret = AES_set_encrypt_key(Key, 128, &CurrentKey);
+
+	// Return true only if key setting was OK
+	return Ret ? false : true; 
+}
+
+
 //! Encrypt data and return in a new buffer
 /*! \return NULL pointer if the encryption is unsuccessful
  */
@@ -261,6 +275,25 @@ bool Encrypt_GCReadHandler::HandleData(GCReaderPtr Caller, KLVObjectPtr Object)
 //	printf("0x%08x -> %02x:0x%08x Data for Track 0x%08x, ", (int)Object->GetLocation(), OurSID, (int)Caller->GetStreamOffset(), Object->GetGCTrackNumber());
 //	printf("Size = 0x%08x\n", (int)Object->GetLength());
 
+	// Set an encryption IV
+	// DRAGONS: The current draft AS-DCP specification requires this to be an encryption strength random number generator.
+	//          However as the IV is always sent in plaintext there is no advantage doing this.
+	//          In fact it is actually more secure to use sequential IVs starting at some moderately random value
+	// TODO: Make IVs sequential
+	UInt8 IV[16];
+	int i; for(i=0; i<16; i++) IV[i] = (UInt8) rand();
+
+	// If we have a worker pool, hand this KLV over to it - it will be written once encrypted
+	if(Pool)
+	{
+		Pool->Add(Object, EncKey, IV, ContextID, PlaintextOffset, Hashing, Index, IndexPos);
+
+		// Update the index position count (even if not yet indexing)
+		IndexPos++;
+
+		return true;
+	}
+
 	// Create an encrypted vertion of this KLVObject
 	KLVEObjectPtr KLVE = new KLVEObject(Object);
 
@@ -282,14 +315,6 @@ bool Encrypt_GCReadHandler::HandleData(GCReaderPtr Caller, KLVObjectPtr Object)
 		Hasher->SetKey(HashKey);
 	}
 
-
-	// Set an encryption IV
-	// DRAGONS: The current draft AS-DCP specification requires this to be an encryption strength random number generator.
-	//          However as the IV is always sent in plaintext there is no advantage doing this.
-	//          In fact it is actually more secure to use sequential IVs starting at some moderately random value
-	// TODO: Make IVs sequential
-	UInt8 IV[16];
-	int i; for(i=0; i<16; i++) IV[i] = (UInt8) rand();
 	KLVE->SetEncryptIV(16, IV, true);
 
 	// Update the index table to the new position
@@ -308,25 +333,377 @@ bool Encrypt_GCReadHandler::HandleData(GCReaderPtr Caller, KLVObjectPtr Object)
 }
 
 
-//! Decrypt data and return in a new buffer
-/*! \return NULL pointer if the encryption is unsuccessful
+//! Construct a pool with a given number of worker threads and start them
+EncryptPool::EncryptPool(GCWriterPtr Writer, int Threads) : Writer(Writer), Stopping(false), Failures(0)
+{
+	// Allow each worker to have one KLV in progress and one waiting
+	MaxPending = 2 * Threads;
+
+	int i;
+	for(i=0; i<Threads; i++)
+	{
+		Worker *ThisWorker = new Worker(this);
+		if(!ThisWorker->Start())
+		{
+			delete ThisWorker;
+			break;
+		}
+
+		Workers.push_back(ThisWorker);
+	}
+
+	if(Workers.size() < static_cast<size_t>(Threads))
+	{
+		warning("Only able to start %d of %d encryption threads\n", (int)Workers.size(), Threads);
+	}
+}
+
+
+//! Stop the workers, discarding any KLVs that have not been written
+EncryptPool::~EncryptPool()
+{
+	Lock.Lock();
+	Stopping = true;
+	Queue.clear();
+	WorkAvailable.Broadcast();
+	Lock.Unlock();
+
+	std::vector<Worker *>::iterator it = Workers.begin();
+	while(it != Workers.end())
+	{
+		(*it)->Join();
+		delete (*it);
+		it++;
+	}
+}
+
+
+//! Queue a KLV for encryption
+void EncryptPool::Add(KLVObjectPtr Object, const DataChunk &Key, const UInt8 *IV, UUIDPtr &ContextID, Length PlaintextOffset, bool Hashing, 
+					  IndexTablePtr Index, Position IndexPos)
+{
+	JobPtr ThisJob = new Job;
+
+	memcpy(ThisJob->SourceKey, Object->GetUL()->GetValue(), 16);
+	ThisJob->KLSize = Object->GetKLSize();
+
+	// Read the whole value and take its buffer, so that the worker owns it
+	Object->ReadData();
+	if(!ThisJob->Plaintext.TakeBuffer(Object->GetData(), true)) ThisJob->Plaintext.Set(Object->GetData());
+
+	if(Key.Size == 16) memcpy(ThisJob->Key, Key.Data, 16);
+	else memset(ThisJob->Key, 0, 16);
+
+	memcpy(ThisJob->IV, IV, 16);
+
+	if(ContextID) memcpy(ThisJob->ContextID, ContextID->GetValue(), 16);
+	else memset(ThisJob->ContextID, 0, 16);
+
+	ThisJob->PlaintextOffset = PlaintextOffset;
+	ThisJob->Hashing = Hashing;
+	ThisJob->Done = false;
+	ThisJob->Index = Index;
+	ThisJob->IndexPos = IndexPos;
+
+	// If there are no workers, do it ourselves
+	if(Workers.empty())
+	{
+		Worker Local(this);
+		Local.Encrypt(ThisJob);
+		WriteJob(ThisJob);
+		return;
+	}
+
+	Pending.push_back(ThisJob);
+
+	Lock.Lock();
+	Queue.push_back(ThisJob);
+	WorkAvailable.Signal();
+	Lock.Unlock();
+
+	WriteReady(MaxPending);
+}
+
+
+//! Wait for all queued KLVs to be encrypted and write them
+void EncryptPool::Flush(void)
+{
+	WriteReady(0);
+}
+
+
+//! Write encrypted KLVs from the front of the pending list
+void EncryptPool::WriteReady(size_t Keep)
+{
+	while(!Pending.empty())
+	{
+		Job *ThisJob = Pending.front();
+
+		Lock.Lock();
+		if(Pending.size() > Keep)
+		{
+			while(!ThisJob->Done) JobDone.Wait(Lock);
+		}
+		bool Ready = ThisJob->Done;
+		Lock.Unlock();
+
+		if(!Ready) break;
+
+		WriteJob(ThisJob);
+		Pending.pop_front();
+	}
+}
+
+
+//! Write a single encrypted KLV
+void EncryptPool::WriteJob(Job *ThisJob)
+{
+	if(!ThisJob->Encrypted)
+	{
+		error("Failed to encrypt KLV for index position %s\n", Int64toString(ThisJob->IndexPos).c_str());
+		Failures++;
+		return;
+	}
+
+	// Update the index table to the new position
+	if(ThisJob->Index)
+	{
+		ThisJob->Index->Update(ThisJob->IndexPos, (UInt64)Writer->GetStreamOffset());
+	}
+
+	// Read the encrypted KLV from its buffer as a memory file, and write it as with any other KLV
+	MXFFilePtr Buffer = new MXFFile;
+	Buffer->OpenMemory(ThisJob->Encrypted);
+
+	KLVObjectPtr Object = new KLVObject;
+	Object->SetSource(Buffer, 0);
+	Object->ReadKL();
+
+	Writer->WriteRaw(Object);
+}
+
+
+//! Construct a worker for a given pool (the thread is not started)
+EncryptPool::Worker::Worker(EncryptPool *Pool) : Pool(Pool), KeySet(false)
+{
+	Encryptor = new AESEncrypt;
+	Hasher = new HashHMACSHA1;
+}
+
+
+//! The body of the worker thread
+void EncryptPool::Worker::Run(void)
+{
+	for(;;)
+	{
+		Pool->Lock.Lock();
+		while(Pool->Queue.empty() && !Pool->Stopping) Pool->WorkAvailable.Wait(Pool->Lock);
+
+		if(Pool->Stopping)
+		{
+			Pool->Lock.Unlock();
+			break;
+		}
+
+		Job *ThisJob = Pool->Queue.front();
+		Pool->Queue.pop_front();
+		Pool->Lock.Unlock();
+
+		Encrypt(ThisJob);
+
+		Pool->Lock.Lock();
+		ThisJob->Done = true;
+		Pool->JobDone.Broadcast();
+		Pool->Lock.Unlock();
+	}
+}
+
+
+//! Encrypt a single job
+void EncryptPool::Worker::Encrypt(Job *ThisJob)
+{
+	// Only reset the key if it changes
+	if((!KeySet) || (memcmp(CurrentKey, ThisJob->Key, 16) != 0))
+	{
+		memcpy(CurrentKey, ThisJob->Key, 16);
+		Encryptor->SetKey(16, CurrentKey);
+		HashKey = BuildHashKey(16, CurrentKey);
+		KeySet = true;
+	}
+
+	// Build the encrypted KLV in a memory file, with enough space for the header, padding and footer
+	ThisJob->Encrypted = new DataChunk;
+	ThisJob->Encrypted->ResizeBuffer(ThisJob->Plaintext.Size + 1024);
+
+	MXFFilePtr Buffer = new MXFFile;
+	Buffer->OpenMemory(ThisJob->Encrypted);
+
+	KLVObjectPtr Object = new KLVObject(new UL(ThisJob->SourceKey));
+	Object->SetLength(ThisJob->Plaintext.Size);
+	Object->SetKLSize(ThisJob->KLSize);
+
+	KLVEObjectPtr KLVE = new KLVEObject(Object);
+	KLVE->SetEncrypt(Encryptor);
+	KLVE->SetPlaintextOffset(ThisJob->PlaintextOffset);
+
+	UUIDPtr ContextID = new mxflib::UUID(ThisJob->ContextID);
+	KLVE->SetContextID(ContextID);
+
+	if(ThisJob->Hashing)
+	{
+		Hasher->SetKey(HashKey);
+		KLVE->SetWriteHasher(Hasher);
+	}
+
+	KLVE->SetEncryptIV(16, ThisJob->IV, true);
+
+	KLVE->SetDestination(Buffer, 0);
+	if(KLVE->WriteKL() == 0)
+	{
+		ThisJob->Encrypted = NULL;
+	}
+	else if(ThisJob->Plaintext.Size)
+	{
+		// Anything short of the whole value is a failure, as the KLV would not match its length
+		if(KLVE->WriteDataTo(ThisJob->Plaintext.Data, 0, ThisJob->Plaintext.Size) != ThisJob->Plaintext.Size)
+		{
+			ThisJob->Encrypted = NULL;
+		}
+	}
+
+	// The plaintext is no longer required, so free it now rather than when the job is written
+	delete[] ThisJob->Plaintext.StealBuffer(true);
+}
+
+
+//! Set an encryption key
+/*! \return True if key is accepted
  */
-DataChunkPtr AESDecrypt::Decrypt(size_t Size, const UInt8 *Data)
+bool AESDecrypt::SetKey(size_t KeySize, const UInt8 *Key)
 {
-	if((sizeof(size_t) > 4) &&(Size > 0xffffffff))
+	if(!Context) return false;
+
+	if(KeySize != 16)
 	{
-		error("Maximum chunk size in AESDecrypt::Decrypt() is 4GBytes\n");
-		return NULL;
+		error("Key for AES decryption must by 16 bytes, tried to use key of size %d\n", KeySize);
+		return false;
 	}
 
+	// Set the key, and the IV if one has already been given
+	if(!EVP_DecryptInit_ex(Context, EVP_aes_128_cbc(), NULL, Key, CurrentIV)) return false;
+
+	// Any padding is removed by the caller (as AS-DCP padding is not the same as the EVP padding)
+	EVP_CIPHER_CTX_set_padding(Context, 0);
+
+	KeyInited = true;
+
+	return true;
+}
+
+
+//! Set a decryption Initialization Vector
+/*! \return False if Initialization Vector is rejected
+ */
+bool AESDecrypt::SetIV(size_t IVSize, const UInt8 *IV, bool Force /*=false*/)
+{ 
+	if(!Force) return false;
+
+	if(IVSize != 16)
+	{
+		error("IV for AES encryption must by 16 bytes, tried to use IV of size %d\n", IVSize);
+		return false;
+	}
+
+	memcpy(CurrentIV, IV, 16);
+
+	// Restart the chain with the new IV, keeping the current key
+	// DRAGONS: If the key has not yet been set the IV will be applied when it is
+	if(KeyInited)
+	{
+		if(!EVP_DecryptInit_ex(Context, NULL, NULL, NULL, CurrentIV)) return false;
+	}
+
+	return true; 
+}
+
+
+//! Decrypt a whole number of blocks, continuing the current chain
+/*! Source and Dest may be the same buffer, but must not otherwise overlap
+ *  \return true if the decryption <i>appears to be</i> successful
+ */
+bool AESDecrypt::DecryptBlocks(size_t Size, const UInt8 *Source, UInt8 *Dest)
+{
+	if(!KeyInited)
+	{
+		error("AESDecrypt called without setting the key\n");
+		return false;
+	}
+
+	if((Size % 16) != 0)
+	{
+		error("AESDecrypt can only decrypt whole 16 byte blocks, tried to decrypt %d bytes\n", Size);
+		return false;
+	}
+
+	if(Size == 0) return true;
+
+	// Record the last ciphertext block as the IV for the next call - it may be overwritten if decrypting in place
+	memcpy(CurrentIV, &Source[Size - 16], 16);
+
+	// EVP takes an int length, so very large buffers are decrypted as a series of large chunks
+	// DRAGONS: This is the largest multiple of 16 that fits in a signed 32-bit int
+	const size_t MaxChunk = 0x7ffffff0;
+
+	while(Size)
+	{
+		size_t ThisSize = (Size > MaxChunk) ? MaxChunk : Size;
+
+		int OutSize = 0;
+		if((!EVP_DecryptUpdate(Context, Dest, &OutSize, Source, static_cast<int>(ThisSize))) || (OutSize != static_cast<int>(ThisSize)))
+		{
+			error("AES decryption failed\n");
+			return false;
+		}
+
+		Source += ThisSize;
+		Dest += ThisSize;
+		Size -= ThisSize;
+	}
+
+	return true;
+}
+
+
+//! Decrypt data and return in a new buffer
+/*! \return NULL pointer if the encryption is unsuccessful
+ */
+DataChunkPtr AESDecrypt::Decrypt(size_t Size, const UInt8 *Data)
+{
 	DataChunkPtr Ret = new DataChunk(Size);
 
-	AES_cbc_encrypt(Data, Ret->Data, static_cast<unsigned long>(Size), &CurrentKey, CurrentIV, AES_DECRYPT);
+	if(!DecryptBlocks(Size, Data, Ret->Data)) return NULL;
 
 	return Ret;
 }
 
 
+//! Report a MIC check failure for the current edit unit
+/*! \return true to accept the data anyway */
+bool MICMismatchReporter::HandleMismatch(KLVEObject *Object, DataChunkPtr &FileMIC, DataChunkPtr &CalcMIC)
+{
+	UNUSED_PARAMETER(FileMIC);
+	UNUSED_PARAMETER(CalcMIC);
+
+	Failures++;
+
+	error("Message Integrity Code check failed for edit unit %s of BodySID %u at %s\n", 
+		  Int64toString(EditUnit).c_str(), OurSID, Object->GetSourceLocation().c_str());
+
+	// Keep the decrypted data so that extraction continues
+	return true;
+}
+
+
 //! Construct a handler for a specified BodySID
 Decrypt_GCEncryptionHandler::Decrypt_GCEncryptionHandler(UInt32 BodySID, DataChunkPtr KeyID, std::string KeyFileName) : OurSID(BodySID) 
 {
@@ -424,6 +801,9 @@ bool Decrypt_GCEncryptionHandler::HandleData(GCReaderPtr Caller, KLVObjectPtr Ob
 		KLVE->SetReadHasher(Hasher);
 		DataChunkPtr HashKey = BuildHashKey(DecKey);
 		Hasher->SetKey(HashKey);
+
+		// Report any MIC check failure rather than stopping the read
+		if(Reporter) KLVE->SetMICHandler(Reporter);
 	}
 
 	// Pass decryption wrapped data back for handling
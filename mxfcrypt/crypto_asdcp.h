@@ -29,9 +29,12 @@
 using namespace mxflib;
 
 #include <stdlib.h>
+#include <list>
+#include <vector>
 
 // Include AES encryption from OpenSSL
 #include "openssl/aes.h"
+#include "openssl/evp.h"
 #include "openssl/sha.h"
 
 
@@ -114,13 +117,7 @@ public:
 	//! Set an encryption key
 	/*! \return True if key is accepted
 	 */
-	bool SetKey(size_t KeySize, const UInt8 *Key) 
-	{
-		int Ret = AES_set_encrypt_key(Key, 128, &CurrentKey);
-
-		// Return true only if key setting was OK
-		return Ret ? false : true; 
-	};
+	bool SetKey(size_t KeySize, const UInt8 *Key);
 
 	//! Set an encryption Initialization Vector
 	/*! \return False if Initialization Vector is rejected
@@ -173,6 +170,131 @@ public:
 };
 
 
+// ============================================================================
+//! Pool of worker threads that encrypt whole KLVs in parallel
+/*! CBC encryption is sequential within a KLV, but each KLV has its own IV so different KLVs (frames)
+ *  can be encrypted at the same time. Each worker has its own AESEncrypt and HashHMACSHA1 objects and
+ *  encrypts into a memory buffer. The encrypted KLVs are written, in their original order, by the thread
+ *  that queued them - either as later KLVs are queued or when Flush() is called.
+ *  DRAGONS: Reference counting is locked, but the objects that smart pointers share are not. The key, IV and
+ *           context ID belong to the read handler, which moves on to the next KLV while workers are still
+ *           encrypting, so each job holds its own copy as plain bytes and the workers only use objects that
+ *           they create themselves. The GCWriter, and any index table, are only used from the queuing thread.
+ */
+// ============================================================================
+class EncryptPool : public RefCount<EncryptPool>
+{
+protected:
+	//! A KLV to be encrypted, and the result of encrypting it
+	class Job : public RefCount<Job>
+	{
+	public:
+		UInt8 SourceKey[16];						//!< The key of the plaintext KLV
+		Int32 KLSize;								//!< The size of the key and length of the plaintext KLV, used to match the length format
+		DataChunk Plaintext;						//!< The plaintext value
+		UInt8 Key[16];								//!< The encryption key
+		UInt8 IV[16];								//!< The Initialization Vector for this KLV
+		UInt8 ContextID[16];						//!< The cryptographic context ID
+		Length PlaintextOffset;						//!< Number of bytes to leave unencrypted at the start of the value
+		bool Hashing;								//!< True if a MIC is to be calculated for this KLV
+
+		DataChunkPtr Encrypted;						//!< The complete encrypted KLV, or NULL if encryption failed
+		bool Done;									//!< Set by the worker once Encrypted is ready
+
+		IndexTablePtr Index;						//!< Index table to update when this KLV is written (or NULL if none)
+		Position IndexPos;							//!< Edit unit of this KLV for indexing
+	};
+
+	//! A smart pointer to a Job
+	typedef SmartPtr<Job> JobPtr;
+
+	//! A worker thread encrypting queued jobs
+	class Worker : public Thread
+	{
+	protected:
+		EncryptPool *Pool;							//!< The pool that owns this worker
+		EncryptPtr Encryptor;						//!< This worker's encryption wrapper
+		HashPtr Hasher;								//!< This worker's hasher
+		UInt8 CurrentKey[16];						//!< The key currently set in Encryptor
+		bool KeySet;								//!< True once CurrentKey is valid
+		DataChunkPtr HashKey;						//!< The hashing key for CurrentKey
+
+	public:
+		//! Construct a worker for a given pool (the thread is not started)
+		Worker(EncryptPool *Pool);
+
+		//! Encrypt a single job
+		void Encrypt(Job *ThisJob);
+
+	protected:
+		//! The body of the worker thread
+		virtual void Run(void);
+	};
+
+	friend class Worker;
+
+	GCWriterPtr Writer;								//!< GCWriter to receive the encrypted data
+	std::vector<Worker *> Workers;					//!< The worker threads
+	size_t MaxPending;								//!< The maximum number of KLVs queued but not yet written
+
+	std::list<JobPtr> Pending;						//!< KLVs queued but not yet written, in order (only used by the queuing thread)
+	std::list<Job *> Queue;							//!< KLVs waiting for a worker, guarded by Lock
+	bool Stopping;									//!< Set to request that the workers stop, guarded by Lock
+
+	int Failures;									//!< The number of KLVs that could not be encrypted (only used by the queuing thread)
+
+	Mutex Lock;										//!< Lock for Queue, Stopping and the Done flag of each job
+	Condition WorkAvailable;						//!< Signalled when a job is queued, or the workers are asked to stop
+	Condition JobDone;								//!< Signalled when a worker finishes a job
+
+private:
+	EncryptPool();									//!< Don't allow standard construction
+	EncryptPool(const EncryptPool &);				//!< Don't allow copy construction
+
+public:
+	//! Construct a pool with a given number of worker threads and start them
+	EncryptPool(GCWriterPtr Writer, int Threads);
+
+	//! Stop the workers, discarding any KLVs that have not been written
+	~EncryptPool();
+
+	//! Queue a KLV for encryption
+	/*! The whole value is read from the source file, so this must be called from the thread that reads the file.
+	 *  Encrypted KLVs that are ready are written first, and if too many KLVs are outstanding this waits for the oldest to be ready.
+	 *  \param Object The plaintext KLV
+	 *  \param Key The 16-byte encryption key
+	 *  \param IV The 16-byte Initialization Vector to use for this KLV
+	 *  \param ContextID The cryptographic context ID
+	 *  \param PlaintextOffset Number of bytes to leave unencrypted at the start of the value
+	 *  \param Hashing True if a MIC is to be calculated
+	 *  \param Index Index table to update with the position of this KLV when written, or NULL
+	 *  \param IndexPos The edit unit of this KLV for indexing
+	 */
+	void Add(KLVObjectPtr Object, const DataChunk &Key, const UInt8 *IV, UUIDPtr &ContextID, Length PlaintextOffset, bool Hashing, 
+			 IndexTablePtr Index, Position IndexPos);
+
+	//! Wait for all queued KLVs to be encrypted and write them
+	/*! This must be called before writing anything else to the file, such as a partition pack */
+	void Flush(void);
+
+	//! Get the number of KLVs that could not be encrypted, and so were not written
+	int GetFailures(void) const { return Failures; }
+
+protected:
+	//! Write encrypted KLVs from the front of the pending list
+	/*! \param Keep Leave this many KLVs pending, waiting for older ones to be ready if required
+	 *  \note KLVs that are ready beyond this limit are written as long as all earlier KLVs are ready too
+	 */
+	void WriteReady(size_t Keep);
+
+	//! Write a single encrypted KLV
+	void WriteJob(Job *ThisJob);
+};
+
+//! A smart pointer to an EncryptPool
+typedef SmartPtr<EncryptPool> EncryptPoolPtr;
+
+
 // ============================================================================
 //! Encrypting GCReader handler
 // ============================================================================
@@ -190,6 +312,8 @@ protected:
 	IndexTablePtr Index;							//!< Index table to update (or NULL if none)
 	Position IndexPos;								//!< Current edit unit for indexing
 
+	EncryptPoolPtr Pool;							//!< Worker pool to encrypt with, or NULL to encrypt each KLV as it is read
+
 private:
 	Encrypt_GCReadHandler();						//!< Don't allow standard construction
 
@@ -207,6 +331,10 @@ public:
 
 	//! Set an index table to update with new byte offsets
 	void SetIndex(IndexTablePtr Index) { this->Index = Index; }
+
+	//! Set a worker pool to encrypt with
+	/*! \note EncryptPool::Flush() must be called before anything else is written to the output file */
+	void SetPool(EncryptPoolPtr Pool) { this->Pool = Pool; }
 };
 
 
@@ -239,24 +367,33 @@ public:
 
 // ============================================================================
 //! AES decryption class
+/*! Decryption is performed through the OpenSSL EVP interface, which uses hardware AES (such as AES-NI) where available
+ *  and decrypts many CBC blocks at once. Padding is handled by KLVEObject so is disabled here, allowing any multiple of
+ *  16 bytes to be decrypted in place - ideally a whole frame per call.
+ */
 // ============================================================================
 class AESDecrypt : public Decrypt_Base
 {
 protected:
-	AES_KEY CurrentKey;
-	UInt8 CurrentIV[16];
+	EVP_CIPHER_CTX *Context;				//!< The EVP cipher context, holding the key and the chaining state
+	bool KeyInited;							//!< True once the key has been set
+	UInt8 CurrentIV[16];					//!< The IV for the next block to be decrypted (the last ciphertext block decrypted)
 
 public:
+	//! Initialize this object
+	AESDecrypt() : KeyInited(false) 
+	{
+		Context = EVP_CIPHER_CTX_new();
+		memset(CurrentIV, 0, 16);
+	}
+
+	//! Free the EVP context
+	~AESDecrypt() { if(Context) EVP_CIPHER_CTX_free(Context); }
+
 	//! Set an encryption key
 	/*! \return True if key is accepted
 	 */
-	virtual bool SetKey(size_t KeySize, const UInt8 *Key) 
-	{
-		int Ret = AES_set_decrypt_key(Key, 128, &CurrentKey);
-
-		// Return true only if key setting was OK
-		return Ret ? false : true; 
-	};
+	virtual bool SetKey(size_t KeySize, const UInt8 *Key);
 
 	//! Set a decryption Initialization Vector
 	/*! \return False if Initialization Vector is rejected
@@ -266,20 +403,7 @@ public:
 	 *        and false for any other calls.  This allows different schemes to be
 	 *        used with minimal changes in the calling code.
 	 */
-	bool SetIV(size_t IVSize, const UInt8 *IV, bool Force = false)
-	{ 
-		if(!Force) return false;
-
-		if(IVSize != 16)
-		{
-			error("IV for AES encryption must by 16 bytes, tried to use IV of size %d\n", IVSize);
-			return false;
-		}
-
-		memcpy(CurrentIV, IV, 16);
-
-		return true; 
-	};
+	bool SetIV(size_t IVSize, const UInt8 *IV, bool Force = false);
 
 	//! Get the Initialization Vector that will be used for the next decryption
 	/*! If called immediately after SetIV() with Force=true or SetIV() for a crypto
@@ -294,22 +418,62 @@ public:
 	//! Can this decryption system safely decrypt in place?
 	/*! If BlockSize is 0 this function will return true if decryption of all block sizes can be "in place".
 	 *  Otherwise the result will indicate whether the given blocksize can be decrypted "in place".
+	 *  \note Any whole number of AES blocks can be decrypted in place
 	 */
-	bool CanDecryptInPlace(size_t BlockSize = 0) { return false; }
+	bool CanDecryptInPlace(size_t BlockSize = 0) { return (BlockSize != 0) && ((BlockSize % 16) == 0); }
 
 	//! Decrypt data bytes in place
 	/*! \return true if the decryption <i>appears to be</i> successful
 	 */
-	bool DecryptInPlace(size_t Size, UInt8 *Data) { return false; }
+	bool DecryptInPlace(size_t Size, UInt8 *Data) { return DecryptBlocks(Size, Data, Data); }
 
 	//! Decrypt data and return in a new buffer
 	/*! \return true if the decryption <i>appears to be</i> successful
 	 */
 	DataChunkPtr Decrypt(size_t Size, const UInt8 *Data);
+
+protected:
+	//! Decrypt a whole number of blocks, continuing the current chain
+	/*! Source and Dest may be the same buffer, but must not otherwise overlap
+	 *  \return true if the decryption <i>appears to be</i> successful
+	 */
+	bool DecryptBlocks(size_t Size, const UInt8 *Source, UInt8 *Dest);
 };
 
 
 
+// ============================================================================
+//! MIC check handler that reports failures by edit unit
+/*! The edit unit is set by the Decrypt_GCReadHandler before each KLV is read,
+ *  failures are reported but the data is still accepted so that the essence is extracted in the same pass
+ */
+// ============================================================================
+class MICMismatchReporter : public MICCheckHandler_Base
+{
+protected:
+	UInt32 OurSID;										//!< The BodySID of this essence
+	Position EditUnit;									//!< The edit unit currently being read
+	int Failures;										//!< The number of MIC check failures reported so far
+
+private:
+	MICMismatchReporter();								//!< Don't allow standard construction
+
+public:
+	//! Construct a reporter for a specified BodySID
+	MICMismatchReporter(UInt32 BodySID) : OurSID(BodySID), EditUnit(0), Failures(0) {};
+
+	//! Set the edit unit about to be read
+	void SetEditUnit(Position EditUnit) { this->EditUnit = EditUnit; }
+
+	//! Report a MIC check failure for the current edit unit
+	/*! \return true to accept the data anyway */
+	virtual bool HandleMismatch(KLVEObject *Object, DataChunkPtr &FileMIC, DataChunkPtr &CalcMIC);
+
+	//! Get the number of MIC check failures reported so far
+	int GetFailures(void) const { return Failures; }
+};
+
+
 // ============================================================================
 //! Decrypting GCReader encryption handler
 // ============================================================================
@@ -320,6 +484,8 @@ protected:
 
 	DataChunk DecKey;									//!< The decryption key we will use
 
+	MICCheckHandlerPtr Reporter;						//!< Reporter for MIC check failures (or NULL if they are errors)
+
 private:
 	Decrypt_GCEncryptionHandler();						//!< Don't allow standard construction
 
@@ -334,6 +500,9 @@ public:
 
 	//! Determin if a valid key has been set
 	bool KeyValid(void) { return (DecKey.Size == 16); }
+
+	//! Set a reporter for MIC check failures when hashing
+	void SetReporter(MICCheckHandlerPtr Reporter) { this->Reporter = Reporter; }
 };
 
 
@@ -352,12 +521,15 @@ protected:
 	IndexTablePtr Index;								//!< Index table to update (or NULL if none)
 	Position IndexPos;									//!< Current edit unit for indexing
 
+	MICCheckHandlerPtr Reporter;						//!< MICMismatchReporter to tell which edit unit is being read (or NULL if none)
+	Position ReportPos;									//!< Current edit unit for MIC check reports (KLVFill items are not counted)
+
 private:
 	Decrypt_GCReadHandler();							//!< Don't allow standard construction
 
 public:
 	//! Construct a test handler for a specified BodySID
-	Decrypt_GCReadHandler(GCWriterPtr Writer, UInt32 BodySID) : OurSID(BodySID), Writer(Writer), IndexPos(0) {};
+	Decrypt_GCReadHandler(GCWriterPtr Writer, UInt32 BodySID) : OurSID(BodySID), Writer(Writer), IndexPos(0), ReportPos(0) {};
 
 	//! Handle a "chunk" of data that has been read from the file
 	/*! \return true if all OK, false on error 
@@ -370,9 +542,22 @@ public:
 			Index->Update(IndexPos, (UInt64)Writer->GetStreamOffset());
 		}
 
+		// Tell any MIC check reporter which edit unit is being read
+		bool IsEssence = true;
+		if(Reporter)
+		{
+			ULPtr ObjectUL = Object->GetUL();
+			if(ObjectUL && ObjectUL->Matches(KLVFill_UL)) IsEssence = false;
+			else SmartPtr_Cast(Reporter, MICMismatchReporter)->SetEditUnit(ReportPos);
+		}
+
 		// Write the data without further processing
+		// DRAGONS: For encrypted data this is where it is read, decrypted and hashed
 		Writer->WriteRaw(Object);
 
+		// Update the report position count (only needed if reporting)
+		if(Reporter && IsEssence) ReportPos++;
+
 		// Update the index position count (even if not yet indexing)
 		IndexPos++;
 
@@ -381,5 +566,8 @@ public:
 
 	//! Set an index table to update with new byte offsets
 	void SetIndex(IndexTablePtr Index) { this->Index = Index; }
+
+	//! Set a reporter to tell which edit unit is being read
+	void SetReporter(MICCheckHandlerPtr Reporter) { this->Reporter = Reporter; }
 };
 
@@ -95,6 +95,15 @@ IndexTablePtr Index;
 //! Original index data (if preserving the index unchanged)
 DataChunkPtr OriginalIndexData;
 
+//! Number of encryption worker threads, 0 to encrypt on the reading thread
+int EncryptThreads = 0;
+
+//! Worker pool to encrypt with (or NULL if not used)
+EncryptPoolPtr Pool;
+
+//! Reporters of MIC check failures when decrypting with hashing, one per BodySID
+std::list<MICCheckHandlerPtr> Reporters;
+
 
 #include <time.h>
 
@@ -148,6 +157,15 @@ int main(int argc, char *argv[])
 				PlaintextOffset = atoi(&argv[i][3]);
 				printf("\nPlaintext Offset = %d\n", PlaintextOffset);
 			}
+			else if((argv[i][1] == 't') || (argv[i][1] == 'T'))
+			{
+				if((argv[i][2] != '=') && (argv[i][2] != ':'))
+				{
+					error("-t option syntax = -t=<threads>\n");
+					return 1;
+				}
+				EncryptThreads = atoi(&argv[i][3]);
+			}
 		}
 	}
 
@@ -160,9 +178,10 @@ int main(int argc, char *argv[])
 
 		printf("Options:\n");
 		printf("  -d         Decrypt (rather than encrypt)\n");
-		printf("  -h         Perform HMAC hashing\n");
+		printf("  -h         Perform HMAC hashing (checking each edit unit when decrypting)\n");
 		printf("  -k=keyfile Use the specified key file\n");
 		printf("  -p=offset  Leave plaintext bytes at the start\n");
+		printf("  -t=threads Encrypt frames in parallel using this many threads\n");
 		printf("  -ip        Preserve the existing index table values\n");
 		printf("  -l-        Don't update the EssenceContainers batch\n");
 		printf("  -l+        Do update the EssenceContainer value in the descriptor\n");
@@ -303,6 +322,10 @@ int main(int argc, char *argv[])
 	// layout of the original file body without complications
 	GCWriterPtr Writer = new GCWriter(OutFile);
 
+	// Start the encryption worker pool if requested
+	// DRAGONS: This must be done before the metadata is processed as that is where the handlers are built
+	if((!DecryptMode) && (EncryptThreads > 1)) Pool = new EncryptPool(Writer, EncryptThreads);
+
 	// Update the header metadata as required - quit if that process failed
 	if(!ProcessMetadata(DecryptMode, HMeta, BodyParser, Writer, true)) return 1;
 
@@ -417,9 +440,18 @@ int main(int argc, char *argv[])
 		Writer->SetKAG(CurrentPartition->GetUInt(KAGSize_UL));
 
 		// Parse the file until next partition or an error
-		if (!BodyParser->ReadFromFile()) break;
+		bool Parsed = BodyParser->ReadFromFile();
+
+		// Write any KLVs still being encrypted before the next partition pack
+		if(Pool) Pool->Flush();
+
+		if(!Parsed) break;
 	}
 
+	// Stop the encryption workers
+	int EncryptFailures = Pool ? Pool->GetFailures() : 0;
+	Pool = NULL;
+
 	// Write the footer partition
 
 	if(WriteMetadataInFooter)
@@ -455,6 +487,27 @@ int main(int argc, char *argv[])
 
 	OutFile->Close();
 
+	// Summarise any MIC check failures
+	int MICFailures = 0;
+	std::list<MICCheckHandlerPtr>::iterator Rep_it = Reporters.begin();
+	while(Rep_it != Reporters.end())
+	{
+		MICFailures += SmartPtr_Cast((*Rep_it), MICMismatchReporter)->GetFailures();
+		Rep_it++;
+	}
+
+	if(MICFailures)
+	{
+		error("%d edit units failed the Message Integrity Code check\n", MICFailures);
+		return 1;
+	}
+
+	if(EncryptFailures)
+	{
+		error("%d KLVs could not be encrypted and are missing from the output file\n", EncryptFailures);
+		return 1;
+	}
+
 	printf("Done\n");
 
 	return 0;
@@ -880,6 +933,7 @@ bool ProcessPackageForEncrypt(BodyReaderPtr BodyParser, GCWriterPtr Writer, UInt
 		Encrypt_GCReadHandler *pHandler = new Encrypt_GCReadHandler(Writer, BodySID, ContextID, KeyID, KeyFileName);
 		pHandler->SetPlaintextOffset(PlaintextOffset);
 		if(Index) pHandler->SetIndex(Index);
+		if(Pool) pHandler->SetPool(Pool);
 		GCReadHandlerPtr Handler = pHandler;
 		GCReadHandlerPtr FillerHandler = new Basic_GCFillerHandler(Writer, BodySID);
 		BodyParser->MakeGCReader(BodySID, Handler, FillerHandler);
@@ -991,6 +1045,15 @@ bool ProcessPackageForDecrypt(BodyReaderPtr BodyParser, GCWriterPtr Writer, UInt
 	Decrypt_GCEncryptionHandler *Test = SmartPtr_Cast(EncHandler, Decrypt_GCEncryptionHandler);
 	if(!Test->KeyValid()) return false;
 
+	// If hashing, check the MIC of each edit unit as it is decrypted
+	if(Hashing)
+	{
+		MICCheckHandlerPtr Reporter = new MICMismatchReporter(BodySID);
+		Reporters.push_back(Reporter);
+		pHandler->SetReporter(Reporter);
+		Test->SetReporter(Reporter);
+	}
+
 	BodyParser->MakeGCReader(BodySID, Handler, FillerHandler);
 	GCReaderPtr Reader = BodyParser->GetGCReader(BodySID);
 	if(Reader) Reader->SetEncryptionHandler(EncHandler);
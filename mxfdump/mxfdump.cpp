@@ -86,6 +86,9 @@ static bool DumpIdents = true;
 //! Flag for basic compiled dictionary as bootstrap when loading a metadictionary
 static bool BootstrapDict = false;
 
+//! Flag for showing I/O and allocation counts once the dump is complete
+static bool ShowStats = false;
+
 #ifdef OPTION3ENABLED
 //! Flag for diplaying baseline UL of sets unsing the ObjectClass extention mechanism
 static bool ShowBaseline = false;
@@ -158,7 +161,9 @@ int main_process(int argc, char *argv[])
 		if(argv[i][0] == '-')
 		{
 			num_options++;
-			if((argv[i][1] == 'a') || (argv[i][1] == 'A'))
+			if(strcmp(argv[i], "--stats") == 0)
+				ShowStats = true;
+			else if((argv[i][1] == 'a') || (argv[i][1] == 'A'))
 				SortedDump = true;
 			else if((argv[i][1] == 'v') || (argv[i][1] == 'V'))
 				DebugMode = true;
@@ -262,6 +267,7 @@ int main_process(int argc, char *argv[])
 		printf("         -x1        Append hex data to labels\n");
 		printf("         -x2 or -x  Append hex data to labels if 'fuzzy' matching used\n");
 		printf("         -z         Pause for input before final exit\n");
+		printf("         --stats    Show I/O and allocation counts once the dump is complete\n");
 		return 1;
 	}
 
@@ -560,6 +566,13 @@ int DumpFile(std::string Name)
 
 	TestFile->Close();
 
+	if(ShowStats)
+	{
+		printf("\nStatistics:\n");
+		printf("  This file:        %s\n", StatsToString(TestFile->GetIOStats()).c_str());
+		printf("%s", StatsToString(GetLibraryStats(), "  ").c_str());
+	}
+
 /*	PrimerPtr NewPrimer = new Primer;
 
 	unsigned char Key[16] = { 0x06, 0x0e, 0x2b, 0x34, 0x01, 0x01, 0x01, 0x04, 0x04, 0x06, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00 };
@@ -0,0 +1,551 @@
+/*! \file	asyncio.cpp
+ *	\brief	Implementation of class that batches positioned file reads and writes using Linux io_uring
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#include "mxflib/mxflib.h"
+
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif // HAVE_IO_URING
+
+using namespace mxflib;
+
+
+//! Default number of requests that may be in flight at once
+const unsigned int AsyncIO::DefaultDepth = 64;
+
+
+#ifdef HAVE_IO_URING
+
+/* DRAGONS: The ring is driven with the raw system calls rather than liburing so that no extra library is required */
+
+//! Native io_uring state
+struct AsyncIO::RingState
+{
+	//! A request in flight
+	struct Slot
+	{
+		bool IsWrite;					//!< True for a write, false for a read
+		int fd;							//!< File descriptor being accessed
+		Position Pos;					//!< Position of the request in the file
+		struct iovec Vec;				//!< The buffer for the request, which must remain valid until it completes
+		DataChunkPtr Data;				//!< The chunk being written, held until the write completes
+		AsyncReadRequest *Read;			//!< The read request to complete, for reads
+	};
+
+	int Fd;								//!< The ring file descriptor
+	unsigned int Entries;				//!< Number of submission queue entries
+
+	void *SQPtr;						//!< Mapped submission queue ring
+	size_t SQSize;						//!< Size of the submission queue ring mapping
+	unsigned *SQHead;					//!< Submission queue head, advanced by the kernel
+	unsigned *SQTail;					//!< Submission queue tail, advanced by us
+	unsigned *SQMask;					//!< Submission queue index mask
+	unsigned *SQArray;					//!< Submission queue index array
+	struct io_uring_sqe *SQEs;			//!< Mapped submission queue entries
+	size_t SQESize;						//!< Size of the submission queue entries mapping
+
+	void *CQPtr;						//!< Mapped completion queue ring (may be the same mapping as SQPtr)
+	size_t CQSize;						//!< Size of the completion queue ring mapping
+	unsigned *CQHead;					//!< Completion queue head, advanced by us
+	unsigned *CQTail;					//!< Completion queue tail, advanced by the kernel
+	unsigned *CQMask;					//!< Completion queue index mask
+	struct io_uring_cqe *CQEs;			//!< Completion queue entries
+
+	std::vector<Slot> Slots;			//!< One slot per possible request in flight
+	std::vector<unsigned int> FreeSlots;//!< Indexes of unused slots
+
+	unsigned int Unsubmitted;			//!< Number of entries added to the submission queue but not yet passed to the kernel
+	unsigned int ReadsInFlight;			//!< Number of reads not yet completed
+	unsigned int WritesInFlight;		//!< Number of writes not yet completed
+	bool WriteFailed;					//!< Set if any write has failed since the last WaitWrites()
+
+	//! Set up a ring
+	/*! \return false if io_uring is not available */
+	bool Setup(unsigned int Depth);
+
+	//! Release the ring
+	void Release(void);
+
+	//! Add a request to the submission queue
+	/*! \return false if there is no free slot */
+	bool Add(bool IsWrite, int fd, Position Pos, UInt8 *Buffer, size_t Size, DataChunkPtr *Data, AsyncReadRequest *Read);
+
+	//! Pass any new submissions to the kernel, optionally waiting for at least some completions
+	bool Enter(unsigned int WaitFor);
+
+	//! Process all available completions
+	void Reap(void);
+
+	//! Take back any entries added to the submission queue but not yet passed to the kernel, failing any reads among them
+	void Withdraw(void);
+
+	//! Wait for all requests passed to the kernel to complete, after withdrawing any not yet passed
+	/*! This is used when Enter() has failed, so it keeps polling for completions if the kernel refuses to wait */
+	void Drain(void);
+};
+
+
+namespace
+{
+	//! Write all of a buffer with pwrite, retrying short writes
+	bool WriteAllAt(int fd, Position Pos, const UInt8 *Buffer, size_t Size)
+	{
+		while(Size)
+		{
+			ssize_t Bytes = pwrite(fd, Buffer, Size, static_cast<off_t>(Pos));
+			if(Bytes < 0)
+			{
+				if(errno == EINTR) continue;
+				return false;
+			}
+			if(Bytes == 0) return false;
+
+			Pos += Bytes;
+			Buffer += Bytes;
+			Size -= static_cast<size_t>(Bytes);
+		}
+
+		return true;
+	}
+}
+
+
+//! Set up a ring
+bool AsyncIO::RingState::Setup(unsigned int Depth)
+{
+	struct io_uring_params Params;
+	memset(&Params, 0, sizeof(Params));
+
+	Fd = static_cast<int>(syscall(__NR_io_uring_setup, Depth, &Params));
+	if(Fd < 0) return false;
+
+	Entries = Params.sq_entries;
+
+	SQSize = Params.sq_off.array + Params.sq_entries * sizeof(unsigned);
+	CQSize = Params.cq_off.cqes + Params.cq_entries * sizeof(struct io_uring_cqe);
+
+	// Newer kernels map both rings with a single mapping
+	bool SingleMap = (Params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if(SingleMap)
+	{
+		if(CQSize > SQSize) SQSize = CQSize;
+		CQSize = SQSize;
+	}
+
+	SQPtr = mmap(NULL, SQSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Fd, IORING_OFF_SQ_RING);
+	if(SQPtr == MAP_FAILED)
+	{
+		close(Fd);
+		return false;
+	}
+
+	if(SingleMap) CQPtr = SQPtr;
+	else
+	{
+		CQPtr = mmap(NULL, CQSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Fd, IORING_OFF_CQ_RING);
+		if(CQPtr == MAP_FAILED)
+		{
+			munmap(SQPtr, SQSize);
+			close(Fd);
+			return false;
+		}
+	}
+
+	SQESize = Params.sq_entries * sizeof(struct io_uring_sqe);
+	SQEs = static_cast<struct io_uring_sqe *>(mmap(NULL, SQESize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Fd, IORING_OFF_SQES));
+	if(SQEs == MAP_FAILED)
+	{
+		if(CQPtr != SQPtr) munmap(CQPtr, CQSize);
+		munmap(SQPtr, SQSize);
+		close(Fd);
+		return false;
+	}
+
+	UInt8 *SQBase = static_cast<UInt8 *>(SQPtr);
+	SQHead = reinterpret_cast<unsigned *>(SQBase + Params.sq_off.head);
+	SQTail = reinterpret_cast<unsigned *>(SQBase + Params.sq_off.tail);
+	SQMask = reinterpret_cast<unsigned *>(SQBase + Params.sq_off.ring_mask);
+	SQArray = reinterpret_cast<unsigned *>(SQBase + Params.sq_off.array);
+
+	UInt8 *CQBase = static_cast<UInt8 *>(CQPtr);
+	CQHead = reinterpret_cast<unsigned *>(CQBase + Params.cq_off.head);
+	CQTail = reinterpret_cast<unsigned *>(CQBase + Params.cq_off.tail);
+	CQMask = reinterpret_cast<unsigned *>(CQBase + Params.cq_off.ring_mask);
+	CQEs = reinterpret_cast<struct io_uring_cqe *>(CQBase + Params.cq_off.cqes);
+
+	// One slot per submission entry, so the completion queue (at least twice as large) can never overflow
+	Slots.resize(Entries);
+	FreeSlots.reserve(Entries);
+	unsigned int i;
+	for(i = 0; i < Entries; i++) FreeSlots.push_back(Entries - 1 - i);
+
+	Unsubmitted = 0;
+	ReadsInFlight = 0;
+	WritesInFlight = 0;
+	WriteFailed = false;
+
+	return true;
+}
+
+
+//! Release the ring
+void AsyncIO::RingState::Release(void)
+{
+	munmap(SQEs, SQESize);
+	if(CQPtr != SQPtr) munmap(CQPtr, CQSize);
+	munmap(SQPtr, SQSize);
+	close(Fd);
+}
+
+
+//! Add a request to the submission queue
+bool AsyncIO::RingState::Add(bool IsWrite, int fd, Position Pos, UInt8 *Buffer, size_t Size, DataChunkPtr *Data, AsyncReadRequest *Read)
+{
+	if(FreeSlots.empty()) return false;
+
+	unsigned int Index = FreeSlots.back();
+	FreeSlots.pop_back();
+
+	Slot &ThisSlot = Slots[Index];
+	ThisSlot.IsWrite = IsWrite;
+	ThisSlot.fd = fd;
+	ThisSlot.Pos = Pos;
+	ThisSlot.Vec.iov_base = Buffer;
+	ThisSlot.Vec.iov_len = Size;
+	if(Data) ThisSlot.Data = *Data;
+	ThisSlot.Read = Read;
+
+	// DRAGONS: There is always a free submission entry as we never have more requests in flight than entries
+	unsigned Tail = *SQTail;
+	unsigned SQIndex = Tail & *SQMask;
+
+	struct io_uring_sqe *SQE = &SQEs[SQIndex];
+	memset(SQE, 0, sizeof(*SQE));
+	SQE->opcode = IsWrite ? IORING_OP_WRITEV : IORING_OP_READV;
+	SQE->fd = fd;
+	SQE->off = static_cast<UInt64>(Pos);
+	SQE->addr = reinterpret_cast<unsigned long>(&ThisSlot.Vec);
+	SQE->len = 1;
+	SQE->user_data = Index;
+
+	SQArray[SQIndex] = SQIndex;
+	__atomic_store_n(SQTail, Tail + 1, __ATOMIC_RELEASE);
+
+	Unsubmitted++;
+	if(IsWrite) WritesInFlight++; else ReadsInFlight++;
+
+	return true;
+}
+
+
+//! Pass any new submissions to the kernel, optionally waiting for at least some completions
+bool AsyncIO::RingState::Enter(unsigned int WaitFor)
+{
+	for(;;)
+	{
+		int Ret = static_cast<int>(syscall(__NR_io_uring_enter, Fd, Unsubmitted, WaitFor, WaitFor ? IORING_ENTER_GETEVENTS : 0, NULL, 0));
+		if(Ret >= 0)
+		{
+			Unsubmitted -= static_cast<unsigned int>(Ret);
+
+			// If not everything was submitted, collect completions to make room and try again
+			if(Unsubmitted == 0) return true;
+			Reap();
+			WaitFor = 0;
+			continue;
+		}
+
+		if(errno == EINTR) continue;
+
+		// The kernel needs completions collected before it will accept more
+		if(errno == EBUSY)
+		{
+			Reap();
+			continue;
+		}
+
+		error("io_uring_enter failed - %s\n", strerror(errno));
+		return false;
+	}
+}
+
+
+//! Process all available completions
+void AsyncIO::RingState::Reap(void)
+{
+	unsigned Head = *CQHead;
+	while(Head != __atomic_load_n(CQTail, __ATOMIC_ACQUIRE))
+	{
+		struct io_uring_cqe *CQE = &CQEs[Head & *CQMask];
+		unsigned int Index = static_cast<unsigned int>(CQE->user_data);
+		int Result = CQE->res;
+		Head++;
+
+		Slot &ThisSlot = Slots[Index];
+		UInt8 *Buffer = static_cast<UInt8 *>(ThisSlot.Vec.iov_base);
+		size_t Size = ThisSlot.Vec.iov_len;
+
+		if(ThisSlot.IsWrite)
+		{
+			if(Result < 0)
+			{
+				error("Asynchronous write of %s bytes at 0x%s failed - %s\n", UInt64toString(Size).c_str(), Int64toHexString(ThisSlot.Pos, 8).c_str(), strerror(-Result));
+				WriteFailed = true;
+			}
+			else if(static_cast<size_t>(Result) < Size)
+			{
+				// Complete a short write synchronously
+				if(!WriteAllAt(ThisSlot.fd, ThisSlot.Pos + Result, &Buffer[Result], Size - Result))
+				{
+					error("Asynchronous write of %s bytes at 0x%s failed - %s\n", UInt64toString(Size).c_str(), Int64toHexString(ThisSlot.Pos, 8).c_str(), strerror(errno));
+					WriteFailed = true;
+				}
+			}
+
+			ThisSlot.Data = NULL;
+			WritesInFlight--;
+		}
+		else
+		{
+			if(Result < 0)
+			{
+				errno = -Result;
+				ThisSlot.Read->Bytes = static_cast<size_t>(-1);
+			}
+			else if((Result > 0) && (static_cast<size_t>(Result) < Size))
+			{
+				// Complete a short read synchronously, this will stop at the end of the file
+				size_t More = FileDescriptorReadAt(ThisSlot.fd, ThisSlot.Pos + Result, &Buffer[Result], Size - Result);
+				ThisSlot.Read->Bytes = (More == static_cast<size_t>(-1)) ? More : static_cast<size_t>(Result) + More;
+			}
+			else ThisSlot.Read->Bytes = static_cast<size_t>(Result);
+
+			ReadsInFlight--;
+		}
+
+		FreeSlots.push_back(Index);
+	}
+
+	__atomic_store_n(CQHead, Head, __ATOMIC_RELEASE);
+}
+
+
+//! Take back any entries added to the submission queue but not yet passed to the kernel, failing any reads among them
+void AsyncIO::RingState::Withdraw(void)
+{
+	// DRAGONS: This is safe as the ring is not set up for kernel polling, so the kernel only reads entries during io_uring_enter
+	unsigned Tail = *SQTail;
+	while(Unsubmitted)
+	{
+		Tail--;
+		unsigned int Index = static_cast<unsigned int>(SQEs[Tail & *SQMask].user_data);
+
+		Slot &ThisSlot = Slots[Index];
+		if(ThisSlot.IsWrite)
+		{
+			ThisSlot.Data = NULL;
+			WritesInFlight--;
+		}
+		else
+		{
+			ThisSlot.Read->Bytes = static_cast<size_t>(-1);
+			ReadsInFlight--;
+		}
+
+		FreeSlots.push_back(Index);
+		Unsubmitted--;
+	}
+
+	__atomic_store_n(SQTail, Tail, __ATOMIC_RELEASE);
+}
+
+
+//! Wait for all requests passed to the kernel to complete, after withdrawing any not yet passed
+void AsyncIO::RingState::Drain(void)
+{
+	Withdraw();
+
+	for(;;)
+	{
+		Reap();
+		if((ReadsInFlight == 0) && (WritesInFlight == 0)) return;
+
+		// The buffers can't be handed back until the kernel has finished with them, so poll if it won't wait
+		if(syscall(__NR_io_uring_enter, Fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0) usleep(1000);
+	}
+}
+
+
+//! Construct a queue, using io_uring if it is available
+AsyncIO::AsyncIO(unsigned int Depth /*=DefaultDepth*/)
+{
+	Ring = new RingState;
+	if(!Ring->Setup(Depth))
+	{
+		debug("io_uring not available - %s\n", strerror(errno));
+		delete Ring;
+		Ring = NULL;
+	}
+}
+
+
+//! Wait for any outstanding writes and release the ring
+AsyncIO::~AsyncIO()
+{
+	if(Ring)
+	{
+		WaitWrites();
+		Ring->Release();
+		delete Ring;
+	}
+}
+
+
+//! Read a batch of ranges from a file descriptor, returning once all have completed
+bool AsyncIO::ReadBatch(int fd, AsyncReadRequestList &Requests)
+{
+	if(!Ring) return false;
+
+	MutexLock Locked(Lock);
+
+	AsyncReadRequestList::iterator it = Requests.begin();
+	for(;;)
+	{
+		// Queue as many reads as will fit
+		while((it != Requests.end()) && Ring->Add(false, fd, (*it).Pos, (*it).Buffer, (*it).Size, NULL, &(*it))) it++;
+
+		if((it == Requests.end()) && (Ring->ReadsInFlight == 0)) break;
+
+		// DRAGONS: Reads in flight point into Requests, so they must all complete before the caller may reuse the buffers
+		if(!Ring->Enter(1))
+		{
+			Ring->Drain();
+			return false;
+		}
+
+		Ring->Reap();
+	}
+
+	return true;
+}
+
+
+//! Queue a write of a data chunk to a given position of a file descriptor
+bool AsyncIO::QueueWrite(int fd, Position Pos, DataChunkPtr &Data)
+{
+	if(!Ring) return false;
+
+	MutexLock Locked(Lock);
+
+	// Wait for a slot to become free if the ring is full
+	while(!Ring->Add(true, fd, Pos, Data->Data, Data->Size, &Data, NULL))
+	{
+		if(!Ring->Enter(1)) return false;
+		Ring->Reap();
+	}
+
+	// Start the write now, but don't wait for it - if it can't be started the caller will write it, so it must not be left queued
+	if(!Ring->Enter(0))
+	{
+		Ring->Withdraw();
+		return false;
+	}
+
+	Ring->Reap();
+
+	return true;
+}
+
+
+//! Wait for all queued writes to complete
+bool AsyncIO::WaitWrites(void)
+{
+	if(!Ring) return true;
+
+	MutexLock Locked(Lock);
+
+	while(Ring->WritesInFlight)
+	{
+		// DRAGONS: Writes in flight hold their data chunks, and the file may be closed once we return, so all must complete
+		if(!Ring->Enter(1))
+		{
+			Ring->Drain();
+			Ring->WriteFailed = true;
+			break;
+		}
+
+		Ring->Reap();
+	}
+
+	bool Ret = !Ring->WriteFailed;
+	Ring->WriteFailed = false;
+
+	return Ret;
+}
+
+
+//! Are there any queued writes that may not yet have completed?
+bool AsyncIO::WritesPending(void)
+{
+	if(!Ring) return false;
+
+	MutexLock Locked(Lock);
+
+	Ring->Reap();
+	return Ring->WritesInFlight != 0;
+}
+
+
+#else // HAVE_IO_URING
+
+/* Without io_uring support every request is refused, so callers use their normal blocking I/O */
+
+//! Placeholder for the native io_uring state
+struct AsyncIO::RingState {};
+
+//! Construct a queue, io_uring is not available
+AsyncIO::AsyncIO(unsigned int Depth /*=DefaultDepth*/) : Ring(NULL) {}
+
+//! Nothing to release as io_uring is not available
+AsyncIO::~AsyncIO() {}
+
+//! Reads cannot be batched without io_uring
+bool AsyncIO::ReadBatch(int fd, AsyncReadRequestList &Requests) { return false; }
+
+//! Writes cannot be queued without io_uring
+bool AsyncIO::QueueWrite(int fd, Position Pos, DataChunkPtr &Data) { return false; }
+
+//! There are never any writes to wait for without io_uring
+bool AsyncIO::WaitWrites(void) { return true; }
+
+//! There are never any writes pending without io_uring
+bool AsyncIO::WritesPending(void) { return false; }
+
+#endif // HAVE_IO_URING
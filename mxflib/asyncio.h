@@ -0,0 +1,117 @@
+/*! \file	asyncio.h
+ *	\brief	Definition of class that batches positioned file reads and writes using Linux io_uring
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#ifndef MXFLIB__ASYNCIO_H
+#define MXFLIB__ASYNCIO_H
+
+#include <vector>
+
+
+namespace mxflib
+{
+	//! A single positioned read for AsyncIO::ReadBatch() or MXFFile::ReadBatch()
+	struct AsyncReadRequest
+	{
+		Position Pos;						//!< Position in the file to read from
+		UInt8 *Buffer;						//!< Buffer to read into
+		size_t Size;						//!< Number of bytes to read
+		size_t Bytes;						//!< Number of bytes read, set once the batch completes (-1 on error)
+
+		AsyncReadRequest(Position Pos = 0, UInt8 *Buffer = NULL, size_t Size = 0) : Pos(Pos), Buffer(Buffer), Size(Size), Bytes(0) {}
+	};
+
+	//! A batch of positioned reads
+	typedef std::vector<AsyncReadRequest> AsyncReadRequestList;
+
+
+	//! Queue of positioned reads and writes on file descriptors, submitted together using Linux io_uring
+	/*! This is only functional if the library is built with HAVE_IO_URING defined (IO_URING=1 with the standard makefiles)
+	 *  and the running kernel permits io_uring. Otherwise IsAsync() returns false and all requests are refused, so
+	 *  callers must fall back to normal blocking I/O - MXFFile does this automatically.
+	 *
+	 *  Reads are submitted as a batch and waited for together, so a whole set of frame reads is in flight at once
+	 *  rather than each being a separate blocking syscall. Writes are queued and complete in the background; a
+	 *  reference to each data chunk is held until it has been written, and completions are collected when more
+	 *  writes are queued or when WaitWrites() is called.
+	 *
+	 *  \note Calls are serialised with an internal lock, so one queue may be shared by threads
+	 */
+	class AsyncIO : public RefCount<AsyncIO>
+	{
+	public:
+		//! Default number of requests that may be in flight at once
+		static const unsigned int DefaultDepth;
+
+	protected:
+		struct RingState;					//!< Native io_uring state, only defined when built with io_uring support
+
+		RingState *Ring;					//!< The io_uring state, or NULL if io_uring is not available
+		Mutex Lock;							//!< Lock serialising use of the ring
+
+	private:
+		//! Prevent copy construction
+		AsyncIO(const AsyncIO &);
+
+		//! Prevent assignment
+		AsyncIO &operator=(const AsyncIO &);
+
+	public:
+		//! Construct a queue, using io_uring if it is available
+		/*! \param Depth The maximum number of requests in flight at once */
+		AsyncIO(unsigned int Depth = DefaultDepth);
+
+		//! Wait for any outstanding writes and release the ring
+		~AsyncIO();
+
+		//! Is io_uring being used? If not all requests will be refused
+		bool IsAsync(void) const { return Ring != NULL; }
+
+		//! Read a batch of ranges from a file descriptor, returning once all have completed
+		/*! \return false if the batch could not be submitted, in which case the reads must be done another way
+		 *  \note Each request's Bytes is set to the number of bytes read, which is only short at the end of the file
+		 */
+		bool ReadBatch(int fd, AsyncReadRequestList &Requests);
+
+		//! Queue a write of a data chunk to a given position of a file descriptor
+		/*! The chunk is referenced until written, and it must not be modified in the meantime
+		 *  \return false if the write could not be queued, in which case it must be done another way
+		 */
+		bool QueueWrite(int fd, Position Pos, DataChunkPtr &Data);
+
+		//! Wait for all queued writes to complete
+		/*! \return false if any write failed since the last call */
+		bool WaitWrites(void);
+
+		//! Are there any queued writes that may not yet have completed?
+		bool WritesPending(void);
+	};
+
+	//! A smart pointer to an AsyncIO object
+	typedef SmartPtr<AsyncIO> AsyncIOPtr;
+}
+
+#endif // MXFLIB__ASYNCIO_H
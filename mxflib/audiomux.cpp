@@ -80,6 +80,8 @@ DataChunkPtr AudioDemux::GetEssenceData(AudioDemuxSource *Caller, unsigned int C
 {
 	AUDIODEMUX_DEBUG("GetEssenceData(Caller, %u, %u, %s, %s)\n", Channel, ChannelCount, UInt64toString(Size).c_str(), UInt64toString(MaxSize).c_str());
 
+	MutexLock Locked(ReadLock);
+
 	// The value we will return
 	DataChunkPtr Ret;
 	
@@ -423,6 +425,8 @@ size_t AudioDemux::GetEssenceDataSize(unsigned int Channel, unsigned int Channel
 {
 	AUDIODEMUX_DEBUG("GetEssenceDataSize(%u, %u)\n", Channel, ChannelCount);
 
+	MutexLock Locked(ReadLock);
+
 	Length SampleCount;
 
 	// Sanity check the channel parameters
@@ -107,6 +107,8 @@ namespace mxflib
 		Rational    VideoEditRate;          //!< Optionally used to calculate the size of a chunk  of audio
 		int         FrameCount;				//!< Count frames for calculating size of individual buffers
 
+		Mutex		ReadLock;				//!< Serialises reads by demultiplexed sources, which may be written to different files on different threads
+
 	private:
 		AudioDemux();						//!< Prevent default construction
 		AudioDemux(AudioDemux&);			//!< Prevent copy construction
@@ -330,7 +332,12 @@ namespace mxflib
 		//! Is all data exhasted?
 		/*! \return true if a call to GetEssenceData() will return some valid essence data
 		 */
-		virtual bool EndOfData(void) { return Parent->Outputs[Channel].Eof; }
+		virtual bool EndOfData(void)
+		{
+			// The output state is updated by reads from other sources, which may be on other threads
+			MutexLock Locked(Parent->ReadLock);
+			return Parent->Outputs[Channel].Eof;
+		}
 
 		//! Get the GCEssenceType to use when wrapping this essence in a Generic Container
 		virtual Uint8 GetGCEssenceType(void) { return Parent->Source->GetGCEssenceType(); }
@@ -354,6 +361,8 @@ namespace mxflib
 		 */
 		virtual Position GetCurrentPosition(void) { 
 			Rational ER=GetEditRate();
+
+			MutexLock Locked(Parent->ReadLock);
 			if(Parent->SourceAudioSampleRate)
 			{
 				Position Ret;
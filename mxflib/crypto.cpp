@@ -460,12 +460,22 @@ size_t KLVEObject::ReadDataFrom(Position Offset, size_t Size /*=-1*/)
 		// Initialize the decryption engine with the specified Initialization Vector
 		Decrypt->SetIV(16, Data.Data, true);
 
-		// Decrypt the check value...
-		DataChunkPtr PlainCheck = Decrypt->Decrypt(16, &Data.Data[16]);
+		// Decrypt the check value... (in place if possible)
+		const UInt8 *PlainCheck = NULL;
+		DataChunkPtr PlainCheckChunk;
+		if(Decrypt->CanDecryptInPlace(16))
+		{
+			if(Decrypt->DecryptInPlace(16, &Data.Data[16])) PlainCheck = &Data.Data[16];
+		}
+		else
+		{
+			PlainCheckChunk = Decrypt->Decrypt(16, &Data.Data[16]);
+			if(PlainCheckChunk && (PlainCheckChunk->Size == 16)) PlainCheck = PlainCheckChunk->Data;
+		}
 
 		// Encrypt the check value... (Which is "CHUKCHUKCHUKCHUK" who ever said Chuck Harrison has no ego?)
 		const UInt8 DefinitivePlainCheck[16] = { 0x43, 0x48, 0x55, 0x4B, 0x43, 0x48, 0x55, 0x4B, 0x43, 0x48, 0x55, 0x4B, 0x43, 0x48, 0x55, 0x4B };
-		if((!PlainCheck) || (memcmp(PlainCheck->Data, DefinitivePlainCheck, PlainCheck->Size) != 0))
+		if((!PlainCheck) || (memcmp(PlainCheck, DefinitivePlainCheck, 16) != 0))
 		{
 			error("Check value did not correctly decrypt in KLVEObject::ReadDataFrom() - is the encryption key correct?\n");
 			return 0;
@@ -552,22 +562,12 @@ size_t KLVEObject::ReadDataFrom(Position Offset, size_t Size /*=-1*/)
 
 	/* We have all the plaintext bytes from Offset forwards, now we read all encrypted bytes too */
 
-	// Take the buffer from the current DataChunk to preserve it
-	DataChunkPtr PlainData = new DataChunk;
-	PlainData->TakeBuffer(Data, true);
-
 	// Work out how many encrypted bytes to read
 	size_t EncSize;
 	if(Size == static_cast<size_t>(-1)) EncSize = Size; else EncSize = Size - static_cast<size_t>(PlainSize);
 
-	// Read the encrypted bytes
-	ReadCryptoDataFrom(PlaintextOffset, EncSize);
-
-	// Append the decrypted data to the plaintext data
-	PlainData->Append(Data);
-
-	// Transfer this data to the "current" DataChunk
-	Data.TakeBuffer(PlainData);
+	// Read the encrypted bytes, decrypting them into the same DataChunk following the plaintext
+	ReadCryptoDataFrom(PlaintextOffset, EncSize, PlainBytes);
 
 	// Set the "next" position to just after the end of what we read
 	CurrentReadOffset = Offset + Data.Size;
@@ -583,11 +583,12 @@ size_t KLVEObject::ReadDataFrom(Position Offset, size_t Size /*=-1*/)
 //! Read data from a specified position in the encrypted portion of the KLV value field into the DataChunk
 /*! \param Offset Offset from the start of the KLV value from which to start reading
  *  \param Size Number of bytes to read, if = -1 all available bytes will be read (which could be billions!)
+ *  \param Prefix Number of bytes already in the DataChunk to keep ahead of the decrypted data (not included in the return value)
  *  \return The number of bytes read
  *	The IV must have already been set.
  *  Only encrypted parts of the value may be read using this function (i.e. Offset >= PlaintextOffset)
  */
-size_t KLVEObject::ReadCryptoDataFrom(Position Offset, size_t Size /*=-1*/)
+size_t KLVEObject::ReadCryptoDataFrom(Position Offset, size_t Size /*=-1*/, size_t Prefix /*=0*/)
 {
 	// Initially plan to read all the bytes available
 	Length BytesToRead = EncryptedLength - Offset;
@@ -598,22 +599,26 @@ size_t KLVEObject::ReadCryptoDataFrom(Position Offset, size_t Size /*=-1*/)
 	// Assume that the read will succeed and move the "next" pointer accordingly
 	CurrentReadOffset += BytesToRead;
 
+	// Discard anything in the DataChunk after the prefix
+	Data.Resize(Prefix);
+
 	// Check if all the requested bytes have already been decrypted
 	if(BytesToRead <= PreDecrypted)
 	{
 		// Set the data	into the DataChunk
-		Data.Set(static_cast<size_t>(BytesToRead), PreDecryptBuffer);
+		Data.Set(static_cast<size_t>(BytesToRead), PreDecryptBuffer, Prefix);
+
+		// Shuffle any remaining bytes
+		PreDecrypted -= static_cast<int>(BytesToRead);
+		memmove(PreDecryptBuffer, &PreDecryptBuffer[BytesToRead], PreDecrypted);
 
 		// Remove any padding if required
-		if(Offset + Data.Size > ValueLength)
+		if(Offset + BytesToRead > ValueLength)
 		{
 			BytesToRead = ValueLength - Offset;
-			Data.Resize(static_cast<size_t>(BytesToRead));
+			Data.Resize(Prefix + static_cast<size_t>(BytesToRead));
 		}
 
-		// Shuffle any remaining bytes
-		memmove(PreDecryptBuffer, &PreDecryptBuffer[BytesToRead], static_cast<size_t>(EncryptionGranularity - BytesToRead));
-
 		// All done
 		return static_cast<size_t>(BytesToRead);
 	}
@@ -632,70 +637,74 @@ size_t KLVEObject::ReadCryptoDataFrom(Position Offset, size_t Size /*=-1*/)
 		return 0;
 	}
 
-	// Read the encrypted data
-	if(!ReadChunkedCryptoDataFrom(PreDecrypted + Offset, static_cast<size_t>(BytesToDecrypt)))
+	// Put any pre-decrypted data after the prefix, the newly decrypted data will follow it
+	if(PreDecrypted) Data.Set(PreDecrypted, PreDecryptBuffer, Prefix);
+
+	// Read and decrypt the encrypted data (for a whole KLV this is a single read and a single decrypt)
+	if(!ReadChunkedCryptoDataFrom(PreDecrypted + Offset, static_cast<size_t>(BytesToDecrypt), Prefix + PreDecrypted))
 	{
 		// Abort if the decrypt failed
+		Data.Resize(Prefix);
 		return 0;
 	}
 
-	// Add back in any pre-decrypted data
-	if(PreDecrypted)
-	{
-		// Steal the newly decrypted bytes
-		UInt8 *Buffer = Data.StealBuffer(true);
-
-		// Make a buffer large enough for the complete data
-		Data.ResizeBuffer(PreDecrypted + static_cast<size_t>(BytesToDecrypt));
-
-		// Put the pre-decrypted bytes at the start
-		Data.Set(PreDecrypted, PreDecryptBuffer);
-
-		// Follow it with the newly decrypted data
-		Data.Set(static_cast<size_t>(BytesToDecrypt), Buffer, PreDecrypted);
-	}
+	// Number of bytes now available after the prefix
+	size_t Bytes = Data.Size - Prefix;
 
 	// If we have decrypted more than requested store them as pre-decrypted for next time
-	if(Data.Size > Size)
+	if(Bytes > BytesToRead)
 	{
-		PreDecrypted = static_cast<int>(Data.Size - Size);
-		memcpy(PreDecryptBuffer, &Data.Data[Size], PreDecrypted);
-		Data.Resize(Size);
+		PreDecrypted = static_cast<int>(Bytes - BytesToRead);
+		memcpy(PreDecryptBuffer, &Data.Data[Prefix + BytesToRead], PreDecrypted);
+		Bytes = static_cast<size_t>(BytesToRead);
 	}
 	else 
 		PreDecrypted = 0;
 
 	// Remove any padding if required
-	if(Offset + Data.Size > ValueLength)
-	{
-		Size = static_cast<size_t>(ValueLength - Offset);
-		Data.Resize(Size);
-	}
+	if(Offset + Bytes > ValueLength) Bytes = static_cast<size_t>(ValueLength - Offset);
 
-	return Size;
+	Data.Resize(Prefix + Bytes);
+
+	return Bytes;
 }
 
 
 //! Read an integer set of chunks from a specified position in the encrypted portion of the KLV value field into the DataChunk
 /*! \param Offset Offset from the start of the KLV value from which to start reading
  *  \param Size Number of bytes to read, if = -1 all available bytes will be read (which could be billions!)
+ *  \param Prefix Number of bytes already in the DataChunk to keep ahead of the decrypted data (not included in the return value)
  *  \return The number of bytes read
  *	The IV must have already been set, Size must be a multiple of 16 as must (Offset - PlaintextOffset). 
  *  Only encrypted parts of the value may be read using this function (i.e. Offset >= PlaintextOffset)
  */
-size_t KLVEObject::ReadChunkedCryptoDataFrom(Position Offset, size_t Size)
+size_t KLVEObject::ReadChunkedCryptoDataFrom(Position Offset, size_t Size, size_t Prefix /*=0*/)
 {
-	// Read the encrypted data
-	size_t NewSize = Base_ReadDataFrom(DataOffset + Offset, Size);
+	// Make room for the encrypted data after the prefix
+	Data.Resize(Prefix + Size);
+
+	// Read the encrypted data directly into place
+	// DRAGONS: A read handler may replace the buffer of Target, in which case we need to copy the data it gives us
+	size_t NewSize;
+	{
+		DataChunk Target;
+		Target.SetBuffer(&Data.Data[Prefix], Size);
+		NewSize = Base_ReadDataFrom(Target, DataOffset + Offset, Size);
+
+		if(NewSize > Size) NewSize = Size;
+		if(NewSize && (Target.Data != &Data.Data[Prefix])) memcpy(&Data.Data[Prefix], Target.Data, NewSize);
+	}
+
+	UInt8 *Buffer = &Data.Data[Prefix];
 
 	// Update the current hash if we are calculating one
-	if(ReadHasher) ReadHasher->HashData(Data);
+	if(ReadHasher) ReadHasher->HashData(NewSize, Buffer);
 
 	// Resize if less bytes than requested were actualy read
 	if(NewSize != Size)
 	{
 		Size = NewSize;
-		Data.Resize(Size);
+		Data.Resize(Prefix + Size);
 		if(Size == 0) return 0;
 
 		// We can cope with less bytes, as long as it is an integer number of blocks
@@ -712,11 +721,11 @@ size_t KLVEObject::ReadChunkedCryptoDataFrom(Position Offset, size_t Size)
 	// See if we can decrypt this in place...
 	if(Decrypt->CanDecryptInPlace(Size))
 	{
-		if(!Decrypt->DecryptInPlace(Data))
+		if(!Decrypt->DecryptInPlace(Size, Buffer))
 		{
 			// Invalidate the "next" position to prevent further read attempts
 			CurrentReadOffset = Source.OuterLength;
-			Data.Resize(0);
+			Data.Resize(Prefix);
 			return 0;
 		}
 
@@ -724,17 +733,18 @@ size_t KLVEObject::ReadChunkedCryptoDataFrom(Position Offset, size_t Size)
 	}
 
 	// Decrypt by making a copy
-	DataChunkPtr NewData = Decrypt->Decrypt(Data);
-	if(!NewData)
+	DataChunkPtr NewData = Decrypt->Decrypt(Size, Buffer);
+	if((!NewData) || (NewData->Size < Size))
 	{
 		// Invalidate the "next" position to prevent further read attempts
 		CurrentReadOffset = Source.OuterLength;
-		Data.Resize(0);
+		Data.Resize(Prefix);
 		return 0;
 	}
 
-	// Take over the buffer from the decrypted data
-	Data.TakeBuffer(NewData);
+	// Copy the decrypted data over the encrypted data, or simply take over the buffer if there is no prefix
+	if(Prefix) memcpy(Buffer, NewData->Data, Size);
+	else Data.TakeBuffer(NewData);
 
 	return Size;
 }
@@ -904,9 +914,8 @@ size_t KLVEObject::WriteDataTo(const UInt8 *Buffer, Position Offset, size_t Size
 		return PlainBytes;
 	}
 
-	// Update the current hash if we are calculating one
-	// TODO: Sort the possible overflow here
-	if(WriteHasher) WriteHasher->HashData(Size, Buffer);
+	// Update the current hash if we are calculating one (the encrypted bytes are hashed as they are written)
+	if(WriteHasher) WriteHasher->HashData(PlainSize, Buffer);
 
 	// Update the write pointer after the plaintext write
 	CurrentWriteOffset = Offset + PlainBytes;
@@ -1330,7 +1339,10 @@ bool KLVEObject::ReadFooter(void)
 
 			if(*MIC != *CalcMIC)
 			{
-				error("Message Integrity Code check failed\n");
+				// Let the handler decide what to do, if we have one
+				if(MICHandler) return MICHandler->HandleMismatch(this, MIC, CalcMIC);
+
+				error("Message Integrity Code check failed in %s\n", GetSourceLocation().c_str());
 				return false;
 			}
 		}
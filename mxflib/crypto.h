@@ -294,6 +294,32 @@ namespace mxflib
 	typedef SmartPtr<Hash_Base> HashPtr;
 
 
+	// Forward declare KLVEObject to allow it to be passed to MIC check handlers
+	class KLVEObject;
+
+	//! Base class for handlers to be notified of Message Integrity Code check failures when reading
+	/*! The MIC is calculated as the encrypted value is read, so a handler allows a single pass to both check and extract the essence.
+	 *  \note Classes derived from this class <b>must not</b> include their own RefCount<> derivation
+	 */
+	class MICCheckHandler_Base : public RefCount<MICCheckHandler_Base>
+	{
+	public:
+		// Virtual base destructor to allow polymorphic destruction
+		virtual ~MICCheckHandler_Base() {};
+
+		//! Handle a KLVEObject where the MIC calculated when reading does not match the MIC in the file
+		/*! \param Object The KLVEObject that has just finished being read
+		 *  \param FileMIC The MIC read from the AS-DCP footer
+		 *  \param CalcMIC The MIC calculated from the data read
+		 *  \return true if the data should be accepted anyway, false if the failure is to be treated as a read error
+		 */
+		virtual bool HandleMismatch(KLVEObject *Object, DataChunkPtr &FileMIC, DataChunkPtr &CalcMIC) = 0;
+	};
+
+	// Smart pointer to a MIC check handler
+	typedef SmartPtr<MICCheckHandler_Base> MICCheckHandlerPtr;
+
+
 	//! KLVEObject class
 	/*! This class gives access to single AS-DCP encrypted KLV items within an MXF file with KLVObject interfacing
 	 */
@@ -311,6 +337,7 @@ namespace mxflib
 		DecryptPtr	Decrypt;						//!< Pointer to the decryption wrapper
 		HashPtr WriteHasher;						//!< Pointer to a hasher being used for hashing data being written
 		HashPtr ReadHasher;							//!< Pointer to a hasher being used for hashing data being read
+		MICCheckHandlerPtr MICHandler;				//!< Handler to notify of MIC check failures when reading, or NULL to treat them as errors
 
 		bool DataLoaded;							//!< True once the AS-DCP header data has been read
 		UUIDPtr ContextID;							//!< The context ID used to link to encryption metadata
@@ -365,6 +392,16 @@ namespace mxflib
 		 */
 		void SetReadHasher(HashPtr &Hasher) { ReadHasher = Hasher; };
 
+		//! Set a handler to notify of MIC check failures when reading
+		/*! Without a handler a MIC check failure is an error and the final read of the value returns no data.
+		 *  \note The MIC is only checked if a read hasher is also set, and the value is read in sequence to the end
+		 */
+		void SetMICHandler(MICCheckHandlerPtr &Handler) { MICHandler = Handler; };
+
+		//! Get the MIC read from the file, or calculated if the file has none
+		/*! \return NULL if the footer has not yet been read or no MIC was read or calculated */
+		DataChunkPtr GetMIC(void) { return MIC; }
+
 
 		//! Set an encryption Initialization Vector
 		/*! \return False if Initialization Vector is rejected
@@ -563,8 +600,9 @@ namespace mxflib
 		 *  \return The number of bytes read
 		 *	The IV must have already been set.
 		 *  Only encrypted parts of the value may be read using this function (i.e. Offset >= PlaintextOffset)
+		 *  \param Prefix Number of bytes already in the DataChunk to keep ahead of the decrypted data (not included in the return value)
 		 */
-		size_t ReadCryptoDataFrom(Position Offset, size_t Size = static_cast<size_t>(-1));
+		size_t ReadCryptoDataFrom(Position Offset, size_t Size = static_cast<size_t>(-1), size_t Prefix = 0);
 
 		//! Read an integer set of chunks from a specified position in the encrypted portion of the KLV value field into the DataChunk
 		/*! \param Offset Offset from the start of the KLV value from which to start reading
@@ -572,8 +610,10 @@ namespace mxflib
 		 *  \return The number of bytes read
 		 *	The IV must have already been set, Size must be a multiple of 16 as must (Offset - PlaintextOffset). 
 		 *  Only encrypted parts of the value may be read using this function (i.e. Offset >= PlaintextOffset)
+		 *  \param Prefix Number of bytes already in the DataChunk to keep ahead of the decrypted data (not included in the return value)
+		 *  \note The encrypted data is read directly into the DataChunk after any prefix, and decrypted in place if the decryption wrapper allows
 		 */
-		size_t ReadChunkedCryptoDataFrom(Position Offset, size_t Size);
+		size_t ReadChunkedCryptoDataFrom(Position Offset, size_t Size, size_t Prefix = 0);
 	
 		//! Write encrypted data from a given buffer to a given location in the destination file
 		/*! \param Buffer Pointer to data to be written
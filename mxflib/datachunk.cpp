@@ -54,6 +54,7 @@ void mxflib::DataChunk::Resize(size_t NewSize, bool PreserveContents /*=true*/)
 	}
 
 	UInt8 *NewData = new UInt8[AllocSize];
+	StatsCountAlloc(AllocSize);
 	if(PreserveContents && (Size != 0)) memcpy(NewData, Data, Size);
 
 //debug("Changing Buffer @ 0x%08x -> 0x%08x (0x%04x)\n", (int)Data, (int)NewData, (int)AllocSize);
@@ -80,6 +81,7 @@ void mxflib::DataChunk::ResizeBuffer(size_t NewSize, bool PreserveContents /*=tr
 	}
 
 	UInt8 *NewData = new UInt8[NewSize];
+	StatsCountAlloc(NewSize);
 	if(PreserveContents && (Size != 0)) memcpy(NewData, Data, Size);
 
 //debug("Changing Buffer @ 0x%08x -> 0x%08x (0x%04x)+\n", (int)Data, (int)NewData, (int)NewSize);
@@ -216,3 +218,77 @@ UInt8 *DataChunk::StealBuffer(bool MakeEmpty /*=false*/)
 }
 
 
+namespace
+{
+	//! A DataChunk that uses a buffer from a DataChunkPool, and returns it when destroyed
+	class PooledDataChunk : public DataChunk
+	{
+	protected:
+		DataChunkPoolPtr Pool;					//!< The pool that owns our buffer
+		UInt8 *PoolBuffer;						//!< The buffer taken from the pool (which may no longer be Data if we have been resized)
+
+	public:
+		PooledDataChunk(DataChunkPool *Pool, UInt8 *Buffer, size_t Size) : Pool(Pool), PoolBuffer(Buffer)
+		{
+			SetBuffer(Buffer, Size, Pool->GetBufferSize());
+		}
+
+		~PooledDataChunk()
+		{
+			Pool->Release(PoolBuffer);
+		}
+	};
+}
+
+
+//! Free all unused buffers
+DataChunkPool::~DataChunkPool()
+{
+	while(!FreeBuffers.empty())
+	{
+		delete[] FreeBuffers.front();
+		FreeBuffers.pop_front();
+	}
+}
+
+
+//! Get a DataChunk of the given size using a buffer from the pool
+/*! If Size is larger than the pool buffer size a normal DataChunk is returned
+ */
+DataChunkPtr DataChunkPool::GetChunk(size_t Size)
+{
+	if(Size > BufferSize) return new DataChunk(Size);
+
+	UInt8 *Buffer = NULL;
+
+	Lock.Lock();
+	if(!FreeBuffers.empty())
+	{
+		Buffer = FreeBuffers.front();
+		FreeBuffers.pop_front();
+	}
+	Lock.Unlock();
+
+	if(!Buffer)
+	{
+		Buffer = new UInt8[BufferSize];
+		StatsCountAlloc(BufferSize);
+	}
+
+	return new PooledDataChunk(this, Buffer, Size);
+}
+
+
+//! Return a buffer to the pool
+void DataChunkPool::Release(UInt8 *Buffer)
+{
+	Lock.Lock();
+	if(FreeBuffers.size() < MaxFree)
+	{
+		FreeBuffers.push_back(Buffer);
+		Buffer = NULL;
+	}
+	Lock.Unlock();
+
+	if(Buffer) delete[] Buffer;
+}
@@ -202,4 +202,77 @@ namespace mxflib
 	};
 }
 
+
+namespace mxflib
+{
+	// Forward declare so the class can be used
+	class DataChunkPool;
+
+	//! A smart pointer to a DataChunkPool object
+	typedef SmartPtr<DataChunkPool> DataChunkPoolPtr;
+
+	//! A pool of equal-sized buffers for DataChunks that are repeatedly built and released
+	/*! Chunks returned by GetChunk() use a buffer from the pool as an external buffer, and the buffer is returned to
+	 *  the pool when the chunk is destroyed. This avoids allocating (and page-faulting) a fresh multi-megabyte buffer
+	 *  for each frame of large essence. Each chunk holds a reference to the pool, so the pool lives until all of its
+	 *  chunks are gone. Buffers may be released from any thread.
+	 *  \note If a pooled chunk is grown beyond the pool buffer size it will allocate its own buffer as normal
+	 */
+	class DataChunkPool : public RefCount<DataChunkPool>
+	{
+	protected:
+		size_t BufferSize;						//!< The size of each buffer in the pool
+		size_t MaxFree;							//!< The maximum number of unused buffers to keep
+		std::list<UInt8*> FreeBuffers;			//!< Buffers not currently in use
+		Mutex Lock;								//!< Lock for FreeBuffers
+
+	private:
+		//! Prevent default construction
+		DataChunkPool();
+
+		//! Prevent copy construction
+		DataChunkPool(const DataChunkPool &);
+
+	public:
+		//! Construct a pool of buffers of a given size, keeping at most MaxFree unused buffers for re-use
+		DataChunkPool(size_t BufferSize, size_t MaxFree = 4) : BufferSize(BufferSize), MaxFree(MaxFree) {}
+
+		//! Free all unused buffers
+		~DataChunkPool();
+
+		//! Get the size of each buffer in the pool
+		size_t GetBufferSize(void) const { return BufferSize; }
+
+		//! Get a DataChunk of the given size using a buffer from the pool
+		/*! If Size is larger than the pool buffer size a normal DataChunk is returned
+		 */
+		DataChunkPtr GetChunk(size_t Size);
+
+		//! Return a buffer to the pool
+		/*! \note This is called by pooled chunks as they are destroyed
+		 */
+		void Release(UInt8 *Buffer);
+	};
+
+
+	//! A DataChunk that refers to part of another DataChunk's buffer, without copying
+	/*! This allows one large read to be handed out as a number of smaller chunks. The parent chunk is kept alive
+	 *  for as long as the view exists.
+	 *  \note If the view is grown beyond its original size it will allocate its own buffer and no longer refer to the parent
+	 */
+	class DataChunkView : public DataChunk
+	{
+	protected:
+		DataChunkPtr Parent;					//!< The chunk that owns the buffer
+
+	public:
+		//! Construct a view of Size bytes starting at Offset in the parent chunk
+		DataChunkView(DataChunkPtr &Parent, size_t Offset, size_t Size) : Parent(Parent)
+		{
+			mxflib_assert(Offset + Size <= Parent->Size);
+			SetBuffer(&Parent->Data[Offset], Size);
+		}
+	};
+}
+
 #endif // MXFLIB__DATACHUNK_H
@@ -152,6 +152,13 @@ namespace mxflib_deftypes
  */
 int mxflib::LoadTypes(const ConstTypeRecord *TypesData, SymbolSpacePtr DefaultSymbolSpace /*=MXFLibSymbols*/)
 {
+	// A frozen dictionary may be in use by other threads, so must not be modified
+	if(MDOType::IsFrozen())
+	{
+		error("Cannot load types as the dictionary is frozen\n");
+		return -1;
+	}
+
 	//! Check if we have required internal items defined
 	if(!MDOType::GetInternalsDefined()) MDOType::DefineInternals();
 
@@ -281,6 +288,9 @@ namespace mxflib
 //! Flag to show when we have loaded types and classes required for internal use
 bool MDOType::InternalsDefined = false;
 
+//! Flag to show when the dictionary has been frozen
+bool MDOType::Frozen = false;
+
 //! Load types and classes required for internal use 
 void MDOType::DefineInternals(void)
 {
@@ -301,6 +311,13 @@ void MDOType::DefineInternals(void)
  */
 int mxflib::LoadTypes(TypeRecordList &TypesData, SymbolSpacePtr DefaultSymbolSpace /*=MXFLibSymbols*/)
 {
+	// A frozen dictionary may be in use by other threads, so must not be modified
+	if(MDOType::IsFrozen())
+	{
+		error("Cannot load types as the dictionary is frozen\n");
+		return -1;
+	}
+
 	//! Check if we have required internal items defined
 	if(!MDOType::GetInternalsDefined()) MDOType::DefineInternals();
 
@@ -1051,6 +1068,22 @@ int mxflib::LoadDictionary(const char *DictFile, SymbolSpacePtr DefaultSymbolSpa
 }
 
 
+//! Freeze the loaded dictionary so that it may be shared by threads processing different files
+void mxflib::FreezeDictionary(void)
+{
+	if(MDOType::IsFrozen()) return;
+
+	// Build everything that would otherwise be built on first use
+	if(!MDOType::GetInternalsDefined()) MDOType::DefineInternals();
+	MDOType::GetStaticPrimer();
+	EssenceParser::Init();
+
+	SymbolSpace::Freeze();
+	MDType::Freeze();
+	MDOType::Freeze();
+}
+
+
 //! Load dictionary from an XML string
 int mxflib::LoadDictionaryFromXML(std::string &strXML, std::string Application, bool /*=false*/)
 {
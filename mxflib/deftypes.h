@@ -1073,6 +1073,15 @@ namespace mxflib
 		return LoadDictionary(DictFile.c_str(), DefaultSymbolSpace, "", FastFail);
 	}
 
+	//! Freeze the loaded dictionary so that it may be shared by threads processing different files
+	/*! After loading is complete this builds any lazily initialised shared state (such as the static primer and the list of
+	 *  essence sub-parsers) and makes all dictionary entries permanent, so that MDObjects of the same type built in different
+	 *  threads do not contend on their reference counts.
+	 *  \note No further dictionary entries may be loaded, and the dictionary cannot be cleared, once it is frozen
+	 *  \note This must be called before starting any threads that use the dictionary
+	 */
+	void FreezeDictionary(void);
+
 	//! Load dictionary from the specified XML definitions with a default symbol space
 	/*! \return 0 if all OK
 	*  \return -1 on error
@@ -0,0 +1,262 @@
+/*! \file	directio.cpp
+ *	\brief	Implementation of class that writes a file with direct I/O, bypassing the page cache
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+// Required for strerror()
+#include <string.h>
+
+#include "mxflib/mxflib.h"
+
+using namespace mxflib;
+
+
+//! Default block size to align direct writes to, which suits most disks and file systems
+const UInt32 DirectWriter::DefaultAlign = 4096;
+
+//! Default size of the stage, which is the size of most direct writes
+const size_t DirectWriter::DefaultStageSize = 4 * 1024 * 1024;
+
+
+namespace
+{
+#ifdef O_DIRECT
+	//! Write all of a buffer at a given position of a file descriptor, retrying short writes
+	bool WriteAt(int fd, UInt64 Pos, const UInt8 *Buffer, size_t Size)
+	{
+		size_t Total = 0;
+		while(Total < Size)
+		{
+			ssize_t Bytes = pwrite(fd, Buffer + Total, Size - Total, static_cast<off_t>(Pos + Total));
+			if(Bytes < 0)
+			{
+				if(errno == EINTR) continue;
+				return false;
+			}
+			if(Bytes == 0) return false;
+			Total += static_cast<size_t>(Bytes);
+		}
+		return true;
+	}
+#endif // O_DIRECT
+}
+
+
+//! Open the named file for direct writes
+DirectWriter::DirectWriter(std::string FileName, int BufferedFD, UInt32 Align /*=DefaultAlign*/, size_t StageSize /*=DefaultStageSize*/)
+	: Name(FileName), BufferedFD(BufferedFD), Align(Align)
+{
+	DirectFD = -1;
+	Stage = NULL;
+	StageStart = 0;
+	StageFill = 0;
+	StageActive = false;
+	WriteFailed = false;
+
+	if((Align == 0) || (Align & (Align - 1)))
+	{
+		error("Direct I/O block size of %u is not a power of two\n", (unsigned int)Align);
+		this->StageSize = 0;
+		return;
+	}
+
+	// The stage is written whole, so it must be a whole number of blocks
+	this->StageSize = ((StageSize + Align - 1) / Align) * Align;
+	if(this->StageSize == 0) this->StageSize = Align;
+
+#ifdef O_DIRECT
+	DirectFD = open(FileName.c_str(), O_WRONLY | O_DIRECT);
+	if(DirectFD < 0)
+	{
+		debug("Unable to open \"%s\" for direct I/O - %s\n", FileName.c_str(), strerror(errno));
+		return;
+	}
+
+	void *Buffer;
+	if(posix_memalign(&Buffer, Align, this->StageSize) != 0)
+	{
+		error("Unable to allocate %s bytes for direct I/O to \"%s\"\n", Int64toString(this->StageSize).c_str(), FileName.c_str());
+
+		close(DirectFD);
+		DirectFD = -1;
+		return;
+	}
+
+	Stage = static_cast<UInt8*>(Buffer);
+#endif // O_DIRECT
+}
+
+
+//! Write any staged data and close the file opened for direct writes
+DirectWriter::~DirectWriter()
+{
+	Sync();
+
+#ifdef O_DIRECT
+	if(DirectFD >= 0) close(DirectFD);
+	free(Stage);
+#endif // O_DIRECT
+}
+
+
+//! Write data at a given position in the file
+size_t DirectWriter::Write(UInt64 Pos, const UInt8 *Buffer, size_t Size)
+{
+	if(!Stage) return static_cast<size_t>(-1);
+	if(!Size) return 0;
+
+	// A write that doesn't follow on from the stage starts a new one
+	if((!StageActive) || (Pos != (StageStart + StageFill)))
+	{
+		// DRAGONS: A failure is remembered so that it is reported again by the next Sync()
+		if(!Sync())
+		{
+			WriteFailed = true;
+			return static_cast<size_t>(-1);
+		}
+
+		if(!StartStage(Pos))
+		{
+			WriteFailed = true;
+			return static_cast<size_t>(-1);
+		}
+	}
+
+	size_t Done = 0;
+	while(Done < Size)
+	{
+		size_t Count = std::min(Size - Done, StageSize - StageFill);
+		memcpy(&Stage[StageFill], &Buffer[Done], Count);
+		StageFill += Count;
+		Done += Count;
+
+		if(StageFill == StageSize)
+		{
+			if(!WriteDirect(StageSize))
+			{
+				WriteFailed = true;
+				StageActive = false;
+				StageFill = 0;
+				return static_cast<size_t>(-1);
+			}
+
+			// Carry on from the end of the stage, which is block aligned so nothing need be read back
+			StageStart += StageSize;
+			StageFill = 0;
+		}
+	}
+
+	return Size;
+}
+
+
+//! Write everything held in the stage to the file
+bool DirectWriter::Sync(void)
+{
+	// Report any earlier failure once, as the caller may not have checked the result of Write()
+	bool Ret = !WriteFailed;
+	WriteFailed = false;
+
+	if(!StageActive) return Ret;
+	StageActive = false;
+
+	size_t Whole = StageFill & ~static_cast<size_t>(Align - 1);
+	if(Whole && !WriteDirect(Whole)) Ret = false;
+
+#ifdef O_DIRECT
+	// DRAGONS: The part block at the end is written through the ordinary descriptor, so that the rest of the block in the file is kept
+	if(StageFill > Whole)
+	{
+		if(!WriteAt(BufferedFD, StageStart + Whole, &Stage[Whole], StageFill - Whole))
+		{
+			error("Error writing file \"%s\" at 0x%s - %s\n", Name.c_str(), Int64toHexString(StageStart + Whole, 8).c_str(), strerror(errno));
+			Ret = false;
+		}
+	}
+#endif // O_DIRECT
+
+	StageFill = 0;
+
+	return Ret;
+}
+
+
+//! Start a new stage for data written at a given position, reading back the start of its first block
+bool DirectWriter::StartStage(UInt64 Pos)
+{
+	StageStart = Pos & ~static_cast<UInt64>(Align - 1);
+	StageFill = static_cast<size_t>(Pos - StageStart);
+	StageActive = true;
+
+#ifdef O_DIRECT
+	if(StageFill)
+	{
+		// The start of the block will be written again unchanged, and is zero where it is past the end of the file
+		size_t Bytes = FileDescriptorReadAt(BufferedFD, StageStart, Stage, StageFill);
+		if(Bytes == static_cast<size_t>(-1))
+		{
+			error("Error reading file \"%s\" at 0x%s - %s\n", Name.c_str(), Int64toHexString(StageStart, 8).c_str(), strerror(errno));
+
+			StageActive = false;
+			StageFill = 0;
+			return false;
+		}
+
+		if(Bytes < StageFill) memset(&Stage[Bytes], 0, StageFill - Bytes);
+	}
+#endif // O_DIRECT
+
+	return true;
+}
+
+
+//! Write part of the stage, from its start, with direct I/O
+bool DirectWriter::WriteDirect(size_t Size)
+{
+#ifdef O_DIRECT
+	if(DirectFD >= 0)
+	{
+		if(WriteAt(DirectFD, StageStart, Stage, Size)) return true;
+
+		// Some file systems accept O_DIRECT when opening but refuse the writes, so carry on through the page cache
+		if(errno != EINVAL)
+		{
+			error("Error writing file \"%s\" at 0x%s - %s\n", Name.c_str(), Int64toHexString(StageStart, 8).c_str(), strerror(errno));
+			return false;
+		}
+
+		debug("Direct I/O refused for \"%s\" - writing through the page cache\n", Name.c_str());
+
+		close(DirectFD);
+		DirectFD = -1;
+	}
+
+	if(WriteAt(BufferedFD, StageStart, Stage, Size)) return true;
+
+	error("Error writing file \"%s\" at 0x%s - %s\n", Name.c_str(), Int64toHexString(StageStart, 8).c_str(), strerror(errno));
+#endif // O_DIRECT
+
+	return false;
+}
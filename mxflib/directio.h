@@ -0,0 +1,118 @@
+/*! \file	directio.h
+ *	\brief	Definition of class that writes a file with direct I/O, bypassing the page cache
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#ifndef MXFLIB__DIRECTIO_H
+#define MXFLIB__DIRECTIO_H
+
+
+namespace mxflib
+{
+	//! Writer for a file that is already open, sending the data to disk with direct I/O rather than through the page cache
+	/*! Direct I/O requires that the position, size and memory address of each write are multiples of the block size of
+	 *  the device, so data is gathered in an aligned stage and written a whole stage at a time. Where a run of writes
+	 *  starts part way into a block, the start of the block is read back from the file into the stage first. Where it
+	 *  ends part way into a block, that part block is written through the ordinary descriptor so that the rest of the
+	 *  block in the file is kept. Only these part blocks pass through the page cache.
+	 *
+	 *  On Linux the file is opened a second time with O_DIRECT. Elsewhere, or if the file system does not support direct
+	 *  I/O, IsOpen() returns false and the writer can't be used.
+	 */
+	class DirectWriter : public RefCount<DirectWriter>
+	{
+	public:
+		//! Default block size to align direct writes to, which suits most disks and file systems
+		static const UInt32 DefaultAlign;
+
+		//! Default size of the stage, which is the size of most direct writes
+		static const size_t DefaultStageSize;
+
+	protected:
+		std::string Name;					//!< The name of the file, for error messages
+		int DirectFD;						//!< The file opened for direct I/O, or -1 if not available
+		int BufferedFD;						//!< The ordinary descriptor of the same file, used for part blocks
+		UInt32 Align;						//!< The block size that direct writes are aligned to
+		UInt8 *Stage;						//!< Aligned buffer in which data is gathered for writing
+		size_t StageSize;					//!< Size of the stage, a multiple of Align
+		UInt64 StageStart;					//!< Position in the file of the first byte of the stage, a multiple of Align
+		size_t StageFill;					//!< Number of bytes in the stage, including any read back from the start of the first block
+		bool StageActive;					//!< True if writes are being gathered in the stage, which may be empty after a whole stage was written
+		bool WriteFailed;					//!< Set if any write has failed since the last Sync()
+
+	private:
+		//! Prevent default construction
+		DirectWriter();
+
+		//! Prevent copy construction
+		DirectWriter(const DirectWriter &);
+
+		//! Prevent assignment
+		DirectWriter &operator=(const DirectWriter &);
+
+	public:
+		//! Open the named file for direct writes
+		/*! \param FileName The name of the file, which must already be open for reading and writing as BufferedFD
+		 *  \param BufferedFD The descriptor of the file already open, which must not have unflushed writes buffered
+		 *  \param Align The block size to align writes to, which must be a power of two
+		 *  \param StageSize The size of the stage, rounded up to a multiple of Align
+		 */
+		DirectWriter(std::string FileName, int BufferedFD, UInt32 Align = DefaultAlign, size_t StageSize = DefaultStageSize);
+
+		//! Write any staged data and close the file opened for direct writes
+		~DirectWriter();
+
+		//! Was the file opened for direct writes?
+		/*! \note This stays true if the file system later refuses a direct write, after which writes go through the page cache */
+		bool IsOpen(void) const { return Stage != NULL; }
+
+		//! Get the block size that direct writes are aligned to
+		UInt32 GetAlign(void) const { return Align; }
+
+		//! Write data at a given position in the file
+		/*! Data that follows on from the last write is added to the stage, otherwise the stage is written first
+		 *  \return The number of bytes written, or -1 on error
+		 *  \note The data may not reach the file until Sync() is called, so Sync() must be called before the file is read,
+		 *        its size is checked, or it is written in any other way
+		 */
+		size_t Write(UInt64 Pos, const UInt8 *Buffer, size_t Size);
+
+		//! Write everything held in the stage to the file
+		/*! \return false if any write has failed since the last call, including earlier whole stage writes */
+		bool Sync(void);
+
+	protected:
+		//! Start a new stage for data written at a given position, reading back the start of its first block
+		bool StartStage(UInt64 Pos);
+
+		//! Write part of the stage, from its start, with direct I/O
+		bool WriteDirect(size_t Size);
+	};
+
+	//! A smart pointer to a DirectWriter
+	typedef SmartPtr<DirectWriter> DirectWriterPtr;
+}
+
+#endif // MXFLIB__DIRECTIO_H
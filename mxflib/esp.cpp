@@ -38,6 +38,7 @@ using namespace mxflib;
 #include <mxflib/esp_wavepcm.h>
 #include <mxflib/esp_dvdif.h>
 #include <mxflib/esp_jp2k.h>
+#include <mxflib/esp_rawvideo.h>
 
 
 //! List of pointers to known parsers
@@ -62,6 +63,9 @@ void EssenceParser::Init()
 		AddNewSubParserType(new DV_DIF_EssenceSubParserFactory);
 		AddNewSubParserType(new JP2K_EssenceSubParser);
 
+		// DRAGONS: Raw video has no header so it is identified from filename options only, and must be tried last
+		AddNewSubParserType(new RAW_VIDEO_EssenceSubParser);
+
 		Inited = true;
 	}
 }
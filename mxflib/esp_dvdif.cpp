@@ -84,8 +84,9 @@ namespace
 }
 
 //! Examine the open file and return a list of essence descriptors
-EssenceStreamDescriptorList DV_DIF_EssenceSubParser::IdentifyEssence(FileHandle InFile)
+EssenceStreamDescriptorList DV_DIF_EssenceSubParser::IdentifyEssence(EssenceProbePtr &Probe)
 {
+	FileHandle InFile = Probe->GetFile();
 	int BufferBytes;
 
 	EssenceStreamDescriptorList Ret;
@@ -94,8 +95,7 @@ EssenceStreamDescriptorList DV_DIF_EssenceSubParser::IdentifyEssence(FileHandle
 	if(!Buffer) Buffer = new UInt8[DV_DIF_BUFFERSIZE];
 
 	// Read the first 12 bytes of the file to allow us to identify it
-	FileSeek(InFile, 0);
-	BufferBytes =(int) FileRead(InFile, Buffer, 12);
+	BufferBytes = (int)Probe->Read(0, Buffer, 12);
 
 	// If the file is smaller than 12 bytes give up now!
 	if(BufferBytes < 12) return Ret;
@@ -311,8 +311,7 @@ EssenceStreamDescriptorList DV_DIF_EssenceSubParser::IdentifyEssence(FileHandle
 	mxflib_assert(DV_DIF_BUFFERSIZE >= (80 * 150));
 
 	// Read the first 80*150 bytes of the file, this should be the first DIF sequence
-	FileSeek(InFile, 0);
-	BufferBytes = (int)FileRead(InFile, Buffer, 80 * 150);
+	BufferBytes = (int)Probe->Read(0, Buffer, 80 * 150);
 
 	// If we couldn't read the sequence give up now!
 	if(BufferBytes < (80 * 150)) return Ret;
@@ -688,7 +687,9 @@ DataChunkPtr DV_DIF_EssenceSubParser::Read(FileHandle InFile, UInt32 Stream, UIn
 	// If this is not an AVI file read the data and return
 	if(DIFEnd != -1)
 	{
-		// Read the data
+		// Read the data, a batch of frames at a time if requested
+		if(BatchFrames > 1) return BatchRead(InFile, Bytes);
+
 		return FileReadChunk(InFile, Bytes);
 	}
 
@@ -785,6 +786,83 @@ DataChunkPtr DV_DIF_EssenceSubParser::AVIRead(FileHandle InFile, size_t Bytes)
 };
 
 
+//! Read data from raw DIF essence, a batch of frames at a time
+/*! A single file read fills a pooled buffer with BatchFrames frames, and each call returns a view of the
+ *  next part of that buffer, so there is no per-frame read, allocation or copy.
+ */
+DataChunkPtr DV_DIF_EssenceSubParser::BatchRead(FileHandle InFile, size_t Bytes)
+{
+	// The batch is only valid if nobody has moved the file pointer since we filled it
+	if(Batch && (static_cast<Position>(FileTell(InFile)) != BatchEnd)) Batch = NULL;
+
+	if(Bytes == 0) return new DataChunk;
+
+	// Return the data from the current batch if it is all there
+	if(Batch && ((Batch->Size - BatchOffset) >= Bytes))
+	{
+		DataChunkPtr Ret = new DataChunkView(Batch, BatchOffset, Bytes);
+		BatchOffset += Bytes;
+		return Ret;
+	}
+
+	// Move back to the first byte we have not returned
+	DropBatch(InFile);
+
+	size_t BatchSize = static_cast<size_t>(BatchFrames * 150 * 80 * SeqCount);
+
+	// Large reads, such as clip wrapping, are done directly
+	if(Bytes > BatchSize) return FileReadChunk(InFile, Bytes);
+
+	if((!BatchPool) || (BatchPool->GetBufferSize() != BatchSize)) BatchPool = new DataChunkPool(BatchSize);
+
+	// Read up to a full batch, but never beyond the end of the essence
+	Position Pos = static_cast<Position>(FileTell(InFile));
+	size_t ReadSize = BatchSize;
+	if((DIFEnd - Pos) < static_cast<Length>(ReadSize)) ReadSize = static_cast<size_t>(DIFEnd - Pos);
+	if(ReadSize < Bytes) ReadSize = Bytes;
+
+	Batch = BatchPool->GetChunk(ReadSize);
+	size_t Got = FileRead(InFile, Batch->Data, ReadSize);
+	if(Got == static_cast<size_t>(-1)) Got = 0;
+	if(Got < ReadSize) Batch->Resize(Got);
+
+	BatchOffset = 0;
+	BatchEnd = Pos + Got;
+
+	if(Bytes > Got) Bytes = Got;
+	DataChunkPtr Ret = new DataChunkView(Batch, 0, Bytes);
+	BatchOffset = Bytes;
+
+	return Ret;
+}
+
+
+//! Get the position in the input file of the next byte to be returned by Read(), allowing for any batched data
+Position DV_DIF_EssenceSubParser::LogicalTell(FileHandle InFile)
+{
+	Position Pos = static_cast<Position>(FileTell(InFile));
+
+	if(Batch && (Pos == BatchEnd)) Pos -= static_cast<Position>(Batch->Size - BatchOffset);
+
+	return Pos;
+}
+
+
+//! Discard any batched data, moving the file pointer back to the next byte to be returned by Read()
+void DV_DIF_EssenceSubParser::DropBatch(FileHandle InFile)
+{
+	if(!Batch) return;
+
+	// Only move the file pointer if it is where we left it
+	if((static_cast<Position>(FileTell(InFile)) == BatchEnd) && (BatchOffset < Batch->Size))
+	{
+		FileSeek(InFile, BatchEnd - static_cast<Position>(Batch->Size - BatchOffset));
+	}
+
+	Batch = NULL;
+}
+
+
 //! Write a number of wrapping items from the specified stream to an MXF file
 /*! If frame or line mapping is used the parameter Count is used to
  *	determine how many items are read. In frame wrapping it is in
@@ -800,6 +878,9 @@ Length DV_DIF_EssenceSubParser::Write(FileHandle InFile, UInt32 Stream, MXFFileP
 
 	// Scan the stream and find out how many bytes to transfer
 	size_t Bytes = ReadInternal(InFile, Stream, Count);
+
+	// Any batched data must be re-read from the file
+	DropBatch(InFile);
 	Length Ret = static_cast<Length>(Bytes);
 
 	while(Bytes)
@@ -1325,7 +1406,11 @@ size_t DV_DIF_EssenceSubParser::ReadInternal(FileHandle InFile, UInt32 Stream, U
 	if((CachedDataSize != static_cast<size_t>(-1)) && CachedCount == Count) return CachedDataSize;
 
 	// Seek to the start of the essence on the first read
-	if(PictureNumber == 0) FileSeek(InFile, DIFStart);
+	if(PictureNumber == 0)
+	{
+		Batch = NULL;
+		FileSeek(InFile, DIFStart);
+	}
 
 	// Return anything remaining if clip wrapping
 	if((Count == 0) && (SelectedWrapping->ThisWrapType == WrappingOption::Clip))
@@ -1350,11 +1435,11 @@ size_t DV_DIF_EssenceSubParser::ReadInternal(FileHandle InFile, UInt32 Stream, U
 		PictureNumber += Count;
 
 		// If this would read beyond the end of the file stop at the end (don't test on AVI files)
-		if((DIFEnd != -1) && ((Ret + static_cast<Position>(FileTell(InFile))) > DIFEnd))
+		if((DIFEnd != -1) && ((Ret + LogicalTell(InFile)) > DIFEnd))
 		{
 			Position SeqSize = (150 * 80 * SeqCount);
 
-			Ret = DIFEnd - static_cast<Position>(FileTell(InFile));
+			Ret = DIFEnd - LogicalTell(InFile);
 			
 			// Fix for an incomplete frame at the end of the previous read
 			if(Ret < 0) Ret = 0;
@@ -1389,7 +1474,13 @@ size_t DV_DIF_EssenceSubParser::ReadInternal(FileHandle InFile, UInt32 Stream, U
 /*! \return true if the option was successfully set */
 bool DV_DIF_EssenceSubParser::SetOption(std::string Option, Int64 Param /*=0*/ )
 {
-		warning("DV_DIF_EssenceSubParser::SetOption(\"%s\", Param) not a known option\n", Option.c_str());
+	if(Option == "BatchFrames")
+	{
+		BatchFrames = (Param > 0) ? static_cast<unsigned int>(Param) : 0;
+		return true;
+	}
+
+	warning("DV_DIF_EssenceSubParser::SetOption(\"%s\", Param) not a known option\n", Option.c_str());
 
 	return false; 
 }
@@ -73,6 +73,13 @@ namespace mxflib
 		int BuffCount;										//!< Count of bytes still unread in Buffer
 		UInt8 *BuffPtr;										//!< Pointer to next byte to read from Buffer
 
+		// Batched reading of raw DIF files
+		unsigned int BatchFrames;							//!< Number of frames to read from the file at once, 0 or 1 to read each frame separately
+		DataChunkPoolPtr BatchPool;							//!< Pool of buffers for batches of frames
+		DataChunkPtr Batch;									//!< The current batch of frames, or NULL if none
+		size_t BatchOffset;									//!< Offset of the first byte in Batch not yet returned by Read()
+		Position BatchEnd;									//!< File position immediately following the data in Batch
+
 		MDObjectParent CurrentDescriptor;					//!< Pointer to the last essence descriptor we built
 															/*!< This is used as a quick-and-dirty check that we know how to process this source */
 
@@ -145,6 +152,10 @@ namespace mxflib
 			StreamNumber = 0;
 			Buffer = NULL;
 
+			BatchFrames = 0;
+			BatchOffset = 0;
+			BatchEnd = -1;
+
 			CachedDataSize = static_cast<size_t>(-1);
 			CachedCount = 0;
 
@@ -172,7 +183,14 @@ namespace mxflib
 		}
 
 		//! Examine the open file and return a list of essence descriptors
-		virtual EssenceStreamDescriptorList IdentifyEssence(FileHandle InFile);
+		virtual EssenceStreamDescriptorList IdentifyEssence(FileHandle InFile)
+		{
+			EssenceProbePtr Probe = new EssenceProbe(InFile);
+			return IdentifyEssence(Probe);
+		}
+
+		//! Examine a probed file and return a list of essence descriptors
+		virtual EssenceStreamDescriptorList IdentifyEssence(EssenceProbePtr &Probe);
 
 		//! Examine the open file and return the wrapping options known by this parser
 		virtual WrappingOptionList IdentifyWrappingOptions(FileHandle InFile, EssenceStreamDescriptor &Descriptor);
@@ -230,7 +248,10 @@ namespace mxflib
 		virtual Length Write(FileHandle InFile, UInt32 Stream, MXFFilePtr OutFile, UInt64 Count = 1/*, IndexTablePtr Index = NULL*/);
 
 		//! Set a parser specific option
-		/*! \return true if the option was successfully set */
+		/*! Options:
+		 *  - <b>BatchFrames</b> - read this many frames from raw DIF files at once, returning each frame from Read() as a view of the batch
+		 *  \return true if the option was successfully set
+		 */
 		virtual bool SetOption(std::string Option, Int64 Param = 0);
 
 		//! Get a unique name for this sub-parser
@@ -259,6 +280,15 @@ namespace mxflib
 		//! Read data from AVI wrapped essence
 		/*! Parses the list and chunk structure - can recurse */
 		DataChunkPtr AVIRead(FileHandle InFile, size_t Bytes);
+
+		//! Read data from raw DIF essence, a batch of frames at a time
+		DataChunkPtr BatchRead(FileHandle InFile, size_t Bytes);
+
+		//! Get the position in the input file of the next byte to be returned by Read(), allowing for any batched data
+		Position LogicalTell(FileHandle InFile);
+
+		//! Discard any batched data, moving the file pointer back to the next byte to be returned by Read()
+		void DropBatch(FileHandle InFile);
 	};
 
 
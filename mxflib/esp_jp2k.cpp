@@ -108,7 +108,7 @@ namespace
 
 //! Examine the open file and return a list of essence descriptors
 /*! \note This call will modify properties SampleRate, DataStart and DataSize */
-EssenceStreamDescriptorList mxflib::JP2K_EssenceSubParser::IdentifyEssence(FileHandle InFile)
+EssenceStreamDescriptorList mxflib::JP2K_EssenceSubParser::IdentifyEssence(EssenceProbePtr &Probe)
 {
 	// ".JP2" Signature box
 	const UInt8 JP2_Signature[] = { 0x00, 0x00, 0x00, 0x0c, 0x6a, 0x50, 0x20, 0x20, 0x0d, 0x0a, 0x87, 0x0a };
@@ -116,17 +116,15 @@ EssenceStreamDescriptorList mxflib::JP2K_EssenceSubParser::IdentifyEssence(FileH
 	// The first 4 bytes of a JPEG 2000 codestream are always the same and are a poor, but usable, signature
 	const UInt8 J2C_Signature[] = { 0xff, 0x4f, 0xff, 0x51 };
 
-	int BufferBytes;
-	UInt8 Buffer[12];
+	FileHandle InFile = Probe->GetFile();
 
 	EssenceStreamDescriptorList Ret;
 
-	// Read the first 12 bytes of the file to allow us to identify it
-	FileSeek(InFile, 0);
-	BufferBytes = (int)FileRead(InFile, Buffer, 12);
+	// Get the first 12 bytes of the file to allow us to identify it
+	const UInt8 *Buffer = Probe->GetHead(12);
 
 	// If the file is smaller than 12 bytes give up now!
-	if(BufferBytes < 12) return Ret;
+	if(!Buffer) return Ret;
 
 	// If the file doesn't start with the signature box if can't be a jp2 file
 	if( memcmp(Buffer, JP2_Signature, 12) != 0 )
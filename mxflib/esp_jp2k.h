@@ -141,7 +141,14 @@ namespace mxflib
 		}
 
 		//! Examine the open file and return a list of essence descriptors
-		virtual EssenceStreamDescriptorList IdentifyEssence(FileHandle InFile);
+		virtual EssenceStreamDescriptorList IdentifyEssence(FileHandle InFile)
+		{
+			EssenceProbePtr Probe = new EssenceProbe(InFile);
+			return IdentifyEssence(Probe);
+		}
+
+		//! Examine a probed file and return a list of essence descriptors
+		virtual EssenceStreamDescriptorList IdentifyEssence(EssenceProbePtr &Probe);
 
 		//! Examine the open file and return the wrapping options known by this parser
 		virtual WrappingOptionList IdentifyWrappingOptions(FileHandle InFile, EssenceStreamDescriptor &Descriptor);
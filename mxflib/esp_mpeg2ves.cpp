@@ -59,25 +59,30 @@ StringList MPEG2_VES_EssenceSubParser::HandledExtensions(void)
 /*! \note Valid MPEG2-VES files with > 510 extra zeroes before the first start code
  *	      will not be identifed!
  */
-EssenceStreamDescriptorList MPEG2_VES_EssenceSubParser::IdentifyEssence(FileHandle InFile)
+EssenceStreamDescriptorList MPEG2_VES_EssenceSubParser::IdentifyEssence(EssenceProbePtr &Probe)
 {
-	int BufferBytes;
-	UInt8 Buffer[1024*8];
-	UInt8 *BuffPtr;
+	FileHandle InFile = Probe->GetFile();
+	const UInt8 *BuffPtr;
 
 	EssenceStreamDescriptorList Ret;
 
-	// Read the first 512 bytes of the file to allow us to investigate it
-	FileSeek(InFile, 0);
-	BufferBytes = (int)FileRead(InFile, Buffer, 1024*8);
-	
 	// If the file is smaller than 16 bytes give up now!
-	if(BufferBytes < 16) return Ret;
+	const UInt8 *Buffer = Probe->GetHead(16);
+	if(!Buffer) return Ret;
 
 	// If the file doesn't start with two zeros the it doesn't start
 	// with a start code and so it can't be a valid MPEG2-VES file
 	if((Buffer[0] != 0) || (Buffer[1] != 0)) return Ret;
 
+	// Get up to the first 8k of the file to allow us to investigate it
+	int BufferBytes = 1024*8;
+	Buffer = Probe->GetHead(BufferBytes);
+	if(!Buffer)
+	{
+		BufferBytes = static_cast<int>(Probe->GetHeadSize());
+		Buffer = Probe->GetHead(BufferBytes);
+	}
+
 	// Scan for the first start code
 	BuffPtr = &Buffer[2];
 	int StartPos = 0;						//!< Start position of sequence header (when found)
@@ -0,0 +1,462 @@
+/*! \file	esp_rawvideo.cpp
+ *	\brief	Implementation of class that handles parsing of raw uncompressed video files
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#include "mxflib/mxflib.h"
+
+using namespace mxflib;
+
+#include <mxflib/esp_rawvideo.h>
+
+
+//! Local definitions
+namespace
+{
+	//! Modified UUID for raw video
+	const UInt8 RAW_VIDEO_Format[] = { 0x45, 0x54, 0x57, 0x62,  0xd6, 0xb4, 0x2e, 0x4e,  0xf3, 'R', 'A', 'W',  'V', 'I', 'D', 0x00 };
+
+	//! Picture essence coding for 8-bit 4:2:2 interleaved uncompressed video (UYVY)
+	const char *PictureEssenceCoding_UYVY = "060e2b34.0401010a.04010201.01020101";
+
+	//! Picture essence coding for 10-bit 4:2:2 interleaved uncompressed video (v210)
+	const char *PictureEssenceCoding_V210 = "060e2b34.0401010a.04010201.01020102";
+
+	//! Maximum number of unused frame buffers to keep in the pool
+	const size_t FramePoolDepth = 4;
+}
+
+
+//! Examine the open file and return a list of essence descriptors
+/*! As raw video cannot be recognised from its contents this only succeeds if the format and geometry have been
+ *  given as options with the filename
+ *	\note This call will modify properties FrameSize, DataStart and DataSize
+ */
+EssenceStreamDescriptorList mxflib::RAW_VIDEO_EssenceSubParser::IdentifyEssence(EssenceProbePtr &Probe)
+{
+	EssenceStreamDescriptorList Ret;
+
+	// We can only identify raw video when told what it is
+	if(Probe->GetOptions().empty()) return Ret;
+
+	// Apply the options to ourself
+	EssenceSubParserPtr This = this;
+	FileParser::SendParserOptions(This, Probe->GetOptions());
+
+	FrameSize = CalcFrameSize();
+	if(FrameSize == 0) return Ret;
+
+	if(NativeEditRate.Numerator == 0) NativeEditRate = Rational(25, 1);
+	UseEditRate = NativeEditRate;
+
+	// The options may have asked for some bytes to be skipped at the start of the file
+	Length FileBytes = Probe->GetFileSize();
+	if(FileBytes <= DataStart) return Ret;
+
+	// Only wrap whole frames
+	Length Frames = (FileBytes - DataStart) / FrameSize;
+	if(Frames == 0) return Ret;
+
+	DataSize = Frames * FrameSize;
+	if(DataSize != (FileBytes - DataStart))
+	{
+		warning("Raw video file is not a whole number of %s byte frames - the last %s bytes will be ignored\n",
+			    Int64toString(FrameSize).c_str(), Int64toString(FileBytes - DataStart - DataSize).c_str());
+	}
+
+	MDObjectPtr DescObj = BuildDescriptor();
+
+	// Quit here if we couldn't build an essence descriptor
+	if(!DescObj) return Ret;
+
+	// Build a descriptor with a zero ID (we only support single stream files)
+	EssenceStreamDescriptorPtr Descriptor = new EssenceStreamDescriptor;
+	Descriptor->ID = 0;
+	Descriptor->Description = "Raw uncompressed video essence";
+	Descriptor->SourceFormat.Set(RAW_VIDEO_Format);
+	Descriptor->Descriptor = DescObj;
+
+	// Record a pointer to the descriptor so we can check if we are asked to process this source
+	CurrentDescriptor = DescObj;
+
+	// Set the single descriptor
+	Ret.push_back(Descriptor);
+
+	return Ret;
+}
+
+
+//! Examine the open file and return the wrapping options known by this parser
+/*! \param InFile The open file to examine (if the descriptor does not contain enough info)
+ *	\param Descriptor An essence stream descriptor (as produced by function IdentifyEssence)
+ *		   of the essence stream requiring wrapping
+ *	\note The options should be returned in an order of preference as the caller is likely to use the first that it can support
+ */
+WrappingOptionList mxflib::RAW_VIDEO_EssenceSubParser::IdentifyWrappingOptions(FileHandle InFile, EssenceStreamDescriptor &Descriptor)
+{
+	// SMPTE 384M uncompressed pictures, with an undefined source mapping (0x7f)
+	UInt8 BaseUL[16] = { 0x06, 0x0e, 0x2b, 0x34, 0x04, 0x01, 0x01, 0x01, 0x0d, 0x01, 0x03, 0x01, 0x02, 0x05, 0x7f, 0x00 };
+	WrappingOptionList Ret;
+
+	// If the source format isn't raw video then we can't wrap the essence
+	if(memcmp(Descriptor.SourceFormat.GetValue(), RAW_VIDEO_Format, 16) != 0) return Ret;
+
+	// The identify step configures some member variables so we can only continue if we just identified this very source
+	if((!CurrentDescriptor) || (Descriptor.Descriptor != CurrentDescriptor)) return Ret;
+
+	// Build a WrappingOption for frame wrapping
+	WrappingOptionPtr FrameWrap = new WrappingOption;
+
+	FrameWrap->Handler = this;							// Set us as the handler
+	FrameWrap->Description = "SMPTE 384M frame wrapping of raw uncompressed video";
+
+	BaseUL[15] = 0x01;									// Frame wrapping
+	FrameWrap->Name = "frame";							// Set the wrapping name
+	FrameWrap->WrappingUL = new UL(BaseUL);				// Set the UL
+	FrameWrap->GCEssenceType = 0x15;					// GC Picture wrapping type
+	FrameWrap->GCElementType = 0x02;					// Frame wrapped uncompressed picture element
+	FrameWrap->ThisWrapType = WrappingOption::Frame;	// Frame wrapping
+	FrameWrap->CanSlave = true;							// Can use non-native edit rate
+	FrameWrap->CanIndex = false;						// We do not need to VBR index this essence
+	FrameWrap->CBRIndex = true;							// This essence uses CBR indexing
+	FrameWrap->BERSize = 4;								// Frame size (and so CBR edit unit size) requires a fixed BER size
+
+	// Build a WrappingOption for clip wrapping
+	WrappingOptionPtr ClipWrap = new WrappingOption;
+
+	ClipWrap->Handler = this;							// Set us as the handler
+	ClipWrap->Description = "SMPTE 384M clip wrapping of raw uncompressed video";
+
+	BaseUL[15] = 0x02;									// Clip wrapping
+	ClipWrap->Name = "clip";							// Set the wrapping name
+	ClipWrap->WrappingUL = new UL(BaseUL);				// Set the UL
+	ClipWrap->GCEssenceType = 0x15;						// GC Picture wrapping type
+	ClipWrap->GCElementType = 0x03;						// Clip wrapped uncompressed picture element
+	ClipWrap->ThisWrapType = WrappingOption::Clip;		// Clip wrapping
+	ClipWrap->CanSlave = true;							// Can use non-native edit rate
+	ClipWrap->CanIndex = false;							// We do not need to VBR index this essence
+	ClipWrap->CBRIndex = true;							// This essence uses CBR indexing
+	ClipWrap->BERSize = 0;								// No BER size forcing
+
+	// Add the two wrapping options
+	// Note: Frame wrapping is preferred
+	Ret.push_back(FrameWrap);
+	Ret.push_back(ClipWrap);
+
+	return Ret;
+}
+
+
+//! Get BytesPerEditUnit, which is constant for raw video
+UInt32 mxflib::RAW_VIDEO_EssenceSubParser::GetBytesPerEditUnit(UInt32 KAGSize /*=1*/)
+{
+	UInt32 Ret = static_cast<UInt32>(FrameSize);
+
+	if(Ret && SelectedWrapping && (SelectedWrapping->ThisWrapType == WrappingOption::Frame))
+	{
+		// Add the key and 4-byte BER length (see GetBERSize())
+		Ret += 16 + 4;
+
+		// Adjust for whole KAGs if required
+		if(KAGSize > 1)
+		{
+			// Work out how much short of the next KAG boundary we would be
+			UInt32 Remainder = Ret % KAGSize;
+			if(Remainder) Remainder = KAGSize - Remainder;
+
+			// Round up to the start of the next KAG
+			Ret += Remainder;
+
+			// If there is not enough space to fit a filler in the remaining space an extra KAG will be required
+			// DRAGONS: For very small KAGSizes we may need to add several KAGs
+			while((Remainder > 0) && (Remainder < 17))
+			{
+				Ret += KAGSize;
+				Remainder += KAGSize;
+			}
+		}
+	}
+
+	return Ret;
+}
+
+
+//! Read a number of wrapping items from the specified stream and return them in a data chunk
+/*! If frame or line mapping is used the parameter Count is used to
+ *	determine how many items are read. In frame wrapping it is in
+ *	units of EditRate, as specified in the call to Use(), which may
+ *  not be the frame rate of this essence
+ *	\note The data is read directly into a buffer from a pool that is re-used as soon as the previous chunks are released
+ */
+DataChunkPtr mxflib::RAW_VIDEO_EssenceSubParser::Read(FileHandle InFile, UInt32 Stream, UInt64 Count /*=1*/)
+{
+	// Find out how many bytes to read
+	size_t Bytes = ReadInternal(InFile, Stream, Count);
+
+	// Clear the cached size
+	CachedDataSize = static_cast<size_t>(-1);
+
+	// Allocate the pool on first use, sized for the usual single-frame read
+	if(!FramePool || (FramePool->GetBufferSize() != FrameSize)) FramePool = new DataChunkPool(FrameSize, FramePoolDepth);
+
+	DataChunkPtr Ret = FramePool->GetChunk(Bytes);
+	if(Bytes == 0) return Ret;
+
+	// Read the data
+	FileSeek(InFile, CurrentPos);
+	size_t BytesRead = FileRead(InFile, Ret->Data, Bytes);
+	if(BytesRead != Bytes) Ret->Resize(BytesRead);
+
+	// Update the file pointer and picture count
+	CurrentPos += BytesRead;
+	PictureNumber += BytesRead / FrameSize;
+
+	return Ret;
+}
+
+
+//! Write a number of wrapping items from the specified stream to an MXF file
+/*! If frame or line mapping is used the parameter Count is used to
+ *	determine how many items are read. In frame wrapping it is in
+ *	units of EditRate, as specified in the call to Use(), which may
+ *  not be the frame rate of this essence stream
+ *	\note This is the only safe option for clip wrapping
+ *	\return Count of bytes transferred
+ */
+Length mxflib::RAW_VIDEO_EssenceSubParser::Write(FileHandle InFile, UInt32 Stream, MXFFilePtr OutFile, UInt64 Count /*=1*/)
+{
+	// Scan the stream and find out how many bytes to transfer
+	size_t Bytes = ReadInternal(InFile, Stream, Count);
+	Length Ret = static_cast<Length>(Bytes);
+
+	// Clear the cached size
+	CachedDataSize = static_cast<size_t>(-1);
+
+	if(!FramePool || (FramePool->GetBufferSize() != FrameSize)) FramePool = new DataChunkPool(FrameSize, FramePoolDepth);
+
+	// Transfer a frame at a time
+	DataChunkPtr Buffer = FramePool->GetChunk(FrameSize);
+
+	FileSeek(InFile, CurrentPos);
+	while(Bytes)
+	{
+		size_t ChunkSize = (Bytes < FrameSize) ? Bytes : FrameSize;
+
+		size_t BytesRead = FileRead(InFile, Buffer->Data, ChunkSize);
+		OutFile->Write(Buffer->Data, BytesRead);
+
+		CurrentPos += BytesRead;
+		PictureNumber += BytesRead / FrameSize;
+
+		if(BytesRead != ChunkSize)
+		{
+			Ret -= (Bytes - BytesRead);
+			break;
+		}
+
+		Bytes -= ChunkSize;
+	}
+
+	return Ret;
+}
+
+
+//! Set a source type or parser specific option
+/*! \return true if the option was successfully set */
+bool mxflib::RAW_VIDEO_EssenceSubParser::SetOption(std::string Option, Int64 Param /*=0*/)
+{
+	const char *Opt = Option.c_str();
+
+	if(strcasecmp(Opt, "UYVY") == 0) Format = FormatUYVY;
+	else if(strcasecmp(Opt, "v210") == 0) Format = FormatV210;
+	else if(strcasecmp(Opt, "YUV422P") == 0) Format = FormatYUV422P;
+	else if((strcasecmp(Opt, "YUV420P") == 0) || (strcasecmp(Opt, "I420") == 0)) Format = FormatYUV420P;
+	else if(strcasecmp(Opt, "Width") == 0) Width = static_cast<UInt32>(Param);
+	else if(strcasecmp(Opt, "Height") == 0) Height = static_cast<UInt32>(Param);
+	else if(strcasecmp(Opt, "RateNum") == 0) NativeEditRate.Numerator = static_cast<Int32>(Param);
+	else if(strcasecmp(Opt, "RateDen") == 0) NativeEditRate.Denominator = static_cast<Int32>(Param);
+	else if(strcasecmp(Opt, "Interlaced") == 0) Interlaced = true;
+	else if(strcasecmp(Opt, "AspectNum") == 0) AspectNum = static_cast<UInt32>(Param);
+	else if(strcasecmp(Opt, "AspectDen") == 0) AspectDen = static_cast<UInt32>(Param);
+	else if(strcasecmp(Opt, "FrameSize") == 0) ForcedFrameSize = static_cast<size_t>(Param);
+	else if(strcasecmp(Opt, "Offset") == 0) DataStart = static_cast<Position>(Param);
+	else
+	{
+		// DRAGONS: Options are offered to us for every file that has options, so unknown options are not an error
+		debug("RAW_VIDEO_EssenceSubParser::SetOption(\"%s\", %s) not a known option\n", Opt, Int64toString(Param).c_str());
+		return false;
+	}
+
+	return true;
+}
+
+
+//! Calculate the size of each frame from the format and geometry
+/*! \return The frame size in bytes, or zero if the geometry is incomplete or invalid */
+size_t mxflib::RAW_VIDEO_EssenceSubParser::CalcFrameSize(void) const
+{
+	if((Width == 0) || (Height == 0)) return 0;
+
+	// All supported formats have horizontally sub-sampled chroma
+	if(Width & 1) return 0;
+
+	size_t Ret;
+	switch(Format)
+	{
+		case FormatUYVY:
+		case FormatYUV422P:
+			Ret = static_cast<size_t>(Width) * Height * 2;
+			break;
+
+		case FormatV210:
+			// Groups of 6 pixels are packed in 16 bytes, and each line is padded to a multiple of 128 bytes (48 pixels)
+			Ret = static_cast<size_t>((Width + 47) / 48) * 128 * Height;
+			break;
+
+		case FormatYUV420P:
+			if(Height & 1) return 0;
+			Ret = (static_cast<size_t>(Width) * Height * 3) / 2;
+			break;
+
+		default:
+			return 0;
+	}
+
+	if(ForcedFrameSize)
+	{
+		if(ForcedFrameSize < Ret)
+		{
+			error("Raw video FrameSize option of %s bytes is smaller than the %s bytes required for the frame geometry\n",
+				  Int64toString(ForcedFrameSize).c_str(), Int64toString(Ret).c_str());
+			return 0;
+		}
+
+		Ret = ForcedFrameSize;
+	}
+
+	return Ret;
+}
+
+
+//! Build an essence descriptor from the format and geometry options
+MDObjectPtr mxflib::RAW_VIDEO_EssenceSubParser::BuildDescriptor(void)
+{
+	MDObjectPtr Ret = new MDObject(CDCIEssenceDescriptor_UL);
+	if(!Ret) return Ret;
+
+	/* File Descriptor items */
+
+	MDObjectPtr Ptr = Ret->AddChild(SampleRate_UL);
+	if(Ptr)
+	{
+		Ptr->SetInt("Numerator", NativeEditRate.Numerator);
+		Ptr->SetInt("Denominator", NativeEditRate.Denominator);
+	}
+
+	/* Picture Essence Descriptor Items */
+
+	if(Format == FormatUYVY) Ret->SetString(PictureEssenceCoding_UL, PictureEssenceCoding_UYVY);
+	else if(Format == FormatV210) Ret->SetString(PictureEssenceCoding_UL, PictureEssenceCoding_V210);
+
+	Ret->SetUInt(FrameLayout_UL, Interlaced ? MixedFields : FullFrame);
+	if(Interlaced) Ret->SetUInt(FieldDominance_UL, 1);
+
+	Ret->SetUInt(StoredWidth_UL, Width);
+	Ret->SetUInt(StoredHeight_UL, Height);
+	Ret->SetUInt(SampledWidth_UL, Width);
+	Ret->SetUInt(SampledHeight_UL, Height);
+	Ret->SetUInt(DisplayWidth_UL, Width);
+	Ret->SetUInt(DisplayHeight_UL, Height);
+
+	MDObjectPtr VLMItem = Ret->AddChild(VideoLineMap_UL);
+	if(VLMItem)
+	{
+		VLMItem->Resize(2);
+		VLMItem[0]->SetInt(1);
+		VLMItem[1]->SetInt(Interlaced ? static_cast<Int32>(Height / 2) + 1 : 0);
+	}
+
+	MDObjectPtr AspectItem = Ret->AddChild(AspectRatio_UL);
+	if(AspectItem)
+	{
+		if(AspectNum && AspectDen)
+		{
+			AspectItem->SetInt("Numerator", AspectNum);
+			AspectItem->SetInt("Denominator", AspectDen);
+		}
+		else
+		{
+			AspectItem->SetInt("Numerator", Width);
+			AspectItem->SetInt("Denominator", Height);
+		}
+	}
+
+	/* CDCI Descriptor Items */
+
+	Ret->SetUInt(ComponentDepth_UL, (Format == FormatV210) ? 10 : 8);
+	Ret->SetUInt(HorizontalSubsampling_UL, 2);
+	Ret->SetUInt(VerticalSubsampling_UL, (Format == FormatYUV420P) ? 2 : 1);
+
+	return Ret;
+}
+
+
+//! Calculate how many bytes to transfer for the given edit unit count
+/*! This is simple arithmetic as every frame is the same size
+ */
+size_t mxflib::RAW_VIDEO_EssenceSubParser::ReadInternal(FileHandle InFile, UInt32 Stream, UInt64 Count)
+{
+	// Return the cached value if we have not yet used it
+	if((CachedDataSize != static_cast<size_t>(-1)) && (CachedCount == Count)) return CachedDataSize;
+
+	// Correct the start if we need to
+	if(CurrentPos == 0) CurrentPos = DataStart;
+
+	// Work out how many bytes are left
+	Length Max = DataStart + DataSize - CurrentPos;
+	if(Max < 0) Max = 0;
+
+	Length Ret;
+
+	// Return everything that is left if in "unspecified" clip wrapping
+	if((Count == 0) && SelectedWrapping && (SelectedWrapping->ThisWrapType == WrappingOption::Clip)) Ret = Max;
+	else Ret = static_cast<Length>(Count * FrameSize);
+
+	// Return no more than the maximum bytes available
+	if(Ret > Max) Ret = Max;
+
+	// Validate the size
+	if((sizeof(size_t) < 8) && (Ret > 0xffffffff))
+	{
+		error("This edit unit > 4GBytes, but this platform can only handle <= 4GByte chunks\n");
+		Ret = 0;
+	}
+
+	// Store so we don't have to calculate if called again without reading
+	CachedDataSize = static_cast<size_t>(Ret);
+	CachedCount = Count;
+
+	return CachedDataSize;
+}
@@ -0,0 +1,275 @@
+/*! \file	esp_rawvideo.h
+ *	\brief	Definition of class that handles parsing of raw uncompressed video files
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#ifndef MXFLIB__ESP_RAWVIDEO_H
+#define MXFLIB__ESP_RAWVIDEO_H
+
+
+namespace mxflib
+{
+	//! Sub-parser for headerless files of fixed-size uncompressed video frames
+	/*! As raw video has no header the frame geometry must be given as parser options with the filename, for example:
+	 *  <tt>clip.yuv{v210;Width=1920;Height=1080;RateNum=25}</tt>
+	 *
+	 *  Options:
+	 *  - <b>UYVY</b>, <b>v210</b>, <b>YUV422P</b> or <b>YUV420P</b> - the pixel format (one is required)
+	 *  - <b>Width</b> and <b>Height</b> - the frame size in pixels (required)
+	 *  - <b>RateNum</b> and <b>RateDen</b> - the native frame rate (default 25/1)
+	 *  - <b>Interlaced</b> - each frame holds two interleaved fields
+	 *  - <b>AspectNum</b> and <b>AspectDen</b> - the display aspect ratio (default is square pixels)
+	 *  - <b>FrameSize</b> - the number of bytes per frame, if frames are padded beyond the size implied by the format
+	 *  - <b>Offset</b> - the number of bytes of header to skip at the start of each file
+	 *
+	 *  The data is never examined: every frame is the same size, so reads are a single seek and read into a pooled buffer.
+	 */
+	class RAW_VIDEO_EssenceSubParser : public EssenceSubParserBase
+	{
+	public:
+		//! Supported pixel formats
+		enum RawFormat
+		{
+			FormatUnknown = 0,								//!< No format has been specified
+			FormatUYVY,										//!< 8-bit 4:2:2 interleaved Cb Y Cr Y
+			FormatV210,										//!< 10-bit 4:2:2 interleaved, packed 3 samples per 32-bit word, lines padded to 128 bytes
+			FormatYUV422P,									//!< 8-bit 4:2:2 planar Y, Cb, Cr
+			FormatYUV420P									//!< 8-bit 4:2:0 planar Y, Cb, Cr
+		};
+
+	protected:
+		RawFormat Format;									//!< The pixel format
+		UInt32 Width;										//!< Frame width in pixels
+		UInt32 Height;										//!< Frame height in pixels (of the whole frame if interlaced)
+		Rational NativeEditRate;							//!< The frame rate of this essence
+		bool Interlaced;									//!< True if each frame holds two interleaved fields
+		UInt32 AspectNum;									//!< Display aspect ratio numerator, or zero for square pixels
+		UInt32 AspectDen;									//!< Display aspect ratio denominator, or zero for square pixels
+		size_t ForcedFrameSize;								//!< The number of bytes per frame if given as an option, else zero
+
+		Rational UseEditRate;								//!< The edit rate to use for wrapping this essence
+		size_t FrameSize;									//!< The number of bytes in each frame
+
+		Position PictureNumber;								//!< The number of pictures read so far
+
+		Position DataStart;									//!< Start of essence data within the file
+		Length DataSize;									//!< Total size of the essence data within the file (a whole number of frames)
+		Position CurrentPos;								//!< Current position in the input file (in bytes)
+															/*!< A value of 0 means the start of the data chunk,
+															 *	 any other value is that position within the whole file.
+															 *	 This means that a full rewind can be achieved by setting CurrentPos = 0
+															 *	 \note Other functions may move the file
+															 *         pointer between calls to our functions */
+
+		size_t CachedDataSize;								//!< The size of the next data to be read, or (size_t)-1 if not known
+		UInt64 CachedCount;									//!< The number of wrapping units that CachedDataSize relates to
+
+		DataChunkPoolPtr FramePool;							//!< Pool of frame buffers, shared with parsers for later files of a sequence
+
+		MDObjectParent CurrentDescriptor;					//!< Pointer to the last essence descriptor we built
+															/*!< This is used as a quick-and-dirty check that we know how to process this source */
+
+	public:
+		//! Class for EssenceSource objects for parsing/sourcing raw video essence
+		class ESP_EssenceSource : public EssenceSubParserBase::ESP_EssenceSource
+		{
+		public:
+			//! Construct and initialise for essence parsing/sourcing
+			ESP_EssenceSource(EssenceSubParserPtr TheCaller, FileHandle InFile, UInt32 UseStream, UInt64 Count = 1)
+				: EssenceSubParserBase::ESP_EssenceSource(TheCaller, InFile, UseStream, Count)
+			{
+			};
+
+			//! Get the size of the essence data in bytes
+			/*! \note There is intentionally no support for an "unknown" response
+			 */
+			virtual size_t GetEssenceDataSize(void)
+			{
+				RAW_VIDEO_EssenceSubParser *pCaller = SmartPtr_Cast(Caller, RAW_VIDEO_EssenceSubParser);
+				return pCaller->ReadInternal(File, Stream, RequestedCount);
+			};
+
+			//! Get the next "installment" of essence data
+			/*! \return Pointer to a data chunk holding the next data or a NULL pointer when no more remains
+			 *	\note If there is more data to come but it is not currently available the return value will be a pointer to an empty data chunk
+			 *	\note If Size = 0 the object will decide the size of the chunk to return
+			 *	\note On no account will the returned chunk be larger than MaxSize (if MaxSize > 0)
+			 */
+			virtual DataChunkPtr GetEssenceData(size_t Size = 0, size_t MaxSize = 0)
+			{
+				return BaseGetEssenceData(Size, MaxSize);
+			}
+
+			//! Get the preferred BER length size for essence KLVs written from this source, 0 for auto
+			virtual int GetBERSize(void)
+			{
+				RAW_VIDEO_EssenceSubParser *pCaller = SmartPtr_Cast(Caller, RAW_VIDEO_EssenceSubParser);
+
+				if(pCaller->SelectedWrapping->ThisWrapType == WrappingOption::Clip) return 8;
+				return 4;
+			}
+		};
+
+		// Give our essence source class privilaged access
+		friend class RAW_VIDEO_EssenceSubParser::ESP_EssenceSource;
+
+	public:
+		RAW_VIDEO_EssenceSubParser()
+		{
+			Format = FormatUnknown;
+			Width = 0;
+			Height = 0;
+			NativeEditRate = Rational(25, 1);
+			Interlaced = false;
+			AspectNum = 0;
+			AspectDen = 0;
+			ForcedFrameSize = 0;
+
+			UseEditRate = NativeEditRate;
+			FrameSize = 0;
+
+			PictureNumber = 0;
+			DataStart = 0;
+			DataSize = 0;
+			CurrentPos = 0;
+
+			CachedDataSize = static_cast<size_t>(-1);
+			CachedCount = 0;
+		}
+
+		//! Build a new parser of this type and return a pointer to it
+		/*! The new parser shares our frame buffer pool, so that a sequence of one-frame files does not need new buffers for each file */
+		virtual EssenceSubParserPtr NewParser(void) const
+		{
+			RAW_VIDEO_EssenceSubParser *Ret = new RAW_VIDEO_EssenceSubParser;
+			Ret->FramePool = FramePool;
+			return Ret;
+		}
+
+		//! Report the extensions of files this sub-parser is likely to handle
+		virtual StringList HandledExtensions(void)
+		{
+			StringList ExtensionList;
+
+			ExtensionList.push_back("YUV");
+			ExtensionList.push_back("UYVY");
+			ExtensionList.push_back("V210");
+
+			return ExtensionList;
+		}
+
+		//! Examine the open file and return a list of essence descriptors
+		virtual EssenceStreamDescriptorList IdentifyEssence(FileHandle InFile)
+		{
+			EssenceProbePtr Probe = new EssenceProbe(InFile);
+			return IdentifyEssence(Probe);
+		}
+
+		//! Examine a probed file and return a list of essence descriptors
+		virtual EssenceStreamDescriptorList IdentifyEssence(EssenceProbePtr &Probe);
+
+		//! Examine the open file and return the wrapping options known by this parser
+		virtual WrappingOptionList IdentifyWrappingOptions(FileHandle InFile, EssenceStreamDescriptor &Descriptor);
+
+		//! Set a wrapping option for future Read and Write calls
+		virtual void Use(UInt32 Stream, WrappingOptionPtr &UseWrapping)
+		{
+			SelectedWrapping = UseWrapping;
+
+			CurrentPos = 0;
+		}
+
+		//! Set a non-native edit rate
+		/*! Each frame is always one edit unit, so this simply changes the rate at which the frames are labelled
+		 *	\return true if this rate is acceptable
+		 */
+		virtual bool SetEditRate(Rational EditRate)
+		{
+			if(EditRate.Numerator == 0) return false;
+
+			UseEditRate = EditRate;
+
+			// Pretend that the essence is sampled at whatever rate we are wrapping at
+			MDObjectPtr Ptr;
+			if(CurrentDescriptor) Ptr = CurrentDescriptor->AddChild(SampleRate_UL);
+			if(Ptr)
+			{
+				Ptr->SetInt("Numerator", UseEditRate.Numerator);
+				Ptr->SetInt("Denominator", UseEditRate.Denominator);
+			}
+
+			return true;
+		}
+
+		//! Get the current edit rate
+		virtual Rational GetEditRate(void) { return UseEditRate; }
+
+		//! Get the preferred edit rate, which is the native frame rate
+		virtual Rational GetPreferredEditRate(void) { return NativeEditRate; }
+
+		//! Get BytesPerEditUnit, which is constant for raw video
+		virtual UInt32 GetBytesPerEditUnit(UInt32 KAGSize = 1);
+
+		//! Get the current position in SetEditRate() sized edit units
+		virtual Position GetCurrentPosition(void) { return PictureNumber; }
+
+		//! Read a number of wrapping items from the specified stream and return them in a data chunk
+		virtual DataChunkPtr Read(FileHandle InFile, UInt32 Stream, UInt64 Count = 1);
+
+		//! Build an EssenceSource to read a number of wrapping items from the specified stream
+		virtual EssenceSourcePtr GetEssenceSource(FileHandle InFile, UInt32 Stream, UInt64 Count = 1)
+		{
+			return new ESP_EssenceSource(this, InFile, Stream, Count);
+		};
+
+		//! Write a number of wrapping items from the specified stream to an MXF file
+		virtual Length Write(FileHandle InFile, UInt32 Stream, MXFFilePtr OutFile, UInt64 Count = 1);
+
+		//! Set a parser specific option
+		/*! \return true if the option was successfully set */
+		virtual bool SetOption(std::string Option, Int64 Param = 0);
+
+		//! Get a unique name for this sub-parser
+		/*! The name must be all lower case, and must be unique.
+		 *  The recommended name is the part of the filename of the parser header after "esp_" and before the ".h".
+		 *  If the parser has no name return "" (however this will prevent named wrapping option selection for this sub-parser)
+		 */
+		virtual std::string GetParserName(void) const { return "rawvideo"; }
+
+
+	protected:
+		//! Calculate the size of each frame from the format and geometry
+		/*! \return The frame size in bytes, or zero if the geometry is incomplete or invalid */
+		size_t CalcFrameSize(void) const;
+
+		//! Build an essence descriptor from the format and geometry options
+		MDObjectPtr BuildDescriptor(void);
+
+		//! Calculate how many bytes to transfer for the given edit unit count
+		size_t ReadInternal(FileHandle InFile, UInt32 Stream, UInt64 Count);
+	};
+}
+
+#endif // MXFLIB__ESP_RAWVIDEO_H
@@ -45,19 +45,18 @@ namespace
 
 //! Examine the open file and return a list of essence descriptors
 /*! \note This call will modify properties SampleRate, DataStart and DataSize */
-EssenceStreamDescriptorList mxflib::TEMPLATE_EssenceSubParser::IdentifyEssence(FileHandle InFile)
+EssenceStreamDescriptorList mxflib::TEMPLATE_EssenceSubParser::IdentifyEssence(EssenceProbePtr &Probe)
 {
-	int BufferBytes;
-	UInt8 Buffer[ <xxx> ];
+	FileHandle InFile = Probe->GetFile();
 
 	EssenceStreamDescriptorList Ret;
 
-	// Read the first <xxx> bytes of the file to allow us to identify it
-	FileSeek(InFile, 0);
-	BufferBytes = (int)FileRead(InFile, Buffer, <xxx>);
+	// Get the first <xxx> bytes of the file to allow us to identify it
+	// DRAGONS: These bytes are shared with other sub-parsers, so use the probe rather than reading the file directly
+	const UInt8 *Buffer = Probe->GetHead( <xxx> );
 
 	// If the file is smaller than <xxx> bytes give up now!
-	if(BufferBytes < <xxx>) return Ret;
+	if(!Buffer) return Ret;
 
 	// If the file doesn't start with <...> if can't be a <File Type> file
 	if( <Not our type> ) return Ret;
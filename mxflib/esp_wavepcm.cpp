@@ -45,19 +45,17 @@ namespace
 
 //! Examine the open file and return a list of essence descriptors
 /*! \note This call will modify properties SampleRate, DataStart and DataSize */
-EssenceStreamDescriptorList mxflib::WAVE_PCM_EssenceSubParser::IdentifyEssence(FileHandle InFile)
+EssenceStreamDescriptorList mxflib::WAVE_PCM_EssenceSubParser::IdentifyEssence(EssenceProbePtr &Probe)
 {
-	int BufferBytes;
-	UInt8 Buffer[12];
+	FileHandle InFile = Probe->GetFile();
 
 	EssenceStreamDescriptorList Ret;
 
-	// Read the first 12 bytes of the file to allow us to identify it
-	FileSeek(InFile, 0);
-	BufferBytes = (int)FileRead(InFile, Buffer, 12);
+	// Get the first 12 bytes of the file to allow us to identify it
+	const UInt8 *Buffer = Probe->GetHead(12);
 
 	// If the file is smaller than 12 bytes give up now!
-	if(BufferBytes < 12) return Ret;
+	if(!Buffer) return Ret;
 
 	// If the file doesn't start with "RIFF" if can't be a wave file
 	if((Buffer[0] != 'R') || (Buffer[1] != 'I') || (Buffer[2] != 'F') || (Buffer[3] != 'F')) return Ret;
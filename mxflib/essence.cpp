@@ -50,10 +50,57 @@ namespace
 			return GCEssenceKey;
 	}
 
-	//! A list of pointers to alternative essence key roots to treat as GC keys
+	//! A key pattern that is compared as two 64-bit words, with a mask selecting which bytes are compared
+	/*! The words are loaded from the key bytes in memory order, so the same masks work whatever the platform byte order */
+	struct GCKeyMask
+	{
+		UInt64 Value[2];								//!< The bytes to be matched, with zero in all wildcard bytes
+		UInt64 Mask[2];									//!< 0xff in each byte to be compared, zero in all wildcard bytes
+
+		//! Build a mask from a key and a string of 16 characters with 'x' for each byte to compare
+		GCKeyMask(const UInt8 *Key, const char *Compare)
+		{
+			UInt8 KeyBytes[16];
+			UInt8 MaskBytes[16];
+
+			int i;
+			for(i=0; i<16; i++)
+			{
+				MaskBytes[i] = (Compare[i] == 'x') ? 0xff : 0x00;
+				KeyBytes[i] = Key[i] & MaskBytes[i];
+			}
+
+			memcpy(Value, KeyBytes, 16);
+			memcpy(Mask, MaskBytes, 16);
+		}
+
+		//! Does a key, loaded as two words, match this mask?
+		bool Matches(const UInt64 *Key) const
+		{
+			return ((Key[0] & Mask[0]) == Value[0]) && ((Key[1] & Mask[1]) == Value[1]);
+		}
+	};
+
+	//! A table of key masks
+	typedef std::vector<GCKeyMask> GCKeyMaskTable;
+
+	//! Does a key, loaded as two words, match any mask in a table?
+	bool MatchesAny(const GCKeyMaskTable &Table, const UInt64 *Key)
+	{
+		GCKeyMaskTable::const_iterator it = Table.begin();
+		while(it != Table.end())
+		{
+			if((*it).Matches(Key)) return true;
+			it++;
+		}
+
+		return false;
+	}
+
+	//! Alternative essence key roots to treat as GC keys, folded into masks
 	/*! This allows private or experimental essence keys to be treated as standard GC keys when reading 
 	 */
-	DataChunkList GCEssenceKeyAlternatives;
+	GCKeyMaskTable GCEssenceKeyAlternatives;
 
 
 	//! The standard Generic Container system item key root
@@ -68,10 +115,42 @@ namespace
 									  0x0d, 0x01, 0x05, 0x00,
 									  0x00, 0x00, 0x00, 0x00  };
 
-	//! A list of pointers to alternative system item key roots to treat as GC keys
+	//! Alternative system item key roots to treat as GC keys, folded into masks
 	/*! This allows private or experimental system item keys to be treated as standard GC keys when reading 
 	 */
-	DataChunkList GCSystemKeyAlternatives;
+	GCKeyMaskTable GCSystemKeyAlternatives;
+
+	//! The KLV Fill key (version 1 only, as tested by the GCReader)
+	const UInt8 GCFillerKey[16] =	{ 0x06, 0x0E, 0x2B, 0x34,
+									  0x01, 0x01, 0x01, 0x01,
+									  0x03, 0x01, 0x02, 0x10,
+									  0x01, 0x00, 0x00, 0x00 };
+
+	//! The AS-DCP encrypted triplet key
+	const UInt8 GCEncryptedKey[16] = { 0x06, 0x0E, 0x2B, 0x34,
+									   0x02, 0x04, 0x01, 0x07,
+									   0x0d, 0x01, 0x03, 0x01,
+									   0x02, 0x7e, 0x01, 0x00 };
+
+	// Precompiled masks for the standard keys
+	// DRAGONS: The version number byte (byte 8) is not compared for GC keys, and for system items byte 6 (set or pack kind) is also skipped
+	const GCKeyMask GCElementMask(GCEssenceKey,		"xxxxxxx-xxx-----");
+	const GCKeyMask GCSystemMask(GCSystemKey,		"xxxxx-x-xxx-----");
+	const GCKeyMask GStreamMask(GStreamKey,			"xxxxxxx-xxx-----");
+	const GCKeyMask GCFillerMask(GCFillerKey,		"xxxxxxxxxxxxxxxx");
+	const GCKeyMask GCEncryptedMask(GCEncryptedKey,	"xxxxxxxxxxxxxxxx");
+
+	//! Is a key, loaded as two words, a GC essence element key?
+	inline bool IsGCElementKey(const UInt64 *Key)
+	{
+		return GCElementMask.Matches(Key) || ((!GCEssenceKeyAlternatives.empty()) && MatchesAny(GCEssenceKeyAlternatives, Key));
+	}
+
+	//! Is a key, loaded as two words, a GC system item key?
+	inline bool IsGCSystemKey(const UInt64 *Key)
+	{
+		return GCSystemMask.Matches(Key) || ((!GCSystemKeyAlternatives.empty()) && MatchesAny(GCSystemKeyAlternatives, Key));
+	}
 }
 
 
@@ -620,7 +699,8 @@ void GCWriter::AddEssenceData(GCStreamID ID, EssenceSourcePtr Source, bool FastC
 	WB.Source = Source;
 	WB.KLVSource = NULL;
 	WB.Stream = BStream;
-	WB.FastClipWrap = FastClipWrap;
+	// DRAGONS: Fast clip wrapping goes back to write the length after the value, which can't be done in a stream
+	WB.FastClipWrap = FastClipWrap && !LinkedFile->IsStreaming();
 	WB.LenSize = Stream->LenSize;
 
 	// Add the index data
@@ -700,7 +780,8 @@ void GCWriter::AddEssenceData(GCStreamID ID, KLVObjectPtr Source, bool FastClipW
 	WB.Buffer = Buffer;
 	WB.KLVSource = Source;
 	WB.Stream = BStream;
-	WB.FastClipWrap = FastClipWrap;
+	// DRAGONS: Fast clip wrapping goes back to write the length after the value, which can't be done in a stream
+	WB.FastClipWrap = FastClipWrap && !LinkedFile->IsStreaming();
 	WB.LenSize = Stream->LenSize;
 
 	// Add the index data
@@ -866,6 +947,9 @@ GCWriter::~GCWriter()
 /*! \note It is important that any changes to this function are propogated to CalcWriteSize() */
 void GCWriter::Flush(void)
 {
+	// Time spent getting the essence from its sources is removed from this and counted as parsing
+	StageTimer WriteTimer(StageWrite);
+
 	//! Stream offset of the first byte of the key for this KLV - this will later be turned into the size of the (Key+Length) once they are written
 	Position KLSize = StreamOffset;
 
@@ -956,6 +1040,7 @@ void GCWriter::Flush(void)
 			}
 			else 
 			{
+				StageTimer ParseTimer(StageParse, &WriteTimer);
 				Size = (*it).second.Source->GetEssenceDataSize();
 				
 				// Increment the EssenceData count in the source stream
@@ -999,8 +1084,12 @@ void GCWriter::Flush(void)
 					}
 				}
 
-				DataChunkPtr Data = (*it).second.Source->GetEssenceData(0, MaxWrapChunkSize);
-				
+				DataChunkPtr Data;
+				{
+					StageTimer ParseTimer(StageParse, &WriteTimer);
+					Data = (*it).second.Source->GetEssenceData(0, MaxWrapChunkSize);
+				}
+
 				// Exit when no more data left
 				if(!Data) break;
 
@@ -1013,7 +1102,8 @@ void GCWriter::Flush(void)
 				// Index this item if required (removing the KLSize if doing value-relative indexing)
 				if(IndexThisItem) (*it).second.IndexMan->OfferOffset((*it).second.IndexSubStream, LastEditUnit, StreamOffset - KLSize);
 
-			StreamOffset += LinkedFile->Write(*Data);
+				// Written by SmartPtr so that large chunks may be written asynchronously if enabled on the file
+				StreamOffset += LinkedFile->Write(Data);
 			}
 
 			// Now correct the length if we are fast clip wrapping
@@ -1421,6 +1511,8 @@ GCReader::GCReader( MXFFilePtr File, GCReadHandlerPtr DefaultHandler /*=NULL*/,
 	PushBackRequested = false;
 
 	StreamOffset = 0;
+
+	KLVCount = 0;
 }
 
 
@@ -1492,41 +1584,29 @@ bool GCReader::ReadFromFile(bool Focus /* = false */, ReaderUnit Unit /* = Unit_
  */
 bool GCReader::HandleData(KLVObjectPtr Object)
 {
+	KLVCount++;
+	StatsAdd(GlobalStats.KLVsDispatched, 1);
+
+	// Classify the key once, giving the track-number of this GC item (or zero if not GC)
+	UInt32 TrackNumber;
+	GCKeyClass KeyClass = ClassifyGCKey(Object->GetUL()->GetValue(), TrackNumber);
+
 	// First check is this KLV is a filler
-	// We first check if byte 9 == 3 which is true for filler keys, but is
-	// false for all GC sets and packs. Once this matches we can do a full memcmp.
-	if(Object->GetUL()->GetValue()[8] == 3)
+	if(KeyClass == GCKey_Filler)
 	{
-		const UInt8 FillerKey[16] = { 0x06, 0x0E, 0x2B, 0x34, 0x01, 0x01, 0x01, 0x01, 0x03, 0x01, 0x02, 0x10, 0x01, 0x00, 0x00, 0x00 };
-		if( memcmp(Object->GetUL()->GetValue(), FillerKey, 16) == 0 )
-		{
-			if(FillerHandler) return FillerHandler->HandleData(this, Object);
-			else return true;
-		}
+		if(FillerHandler) return FillerHandler->HandleData(this, Object);
+		else return true;
 	}
 
 	// Next check if this KLV is encrypted essence data - but only if we have an encryption handler
-	if(EncryptionHandler)
+	if((KeyClass == GCKey_Encrypted) && EncryptionHandler)
 	{
-		// We first check if byte 6 == 4 (variable pack) which is true for encrypted data keys,
-		// but is false for standard GC sets and packs. Once this matches we can do a full memcmp.
-		if(Object->GetUL()->GetValue()[5] == 4)
-		{
-			const UInt8 EncryptedKey[16] = { 0x06, 0x0E, 0x2B, 0x34, 0x02, 0x04, 0x01, 0x07, 0x0d, 0x01, 0x03, 0x01, 0x02, 0x7e, 0x01, 0x00 };
-			if( memcmp(Object->GetUL()->GetValue(), EncryptedKey, 16) == 0 )
-			{
-				return EncryptionHandler->HandleData(this, Object);
-			}
-		}
+		return EncryptionHandler->HandleData(this, Object);
 	}
 
-	// Get the track-number of this GC item (or zero if not GC)
-	// Note that we don't bother if no handlers have been registered 
+	// Note that we don't bother with the track number if no handlers have been registered 
 	// because we will have to use the defualt handler whatever!
-	UInt32 TrackNumber; 
-	if(!Handlers.size()) TrackNumber = 0; else TrackNumber = Object->GetGCTrackNumber();
-
-	if( TrackNumber != 0 )
+	if((TrackNumber != 0) && (!Handlers.empty()))
 	{
 		// See if we have a handler registered for this track
 		std::map<UInt32, GCReadHandlerPtr>::iterator it = Handlers.find(TrackNumber);
@@ -1580,6 +1660,7 @@ Position BodyReader::Seek(Position Pos /*=0*/)
 	File->Seek(Pos);				// Move the file pointer
 	CurrentPos = File->Tell();		// Find out where we ended up
 	NewPos = true;					// Force reading to be reinitialized
+	StartPartition = NULL;			// Any partition pack given by the caller is no longer where we are
 
 	AtPartition = false;			// We don't know if we are at a partition
 	AtEOF = false;					// We don't know if we are at the end of the file
@@ -1591,10 +1672,11 @@ Position BodyReader::Seek(Position Pos /*=0*/)
 
 
 
-//! Seek to a specific byte offset in a given stream
-/*! \return New file offset or -1 on seek error
+//! Find the file offset of a specific byte offset in a given stream
+/*! \return The file offset, -1 on error or 0 if beyond the last partition in the RIP
+ *  \note The file pointer may be moved by this function
  */
-Position BodyReader::Seek(UInt32 BodySID, Position Pos)
+Position BodyReader::LocateStreamOffset(UInt32 BodySID, Position Pos)
 {
 	// We <b>need</b> a RIP for this to work
 	if(File->FileRIP.empty()) File->GetRIP();
@@ -1603,7 +1685,7 @@ Position BodyReader::Seek(UInt32 BodySID, Position Pos)
 
 	if(!PartInfo)
 	{
-		error("BodyReader::Seek(%d, 0x%s) failed to locate the correct partition\n", BodySID, Int64toHexString(Pos).c_str());
+		error("BodyReader::LocateStreamOffset(%d, 0x%s) failed to locate the correct partition\n", BodySID, Int64toHexString(Pos).c_str());
 		return -1;
 	}
 
@@ -1626,6 +1708,9 @@ Position BodyReader::Seek(UInt32 BodySID, Position Pos)
 			if(PartInfo->ThePartition)
 			{
 				StreamOffset = PartInfo->ThePartition->GetInt64("BodyOffset");
+
+				// Record it so that later seeks into this partition don't need to re-read the pack
+				PartInfo->SetStreamOffset(StreamOffset);
 			}
 		}
 
@@ -1640,13 +1725,13 @@ Position BodyReader::Seek(UInt32 BodySID, Position Pos)
 
 			if(!PartInfo->ThePartition)
 			{
-				error("BodyReader::Seek(%d, 0x%s) failed to read the partition\n", BodySID, Int64toHexString(Pos).c_str());
+				error("BodyReader::LocateStreamOffset(%d, 0x%s) failed to read the partition\n", BodySID, Int64toHexString(Pos).c_str());
 				return -1;
 			}
 		
 			if(!(PartInfo->ThePartition->SeekEssence()))
 			{
-				error("BodyReader::Seek(%d, 0x%s) failed to locate essence in the predicted partition\n", BodySID, Int64toHexString(Pos).c_str());
+				error("BodyReader::LocateStreamOffset(%d, 0x%s) failed to locate essence in the predicted partition\n", BodySID, Int64toHexString(Pos).c_str());
 				return -1;
 			}
 
@@ -1669,7 +1754,7 @@ Position BodyReader::Seek(UInt32 BodySID, Position Pos)
 		
 		RIP::iterator it = File->FileRIP.lower_bound(PredictedPos+1);
 		if(it == File->FileRIP.end()) 
-			return NULL;
+			return 0;
 		if(it != File->FileRIP.begin()) 
 			it--;
 
@@ -1693,6 +1778,18 @@ Position BodyReader::Seek(UInt32 BodySID, Position Pos)
 		PartInfo = (*it).second;
 	}
 
+	return PredictedPos;
+}
+
+
+//! Seek to a specific byte offset in a given stream
+/*! \return New file offset or -1 on seek error
+ */
+Position BodyReader::Seek(UInt32 BodySID, Position Pos)
+{
+	Position PredictedPos = LocateStreamOffset(BodySID, Pos);
+	if(PredictedPos <= 0) return PredictedPos;
+
 	// Seek to the requested location
 	// DRAGONS: Seek beyond end of file is a silent failure as this may be an incomplete file
 	if(File->Seek(PredictedPos) != 0)
@@ -1721,6 +1818,33 @@ Position BodyReader::Seek(UInt32 BodySID, Position Pos)
 }
 
 
+//! Hint that a range of edit units of an indexed stream will be read soon
+bool BodyReader::WillNeed(UInt32 BodySID, IndexTablePtr Index, Position EditUnit, Length Count /*=1*/)
+{
+	if(!Index || (EditUnit < 0) || (Count < 1)) return false;
+
+	// The stream offsets of the start of the first edit unit and of the one following the last (in stored order, as they are read)
+	IndexPosPtr First = Index->Lookup(EditUnit, 0, false);
+	if(!First || !First->Exact) return false;
+
+	IndexPosPtr End = Index->Lookup(EditUnit + Count, 0, false);
+	if(!End || !End->Exact || (End->Location <= First->Location)) return false;
+
+	// Locating the stream offset may need to read partition packs, so put the file pointer back afterwards
+	Position FilePos = File->Tell();
+	Position Start = LocateStreamOffset(BodySID, First->Location);
+	File->Seek(FilePos);
+
+	if(Start <= 0) return false;
+
+	// DRAGONS: If the range spans a partition boundary this will include the partition pack and any header or index, and
+	//          will miss the same amount from the end of the range - this is only a hint so is close enough
+	File->WillNeed(Start, End->Location - First->Location);
+
+	return true;
+}
+
+
 //! Are we currently at the start of a partition pack?
 bool BodyReader::IsAtPartition(void)
 {
@@ -1817,19 +1941,35 @@ bool BodyReader::ReadFromFile(bool Focus /* = false */, ReaderUnit Unit /* = Uni
 	// First check if we need to re-initialise
 	if(NewPos)
 	{
-		// Use resync to locate the next partition pack
-		// TODO: We could allow reinitializing within a partition if we can validate the offsets
-		//       This would involve knowledge of the partition pack for this partition which could
-		//       be found by a valid RIP or by scanning backwards from the current location
-		if(!ReSync()) return false;
-
 		PartitionPtr NewPartition;				// Pointer to the new partition pack
+
+		if(StartPartition)
+		{
+			// Use the partition pack given by the caller, which may no longer be readable if this is a stream
+			NewPartition = StartPartition;
+			StartPartition = NULL;
+		}
+		else
+		{
+			// Use resync to locate the next partition pack
+			// TODO: We could allow reinitializing within a partition if we can validate the offsets
+			//       This would involve knowledge of the partition pack for this partition which could
+			//       be found by a valid RIP or by scanning backwards from the current location
+			if(!ReSync()) return false;
+		}
+
 		for(;;)
 		{
 			// Read the partition pack to establish offsets and BodySID
-			NewPartition = File->ReadPartition();
+			if(!NewPartition) NewPartition = File->ReadPartition();
 			if(!NewPartition) return false;
 
+			// Extend any index table from the segments in this partition
+			if(!IndexTables.empty()) ReadIndexSegments(NewPartition);
+
+			// Nothing after the footer is essence, so there is no more to wait for if following a growing file
+			if(File->IsFollowing() && (NewPartition->IsA(CompleteFooter_UL) || NewPartition->IsA(Footer_UL))) File->SetFollow(false);
+
 			CurrentBodySID = NewPartition->GetUInt(BodySID_UL);
 			if(CurrentBodySID != 0) Reader = GetGCReader(CurrentBodySID);
 		
@@ -1939,45 +2079,137 @@ bool BodyReader::ReSync()
 
 		// At this point we have read a key that does not start with the same 4 bytes as standard MXF keys
 		// This could mean that we have found a valid non-SMPTE key, or that we have encountered a portion
-		// of the file where data is missing or corrupted.  We not try a byte-by-byte search for a partition
-		// key
+		// of the file where data is missing or corrupted.  We now search the following bytes for a partition key
+		Position PartitionPos = ScanForPartition(CurrentPos + 1);
+		if(PartitionPos < 0)
+		{
+			AtEOF = true;
+			return false;
+		}
 
-		for(;;)
+		CurrentPos = PartitionPos;						// Move pointer to new partition pack
+		File->Seek(CurrentPos);
+		NewPos = true;									// Force read to be reinitialized
+		AtPartition= true;
+
+		return true;
+	}
+}
+
+
+//! The size of the window used when scanning for partition packs through corrupt or unknown data
+const size_t BodyReader::ScanWindowSize = 1024 * 1024;
+
+
+//! Scan forwards for the next valid partition pack
+/*! \param Start The position in the file from which to start searching
+ *  \return The position of the partition pack, or -1 if none is found before the end of the file
+ */
+Position BodyReader::ScanForPartition(Position Start)
+{
+	DataChunk Buffer(ScanWindowSize);
+
+	for(;;)
+	{
+		size_t Window = ScanWindowSize;
+
+		// When following a growing file scan what has been written so far, waiting only if there is not yet a whole key
+		if(File->IsFollowing())
 		{
-			// Scan 64k at a time
-			const UInt64 BufferLen = 65536;
-			DataChunkPtr Buffer = File->Read(BufferLen);
-			
-			if(Buffer->Size < 16) return false;
+			Length Available = File->Size() - Start;
+			if(Available < 16) Available = 16;
+			if(Available < static_cast<Length>(Window)) Window = static_cast<size_t>(Available);
+		}
+
+		File->Seek(Start);
+		size_t Bytes = File->Read(Buffer.Data, Window);
+
+		if(Bytes < 16) return -1;
 
-			size_t i;									// Loop variable
-			size_t End = Buffer->Size - 15;				// End of loop - 15 bytes early to allow 16-byte compares
-			UInt8 *p = Buffer->Data;					// Use moving pointer for faster compares
-			for(i=0; i<End; i++)
+		const UInt8 *Base = Buffer.Data;
+		const UInt8 *End = &Base[Bytes - 15];			// End of search - 15 bytes early to allow 16-byte compares
+		const UInt8 *p = Base;
+		while(p < End)
+		{
+			// Let the C library find the next possible start of a key - this is much faster than a byte-by-byte loop
+			p = static_cast<const UInt8 *>(memchr(p, 0x06, End - p));
+			if(!p) break;
+
+			// Only perform full partition key check if it looks promising, then check that it really is a partition pack
+			if((p[1] == 0x0e) && (p[2] == 0x2b) && (p[3] == 0x34) && IsPartitionKey(p))
 			{
-				// Only perform full partition key check if it looks promising
-				if((*p == 0x06) && (p[1] == 0x0e))
-				{
-					if(IsPartitionKey(p))
-					{
-						CurrentPos += i;				// Move pointer to new partition pack
-						File->Seek(CurrentPos);
-						NewPos = true;					// Force read to be reinitialized
-						AtPartition= true;
-		
-						return true;
-					}
-				}
-				p++;
+				Position Pos = Start + (p - Base);
+				if(ValidatePartition(Pos)) return Pos;
 			}
 
-			CurrentPos += End;
-			File->Seek(CurrentPos);
+			p++;
 		}
+
+		// A short read means we have reached the end of the file
+		if(Bytes < Window) return -1;
+
+		// Move to the next window, overlapping by 15 bytes so that keys spanning the boundary are found
+		Start += Bytes - 15;
 	}
 }
 
 
+//! Add the index table segments of a partition to any index table set for its IndexSID
+void BodyReader::ReadIndexSegments(PartitionPtr &ThisPartition)
+{
+	UInt32 IndexSID = ThisPartition->GetUInt(IndexSID_UL);
+	if(IndexSID == 0) return;
+
+	std::map<UInt32, IndexTablePtr>::iterator it = IndexTables.find(IndexSID);
+	if(it == IndexTables.end()) return;
+
+	DataChunkPtr IndexChunk = ThisPartition->ReadIndexChunk();
+	if(IndexChunk && (IndexChunk->Size != 0)) (*it).second->AddSegments(IndexChunk, true);
+}
+
+
+//! Check that a partition pack key found by scanning starts a valid partition pack
+/*! \note The file pointer is moved by this function
+ */
+bool BodyReader::ValidatePartition(Position Pos)
+{
+	// The fixed part of a partition pack is 88 bytes, including the header of the essence containers batch
+	const Length MinPackSize = 88;
+
+	// Limit the size of the essence containers batch to something that could be real
+	const Length MaxPackSize = MinPackSize + (1024 * 16);
+
+	File->Seek(Pos + 16);
+	Length Len = File->ReadBER();
+	if((Len < MinPackSize) || (Len > MaxPackSize)) return false;
+
+	DataChunkPtr Pack = File->Read(static_cast<size_t>(Len));
+	if(Pack->Size != static_cast<size_t>(Len)) return false;
+
+	const UInt8 *p = Pack->Data;
+
+	// Check the major version
+	if(GetU16(p) != 1) return false;
+
+	// The operational pattern must be a SMPTE label
+	if((p[64] != 0x06) || (p[65] != 0x0e) || (p[66] != 0x2b) || (p[67] != 0x34)) return false;
+
+	// The essence containers batch must be a batch of 16-byte labels exactly filling the rest of the pack
+	UInt32 Count = GetU32(&p[80]);
+	UInt32 ItemSize = GetU32(&p[84]);
+	if((Count != 0) && (ItemSize != 16)) return false;
+	if(static_cast<Length>(MinPackSize + (static_cast<Length>(Count) * 16)) != Len) return false;
+
+	// The following KLV (if there is one) must have a SMPTE key
+	UInt8 NextKey[16];
+	size_t Bytes = File->Read(NextKey, 16);
+	if(Bytes == 0) return true;
+	if(Bytes < 4) return false;
+
+	return (NextKey[0] == 0x06) && (NextKey[1] == 0x0e) && (NextKey[2] == 0x2b) && (NextKey[3] == 0x34);
+}
+
+
 //! Initialize the per SID seek system
 /*! To allow us to seek to byte offsets within a file we need to initialize 
  *  various structures - seeking is not always possible!!
@@ -1999,7 +2231,16 @@ void mxflib::RegisterGCElementKey(DataChunkPtr &Key)
 		return;
 	}
 
-	GCEssenceKeyAlternatives.push_back(Key);
+	// Build the compare pattern: the bytes given, except the version number byte
+	// DRAGONS: There is no point comparing exactly 8 bytes, as the last would be the version number
+	char Compare[17] = "----------------";
+	UInt8 Root[16] = { 0 };
+	memcpy(Root, Key->Data, Key->Size);
+
+	size_t i;
+	for(i=0; i<Key->Size; i++) if(i != 7) Compare[i] = 'x';
+
+	GCEssenceKeyAlternatives.push_back(GCKeyMask(Root, Compare));
 }
 
 
@@ -2016,7 +2257,16 @@ void mxflib::RegisterGCSystemKey(DataChunkPtr &Key)
 		return;
 	}
 
-	GCSystemKeyAlternatives.push_back(Key);
+	// Build the compare pattern: the bytes given, except bytes 6 and 8
+	// DRAGONS: For short keys only up to 5 bytes of the start are compared, plus byte 7 if given
+	char Compare[17] = "----------------";
+	UInt8 Root[16] = { 0 };
+	memcpy(Root, Key->Data, Key->Size);
+
+	size_t i;
+	for(i=0; i<Key->Size; i++) if((i != 5) && (i != 7)) Compare[i] = 'x';
+
+	GCSystemKeyAlternatives.push_back(GCKeyMask(Root, Compare));
 }
 
 
@@ -2025,64 +2275,19 @@ GCElementKind mxflib::GetGCElementKind(const ULPtr TheUL)
 {
 	GCElementKind ret;
 
-	// Assume it's not a valid key
-	ret.IsValid = false;
+	const UInt8 *Key = TheUL->GetValue();
 
-	// Note that we first test the 11th byte as this where "Application = MXF Generic Container Keys"
-	// is set and so is the same for all GC keys and different in the majority of non-CG keys
-	// also, avoid testing the 8th byte (version number)
-	if( ( TheUL->GetValue()[10] == GetGCEssenceKey()[10] )
-	 && ( TheUL->GetValue()[9]  == GetGCEssenceKey()[9]  )
-	 && ( TheUL->GetValue()[8]  == GetGCEssenceKey()[8]  )
-	 && ( memcmp(TheUL->GetValue(), GetGCEssenceKey(), 7 ) == 0) )
-	{
-		ret.IsValid = true;
-	}
-	else
-	{
-		// Scan for any registered alternative GC-type essence keys
-		if(GCEssenceKeyAlternatives.size())
-		{
-			DataChunkList::iterator it = GCEssenceKeyAlternatives.begin();
-			while(it != GCEssenceKeyAlternatives.end())
-			{
-				size_t Size = (*it)->Size;
-				
-				if(Size > 8)
-				{
-					// Compare top bytes first as these are the most likely to differ
-					if(memcmp(&TheUL->GetValue()[8], &(*it)->Data[8], Size - 8) == 0)
-					{
-						// DRAGONS: Don't test the version number byte
-						if(memcmp(TheUL->GetValue(), (*it)->Data, 7) == 0)
-						{
-							ret.IsValid = true;
-							break;
-						}
-					}
-				}
-				else
-				{
-					// There is no point comparing exactly 8 bytes
-					if(Size == 8) Size = 7;
-
-					if(memcmp(TheUL->GetValue(), (*it)->Data, Size) == 0)
-					{
-						ret.IsValid = true;
-						break;
-					}
-				}
+	// Load the key as two words for masked compares
+	UInt64 Words[2];
+	memcpy(Words, Key, 16);
 
-				it++;
-			}
-		}
-	}
+	ret.IsValid = IsGCElementKey(Words);
 
 	// DRAGONS: We set the sub-values in case we later find this to be a system or generic stream item
-	ret.Item =				(TheUL->GetValue())[12];
-	ret.Count =				(TheUL->GetValue())[13];
-	ret.ElementType =       (TheUL->GetValue())[14];
-	ret.Number =			(TheUL->GetValue())[15];
+	ret.Item =				Key[12];
+	ret.Count =				Key[13];
+	ret.ElementType =       Key[14];
+	ret.Number =			Key[15];
 
 	return ret;
 }
@@ -2091,92 +2296,213 @@ GCElementKind mxflib::GetGCElementKind(const ULPtr TheUL)
 //! Determine if this is a system item
 bool mxflib::IsGCSystemItem(const ULPtr TheUL)
 {
-	// Note that we first test the 11th byte as this where "Application = MXF Generic Container Keys"
-	// is set and so is the same for all GC keys and different in the majority of non-CG keys
-	// also, avoid testing the 6th byte (set or pack structure) and the 8th byte (version number)
-	if( ( TheUL->GetValue()[10] == GCSystemKey[10] )
-	 && ( TheUL->GetValue()[9]  == GCSystemKey[9]  )
-	 && ( TheUL->GetValue()[8]  == GCSystemKey[8]  )
-	 && ( TheUL->GetValue()[6]  == GCSystemKey[6]  )
-	 && ( memcmp(TheUL->GetValue(), GCSystemKey, 5 ) == 0) )
+	UInt64 Words[2];
+	memcpy(Words, TheUL->GetValue(), 16);
+
+	return IsGCSystemKey(Words);
+}
+
+
+
+//! Determine if this is a generic stream item
+bool mxflib::IsGStreamItem(const ULPtr TheUL)
+{
+	UInt64 Words[2];
+	memcpy(Words, TheUL->GetValue(), 16);
+
+	return GStreamMask.Matches(Words);
+}
+
+
+
+//! Get the track number of this essence key (if it is a GC Key)
+/*! \return 0 if not a valid GC Key
+ */
+UInt32 mxflib::GetGCTrackNumber(const ULPtr TheUL)
+{
+	const UInt8 *Key = TheUL->GetValue();
+
+	UInt64 Words[2];
+	memcpy(Words, Key, 16);
+
+	if(!IsGCElementKey(Words)) return 0;
+
+	return GetU32(&Key[12]);
+}
+
+
+//! Classify a key for dispatch when reading a Generic Container
+/*! \param Key The 16-byte key to classify
+ *  \param TrackNumber Set to the track number if this is a GC element key, else 0
+ */
+GCKeyClass mxflib::ClassifyGCKey(const UInt8 *Key, UInt32 &TrackNumber)
+{
+	UInt64 Words[2];
+	memcpy(Words, Key, 16);
+
+	// Standard GC elements are the most common, so test for them first
+	if(GCElementMask.Matches(Words))
 	{
-		return true;
+		TrackNumber = GetU32(&Key[12]);
+		return GCKey_Element;
 	}
-	else
-	{
-		// Scan for any registered alternative GC-type system item keys
-		if(GCSystemKeyAlternatives.size())
-		{
-			DataChunkList::iterator it = GCSystemKeyAlternatives.begin();
-			while(it != GCSystemKeyAlternatives.end())
-			{
-				size_t Size = (*it)->Size;
-				
-				if(Size > 8)
-				{
-					// Compare top bytes first as these are the most likely to differ
-					if(memcmp(&TheUL->GetValue()[8], &(*it)->Data[8], Size - 8) == 0)
-					{
-						// DRAGONS: Don't test the bytes 6 or 8 (array index 5 and 7)
-						if((TheUL->GetValue()[6] == (*it)->Data[6]) && (memcmp(TheUL->GetValue(), (*it)->Data, 5) == 0)) return true;
-					}
-				}
-				else
-				{
-					// Test byte 7 if the test key is that long
-					if((Size < 7) || (TheUL->GetValue()[6] == (*it)->Data[6]))
-					{
-						// Test up to 5 bytes of the start of the key
-						if(memcmp(TheUL->GetValue(), (*it)->Data, (Size > 5) ? 5 : Size) == 0) return true;
-					}
-				}
 
-				it++;
-			}
-		}
+	TrackNumber = 0;
+
+	// Test for filler and encrypted keys before alternative element keys, which may be short enough to match them
+	if(GCFillerMask.Matches(Words)) return GCKey_Filler;
+	if(GCEncryptedMask.Matches(Words)) return GCKey_Encrypted;
+
+	if((!GCEssenceKeyAlternatives.empty()) && MatchesAny(GCEssenceKeyAlternatives, Words))
+	{
+		TrackNumber = GetU32(&Key[12]);
+		return GCKey_Element;
 	}
 
-	return false;
+	if(IsGCSystemKey(Words)) return GCKey_System;
+	if(GStreamMask.Matches(Words)) return GCKey_GStream;
+
+	return GCKey_Other;
 }
 
 
 
-//! Determine if this is a generic stream item
-bool mxflib::IsGStreamItem(const ULPtr TheUL)
+//! Number of bytes read from the start of the file when the probe is built
+/*! This is enough to hold a complete DV-DIF sequence for validation */
+const size_t EssenceProbe::DefaultHeadSize = 16 * 1024;
+
+//! Largest head or tail buffer that will be held by a probe
+const size_t EssenceProbe::MaxBufferSize = 1024 * 1024;
+
+
+//! Construct a probe for an open file, reading the first HeadSize bytes
+EssenceProbe::EssenceProbe(FileHandle InFile, size_t HeadSize /*=DefaultHeadSize*/)
+	: File(InFile), TailStart(0), FileLength(-1), HeadIsWholeFile(false)
+{
+	if(HeadSize > MaxBufferSize) HeadSize = MaxBufferSize;
+
+	Head.ResizeBuffer(HeadSize);
+
+	FileSeek(File, 0);
+	size_t Bytes = FileRead(File, Head.Data, HeadSize);
+	if(Bytes == static_cast<size_t>(-1)) Bytes = 0;
+
+	Head.Size = Bytes;
+	if(Bytes < HeadSize) HeadIsWholeFile = true;
+}
+
+
+//! Get a pointer to at least Size bytes from the start of the file, extending the buffer if required
+/*! \return NULL if the file is shorter than Size bytes (or Size > MaxBufferSize)
+ */
+const UInt8 *EssenceProbe::GetHead(size_t Size)
 {
-	// Note that we first test the 11th byte as this where "Application = MXF Generic Stream Keys"
-	// is set and so is the same for all GC keys and different in the majority of non-CG keys
-	// also, avoid testing 8th byte (version number) and bytes 14-16 (reserved)
-	if( ( TheUL->GetValue()[10] == GStreamKey[10] )
-	 && ( TheUL->GetValue()[9]  == GStreamKey[9]  )
-	 && ( TheUL->GetValue()[8]  == GStreamKey[8]  )
-	 && ( memcmp(TheUL->GetValue(), GStreamKey, 7 ) == 0) )
+	if(Size > Head.Size)
 	{
-		return true;
+		if(HeadIsWholeFile || (Size > MaxBufferSize)) return NULL;
+
+		// Grow by at least a factor of two to limit the number of reads for sub-parsers that creep forwards
+		size_t NewSize = Head.Size * 2;
+		if(NewSize < Size) NewSize = Size;
+		if(NewSize > MaxBufferSize) NewSize = MaxBufferSize;
+
+		size_t OldSize = Head.Size;
+		Head.ResizeBuffer(NewSize);
+
+		FileSeek(File, OldSize);
+		size_t Bytes = FileRead(File, &Head.Data[OldSize], NewSize - OldSize);
+		if(Bytes == static_cast<size_t>(-1)) Bytes = 0;
+
+		Head.Size = OldSize + Bytes;
+		if(Head.Size < NewSize) HeadIsWholeFile = true;
+
+		if(Size > Head.Size) return NULL;
 	}
 
-	return false;
+	return Head.Data;
 }
 
 
+//! Get a pointer to the last Size bytes of the file, reading them if required
+/*! \return NULL if the file is shorter than Size bytes (or Size > MaxBufferSize)
+ */
+const UInt8 *EssenceProbe::GetTail(size_t Size)
+{
+	if(Size > Tail.Size)
+	{
+		Length FileBytes = GetFileSize();
+		if((FileBytes < 0) || (static_cast<Length>(Size) > FileBytes) || (Size > MaxBufferSize)) return NULL;
 
-//! Get the track number of this essence key (if it is a GC Key)
-/*! \return 0 if not a valid GC Key
+		// If the whole file is already in the head buffer there is no need to read anything
+		if(HeadIsWholeFile) return &Head.Data[Head.Size - Size];
+
+		Tail.ResizeBuffer(Size, false);
+		TailStart = FileBytes - Size;
+
+		FileSeek(File, TailStart);
+		size_t Bytes = FileRead(File, Tail.Data, Size);
+		if(Bytes == static_cast<size_t>(-1)) Bytes = 0;
+
+		Tail.Size = Bytes;
+		if(Bytes < Size) return NULL;
+	}
+
+	return &Tail.Data[Tail.Size - Size];
+}
+
+
+//! Read bytes from a given offset in the file, using the buffered data where possible
+/*! \return The number of bytes read, which will be less than Size if the file is too short
  */
-UInt32 mxflib::GetGCTrackNumber(const ULPtr TheUL)
+size_t EssenceProbe::Read(Position Offset, UInt8 *Dest, size_t Size)
 {
-	GCElementKind Info = GetGCElementKind(TheUL);
+	if(Offset < 0) return 0;
+
+	// Satisfy from the head, extending it if that will fit in the buffer limit
+	if((static_cast<UInt64>(Offset) + Size) <= MaxBufferSize)
+	{
+		GetHead(static_cast<size_t>(Offset) + Size);
+
+		if(static_cast<size_t>(Offset) >= Head.Size) return 0;
+
+		size_t Bytes = Head.Size - static_cast<size_t>(Offset);
+		if(Bytes > Size) Bytes = Size;
 
-	if(!Info.IsValid) return 0;
+		memcpy(Dest, &Head.Data[Offset], Bytes);
+		return Bytes;
+	}
+
+	// Satisfy from the tail if it is already buffered
+	if(Tail.Size && (Offset >= TailStart) && ((Offset + static_cast<Position>(Size)) <= (TailStart + static_cast<Position>(Tail.Size))))
+	{
+		memcpy(Dest, &Tail.Data[Offset - TailStart], Size);
+		return Size;
+	}
+
+	// Otherwise read directly from the file
+	FileSeek(File, Offset);
+	size_t Bytes = FileRead(File, Dest, Size);
+	if(Bytes == static_cast<size_t>(-1)) Bytes = 0;
 
-	return    (static_cast<UInt32>(TheUL->GetValue()[12]) << 24) | (static_cast<UInt32>(TheUL->GetValue()[13]) << 16) 
-			| (static_cast<UInt32>(TheUL->GetValue()[14]) << 8)  | static_cast<UInt32>(TheUL->GetValue()[15]);
+	return Bytes;
 }
 
 
+//! Get the size of the file being probed, or -1 if not known
+Length EssenceProbe::GetFileSize(void)
+{
+	if(FileLength < 0)
+	{
+		if(HeadIsWholeFile) FileLength = static_cast<Length>(Head.Size);
+		else FileLength = FileSize(File);
+	}
+
+	return FileLength;
+}
+
 
-//! Build a list of parsers with their descriptors for a given essence file
-ParserDescriptorListPtr EssenceParser::IdentifyEssence(FileHandle InFile)
+//! Build a list of parsers with their descriptors for a given probed essence file
+ParserDescriptorListPtr EssenceParser::IdentifyEssence(EssenceProbePtr &Probe)
 {
 	// Ensure the EPList is initialized
 	if(!Inited) Init();
@@ -2187,7 +2513,7 @@ ParserDescriptorListPtr EssenceParser::IdentifyEssence(FileHandle InFile)
 	while(it != EPList.end())
 	{
 		EssenceSubParserPtr EP = (*it)->NewParser();
-		EssenceStreamDescriptorList DescList = EP->IdentifyEssence(InFile);
+		EssenceStreamDescriptorList DescList = EP->IdentifyEssence(Probe);
 		
 		if(!DescList.empty())
 		{
@@ -2745,6 +3071,7 @@ Length BodyWriter::WriteEssence(StreamInfoPtr &Info, Length Duration /*=0*/, Len
 						else
 						{
 							// Read the next data for this sub-stream
+							StageTimer ParseTimer(StageParse);
 							Dat = (*it)->GetEssenceData();
 						}
 
@@ -3122,6 +3449,50 @@ BodyStream::StateType mxflib::BodyStream::GetNextState(void)
 }
 
 
+//! Allowance added by EstimateSize() for the partition packs, metadata and index tables
+const Length BodyWriter::EstimateOverhead = 1024 * 1024;
+
+
+//! Estimate the final size of the file from the constant bit rates and durations of the streams
+Length mxflib::BodyWriter::EstimateSize(Length Duration /*=0*/)
+{
+	Length Ret = 0;
+
+	StreamInfoList::iterator it = StreamList.begin();
+	while(it != StreamList.end())
+	{
+		BodyStreamPtr &Stream = (*it)->Stream;
+
+		Length StreamDuration = (*it)->StopAfter;
+		if(StreamDuration <= 0) StreamDuration = Duration;
+		if((StreamDuration <= 0) && Stream->GetSource()) StreamDuration = Stream->GetSource()->GetRangeDuration();
+		if(StreamDuration <= 0) return -1;
+
+		UInt32 UseKAG = Stream->GetKAG() ? Stream->GetKAG() : KAG;
+
+		// DRAGONS: System items are small and are covered by the allowance for metadata
+		BodyStream::iterator SubIt = Stream->begin();
+		while(SubIt != Stream->end())
+		{
+			if(!(*SubIt)->IsSystemItem())
+			{
+				UInt32 Bytes = (*SubIt)->GetBytesPerEditUnit(UseKAG);
+				if(Bytes == 0) return -1;
+
+				Ret += StreamDuration * Bytes;
+			}
+
+			SubIt++;
+		}
+
+		it++;
+	}
+
+	// Allow for body partitions and the KAG filler not counted in the bytes per edit unit
+	return Ret + (Ret / 100) + MinPartitionSize + MinPartitionFiller + EstimateOverhead;
+}
+
+
 //! Write the file header
 /*! No essence will be written, but CBR index tables will be written if required.
  *  The partition will not be "ended" if only the header partition is written
@@ -3135,8 +3506,28 @@ void mxflib::BodyWriter::WriteHeader(bool IsClosed, bool IsComplete)
 		return;
 	}
 
+	// A stream is written strictly forwards, so the header can't be closed or completed later, and index tables must go in the body
+	if(File->IsStreaming())
+	{
+		IsClosed = false;
+		IsComplete = false;
+
+		SetStreamingIndexTypes();
+	}
+
 	// Initialize any index managers required for this writer before we write the header
 	InitIndexManagers();
+
+	// Reserve the disk space before anything is written, rounded up to whole extents
+	Preallocated = false;
+	if(PreallocateSize > 0)
+	{
+		Length Size = PreallocateSize;
+		if(ExtentSize) Size = ((Size + ExtentSize - 1) / ExtentSize) * ExtentSize;
+
+		Preallocated = File->Preallocate(Size);
+		if(!Preallocated) debug("Unable to reserve %s bytes of disk space for \"%s\"\n", Int64toString(Size).c_str(), File->Name.c_str());
+	}
 	
 	// Turn the partition into the correct type of header
 	if(IsClosed)
@@ -3285,6 +3676,28 @@ void mxflib::BodyWriter::WritePartitionPack(void)
 	/* Write a generic stream partition if required */
 	if(PendingGeneric) BasePartition->ChangeType(GenericStreamPartition_UL);
 
+	// Start body partitions on an extent boundary, ending the previous partition with filler
+	if(ExtentSize && (!PendingHeader) && (!PendingFooter))
+	{
+		// DRAGONS: A single filler is limited to 0x00ffffff bytes, so a larger gap is first reduced with fillers to 8Mbyte boundaries
+		const UInt32 MinFill = ForceBER4 ? 20 : 17;
+		for(;;)
+		{
+			UInt32 Offset = static_cast<UInt32>(File->Tell() % ExtentSize);
+			if(Offset == 0) break;
+
+			// A gap too small for a filler is extended to the following boundary, as is done by Align()
+			UInt64 Remaining = ExtentSize - Offset;
+			if(Remaining < MinFill) Remaining += ExtentSize;
+
+			// The minimum size ensures that a filler is written even if already on an 8Mbyte boundary
+			if(Remaining <= 0x00ffffff) break;
+			File->Align(ForceBER4, 0x00800000, MinFill);
+		}
+
+		File->Align(ForceBER4, ExtentSize);
+	}
+
 	// FIXME: Need to force a separate partition pack if we are about to violate the metadata sharing rules
 
 	if(PendingIndexData)
@@ -3988,6 +4401,13 @@ void mxflib::BodyWriter::WriteFooter(bool WriteMetadata /*=false*/, bool IsCompl
 	// Add a RIP (note that we have to manually KAG align as a footer can end off the KAG)
 	if(KAG > 1) File->Align(KAG);
 	File->WriteRIP();
+
+	// Release any reserved disk space that was not used
+	if(Preallocated)
+	{
+		File->Crop();
+		Preallocated = false;
+	}
 }
 
 
@@ -4223,6 +4643,9 @@ void BodyStream::SetWriter(GCWriter* Writer)
 //! Parse a given multi-file name
 void ListOfFiles::ParseFileName(std::string FileName)
 {
+	// Stop prefetching any previous pattern
+	StopPrefetch();
+
 	// Initialize settings
 	ListOrigin = 0;
 	ListIncrement = 1;
@@ -4520,8 +4943,10 @@ ParserDescriptorListPtr FileParser::IdentifyEssence(void)
 
 
 
-	// Identify the options
-	Ret = EssenceParser::IdentifyEssence(CurrentFile);
+	// Identify the options, passing on any parser options for essence types that cannot be identified without them
+	EssenceProbePtr Probe = new EssenceProbe(CurrentFile);
+	Probe->SetOptions(Options);
+	Ret = EssenceParser::IdentifyEssence(Probe);
 
 	return Ret;
 }
@@ -4749,6 +5174,20 @@ void FileParser::SendParserOptions(EssenceSubParserPtr &SubParser, const std::st
 }
 
 
+//! Stop any prefetcher for the current sequence, reporting how many of its files were used
+void ListOfFiles::StopPrefetch(void)
+{
+	if(Prefetcher)
+	{
+		debug("%u of %u files of \"%s\" were opened ahead\n", (unsigned int)PrefetchHits, (unsigned int)(PrefetchHits + PrefetchMisses), BaseFileName.c_str());
+		Prefetcher = NULL;
+	}
+
+	PrefetchHits = 0;
+	PrefetchMisses = 0;
+}
+
+
 //! Open the next file in the set of source files
 /*! \return true if all OK, false if no file or error
  */
@@ -4791,6 +5230,12 @@ bool ListOfFiles::GetNextFile(void)
 	// Free the name buffer
 	delete[] NameBuffer;
 
+	// Start opening a numbered sequence in the background if requested, from the file about to be opened as it will be taken next
+	if(PrefetchDepth && FileList && (FilesRemaining != 1) && !Prefetcher)
+	{
+		Prefetcher = new FilePrefetcher(BaseFileName, FileNumber, ListIncrement, FilesRemaining, PrefetchDepth);
+	}
+
 	// Get the next file number
 	FileNumber += ListIncrement;
 
@@ -4812,6 +5257,115 @@ bool ListOfFiles::GetNextFile(void)
 
 
 
+//! The size of the buffer used to read through each file
+const size_t FilePrefetcher::ReadBufferSize = 256 * 1024;
+
+
+//! Construct a prefetcher and start it running
+FilePrefetcher::FilePrefetcher(std::string BaseFileName, int FirstNumber, int Increment, int Count, size_t Depth)
+	: BaseFileName(BaseFileName), NextNumber(FirstNumber), Increment(Increment), Remaining(Count), Depth(Depth)
+{
+	Stopping = false;
+	Finished = false;
+
+	// If we can't start the thread we simply queue nothing and all files get opened directly
+	if(!Start()) Finished = true;
+}
+
+
+//! Stop the worker and close any files not yet taken
+FilePrefetcher::~FilePrefetcher()
+{
+	Lock.Lock();
+	Stopping = true;
+	SpaceAvailable.Broadcast();
+	Lock.Unlock();
+
+	Join();
+
+	while(!Queue.empty())
+	{
+		if(FileValid(Queue.front().File)) FileClose(Queue.front().File);
+		Queue.pop_front();
+	}
+}
+
+
+//! Take the next file from the queue, waiting for it if required
+FileHandle FilePrefetcher::Take(const std::string &FileName)
+{
+	MutexLock Locked(Lock);
+
+	while(Queue.empty() && !Finished) DataAvailable.Wait(Lock);
+
+	if(Queue.empty()) return FileInvalid;
+
+	PrefetchedFile Next = Queue.front();
+	Queue.pop_front();
+	SpaceAvailable.Signal();
+
+	// DRAGONS: A new-file handler may have changed the name, in which case this file is not the one wanted
+	if(Next.Name != FileName)
+	{
+		if(FileValid(Next.File)) FileClose(Next.File);
+		return FileInvalid;
+	}
+
+	return Next.File;
+}
+
+
+//! The body of the worker thread
+void FilePrefetcher::Run(void)
+{
+	UInt8 *Buffer = new UInt8[ReadBufferSize];
+	char *NameBuffer = new char[1024];
+
+	for(;;)
+	{
+		// Wait for space in the queue
+		Lock.Lock();
+		while(!Stopping && (Queue.size() >= Depth)) SpaceAvailable.Wait(Lock);
+		bool Stop = Stopping;
+		Lock.Unlock();
+
+		if(Stop || (Remaining == 0)) break;
+
+		PrefetchedFile This;
+
+		sprintf(NameBuffer, BaseFileName.c_str(), NextNumber);
+		This.Name = std::string(NameBuffer);
+
+		// Open the file and read it through to pull its data into the OS cache, then rewind it ready for use
+		This.File = FileOpenRead(NameBuffer);
+		if(FileValid(This.File))
+		{
+			while(FileRead(This.File, Buffer, ReadBufferSize) == ReadBufferSize) {};
+			FileSeek(This.File, 0);
+		}
+
+		Lock.Lock();
+		Queue.push_back(This);
+		DataAvailable.Signal();
+		Lock.Unlock();
+
+		// Stop at the first missing file, as will GetNextFile()
+		if(!FileValid(This.File)) break;
+
+		NextNumber += Increment;
+		if(Remaining > 0) Remaining--;
+	}
+
+	delete[] NameBuffer;
+	delete[] Buffer;
+
+	Lock.Lock();
+	Finished = true;
+	DataAvailable.Broadcast();
+	Lock.Unlock();
+}
+
+
 //! Set the sequential source to use the EssenceSource from the currently open and identified source file
 /*! \return true if all OK, false if no EssenceSource available
  */
@@ -4883,8 +5437,10 @@ bool FileParser::GetNextSource(void)
 	// Build a new parser of the same type as there is no guarantee that older parsers can be re-used
 	EssenceSubParserPtr NewParser = SubParser->NewParser();
 
-	// Identify the essence
-	EssenceStreamDescriptorList ESDList = NewParser->IdentifyEssence(CurrentFile);
+	// Identify the essence, passing on any parser options for essence types that cannot be identified without them
+	EssenceProbePtr Probe = new EssenceProbe(CurrentFile);
+	Probe->SetOptions(Options);
+	EssenceStreamDescriptorList ESDList = NewParser->IdentifyEssence(Probe);
 
 	// Scan for a matching wrapping
 	bool FoundMatch = false;
@@ -5466,6 +6022,33 @@ void BodyStream::InitIndexManager(void)
 }
 
 
+//! Move the index tables of each stream into body partitions, for writing to a stream
+void BodyWriter::SetStreamingIndexTypes(void)
+{
+	const int VBRTypes = BodyStream::StreamIndexFullFooter | BodyStream::StreamIndexSparseFooter;
+	const int CBRTypes = BodyStream::StreamIndexCBRHeader | BodyStream::StreamIndexCBRHeaderIsolated | BodyStream::StreamIndexCBRFooter;
+
+	StreamInfoList::iterator it = StreamList.begin();
+	while(it != StreamList.end())
+	{
+		BodyStreamPtr &Stream = (*it)->Stream;
+		int IndexFlags = Stream->GetIndexType();
+
+		// DRAGONS: A stream may ask for both CBR and VBR types as it may not know which it will be, so both are moved
+		if(IndexFlags & VBRTypes) IndexFlags = (IndexFlags & ~VBRTypes) | BodyStream::StreamIndexSprinkled;
+		if(IndexFlags & CBRTypes) IndexFlags = (IndexFlags & ~CBRTypes) | BodyStream::StreamIndexCBRBody;
+
+		if(IndexFlags != Stream->GetIndexType())
+		{
+			debug("Index tables for BodySID 0x%04x moved to body partitions as %s is a stream\n", Stream->GetBodySID(), File->Name.c_str());
+			Stream->SetIndexType(static_cast<BodyStream::IndexType>(IndexFlags));
+		}
+
+		it++;
+	}
+}
+
+
 //! Initialize all required index managers
 void BodyWriter::InitIndexManagers(void)
 {
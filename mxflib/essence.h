@@ -1080,6 +1080,81 @@ namespace mxflib
 	typedef SmartPtr<EssenceSubParserFactory> EssenceSubParserFactoryPtr;
 
 
+	//! Shared read-once view of the start (and optionally the end) of an essence file being identified
+	/*! EssenceParser::IdentifyEssence() builds one of these for each file and offers it to every sub-parser in turn.
+	 *  The head of the file is read in a single call when the probe is built, the tail is only read the first time
+	 *  it is requested. Sub-parsers that need more of the file than has been buffered may ask for it, and the buffer
+	 *  will be extended by a single read, so that the extra bytes are also available to any later sub-parsers.
+	 *  \note Reads that lie beyond MaxBufferSize are passed directly to the file and are not buffered
+	 */
+	class EssenceProbe : public RefCount<EssenceProbe>
+	{
+	public:
+		//! Number of bytes read from the start of the file when the probe is built
+		static const size_t DefaultHeadSize;
+
+		//! Largest head or tail buffer that will be held by a probe
+		static const size_t MaxBufferSize;
+
+	protected:
+		FileHandle File;						//!< The file being probed
+		DataChunk Head;							//!< Bytes from the start of the file
+		DataChunk Tail;							//!< Bytes from the end of the file, or empty if not yet requested
+		Position TailStart;						//!< File offset of the first byte in Tail
+		Length FileLength;						//!< The size of the file, or -1 if not yet known
+		bool HeadIsWholeFile;					//!< True once a read of the head has hit the end of the file
+		std::string Options;					//!< Any parser options supplied with the filename
+
+	private:
+		//! Prevent default construction
+		EssenceProbe();
+
+		//! Prevent copy construction
+		EssenceProbe(const EssenceProbe &);
+
+	public:
+		//! Construct a probe for an open file, reading the first HeadSize bytes
+		EssenceProbe(FileHandle InFile, size_t HeadSize = DefaultHeadSize);
+
+		//! Get the handle of the file being probed
+		/*! \note The file pointer position is undefined after any call to a probe method */
+		FileHandle GetFile(void) const { return File; }
+
+		//! Get a pointer to at least Size bytes from the start of the file, extending the buffer if required
+		/*! \return NULL if the file is shorter than Size bytes (or Size > MaxBufferSize)
+		 */
+		const UInt8 *GetHead(size_t Size);
+
+		//! Get the number of bytes currently buffered from the start of the file
+		size_t GetHeadSize(void) const { return Head.Size; }
+
+		//! Get a pointer to the last Size bytes of the file, reading them if required
+		/*! \return NULL if the file is shorter than Size bytes (or Size > MaxBufferSize)
+		 */
+		const UInt8 *GetTail(size_t Size);
+
+		//! Read bytes from a given offset in the file, using the buffered data where possible
+		/*! \return The number of bytes read, which will be less than Size if the file is too short
+		 */
+		size_t Read(Position Offset, UInt8 *Dest, size_t Size);
+
+		//! Get the size of the file being probed, or -1 if not known
+		Length GetFileSize(void);
+
+		//! Set the parser options supplied with the filename
+		/*! These are in the format used by FileParser::SendParserOptions(). They allow sub-parsers for essence
+		 *  with no identifying header, such as raw video, to be told how to interpret the file.
+		 */
+		void SetOptions(const std::string &NewOptions) { Options = NewOptions; }
+
+		//! Get the parser options supplied with the filename, if any
+		const std::string &GetOptions(void) const { return Options; }
+	};
+
+	//! Smart pointer to an EssenceProbe
+	typedef SmartPtr<EssenceProbe> EssenceProbePtr;
+
+
 	//! Abstract base class for all essence parsers
 	/*! \note It is important that no derived class has its own derivation of RefCount<> */
 	class EssenceSubParser : public RefCount<EssenceSubParser>
@@ -1309,6 +1384,16 @@ namespace mxflib
 			return Ret;
 		}
 
+		//! Examine a probed file and return a list of essence descriptors
+		/*! This version is called by EssenceParser::IdentifyEssence() with a probe that is shared between all sub-parsers,
+		 *  allowing a sub-parser to reject the file using already buffered data without any further file access.
+		 *  The default action is to call the FileHandle version, so sub-parsers that do not support probes still work.
+		 */
+		virtual EssenceStreamDescriptorList IdentifyEssence(EssenceProbePtr &Probe)
+		{
+			return IdentifyEssence(Probe->GetFile());
+		}
+
 		//! Examine the open file and return the wrapping options known by this parser
 		/*! \param InFile The open file to examine (if the descriptor does not contain enough info)
 		 *	\param Descriptor An essence stream descriptor (as produced by function IdentifyEssence)
@@ -1585,7 +1670,15 @@ namespace mxflib
 		}
 
 		//! Build a list of parsers with their descriptors for a given essence file
-		static ParserDescriptorListPtr IdentifyEssence(FileHandle InFile);
+		/*! The start of the file is read once into an EssenceProbe that is shared by all sub-parsers */
+		static ParserDescriptorListPtr IdentifyEssence(FileHandle InFile)
+		{
+			EssenceProbePtr Probe = new EssenceProbe(InFile);
+			return IdentifyEssence(Probe);
+		}
+
+		//! Build a list of parsers with their descriptors for a given probed essence file
+		static ParserDescriptorListPtr IdentifyEssence(EssenceProbePtr &Probe);
 
 		//! Configuration data for an essence parser with a specific wrapping option
 		class WrappingConfig;
@@ -1638,6 +1731,9 @@ namespace mxflib
 			//! Set the source file
 			void SetFile(FileHandle InFile) { File = InFile; }
 
+			//! Get the source file, or FileInvalid if not set
+			FileHandle GetFile(void) const { return File; }
+
 			//! Set the essence source
 			/*! DRAGONS: When called, this wrapping config will take (shared) ownership of the source */
 			void SetSource(EssenceSourcePtr &Value) { Source = Value; }
@@ -1782,9 +1878,10 @@ namespace mxflib
 		*/
 		static void ExtractValidWrappingOptions(WrappingConfigList &Ret, FileHandle InFile, EssenceStreamDescriptorPtr &ESDescriptor, WrappingOptionList &WO, Rational &ForceEditRate, WrappingOption::WrapType ForceWrap);
 
-	
-	protected:
+
+	public:
 		//! Initialise the sub-parser list
+		/*! This is called automatically on first use, but must be called before sharing the parser list between threads */
 		static void Init(void);
 	};
 
@@ -1899,6 +1996,76 @@ namespace mxflib
 	typedef SmartPtr<FileParser> FileParserPtr;
 
 
+	//! Background opener for the files of a numbered sequence
+	/*! A worker thread opens each file of the sequence in turn and reads it through, so that its data is in the
+	 *  OS cache when it is needed, then queues the open handle. At most Depth handles are held at a time.
+	 *  This hides the open and stat latency of networked storage for sequences with one (small) file per frame.
+	 *  \note Files are handed over in sequence order and each call to Take() consumes one file, in step with ListOfFiles::GetNextFile()
+	 */
+	class FilePrefetcher : public RefCount<FilePrefetcher>, protected Thread
+	{
+	public:
+		//! The size of the buffer used to read through each file
+		static const size_t ReadBufferSize;
+
+	protected:
+		//! A file that has been opened ahead of time
+		struct PrefetchedFile
+		{
+			std::string Name;					//!< The name of the file as built from the pattern
+			FileHandle File;					//!< The open handle, or FileInvalid if the file could not be opened
+		};
+
+		std::string BaseFileName;				//!< Base filename as a printf string
+		int NextNumber;							//!< The file number of the next file to prefetch
+		int Increment;							//!< Number to add to the file number for each new file
+		int Remaining;							//!< The number of files left to prefetch or -1 for "end when no more files"
+		size_t Depth;							//!< The maximum number of files held open ahead
+
+		std::list<PrefetchedFile> Queue;		//!< Files opened, but not yet taken
+		bool Stopping;							//!< Set to request that the worker stops
+		bool Finished;							//!< Set by the worker once it will queue no more files
+
+		Mutex Lock;								//!< Lock for Queue, Stopping and Finished
+		Condition DataAvailable;				//!< Signalled when a file is queued, or the worker finishes
+		Condition SpaceAvailable;				//!< Signalled when a file is taken, or the worker is asked to stop
+
+	private:
+		//! Prevent default construction
+		FilePrefetcher();
+
+		//! Prevent copy construction
+		FilePrefetcher(const FilePrefetcher &);
+
+	public:
+		//! Construct a prefetcher and start it running
+		/*! \param BaseFileName The printf pattern used to build each file name
+		 *  \param FirstNumber The file number of the first file to prefetch
+		 *  \param Increment The amount to add to the file number for each subsequent file
+		 *  \param Count The number of files to prefetch, or -1 to continue until a file cannot be opened
+		 *  \param Depth The maximum number of files to hold open ahead of use
+		 */
+		FilePrefetcher(std::string BaseFileName, int FirstNumber, int Increment, int Count, size_t Depth);
+
+		//! Stop the worker and close any files not yet taken
+		~FilePrefetcher();
+
+		//! Take the next file from the queue, waiting for it if required
+		/*! \param FileName The name of the file expected next
+		 *  \return The open handle, positioned at the start of the file, or FileInvalid if the next prefetched file
+		 *          does not have the expected name or could not be opened (the caller should then open it directly)
+		 */
+		FileHandle Take(const std::string &FileName);
+
+	protected:
+		//! The body of the worker thread
+		virtual void Run(void);
+	};
+
+	//! Smart pointer to a FilePrefetcher
+	typedef SmartPtr<FilePrefetcher> FilePrefetcherPtr;
+
+
 	//! List-of-files base class for handling a sequential set of files
 	class ListOfFiles
 	{
@@ -1923,9 +2090,14 @@ namespace mxflib
 		Position RangeEnd;						//!< The requested last edit unit, or -1 if using RequestedDuration
 		Length RangeDuration;					//!< The requested duration, or -1 if using RequestedEnd
 
+		size_t PrefetchDepth;					//!< The number of files of a numbered sequence to open ahead, or 0 to disable prefetching
+		FilePrefetcherPtr Prefetcher;			//!< The prefetcher for the current sequence, if one is running
+		size_t PrefetchHits;					//!< Number of files of the current sequence taken from the prefetcher
+		size_t PrefetchMisses;					//!< Number of files of the current sequence that the prefetcher did not supply
+
 	public:
 		//! Construct a ListOfFiles and optionally set a single source filename pattern
-		ListOfFiles(std::string FileName = "") : ExternalEssence(false), RangeStart(-1), RangeEnd(-1), RangeDuration(-1)
+		ListOfFiles(std::string FileName = "") : ExternalEssence(false), RangeStart(-1), RangeEnd(-1), RangeDuration(-1), PrefetchDepth(0), PrefetchHits(0), PrefetchMisses(0)
 		{
 			AtEOF = false;
 
@@ -1942,7 +2114,7 @@ namespace mxflib
 		}
 
 		//! Virtual destructor to allow polymorphism
-		virtual ~ListOfFiles() {}
+		virtual ~ListOfFiles() { StopPrefetch(); }
 
 		//! Set a single source filename pattern
 		void SetFileName(std::string &FileName) 
@@ -1983,6 +2155,18 @@ namespace mxflib
 		//! Set a handler to receive notification of all file open actions
 		void SetNewFileHandler(NewFileHandler *NewHandler) { Handler = NewHandler; }
 
+		//! Enable opening of the next Depth files of a numbered sequence on a background thread
+		/*! This hides per-file open latency, which can dominate for one-file-per-frame sequences on networked storage.
+		 *  A Depth of zero disables prefetching (the default). Takes effect from the next sequence started.
+		 */
+		void SetPrefetch(size_t Depth) { PrefetchDepth = Depth; }
+
+		//! Get the number of files of the current sequence that were taken from the prefetcher, already open
+		size_t GetPrefetchHits(void) const { return PrefetchHits; }
+
+		//! Get the number of files of the current sequence that had to be opened when needed, despite prefetching
+		size_t GetPrefetchMisses(void) const { return PrefetchMisses; }
+
 		//! Get the start of any range specified, or -1 if none
 		Position GetRangeStart(void) const { return RangeStart; }
 
@@ -2024,6 +2208,22 @@ namespace mxflib
 		//! Parse a given multi-file name
 		void ParseFileName(std::string FileName);
 
+		//! Take the current file from the prefetcher, if it has been opened ahead of time
+		/*! \return The open handle, or FileInvalid if the file has not been prefetched
+		 */
+		FileHandle TakePrefetchedFile(void)
+		{
+			if(!Prefetcher) return FileInvalid;
+
+			FileHandle Ret = Prefetcher->Take(CurrentFileName);
+			if(FileValid(Ret)) PrefetchHits++; else PrefetchMisses++;
+
+			return Ret;
+		}
+
+		//! Stop any prefetcher for the current sequence, reporting how many of its files were used
+		void StopPrefetch(void);
+
 		//! Process an ampersand separated list of sub-file names
 		virtual void ProcessSubNames(std::string SubNames) {};
 	};
@@ -2633,7 +2833,8 @@ namespace mxflib
 		 */
 		bool OpenFile(void)
 		{
-			CurrentFile = FileOpenRead(CurrentFileName.c_str());
+			CurrentFile = TakePrefetchedFile();
+			if(!FileValid(CurrentFile)) CurrentFile = FileOpenRead(CurrentFileName.c_str());
 			CurrentFileOpen = FileValid(CurrentFile);
 
 			return CurrentFileOpen;
@@ -2654,6 +2855,12 @@ namespace mxflib
 		//! Add a sub-source that will be processed as if it contains data extracted from the primary source
 		UInt32 AddSubSource(EssenceSubSource *SubSource);
 
+		//! Send options to a sub-parser based on a formatted string
+		/*! Each option is a string with an optional equals and Int64 number. Options are semi-colon separated.
+		 *  The option string may be within quotes, if not it will be left and right trimmed to remove spaces
+		 */
+		static void SendParserOptions(EssenceSubParserPtr &SubParser, const std::string Options);
+
 		//! Set the essence descriptor
 		virtual void SetDescriptor(MDObjectPtr Descriptor) 
 		{
@@ -2892,12 +3099,6 @@ namespace mxflib
 		// Allow our protected member to access our internals
 		friend class SequentialEssenceSource;
 
-		//! Send options to a sub-parser based on a formatted string
-		/*! Each option is a string with an optional equals and Int64 number. Options are semi-colon separated.
-		 *  The option string may be within quotes, if not it will be left and right trimmed to remove spaces
-		 */
-		void SendParserOptions(EssenceSubParserPtr &SubParser, const std::string Options);
-
 		//! Process an ampersand separated list of sub-file names
 		virtual void ProcessSubNames(std::string SubNames);
 	};
@@ -2941,6 +3142,8 @@ namespace mxflib
 		bool StopCalled;								//!< True if StopReading() called while processing the current KLV
 		bool PushBackRequested;							//!< True if StopReading() called with PushBackKLV = true
 
+		UInt64 KLVCount;								//!< Number of KLVs passed to handlers (or discarded for want of one) by this reader
+
 		GCReadHandlerPtr DefaultHandler;				//!< The default handler to receive all KLVs without a specific handler
 		GCReadHandlerPtr FillerHandler;					//!< The hanlder to receive all filler KLVs
 		GCReadHandlerPtr EncryptionHandler;				//!< The hanlder to receive all encrypted KLVs
@@ -3047,6 +3250,9 @@ namespace mxflib
 		 */
 		Position GetFileOffset(void) { return FileOffset; }
 
+		//! Get the number of KLVs dispatched by this reader, including fillers and any decrypted KLVs pushed back by a handler
+		UInt64 GetKLVCount(void) const { return KLVCount; }
+
 
 		/*** Functions for use by read handlers ***/
 
@@ -3093,6 +3299,10 @@ namespace mxflib
 
 		std::map<UInt32, GCReaderPtr> Readers;	//!< Map of GCReaders indexed by BodySID
 
+		std::map<UInt32, IndexTablePtr> IndexTables;	//!< Index tables extended from the segments in each partition read, indexed by IndexSID
+
+		PartitionPtr StartPartition;			//!< A partition pack already read by the caller from which to start reading, or NULL
+
 	public:
 		//! Construct a body reader and associate it with an MXF file
 		BodyReader(MXFFilePtr File);
@@ -3140,6 +3350,49 @@ namespace mxflib
 		 */
 		GCReader *NewGCReader(UInt32 BodySID, GCReadHandlerPtr DefaultHandler = NULL, GCReadHandlerPtr FillerHandler = NULL);
 
+		//! Set an index table to be extended from the index table segments of each partition read
+		/*! Each time a partition pack with this IndexSID is read its index table segments are added to the table, skipping
+		 *  any segment already held. This keeps the table up to date with a file that is still being written.
+		 *  \param IndexSID The IndexSID of the index table
+		 *  \param Index The table to extend, or NULL to stop extending the table for this IndexSID
+		 */
+		void SetIndexTable(UInt32 IndexSID, IndexTablePtr Index = NULL)
+		{
+			if(Index) IndexTables[IndexSID] = Index;
+			else IndexTables.erase(IndexSID);
+		}
+
+		//! Start reading from a partition pack that has already been read, rather than reading it again
+		/*! This allows a stream, such as a pipe, to be read from the header partition after its metadata has been read,
+		 *  without reading back to the partition pack. The partition's metadata, if any, must be read before calling this.
+		 *  Reading continues with the index table segments and essence of this partition, then the following partitions.
+		 */
+		void SetStartPartition(PartitionPtr ThisPartition)
+		{
+			StartPartition = ThisPartition;
+			CurrentPos = ThisPartition->GetLocation();
+			NewPos = true;
+			AtPartition = true;
+			AtEOF = false;
+		}
+
+		//! Follow a file that is still being written, waiting for new partitions and essence rather than stopping at its end
+		/*! Reads wait for each KLV to be completely written, using MXFFile::SetFollow(), so handlers keep receiving data as
+		 *  the writer appends it. Following stops once the footer partition is reached, as nothing after that is essence.
+		 *  Use SetIndexTable() to have the index table extended from the sprinkled or isolated index segments of new partitions.
+		 *  \param Enable true to follow the file, false to stop at its current end
+		 *  \param Timeout Time in milliseconds without the file growing after which reading gives up as at the end of a
+		 *                 normal file, or -1 to wait until StopFollowing() is called
+		 *  \return true if the file is now being followed
+		 *  \note The RIP, header and any other data needed from the end of the file should be read before enabling this
+		 *  \note Clip wrapped essence written with FastClipWrap enabled cannot be followed as its length is not known until the end
+		 */
+		bool SetFollow(bool Enable = true, int Timeout = -1) { return File->SetFollow(Enable, Timeout); }
+
+		//! End any wait for the file to grow, so that reading stops as at the end of a normal file
+		/*! This is safe to call from another thread while ReadFromFile() is waiting */
+		void StopFollowing(void) { File->StopFollowing(); }
+
 		//! Get a pointer to the GCReader used for the specified BodySID
 		GCReaderPtr GetGCReader(UInt32 BodySID)
 		{
@@ -3174,12 +3427,28 @@ namespace mxflib
 		bool Eof(void);
 
 
+		//! Hint that a range of edit units of an indexed stream will be read soon
+		/*! The index table is used to predict where the edit units lie in the file, and the operating system is asked to
+		 *  start reading them in the background. The reading state and the file pointer are not changed.
+		 *  \param BodySID The BodySID of the stream
+		 *  \param Index The index table for the stream, which must have exact entries for EditUnit and EditUnit + Count
+		 *  \param EditUnit The first edit unit that will be read, in stored order (as for a BodyReader, not reordered as displayed)
+		 *  \param Count The number of edit units that will be read
+		 *  \return false if the range could not be located
+		 */
+		bool WillNeed(UInt32 BodySID, IndexTablePtr Index, Position EditUnit, Length Count = 1);
+
+
 		/*** Functions for use by read handlers ***/
 
 		//! Get the BodySID of the current location (0 if not known)
 		UInt32 GetBodySID(void) { return CurrentBodySID; }
 
 
+	public:
+		//! The size of the window used when scanning for partition packs through corrupt or unknown data
+		static const size_t ScanWindowSize;
+
 	protected:
 		//! Initialize the per SID seek system
 		/*! To allow us to seek to byte offsets within a file we need to initialize 
@@ -3187,6 +3456,31 @@ namespace mxflib
 		 *  \return False if seeking could not be initialized (perhaps because the file is not seekable)
 		 */
 		bool InitSeek(void);
+
+		//! Find the file offset of a specific byte offset in a given stream
+		/*! \return The file offset, -1 on error or 0 if beyond the last partition in the RIP
+		 *  \note The file pointer may be moved by this function
+		 */
+		Position LocateStreamOffset(UInt32 BodySID, Position Pos);
+
+		//! Scan forwards for the next valid partition pack
+		/*! The file is read in ScanWindowSize windows, and each window is searched in memory, so corrupt
+		 *  or non-MXF data is crossed with few reads rather than one read per byte or per KLV. If the file is being
+		 *  followed only the data written so far is scanned, rather than waiting for a whole window
+		 *  \param Start The position in the file from which to start searching
+		 *  \return The position of the partition pack, or -1 if none is found before the end of the file
+		 */
+		Position ScanForPartition(Position Start);
+
+		//! Check that a partition pack key found by scanning starts a valid partition pack
+		/*! The length and structure of the partition pack are checked, along with the start of the key of the following KLV (if any)
+		 *  \note The file pointer is moved by this function
+		 */
+		bool ValidatePartition(Position Pos);
+
+		//! Add the index table segments of a partition to any index table set for its IndexSID
+		/*! \note The file pointer is moved by this function */
+		void ReadIndexSegments(PartitionPtr &ThisPartition);
 	};
 
 	//! Smart pointer to a BodyReader
@@ -3248,6 +3542,18 @@ namespace mxflib
 	 */
 	UInt32 GetGCTrackNumber(ULPtr TheUL);
 
+	//! Classes of key, as used to dispatch KLVs when reading a Generic Container
+	typedef enum _GCKeyClass { GCKey_Other, GCKey_Element, GCKey_Filler, GCKey_Encrypted, GCKey_System, GCKey_GStream } GCKeyClass;
+
+	//! Classify a key for dispatch when reading a Generic Container
+	/*! The key is compared as two 64-bit words against precompiled masks, including those for any registered alternative keys,
+	 *  so that a GC element is recognised and its track number found without any byte-by-byte compares.
+	 *  \param Key The 16-byte key to classify
+	 *  \param TrackNumber Set to the track number if this is a GC element key, else 0
+	 *  \note Standard GC element keys are found first, then filler and encrypted keys before any registered alternative keys are tried
+	 */
+	GCKeyClass ClassifyGCKey(const UInt8 *Key, UInt32 &TrackNumber);
+
 	//! GCLayout class maintains a vector of GC elements (both Sys and Essence) discovered while reading
 	class GCLayout
 	{
@@ -3886,6 +4192,10 @@ namespace mxflib
 		 */
 		UInt32 PartitionBodySID;
 
+		Length PreallocateSize;									//!< Number of bytes of disk space to reserve when the header is written, or 0 for none
+		bool Preallocated;										//!< True if disk space was reserved, so any not used must be released after the footer
+		UInt32 ExtentSize;										//!< File system extent size to align body partitions to, or 0 for none
+
 		//! Prevent NULL construction
 		BodyWriter();
 
@@ -3893,6 +4203,9 @@ namespace mxflib
 		BodyWriter(BodyWriter &);
 
 	public:
+		//! Allowance added by EstimateSize() for the partition packs, metadata and index tables
+		static const Length EstimateOverhead;
+
 		//! Construct a body writer for a specified file
 		BodyWriter(MXFFilePtr &DestFile)
 		{
@@ -3918,6 +4231,10 @@ namespace mxflib
 			PendingMetadata = false;
 			PartitionBodySID = 0;
 			PendingGeneric = false;
+
+			PreallocateSize = 0;
+			Preallocated = false;
+			ExtentSize = 0;
 		}
 
 		//! Clear any stream details ready to call AddStream()
@@ -3972,6 +4289,7 @@ namespace mxflib
 		/*! No essence will be written, but CBR index tables will be written if required.
 		 *  The partition will not be "ended" if only the header partition is written
 		 *  meaning that essence will be added by the next call to WritePartition()
+		 *  \note If the file is a stream the header is always open and incomplete, as it can't be updated later
 		 */
 		void WriteHeader(bool IsClosed, bool IsComplete);
 
@@ -4033,6 +4351,40 @@ namespace mxflib
 		 */
 		void SetPartitionFiller(UInt32 PartitionFiller) { MinPartitionFiller = PartitionFiller; }
 
+		//! Reserve disk space for the file when the header is written
+		/*! A file grown by many small writes, particularly while other files are written to the same storage, may be scattered
+		 *  over many small extents, which slows later reads. Reserving the space first lets the file system lay it out in a few
+		 *  large extents. Any space not used is released after the footer is written, so an over-estimate only costs disk space
+		 *  while the file is being written.
+		 *  \param Size The number of bytes to reserve, such as a value returned by EstimateSize(), or zero (or -1) for none
+		 *  \note This has no effect if the system or file system can't reserve space, or for streams
+		 */
+		void SetPreallocate(Length Size) { PreallocateSize = (Size > 0) ? Size : 0; }
+
+		//! Get the number of bytes of disk space to be reserved when the header is written, or zero for none
+		Length GetPreallocate(void) { return PreallocateSize; }
+
+		//! Estimate the final size of the file from the constant bit rates and durations of the streams
+		/*! The duration of each stream is its StopAfter value if set, otherwise Duration if given, otherwise the duration
+		 *  of the range set for its source.
+		 *  \return The estimated size in bytes, including an allowance for metadata and index tables, or -1 if any stream
+		 *          is not constant bit rate or its duration is not known
+		 *  \note This must be called after all streams are added and the KAG is set
+		 */
+		Length EstimateSize(Length Duration = 0);
+
+		//! Set the file system extent size to align body partitions to
+		/*! Each body partition is started at a multiple of this size from the start of the file, by adding filler to the end
+		 *  of the previous partition, so that partitions fill whole extents and are not split across more extents than needed.
+		 *  The footer is not aligned, as this would only add filler to the end of the file.
+		 *  \note This should be a multiple of the KAG. Where the gap to the next boundary is more than the largest filler
+		 *        supported (0x00ffffff bytes) it is filled with several fillers
+		 */
+		void SetExtentSize(UInt32 Size) { ExtentSize = Size; }
+
+		//! Get the file system extent size body partitions are aligned to, or zero for none
+		UInt32 GetExtentSize(void) { return ExtentSize; }
+
 		//! Initialize all required index managers
 		void InitIndexManagers(void);
 
@@ -4061,6 +4413,12 @@ namespace mxflib
 
 		//! Write a partition pack for the current partition - but do not flag it as "ended"
 		void WritePartitionPack(void);
+
+		//! Move the index tables of each stream into body partitions, for writing to a stream
+		/*! A stream's reader may never see the footer, and the header can't be updated, so header and footer index
+		 *  tables are replaced by sprinkled VBR or per-partition CBR index tables in the body
+		 */
+		void SetStreamingIndexTypes(void);
 	};
 
 	//! Smart pointer to a BodyWriter
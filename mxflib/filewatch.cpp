@@ -0,0 +1,106 @@
+/*! \file	filewatch.cpp
+ *	\brief	Implementation of class that waits for changes to a file that is being written
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+// Required for strerror()
+#include <string.h>
+
+#include "mxflib/mxflib.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif // __linux__
+
+using namespace mxflib;
+
+
+//! Start watching the named file
+FileWatch::FileWatch(std::string FileName)
+{
+	NotifyFD = -1;
+	WatchFD = -1;
+
+#ifdef __linux__
+	NotifyFD = inotify_init();
+	if(NotifyFD < 0) return;
+
+	// Make sure that draining the events in Wait() cannot block
+	fcntl(NotifyFD, F_SETFL, fcntl(NotifyFD, F_GETFL) | O_NONBLOCK);
+
+	WatchFD = inotify_add_watch(NotifyFD, FileName.c_str(), IN_MODIFY | IN_CLOSE_WRITE);
+	if(WatchFD < 0)
+	{
+		debug("Unable to watch \"%s\" for changes, will poll instead - %s\n", FileName.c_str(), strerror(errno));
+
+		close(NotifyFD);
+		NotifyFD = -1;
+	}
+#endif // __linux__
+}
+
+
+//! Stop watching the file
+FileWatch::~FileWatch()
+{
+#ifdef __linux__
+	// Closing the instance removes the watch
+	if(NotifyFD >= 0) close(NotifyFD);
+#endif // __linux__
+}
+
+
+//! Wait until the file is written to, or a time has passed
+bool FileWatch::Wait(int Timeout)
+{
+#ifdef __linux__
+	if(NotifyFD >= 0)
+	{
+		struct pollfd Poll;
+		Poll.fd = NotifyFD;
+		Poll.events = POLLIN;
+		Poll.revents = 0;
+
+		int Ret = poll(&Poll, 1, Timeout);
+		if(Ret <= 0) return false;
+
+		// Drain the queued events, we only need to know that there were some
+		UInt8 Buffer[4096];
+		while(read(NotifyFD, Buffer, sizeof(Buffer)) > 0) {};
+
+		return true;
+	}
+
+	poll(NULL, 0, Timeout);
+#elif defined(_WIN32)
+	Sleep(Timeout);
+#else
+	usleep(static_cast<useconds_t>(Timeout) * 1000);
+#endif
+
+	return false;
+}
@@ -0,0 +1,77 @@
+/*! \file	filewatch.h
+ *	\brief	Definition of class that waits for changes to a file that is being written
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#ifndef MXFLIB__FILEWATCH_H
+#define MXFLIB__FILEWATCH_H
+
+
+namespace mxflib
+{
+	//! Watch on a file that is being written by another process, used to wait for it to grow
+	/*! On Linux the kernel notifies us of each write to the file using inotify, so a wait ends as soon as new data is
+	 *  written. Elsewhere, or if the watch cannot be set up (for example on some network filesystems), Wait() simply
+	 *  sleeps for the given time so that the caller polls the file instead.
+	 */
+	class FileWatch : public RefCount<FileWatch>
+	{
+	protected:
+		int NotifyFD;						//!< The inotify instance, or -1 if not notified of changes
+		int WatchFD;						//!< The watch on the file within the inotify instance, or -1 if none
+
+	private:
+		//! Prevent default construction
+		FileWatch();
+
+		//! Prevent copy construction
+		FileWatch(const FileWatch &);
+
+		//! Prevent assignment
+		FileWatch &operator=(const FileWatch &);
+
+	public:
+		//! Start watching the named file
+		FileWatch(std::string FileName);
+
+		//! Stop watching the file
+		~FileWatch();
+
+		//! Are we notified of changes to the file, rather than polling?
+		bool IsNotified(void) const { return WatchFD >= 0; }
+
+		//! Wait until the file is written to, or a time has passed
+		/*! \param Timeout The longest time to wait, in milliseconds
+		 *  \return true if notified that the file was written to, false if the time passed
+		 *  \note Writes made before the call may also end the wait, so the caller should always check for the change it wants
+		 */
+		bool Wait(int Timeout);
+	};
+
+	//! A smart pointer to a FileWatch
+	typedef SmartPtr<FileWatch> FileWatchPtr;
+}
+
+#endif // MXFLIB__FILEWATCH_H
@@ -0,0 +1,363 @@
+/*! \file	frameprefetch.cpp
+ *	\brief	Implementation of class that reads edit units ahead of use for random-access playback
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#include "mxflib/mxflib.h"
+
+#include "mxflib/frameprefetch.h"
+
+#include <algorithm>
+
+using namespace mxflib;
+
+
+namespace
+{
+	//! Look up the start of an edit unit, ignoring whether the location of any particular element is known
+	/*! \return true if the edit unit is indexed, with Pos set to the result
+	 */
+	bool LookupEditUnit(IndexTablePtr &Index, Position EditUnit, bool Reorder, IndexPosPtr &Pos)
+	{
+		if(EditUnit < 0) return false;
+
+		Pos = Index->Lookup(EditUnit, 0, Reorder);
+		if(!Pos) return false;
+
+		// Not being exact only means that the sub-item was not found, but a different position means the edit unit is not indexed
+		if(Pos->Exact) return true;
+		if(Pos->OtherPos) return false;
+
+		// DRAGONS: A lookup before the start of the index table returns edit unit 0 at location 0 without setting OtherPos
+		return (Pos->ThisPos != 0) || (EditUnit == 0);
+	}
+}
+
+
+//! Default maximum number of edit units held in the cache
+const size_t FramePrefetcher::DefaultCacheSize = 32;
+
+//! Default number of edit units to read ahead
+const size_t FramePrefetcher::DefaultDepth = 8;
+
+//! The largest distance between requests taken as a play speed rather than a jump
+const Length FramePrefetcher::MaxAutoStep = 32;
+
+
+//! Construct a prefetcher and start it running
+FramePrefetcher::FramePrefetcher(MXFFilePtr File, IndexTablePtr Index, UInt32 BodySID, size_t CacheSize /*=DefaultCacheSize*/, size_t Depth /*=DefaultDepth*/)
+	: File(File), Index(Index), BodySID(BodySID), CacheSize(CacheSize), Depth(Depth)
+{
+	UseCount = 0;
+	Current = -1;
+	Step = 1;
+	AutoStep = true;
+	Pending = -1;
+	Hits = 0;
+	Misses = 0;
+	Stopping = false;
+
+	// Leave space for the frame being used as well as those read ahead
+	if(this->CacheSize < 2) this->CacheSize = 2;
+	if(this->Depth >= this->CacheSize) this->Depth = this->CacheSize - 1;
+
+	/* Map the stream offset of each partition of this essence container to the file offset of its essence, so
+	 * that frames can be located without reading partition packs, which would move the shared file pointer
+	 */
+
+	if(File->FileRIP.empty()) File->GetRIP();
+
+	Position FilePos = File->Tell();
+
+	RIP::iterator it;
+	for(it = File->FileRIP.begin(); it != File->FileRIP.end(); it++)
+	{
+		PartitionInfoPtr PartInfo = (*it).second;
+		PartitionStarts.push_back(PartInfo->GetByteOffset());
+
+		if(PartInfo->GetBodySID() != BodySID) continue;
+
+		Position StreamOffset = PartInfo->GetStreamOffset();
+		Position EssenceStart = PartInfo->GetEssenceStart();
+		if((StreamOffset == -1) || (EssenceStart == -1))
+		{
+			File->Seek(PartInfo->GetByteOffset());
+			PartInfo->ThePartition = File->ReadPartition();
+			if(!PartInfo->ThePartition) continue;
+
+			StreamOffset = PartInfo->ThePartition->GetInt64("BodyOffset");
+			PartInfo->SetStreamOffset(StreamOffset);
+
+			if(!PartInfo->ThePartition->SeekEssence()) continue;
+
+			EssenceStart = File->Tell();
+			PartInfo->SetEssenceStart(EssenceStart);
+		}
+
+		// DRAGONS: A later partition replaces an earlier one with the same stream offset, as the earlier one holds no essence
+		EssenceStarts[StreamOffset] = EssenceStart;
+	}
+
+	// The end of the file ends the last partition
+	PartitionStarts.push_back(File->Size());
+
+	File->Seek(FilePos);
+
+	// DRAGONS: Only positioned reads of a read-only file are safe alongside other use of the file, otherwise all frames are read when requested
+	if(File->IsReadOnly()) Start();
+}
+
+
+//! Stop the worker and release the cache
+FramePrefetcher::~FramePrefetcher()
+{
+	Lock.Lock();
+	Stopping = true;
+	WorkAvailable.Broadcast();
+	Lock.Unlock();
+
+	Join();
+}
+
+
+//! Get the bytes of an edit unit, waiting for it to be read if not already in the cache
+DataChunkPtr FramePrefetcher::GetFrame(Position EditUnit)
+{
+	DataChunkPtr Ret;
+
+	Lock.Lock();
+
+	// The distance from the last request gives the play direction and speed, unless it is a jump to a new position
+	if(AutoStep && (Current >= 0))
+	{
+		Length Distance = EditUnit - Current;
+		if((Distance != 0) && (Distance <= MaxAutoStep) && (Distance >= -MaxAutoStep)) Step = Distance;
+	}
+
+	Current = EditUnit;
+	UseCount++;
+
+	// The cache holds edit units in stored order, so find where this one is stored
+	IndexPosPtr Pos;
+	if(!LookupEditUnit(Index, EditUnit, true, Pos))
+	{
+		Lock.Unlock();
+
+		error("No index entry for edit unit %s in FramePrefetcher::GetFrame()\n", Int64toString(EditUnit).c_str());
+		return NULL;
+	}
+
+	Position Stored = static_cast<Position>(Pos->ThisPos);
+
+	// If the worker is reading this frame now, wait for it rather than reading it again
+	while(Pending == Stored) FrameReady.Wait(Lock);
+
+	FrameMap::iterator it = Cache.find(Stored);
+	if(it != Cache.end())
+	{
+		Hits++;
+		(*it).second.LastUse = UseCount;
+		Ret = (*it).second.Data;
+	}
+	else
+	{
+		Misses++;
+
+		Position Start;
+		Length Size;
+		if(LocateFrame(Stored, Start, Size))
+		{
+			// Read the frame ourselves, rather than waiting for the worker to reach it
+			Lock.Unlock();
+			Ret = File->ReadAt(Start, static_cast<size_t>(Size));
+			Lock.Lock();
+
+			if(Ret->Size != static_cast<size_t>(Size))
+			{
+				error("Only read 0x%s of 0x%s bytes of edit unit %s\n", Int64toHexString(Ret->Size).c_str(), Int64toHexString(Size).c_str(), Int64toString(EditUnit).c_str());
+				Ret = NULL;
+			}
+
+			AddFrame(Stored, Ret);
+		}
+		else
+		{
+			error("Could not locate edit unit %s in BodySID 0x%04x\n", Int64toString(EditUnit).c_str(), BodySID);
+		}
+	}
+
+	// The new position changes the frames predicted
+	WorkAvailable.Signal();
+	Lock.Unlock();
+
+	return Ret;
+}
+
+
+//! Set the distance between requests, negative for reverse play
+void FramePrefetcher::SetStep(Length NewStep)
+{
+	MutexLock Locked(Lock);
+
+	if(NewStep == 0)
+	{
+		AutoStep = true;
+	}
+	else
+	{
+		AutoStep = false;
+		Step = NewStep;
+	}
+
+	WorkAvailable.Signal();
+}
+
+
+//! The body of the worker thread
+void FramePrefetcher::Run(void)
+{
+	Lock.Lock();
+
+	for(;;)
+	{
+		Position EditUnit = -1;
+		while(!Stopping && ((EditUnit = NextWanted()) < 0)) WorkAvailable.Wait(Lock);
+
+		if(Stopping) break;
+
+		DataChunkPtr Data;
+
+		Position Start;
+		Length Size;
+		if(LocateFrame(EditUnit, Start, Size))
+		{
+			Pending = EditUnit;
+
+			Lock.Unlock();
+			Data = File->ReadAt(Start, static_cast<size_t>(Size));
+			Lock.Lock();
+
+			if(Data->Size != static_cast<size_t>(Size)) Data = NULL;
+
+			Pending = -1;
+		}
+
+		// A frame that could not be read is cached as NULL so that it is not tried again, GetFrame() will report the error
+		AddFrame(EditUnit, Data);
+		FrameReady.Broadcast();
+	}
+
+	Lock.Unlock();
+}
+
+
+//! Locate an edit unit in the file
+bool FramePrefetcher::LocateFrame(Position EditUnit, Position &Start, Length &Size)
+{
+	IndexPosPtr Pos;
+	if(!LookupEditUnit(Index, EditUnit, false, Pos)) return false;
+
+	// Find the partition holding this stream offset
+	std::map<Position, Position>::iterator it = EssenceStarts.upper_bound(Pos->Location);
+	if(it == EssenceStarts.begin()) return false;
+	it--;
+
+	Start = (*it).second + (Pos->Location - (*it).first);
+
+	// The edit unit ends where the next one starts, which is valid even if the next is in a following partition
+	IndexPosPtr NextPos;
+	if(LookupEditUnit(Index, EditUnit + 1, false, NextPos) && (NextPos->Location > Pos->Location))
+	{
+		Size = NextPos->Location - Pos->Location;
+		return true;
+	}
+
+	// DRAGONS: The last indexed edit unit is taken to run to the next partition or the end of the file, so may include trailing fill
+	std::vector<Position>::iterator End_it = std::upper_bound(PartitionStarts.begin(), PartitionStarts.end(), Start);
+	if(End_it == PartitionStarts.end()) return false;
+
+	Size = (*End_it) - Start;
+
+	return Size > 0;
+}
+
+
+//! Choose the next edit unit for the worker to read
+Position FramePrefetcher::NextWanted(void)
+{
+	if(Current < 0) return -1;
+
+	// Count the frames wanted, cached or not, so that the cache is never asked to hold more than it can
+	size_t Wanted = 0;
+
+	for(size_t i = 1; i <= Depth; i++)
+	{
+		IndexPosPtr Pos;
+		if(!LookupEditUnit(Index, Current + Step * static_cast<Length>(i), true, Pos)) break;
+
+		Position Stored = static_cast<Position>(Pos->ThisPos);
+
+		// Long-GOP frames can't be decoded without their key frame, so read that first
+		if(Pos->KeyFrameOffset != 0)
+		{
+			Position Key = Stored + Pos->KeyFrameOffset;
+			if(Key >= 0)
+			{
+				if(++Wanted >= CacheSize) break;
+				if(Cache.find(Key) == Cache.end()) return Key;
+			}
+		}
+
+		if(++Wanted >= CacheSize) break;
+		if(Cache.find(Stored) == Cache.end()) return Stored;
+	}
+
+	return -1;
+}
+
+
+//! Add a frame to the cache, discarding the least recently used frame if it is full
+void FramePrefetcher::AddFrame(Position EditUnit, DataChunkPtr &Data)
+{
+	FrameMap::iterator it = Cache.find(EditUnit);
+	if(it == Cache.end())
+	{
+		while(Cache.size() >= CacheSize)
+		{
+			FrameMap::iterator Oldest = Cache.begin();
+			for(it = Cache.begin(); it != Cache.end(); it++)
+			{
+				if((*it).second.LastUse < (*Oldest).second.LastUse) Oldest = it;
+			}
+
+			Cache.erase(Oldest);
+		}
+
+		it = Cache.insert(FrameMap::value_type(EditUnit, CachedFrame())).first;
+	}
+
+	(*it).second.Data = Data;
+	(*it).second.LastUse = UseCount;
+}
@@ -0,0 +1,158 @@
+/*! \file	frameprefetch.h
+ *	\brief	Definition of class that reads edit units ahead of use for random-access playback
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#ifndef MXFLIB__FRAMEPREFETCH_H
+#define MXFLIB__FRAMEPREFETCH_H
+
+#include <map>
+#include <vector>
+
+
+namespace mxflib
+{
+	//! Reader for the edit units of an indexed essence container that reads ahead of playback on a worker thread
+	/*! Each call to GetFrame() returns the bytes of one edit unit (for frame wrapped essence this is the whole content package)
+	 *  and notes the play direction and speed as the distance from the previous request. A worker thread uses the index table
+	 *  to predict the next Depth edit units at that step, along with the key frame each depends on, and reads them into a
+	 *  bounded cache so that jog, shuttle and scrub playback do not wait for each read.
+	 *
+	 *  \note The file must be opened read-only, as the worker uses MXFFile::ReadAt(). If not, no worker is started and every
+	 *        frame is read when requested. The index table must not be changed while the prefetcher exists.
+	 */
+	class FramePrefetcher : public RefCount<FramePrefetcher>, protected Thread
+	{
+	public:
+		//! Default maximum number of edit units held in the cache
+		static const size_t DefaultCacheSize;
+
+		//! Default number of edit units to read ahead
+		static const size_t DefaultDepth;
+
+		//! The largest distance between requests taken as a play speed rather than a jump
+		static const Length MaxAutoStep;
+
+	protected:
+		//! An edit unit held in the cache
+		struct CachedFrame
+		{
+			DataChunkPtr Data;						//!< The bytes of the edit unit, or NULL if it could not be read
+			UInt64 LastUse;							//!< Value of UseCount when last requested or read
+		};
+
+		//! Map of cached frames, indexed by edit unit
+		typedef std::map<Position, CachedFrame> FrameMap;
+
+		MXFFilePtr File;							//!< The file being read
+		IndexTablePtr Index;						//!< Index table for the essence container
+		UInt32 BodySID;								//!< BodySID of the essence container
+		size_t CacheSize;							//!< Maximum number of edit units held in the cache
+		size_t Depth;								//!< Number of edit units to read ahead
+
+		std::map<Position, Position> EssenceStarts;	//!< File offset of the essence in each partition, indexed by stream offset
+		std::vector<Position> PartitionStarts;		//!< File offset of each partition, in order
+
+		FrameMap Cache;								//!< Frames read, indexed by edit unit
+		UInt64 UseCount;							//!< Incremented for each request, used to find the least recently used frame
+		Position Current;							//!< The most recently requested edit unit, or -1 if none
+		Length Step;								//!< The predicted distance to the next request
+		bool AutoStep;								//!< True if Step is updated from the distance between requests
+		Position Pending;							//!< The edit unit being read by the worker, or -1 if none
+
+		UInt64 Hits;								//!< Number of requests satisfied from the cache
+		UInt64 Misses;								//!< Number of requests that had to be read
+
+		bool Stopping;								//!< Set to request that the worker stops
+
+		Mutex Lock;									//!< Lock for all the above that may change, and for use of the index table
+		Condition WorkAvailable;					//!< Signalled when a new request changes the predicted frames, or the worker is asked to stop
+		Condition FrameReady;						//!< Signalled when the worker has finished reading a frame
+
+	private:
+		//! Prevent default construction
+		FramePrefetcher();
+
+		//! Prevent copy construction
+		FramePrefetcher(const FramePrefetcher &);
+
+	public:
+		//! Construct a prefetcher and start it running
+		/*! \param File The open MXF file to read from, which should be opened read-only
+		 *  \param Index An index table for the essence container, with an entry for each edit unit to be read
+		 *  \param BodySID The BodySID of the essence container
+		 *  \param CacheSize The maximum number of edit units held in the cache
+		 *  \param Depth The number of edit units to read ahead, this is limited to one less than CacheSize
+		 */
+		FramePrefetcher(MXFFilePtr File, IndexTablePtr Index, UInt32 BodySID, size_t CacheSize = DefaultCacheSize, size_t Depth = DefaultDepth);
+
+		//! Stop the worker and release the cache
+		~FramePrefetcher();
+
+		//! Get the bytes of an edit unit, waiting for it to be read if not already in the cache
+		/*! \return The edit unit, or NULL if it could not be located or read
+		 *  \note The returned chunk may be shared with the cache and must not be modified
+		 */
+		DataChunkPtr GetFrame(Position EditUnit);
+
+		//! Set the distance between requests, negative for reverse play
+		/*! \param NewStep The step to use, or 0 to predict it from the distance between requests (the default) */
+		void SetStep(Length NewStep);
+
+		//! Get the distance currently predicted between requests
+		Length GetStep(void) { MutexLock Locked(Lock); return Step; }
+
+		//! Get the number of requests satisfied from the cache
+		UInt64 GetHits(void) { MutexLock Locked(Lock); return Hits; }
+
+		//! Get the number of requests that had to be read when requested
+		UInt64 GetMisses(void) { MutexLock Locked(Lock); return Misses; }
+
+	protected:
+		//! The body of the worker thread
+		virtual void Run(void);
+
+		//! Locate an edit unit in the file
+		/*! \return true if found, with Start set to the file offset of the edit unit and Size set to its length
+		 *  \note Must be called with Lock held
+		 */
+		bool LocateFrame(Position EditUnit, Position &Start, Length &Size);
+
+		//! Choose the next edit unit for the worker to read
+		/*! \return The edit unit, or -1 if all predicted frames are cached
+		 *  \note Must be called with Lock held
+		 */
+		Position NextWanted(void);
+
+		//! Add a frame to the cache, discarding the least recently used frame if it is full
+		/*! \note Must be called with Lock held */
+		void AddFrame(Position EditUnit, DataChunkPtr &Data);
+	};
+
+	//! A smart pointer to a FramePrefetcher
+	typedef SmartPtr<FramePrefetcher> FramePrefetcherPtr;
+}
+
+#endif // MXFLIB__FRAMEPREFETCH_H
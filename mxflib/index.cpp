@@ -133,6 +133,8 @@ bool IndexTable::AddIndexEntry(Position EditUnit, Int8 TemporalOffset, Int8 KeyF
  */
 IndexPosPtr IndexTable::Lookup(Position EditUnit, int SubItem /* =0 */, bool Reorder /* =true */)
 {
+	StatsAdd(GlobalStats.IndexLookups, 1);
+
 	IndexPosPtr Ret = new IndexPos;
 
 	// Deal with CBR first
@@ -506,7 +508,7 @@ IndexSegmentPtr IndexTable::AddSegment(MDObjectPtr Segment)
 
 //! Add an index table segment from a raw DataChunk containing a section of un-parsed index table data
 /*! DRAGONS: This is far more efficient for loading the index table than using the general metadata functions */
-void IndexTable::AddSegments(DataChunkPtr &IndexChunk)
+void IndexTable::AddSegments(DataChunkPtr &IndexChunk, bool SkipExisting /*=false*/)
 {
 	UInt8 const *pData = IndexChunk->Data;
 	Length Size = IndexChunk->Size;
@@ -532,7 +534,7 @@ void IndexTable::AddSegments(DataChunkPtr &IndexChunk)
 		if(SetKey.Matches(IndexTableSegment_UL))
 		{
 			debug("%s is 0x%s bytes at %p\n", SetKey.GetString().c_str(), Int64toHexString(SetLength, 4).c_str(), pData);
-			AddSegment(pData, SetLength, 2);
+			AddSegment(pData, SetLength, 2, SkipExisting);
 		}
 		else if(!SetKey.Matches(KLVFill_UL))
 		{
@@ -551,7 +553,7 @@ void IndexTable::AddSegments(DataChunkPtr &IndexChunk)
 
 //! Add an index table segment from a raw DataChunk containing an un-parsed "IndexSegment"
 /*! DRAGONS: This is far more efficient for loading the index table than using the general metadata functions */
-IndexSegmentPtr IndexTable::AddSegment(UInt8 const *pSegment, Length Size, int LenSize /*=2*/)
+IndexSegmentPtr IndexTable::AddSegment(UInt8 const *pSegment, Length Size, int LenSize /*=2*/, bool SkipExisting /*=false*/)
 {
 	IndexSegmentPtr Ret;
 
@@ -755,6 +757,13 @@ IndexSegmentPtr IndexTable::AddSegment(UInt8 const *pSegment, Length Size, int L
 	}
 	else // VBR
 	{
+		// Don't add the entries of a segment that we already hold a second time
+		if(SkipExisting)
+		{
+			IndexSegmentMap::iterator it = SegmentMap.find(StartPosition);
+			if(it != SegmentMap.end()) return (*it).second;
+		}
+
 		Ret = AddSegment(StartPosition);
 
 		if(DeltaEntryArraySize == 0)
@@ -1025,6 +1034,8 @@ IndexSegmentPtr IndexSegment::AddIndexSegmentToIndexTable(IndexTablePtr ParentTa
 //! Write this index table to a memory buffer
 size_t IndexTable::WriteIndex(DataChunk &Buffer)
 {
+	StageTimer Timer(StageIndex);
+
 	// If we don't have a delta array, but we have more than 1 slice
 	if((NSL != 0) && (BaseDeltaCount == 0))
 	{
@@ -1968,6 +1979,8 @@ void IndexManager::Flush(Position FirstEditUnit, Position LastEditUnit)
 //! Generate a CBR index table or empty VBR index table for the managed index
 IndexTablePtr IndexManager::MakeIndex(void)
 {
+	StageTimer Timer(StageIndex);
+
 	// Once we have made an index table the format is very definately fixed
 	FormatFixed = true;
 
@@ -2013,6 +2026,8 @@ IndexTablePtr IndexManager::MakeIndex(void)
 /*! \return Number of index entries added */
 int IndexManager::AddEntriesToIndex(bool UndoReorder, IndexTablePtr Index, Position FirstEditUnit /*=IndexLowest*/, Position LastEditUnit /*=UINT64_C(0x7fffffffffffffff)*/)
 {
+	StageTimer Timer(StageIndex);
+
 	// Count of number of index table entries added
 	int Ret = 0;
 
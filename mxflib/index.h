@@ -270,12 +270,17 @@ namespace mxflib
 		IndexSegmentPtr AddSegment(MDObjectPtr Segment);
 
 		//! Add an index table segment from a raw DataChunk containing a section of un-parsed index table data
-		/*! DRAGONS: This is far more efficient for loading the index table than using the general metadata functions */
-		void AddSegments(DataChunkPtr &IndexChunk);
+		/*! DRAGONS: This is far more efficient for loading the index table than using the general metadata functions
+		 *  \param SkipExisting If true, VBR segments with the same start position as a segment already in the table are ignored,
+		 *                      so that segments repeated in later partitions (such as a full index in the footer) are not added twice
+		 */
+		void AddSegments(DataChunkPtr &IndexChunk, bool SkipExisting = false);
 
 		//! Add an index table segment from a raw DataChunk containing an un-parsed "IndexSegment"
-		/*! DRAGONS: This is far more efficient for loading the index table than using the general metadata functions */
-		IndexSegmentPtr AddSegment(UInt8 const *pSegment, Length Size, int LenSize = 2);
+		/*! DRAGONS: This is far more efficient for loading the index table than using the general metadata functions
+		 *  \note If SkipExisting is true, and a VBR segment exists with this start position, the existing segment is returned unchanged
+		 */
+		IndexSegmentPtr AddSegment(UInt8 const *pSegment, Length Size, int LenSize = 2, bool SkipExisting = false);
 
 		//! Create a new empty index table segment
 		/*! DRAGONS: Will return the existing segment if one already exists for this start position */
@@ -384,6 +389,10 @@ namespace mxflib
 
 namespace mxflib
 {
+	//! Manager for building index tables from data offered by essence parsers and the writer
+	/*! The methods used by essence parsers to offer index data are virtual so that a parser running on another thread
+	 *  can be given an IndexOfferRecorder, with the offers being made to the real manager later by the writer's thread
+	 */
 	class IndexManager : public RefCount<IndexManager>
 	{
 	protected:
@@ -461,7 +470,7 @@ namespace mxflib
 		IndexManager(int PosTableIndex, UInt32 ElementSize);
 
 		//! Free any memory used
-		~IndexManager()
+		virtual ~IndexManager()
 		{
 			delete[] PosTableList;
 			delete[] ElementSizeList;
@@ -503,7 +512,7 @@ namespace mxflib
 		int AddSubStream(int PosTableIndex, UInt32 ElementSize);
 
 		//! Update the PosTableIndex for a given stream
-		void SetPosTableIndex(int StreamID, int PosTableIndex)
+		virtual void SetPosTableIndex(int StreamID, int PosTableIndex)
 		{
 			if(StreamID < StreamCount) PosTableList[StreamID] = PosTableIndex;
 		}
@@ -518,28 +527,28 @@ namespace mxflib
 		}
 
 		//! Add an edit unit (of a stream) without a known offset
-		void AddEditUnit(int SubStream, Position EditUnit, int KeyOffset = 0, int Flags = -1);
+		virtual void AddEditUnit(int SubStream, Position EditUnit, int KeyOffset = 0, int Flags = -1);
 
 		//! Set the offset for a particular edit unit of a stream
 		void SetOffset(int SubStream, Position EditUnit, UInt64 Offset, int KeyOffset = 0, int Flags = -1);
 
 		//! Accept or decline an offered edit unit (of a stream) without a known offset
-		bool OfferEditUnit(int SubStream, Position EditUnit, int KeyOffset = 0, int Flags = -1);
+		virtual bool OfferEditUnit(int SubStream, Position EditUnit, int KeyOffset = 0, int Flags = -1);
 
 		//! Accept or decline an offered offset for a particular edit unit of a stream
 		bool OfferOffset(int SubStream, Position EditUnit, UInt64 Offset, int KeyOffset = 0, int Flags = -1);
 
 		//! Set the temporal offset for a particular edit unit
-		void SetTemporalOffset(Position EditUnit, int Offset);
+		virtual void SetTemporalOffset(Position EditUnit, int Offset);
 
 		//! Accept or decline an offered temporal offset for a particular edit unit
-		bool OfferTemporalOffset(Position EditUnit, int Offset);
+		virtual bool OfferTemporalOffset(Position EditUnit, int Offset);
 
 		//! Set the key-frame offset for a particular edit unit
-		void SetKeyOffset(Position EditUnit, int Offset);
+		virtual void SetKeyOffset(Position EditUnit, int Offset);
 
 		//! Accept or decline an offered key-frame offset for a particular edit unit
-		bool OfferKeyOffset(Position EditUnit, int Offset);
+		virtual bool OfferKeyOffset(Position EditUnit, int Offset);
 
 		//! Accept provisional entry
 		/*! \return The edit unit of the entry accepted - or IndexLowest if none available */
@@ -0,0 +1,681 @@
+/*! \file	jp2kreader.cpp
+ *	\brief	Implementation of class that reads JPEG 2000 frames from an MXF file, optionally at reduced resolution
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#include "mxflib/mxflib.h"
+
+#include "mxflib/jp2kreader.h"
+
+using namespace mxflib;
+
+
+namespace
+{
+	// Codestream markers (second byte only, the first is always 0xff)
+	const UInt8 Marker_SOC = 0x4f;			//!< Start of codestream
+	const UInt8 Marker_SIZ = 0x51;			//!< Image and tile size
+	const UInt8 Marker_COD = 0x52;			//!< Coding style default
+	const UInt8 Marker_COC = 0x53;			//!< Coding style component
+	const UInt8 Marker_PLT = 0x58;			//!< Packet length, tile-part header
+	const UInt8 Marker_POC = 0x5f;			//!< Progression order change
+	const UInt8 Marker_PPM = 0x60;			//!< Packed packet headers, main header
+	const UInt8 Marker_PPT = 0x61;			//!< Packed packet headers, tile-part header
+	const UInt8 Marker_SOT = 0x90;			//!< Start of tile-part
+	const UInt8 Marker_SOD = 0x93;			//!< Start of data
+	const UInt8 Marker_EOC = 0xd9;			//!< End of codestream
+
+	// Progression orders, as coded in COD
+	enum { LRCP = 0, RLCP = 1, RPCL = 2, PCRL = 3, CPRL = 4 };
+
+	//! Size of blocks read when parsing headers
+	const size_t HeaderReadSize = 4096;
+
+	//! Divide, rounding up
+	inline UInt32 CeilDiv(UInt32 Num, UInt32 Den) { return static_cast<UInt32>((static_cast<UInt64>(Num) + Den - 1) / Den); }
+
+	//! Cached reader for small sections of a codestream within a file
+	class HeaderCache
+	{
+	protected:
+		MXFFilePtr File;					//!< The file being read
+		Position Start;						//!< File offset of the codestream
+		Length Size;						//!< Size of the codestream
+		DataChunk Buffer;					//!< Cached data
+		Position BufferStart;				//!< Codestream offset of the first byte in the buffer
+
+	public:
+		Length BytesRead;					//!< Total bytes read from the file
+
+		HeaderCache(MXFFilePtr File, Position Start, Length Size) : File(File), Start(Start), Size(Size), BufferStart(0), BytesRead(0) {}
+
+		//! Get a pointer to Bytes bytes from the given codestream offset
+		/*! \return NULL if the bytes are beyond the end of the codestream or could not be read */
+		const UInt8 *Get(Position Offset, size_t Bytes)
+		{
+			if((Offset < 0) || (Offset + static_cast<Length>(Bytes) > Size)) return NULL;
+
+			// Satisfy from the cache if we can
+			if((Offset >= BufferStart) && ((Offset + static_cast<Length>(Bytes)) <= (BufferStart + static_cast<Length>(Buffer.Size))))
+			{
+				return &Buffer.Data[Offset - BufferStart];
+			}
+
+			// Read a new block, clipped to the end of the codestream
+			size_t ReadSize = Bytes < HeaderReadSize ? HeaderReadSize : Bytes;
+			if(Offset + static_cast<Length>(ReadSize) > Size) ReadSize = static_cast<size_t>(Size - Offset);
+
+			Buffer.Resize(ReadSize);
+			File->Seek(Start + Offset);
+			size_t Got = File->Read(Buffer.Data, ReadSize);
+			BytesRead += Got;
+			Buffer.Resize(Got);
+			BufferStart = Offset;
+
+			if(Got < Bytes) return NULL;
+			return Buffer.Data;
+		}
+
+		//! Get a pointer to Bytes bytes from the given codestream offset, only if they are already in the cache
+		const UInt8 *GetCached(Position Offset, size_t Bytes)
+		{
+			if((Offset >= BufferStart) && ((Offset + static_cast<Length>(Bytes)) <= (BufferStart + static_cast<Length>(Buffer.Size))))
+			{
+				return &Buffer.Data[Offset - BufferStart];
+			}
+
+			return NULL;
+		}
+	};
+
+	//! Coding parameters from the main header
+	struct CodingInfo
+	{
+		UInt32 Xsiz, Ysiz, XOsiz, YOsiz;					//!< Image size and offset on the reference grid
+		UInt32 XTsiz, YTsiz, XTOsiz, YTOsiz;				//!< Tile size and offset on the reference grid
+		std::vector<UInt8> XRsiz, YRsiz;					//!< Sub-sampling of each component
+		int Progression;									//!< Progression order
+		int Layers;											//!< Number of quality layers
+		int Levels;											//!< Number of decomposition levels
+		std::vector<UInt8> PPx, PPy;						//!< Precinct size exponents for each resolution level
+
+		UInt32 TilesX(void) const { return CeilDiv(Xsiz - XTOsiz, XTsiz); }
+		UInt32 TilesY(void) const { return CeilDiv(Ysiz - YTOsiz, YTsiz); }
+	};
+
+	//! Parse the contents of a SIZ marker segment (excluding the marker and length)
+	bool ParseSIZ(CodingInfo &Info, const UInt8 *p, size_t Size)
+	{
+		if(Size < 36) return false;
+
+		Info.Xsiz = GetU32(&p[2]);
+		Info.Ysiz = GetU32(&p[6]);
+		Info.XOsiz = GetU32(&p[10]);
+		Info.YOsiz = GetU32(&p[14]);
+		Info.XTsiz = GetU32(&p[18]);
+		Info.YTsiz = GetU32(&p[22]);
+		Info.XTOsiz = GetU32(&p[26]);
+		Info.YTOsiz = GetU32(&p[30]);
+
+		int Components = GetU16(&p[34]);
+		if((Components == 0) || (Size < static_cast<size_t>(36 + Components * 3))) return false;
+		if((Info.XTsiz == 0) || (Info.YTsiz == 0)) return false;
+
+		Info.XRsiz.resize(Components);
+		Info.YRsiz.resize(Components);
+		for(int i = 0; i < Components; i++)
+		{
+			Info.XRsiz[i] = p[37 + i * 3];
+			Info.YRsiz[i] = p[38 + i * 3];
+			if((Info.XRsiz[i] == 0) || (Info.YRsiz[i] == 0)) return false;
+		}
+
+		return true;
+	}
+
+	//! Parse the contents of a COD marker segment (excluding the marker and length)
+	bool ParseCOD(CodingInfo &Info, const UInt8 *p, size_t Size)
+	{
+		if(Size < 10) return false;
+
+		UInt8 Scod = p[0];
+		Info.Progression = p[1];
+		Info.Layers = GetU16(&p[2]);
+		Info.Levels = p[5];
+
+		if((Info.Progression > CPRL) || (Info.Layers == 0) || (Info.Levels > 31)) return false;
+
+		Info.PPx.resize(Info.Levels + 1);
+		Info.PPy.resize(Info.Levels + 1);
+		for(int r = 0; r <= Info.Levels; r++)
+		{
+			// Without user-defined precincts each precinct is 2^15 by 2^15
+			if(Scod & 0x01)
+			{
+				if(Size < static_cast<size_t>(10 + r + 1)) return false;
+				Info.PPx[r] = p[10 + r] & 0x0f;
+				Info.PPy[r] = p[10 + r] >> 4;
+			}
+			else
+			{
+				Info.PPx[r] = 15;
+				Info.PPy[r] = 15;
+			}
+		}
+
+		return true;
+	}
+
+	//! Work out which packets of a tile are needed, in codestream order
+	/*! \return false if the progression order can't be handled for this tile */
+	bool MapPackets(const CodingInfo &Info, UInt32 Tile, int MaxRes, int MaxLayers, std::vector<bool> &Needed)
+	{
+		// Locate the tile on the reference grid
+		UInt32 p = Tile % Info.TilesX();
+		UInt32 q = Tile / Info.TilesX();
+		UInt32 tx0 = std::max(Info.XTOsiz + p * Info.XTsiz, Info.XOsiz);
+		UInt32 ty0 = std::max(Info.YTOsiz + q * Info.YTsiz, Info.YOsiz);
+		UInt32 tx1 = std::min(Info.XTOsiz + (p + 1) * Info.XTsiz, Info.Xsiz);
+		UInt32 ty1 = std::min(Info.YTOsiz + (q + 1) * Info.YTsiz, Info.Ysiz);
+
+		int Components = static_cast<int>(Info.XRsiz.size());
+		int Resolutions = Info.Levels + 1;
+
+		// Count the precincts in each resolution level of each tile-component
+		std::vector<UInt32> Precincts(Resolutions * Components);
+		bool SinglePrecincts = true;
+		for(int c = 0; c < Components; c++)
+		{
+			UInt32 tcx0 = CeilDiv(tx0, Info.XRsiz[c]);
+			UInt32 tcy0 = CeilDiv(ty0, Info.YRsiz[c]);
+			UInt32 tcx1 = CeilDiv(tx1, Info.XRsiz[c]);
+			UInt32 tcy1 = CeilDiv(ty1, Info.YRsiz[c]);
+
+			for(int r = 0; r < Resolutions; r++)
+			{
+				UInt32 Scale = 1 << (Info.Levels - r);
+				UInt32 trx0 = CeilDiv(tcx0, Scale);
+				UInt32 try0 = CeilDiv(tcy0, Scale);
+				UInt32 trx1 = CeilDiv(tcx1, Scale);
+				UInt32 try1 = CeilDiv(tcy1, Scale);
+
+				UInt32 Count = 0;
+				if((trx1 > trx0) && (try1 > try0))
+				{
+					UInt32 npx = CeilDiv(trx1, 1 << Info.PPx[r]) - (trx0 >> Info.PPx[r]);
+					UInt32 npy = CeilDiv(try1, 1 << Info.PPy[r]) - (try0 >> Info.PPy[r]);
+					Count = npx * npy;
+				}
+
+				Precincts[r * Components + c] = Count;
+				if(Count > 1) SinglePrecincts = false;
+			}
+		}
+
+		Needed.clear();
+
+		int l, r, c;
+		UInt32 i;
+		switch(Info.Progression)
+		{
+		case LRCP:
+			for(l = 0; l < Info.Layers; l++)
+				for(r = 0; r < Resolutions; r++)
+					for(c = 0; c < Components; c++)
+						for(i = 0; i < Precincts[r * Components + c]; i++) Needed.push_back((r <= MaxRes) && (l < MaxLayers));
+			return true;
+
+		case RLCP:
+			for(r = 0; r < Resolutions; r++)
+				for(l = 0; l < Info.Layers; l++)
+					for(c = 0; c < Components; c++)
+						for(i = 0; i < Precincts[r * Components + c]; i++) Needed.push_back((r <= MaxRes) && (l < MaxLayers));
+			return true;
+
+		case RPCL:
+			// With all layers kept only the resolution matters, so the order within each resolution is irrelevant
+			if(SinglePrecincts || (MaxLayers >= Info.Layers))
+			{
+				for(r = 0; r < Resolutions; r++)
+					for(c = 0; c < Components; c++)
+						for(i = 0; i < Precincts[r * Components + c]; i++)
+							for(l = 0; l < Info.Layers; l++) Needed.push_back((r <= MaxRes) && (l < MaxLayers));
+				return true;
+			}
+			return false;
+
+		case PCRL:
+		case CPRL:
+			// With a single precinct per resolution level all precincts are visited at the tile origin
+			if(SinglePrecincts)
+			{
+				for(c = 0; c < Components; c++)
+					for(r = 0; r < Resolutions; r++)
+						if(Precincts[r * Components + c])
+							for(l = 0; l < Info.Layers; l++) Needed.push_back((r <= MaxRes) && (l < MaxLayers));
+				return true;
+			}
+			return false;
+
+		default:
+			return false;
+		}
+	}
+
+	//! Details of a tile-part to be copied to the output
+	struct KeptTilePart
+	{
+		DataChunkPtr Header;							//!< Tile-part header, from SOT to SOD inclusive, without any PLT segments
+		Position DataOffset;							//!< Codestream offset of the tile-part data
+		Length DataLength;								//!< Number of bytes of tile-part data to keep
+	};
+
+	//! State of each tile while walking the tile-parts
+	struct TileState
+	{
+		bool Mapped;									//!< Set once Needed and LastNeeded are valid
+		bool Done;										//!< Set once all needed packets have been found
+		std::vector<bool> Needed;						//!< Flag for each packet in codestream order, true if needed
+		Int64 LastNeeded;								//!< Index of the last needed packet
+		Int64 NextPacket;								//!< Index of the first packet in the next tile-part
+
+		TileState() : Mapped(false), Done(false), LastNeeded(-1), NextPacket(0) {}
+	};
+}
+
+
+//! Construct a reader for JPEG 2000 essence in a given essence container
+JP2KFrameReader::JP2KFrameReader(MXFFilePtr File, IndexTablePtr Index, UInt32 BodySID)
+	: File(File), Index(Index), BodySID(BodySID)
+{
+	Reader = new BodyReader(File);
+
+	FrameSize = 0;
+	BytesRead = 0;
+}
+
+
+//! Read a frame, optionally at reduced resolution or quality
+DataChunkPtr JP2KFrameReader::ReadFrame(Position EditUnit, int Reduce /*=0*/, int Layers /*=0*/)
+{
+	FrameSize = 0;
+	BytesRead = 0;
+
+	Position Start;
+	Length Size;
+	if(!LocateFrame(EditUnit, Start, Size)) return NULL;
+
+	FrameSize = Size;
+
+	if((Reduce > 0) || (Layers > 0))
+	{
+		DataChunkPtr Ret = ReadPartial(Start, Size, Reduce, Layers);
+		if(Ret) return Ret;
+	}
+
+	// Read the whole codestream
+	DataChunkPtr Ret = new DataChunk(static_cast<size_t>(Size));
+	File->Seek(Start);
+	size_t Bytes = File->Read(Ret->Data, static_cast<size_t>(Size));
+	BytesRead += Bytes;
+
+	if(Bytes != static_cast<size_t>(Size))
+	{
+		error("Only read 0x%s of 0x%s bytes of JPEG 2000 frame %s\n", Int64toHexString(Bytes).c_str(), Int64toHexString(Size).c_str(), Int64toString(EditUnit).c_str());
+		Ret->Resize(Bytes);
+	}
+
+	return Ret;
+}
+
+
+//! Locate the codestream of a given edit unit within the file
+bool JP2KFrameReader::LocateFrame(Position EditUnit, Position &Start, Length &Size)
+{
+	IndexPosPtr Pos = Index->Lookup(EditUnit);
+	if(!Pos || !Pos->Exact)
+	{
+		error("No index entry for JPEG 2000 frame %s\n", Int64toString(EditUnit).c_str());
+		return false;
+	}
+
+	Position FilePos = Reader->Seek(BodySID, Pos->Location);
+	if(FilePos < 0)
+	{
+		error("Could not locate JPEG 2000 frame %s in BodySID 0x%04x\n", Int64toString(EditUnit).c_str(), BodySID);
+		return false;
+	}
+
+	// If there is no key at this point the essence is clip wrapped and the next index entry marks the end of this frame
+	DataChunkPtr Peek = File->Read(4);
+	File->Seek(FilePos);
+	if((Peek->Size < 4) || (Peek->Data[0] != 0x06) || (Peek->Data[1] != 0x0e) || (Peek->Data[2] != 0x2b) || (Peek->Data[3] != 0x34))
+	{
+		IndexPosPtr NextPos = Index->Lookup(EditUnit + 1);
+		if(!NextPos || !NextPos->Exact || (NextPos->Location <= Pos->Location))
+		{
+			error("Could not determine the size of clip wrapped JPEG 2000 frame %s\n", Int64toString(EditUnit).c_str());
+			return false;
+		}
+
+		Start = FilePos;
+		Size = NextPos->Location - Pos->Location;
+		return true;
+	}
+
+	// Frame wrapped, scan the content package for the picture element
+	// DRAGONS: This assumes that the content package does not span a partition boundary
+	const int MaxElements = 16;
+	for(int i = 0; i < MaxElements; i++)
+	{
+		ULPtr Key = File->ReadKey();
+		if(!Key) break;
+
+		Length Len = File->ReadBER();
+		if(Len < 0) break;
+
+		GCElementKind Kind = GetGCElementKind(Key);
+		if(Kind.IsValid && ((Kind.Item == 0x15) || (Kind.Item == 0x05)))
+		{
+			Start = File->Tell();
+			Size = Len;
+			return true;
+		}
+
+		File->Seek(File->Tell() + Len);
+	}
+
+	error("No picture element found for JPEG 2000 frame %s\n", Int64toString(EditUnit).c_str());
+	return false;
+}
+
+
+//! Read part of a codestream, holding only the packets needed for a given resolution and quality
+DataChunkPtr JP2KFrameReader::ReadPartial(Position Start, Length Size, int Reduce, int Layers)
+{
+	HeaderCache Cache(File, Start, Size);
+
+	/* Parse the main header */
+
+	const UInt8 *p = Cache.Get(0, 2);
+	if(!p || (p[0] != 0xff) || (p[1] != Marker_SOC))
+	{
+		error("JPEG 2000 frame does not start with an SOC marker\n");
+		BytesRead += Cache.BytesRead;
+		return NULL;
+	}
+
+	CodingInfo Info;
+	bool HaveSIZ = false;
+	bool HaveCOD = false;
+	const char *Unsupported = NULL;
+
+	Position Offset = 2;
+	for(;;)
+	{
+		p = Cache.Get(Offset, 4);
+		if(!p || (p[0] != 0xff)) { Unsupported = "a malformed main header"; break; }
+		if(p[1] == Marker_SOT) break;
+
+		UInt8 Marker = p[1];
+		size_t SegmentLength = GetU16(&p[2]);
+		p = Cache.Get(Offset + 4, SegmentLength - 2);
+		if(!p || (SegmentLength < 2)) { Unsupported = "a malformed main header"; break; }
+
+		switch(Marker)
+		{
+		case Marker_SIZ: HaveSIZ = ParseSIZ(Info, p, SegmentLength - 2); break;
+		case Marker_COD: HaveCOD = ParseCOD(Info, p, SegmentLength - 2); break;
+		case Marker_COC: Unsupported = "COC markers"; break;
+		case Marker_POC: Unsupported = "POC markers"; break;
+		case Marker_PPM: Unsupported = "PPM markers"; break;
+		default: break;
+		}
+		if(Unsupported) break;
+
+		Offset += SegmentLength + 2;
+	}
+
+	if(!Unsupported && !(HaveSIZ && HaveCOD)) Unsupported = "invalid or missing SIZ or COD markers";
+
+	// Keep a copy of the main header while it is still cached
+	DataChunkPtr MainHeader;
+	if(!Unsupported)
+	{
+		p = Cache.Get(0, static_cast<size_t>(Offset));
+		if(p) MainHeader = new DataChunk(static_cast<size_t>(Offset), p);
+		else Unsupported = "a malformed main header";
+	}
+
+	/* Walk the tile-parts, reading only their headers */
+
+	int MaxRes = Info.Levels - Reduce;
+	if(MaxRes < 0) MaxRes = 0;
+	int MaxLayers = (Layers > 0) ? Layers : Info.Layers;
+
+	UInt32 TileCount = Unsupported ? 0 : (Info.TilesX() * Info.TilesY());
+	std::vector<TileState> Tiles(TileCount);
+	UInt32 TilesDone = 0;
+
+	std::list<KeptTilePart> Kept;
+	bool Truncated = false;
+
+	// Find the end of the last tile-part, allowing for a final EOC marker
+	Length CodestreamEnd = Size;
+	p = Cache.Get(Size - 2, 2);
+	if(p && (p[0] == 0xff) && (p[1] == Marker_EOC)) CodestreamEnd = Size - 2;
+
+	while(!Unsupported && (Offset + 12 <= CodestreamEnd) && (TilesDone < TileCount))
+	{
+		p = Cache.Get(Offset, 12);
+		if(!p || (p[0] != 0xff) || (p[1] != Marker_SOT)) { Unsupported = "a malformed tile-part header"; break; }
+
+		UInt16 Isot = GetU16(&p[4]);
+		Length Psot = GetU32(&p[6]);
+		if(Psot == 0) Psot = CodestreamEnd - Offset;
+
+		if((Isot >= TileCount) || (Psot < 14) || (Offset + Psot > CodestreamEnd)) { Unsupported = "a malformed tile-part header"; break; }
+
+		TileState &Tile = Tiles[Isot];
+
+		// Skip tile-parts once we have all we need from a tile
+		if(Tile.Done)
+		{
+			Truncated = true;
+			Offset += Psot;
+			continue;
+		}
+
+		if(!Tile.Mapped)
+		{
+			if(!MapPackets(Info, Isot, MaxRes, MaxLayers, Tile.Needed)) { Unsupported = "position-major progression with multiple precincts"; break; }
+
+			Tile.LastNeeded = static_cast<Int64>(Tile.Needed.size()) - 1;
+			while((Tile.LastNeeded >= 0) && !Tile.Needed[static_cast<size_t>(Tile.LastNeeded)]) Tile.LastNeeded--;
+			Tile.Mapped = true;
+		}
+
+		// Copy the tile-part header, dropping PLT markers which would describe packets we may discard, and collect the packet lengths
+		DataChunkPtr Header = new DataChunk(12, p);
+		std::vector<Length> PacketLengths;
+		Length PacketLength = 0;
+
+		Position HeaderOffset = Offset + 12;
+		for(;;)
+		{
+			p = Cache.Get(HeaderOffset, 2);
+			if(!p || (p[0] != 0xff)) { Unsupported = "a malformed tile-part header"; break; }
+			if(p[1] == Marker_SOD)
+			{
+				Header->Append(DataChunk(2, p));
+				HeaderOffset += 2;
+				break;
+			}
+
+			UInt8 Marker = p[1];
+			if((Marker == Marker_COD) || (Marker == Marker_COC) || (Marker == Marker_POC) || (Marker == Marker_PPT))
+			{
+				Unsupported = "coding style or progression changes in tile-part headers";
+				break;
+			}
+
+			p = Cache.Get(HeaderOffset + 2, 2);
+			size_t SegmentLength = p ? GetU16(p) : 0;
+			p = Cache.Get(HeaderOffset, SegmentLength + 2);
+			if(!p || (SegmentLength < 2)) { Unsupported = "a malformed tile-part header"; break; }
+
+			if(Marker == Marker_PLT)
+			{
+				// Packet lengths are coded 7 bits per byte, with the top bit set on all but the last byte
+				for(size_t i = 5; i < SegmentLength + 2; i++)
+				{
+					PacketLength = (PacketLength << 7) | (p[i] & 0x7f);
+					if(!(p[i] & 0x80))
+					{
+						PacketLengths.push_back(PacketLength);
+						PacketLength = 0;
+					}
+				}
+			}
+			else
+				Header->Append(DataChunk(SegmentLength + 2, p));
+
+			HeaderOffset += SegmentLength + 2;
+		}
+		if(Unsupported) break;
+
+		if(PacketLengths.empty()) { Unsupported = "tile-parts without PLT markers"; break; }
+
+		Length DataLength = Offset + Psot - HeaderOffset;
+
+		// Work out how much of this tile-part's data is needed
+		Length KeepLength = 0;
+		size_t Packet;
+		for(Packet = 0; Packet < PacketLengths.size(); Packet++)
+		{
+			if(Tile.NextPacket + static_cast<Int64>(Packet) > Tile.LastNeeded) break;
+			KeepLength += PacketLengths[Packet];
+		}
+
+		if(KeepLength > DataLength) { Unsupported = "PLT markers that do not match the tile-part data"; break; }
+
+		Tile.NextPacket += PacketLengths.size();
+		if(Tile.NextPacket > Tile.LastNeeded)
+		{
+			Tile.Done = true;
+			TilesDone++;
+
+			if(KeepLength < DataLength) Truncated = true;
+		}
+		else
+		{
+			// Keep the whole tile-part, including any padding after the last packet
+			KeepLength = DataLength;
+		}
+
+		// The first tile-part of each tile is always kept, even if empty, so that every tile is present
+		if((KeepLength > 0) || (GetU8(&Header->Data[10]) == 0))
+		{
+			KeptTilePart Part;
+			Part.Header = Header;
+			Part.DataOffset = HeaderOffset;
+			Part.DataLength = KeepLength;
+			Kept.push_back(Part);
+		}
+
+		Offset += Psot;
+	}
+
+	// Any tile-parts beyond the last one we visited are discarded
+	if(Offset < CodestreamEnd) Truncated = true;
+
+	if(Unsupported || !Truncated)
+	{
+		if(Unsupported) debug("Reading whole JPEG 2000 frame as it contains %s\n", Unsupported);
+
+		BytesRead += Cache.BytesRead;
+		return NULL;
+	}
+
+	/* Build the truncated codestream */
+
+	Length OutSize = MainHeader->Size + 2;
+	std::list<KeptTilePart>::iterator it;
+	for(it = Kept.begin(); it != Kept.end(); it++) OutSize += (*it).Header->Size + (*it).DataLength;
+
+	DataChunkPtr Ret = new DataChunk(static_cast<size_t>(OutSize));
+
+	memcpy(Ret->Data, MainHeader->Data, MainHeader->Size);
+	UInt8 *Dest = &Ret->Data[MainHeader->Size];
+
+	// Reads of tile-part data not already cached
+	AsyncReadRequestList Reads;
+
+	for(it = Kept.begin(); it != Kept.end(); it++)
+	{
+		// Update Psot with the new tile-part length, and set TNsot to zero as the number of tile-parts may have changed
+		PutU32(static_cast<UInt32>((*it).Header->Size + (*it).DataLength), &(*it).Header->Data[6]);
+		PutU8(0, &(*it).Header->Data[11]);
+
+		memcpy(Dest, (*it).Header->Data, (*it).Header->Size);
+		Dest += (*it).Header->Size;
+
+		// Small tile-parts may already have been read while parsing the headers
+		const UInt8 *Cached = (*it).DataLength ? Cache.GetCached((*it).DataOffset, static_cast<size_t>((*it).DataLength)) : NULL;
+		if(Cached)
+		{
+			memcpy(Dest, Cached, static_cast<size_t>((*it).DataLength));
+			Dest += (*it).DataLength;
+		}
+		else if((*it).DataLength)
+		{
+			// Gather the reads so they can all be issued together
+			Reads.push_back(AsyncReadRequest(Start + (*it).DataOffset, Dest, static_cast<size_t>((*it).DataLength)));
+			Dest += (*it).DataLength;
+		}
+	}
+
+	if(!Reads.empty())
+	{
+		bool ReadOK = File->ReadBatch(Reads);
+
+		AsyncReadRequestList::iterator Read_it;
+		for(Read_it = Reads.begin(); Read_it != Reads.end(); Read_it++) BytesRead += (*Read_it).Bytes;
+
+		if(!ReadOK)
+		{
+			error("Failed to read JPEG 2000 tile-part data\n");
+			BytesRead += Cache.BytesRead;
+			return NULL;
+		}
+	}
+
+	PutU8(0xff, Dest);
+	PutU8(Marker_EOC, &Dest[1]);
+
+	BytesRead += Cache.BytesRead;
+
+	return Ret;
+}
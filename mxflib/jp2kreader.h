@@ -0,0 +1,97 @@
+/*! \file	jp2kreader.h
+ *	\brief	Definition of class that reads JPEG 2000 frames from an MXF file, optionally at reduced resolution
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#ifndef MXFLIB__JP2KREADER_H
+#define MXFLIB__JP2KREADER_H
+
+
+namespace mxflib
+{
+	//! Random-access reader for JPEG 2000 codestreams in an MXF essence container
+	/*! Frames are located using the index table for the essence container, so only the bytes of the requested frame are read.
+	 *
+	 *  A frame may be requested at reduced resolution and/or with fewer quality layers, as is useful for proxies and thumbnails.
+	 *  In this case the codestream headers are parsed and only the tile-part data holding the required packets is read, the
+	 *  result being a valid (but shorter) codestream ending with an EOC marker. How much is saved depends on the codestream:
+	 *  - Packet lengths must be signalled with PLT markers in the tile-part headers
+	 *  - The progression order decides how much data can be skipped; resolution-major orders (RLCP and RPCL) are best for
+	 *    reduced resolution reads and layer-major order (LRCP) is best for reduced layer reads
+	 *  - Position-major orders (PCRL and CPRL, and RPCL when limiting layers) are only handled if there is one precinct per resolution level
+	 *
+	 *  If a codestream cannot be truncated (for example no PLT markers, or COC, POC, PPM or PPT markers are used) the whole frame is returned.
+	 *
+	 *  \note Only unencrypted essence is supported
+	 */
+	class JP2KFrameReader : public RefCount<JP2KFrameReader>
+	{
+	protected:
+		MXFFilePtr File;								//!< The file being read
+		IndexTablePtr Index;							//!< Index table for the essence container
+		UInt32 BodySID;									//!< BodySID of the essence container
+		BodyReaderPtr Reader;							//!< Body reader used to map stream offsets to file offsets
+
+		Length FrameSize;								//!< Size of the complete codestream of the last frame read
+		Length BytesRead;								//!< The number of bytes read from the file for the last frame
+
+	public:
+		//! Construct a reader for JPEG 2000 essence in a given essence container
+		/*! \param File The open MXF file to read from
+		 *  \param Index An index table for the essence container, this must contain an entry for each frame to be read
+		 *  \param BodySID The BodySID of the essence container
+		 */
+		JP2KFrameReader(MXFFilePtr File, IndexTablePtr Index, UInt32 BodySID);
+
+		//! Read a frame, optionally at reduced resolution or quality
+		/*! \param EditUnit The edit unit to read
+		 *  \param Reduce The number of highest resolution levels to discard, 0 for full resolution
+		 *  \param Layers The number of quality layers to keep, 0 for all layers
+		 *  \return The codestream for the frame, or NULL on error
+		 */
+		DataChunkPtr ReadFrame(Position EditUnit, int Reduce = 0, int Layers = 0);
+
+		//! Get the size of the complete codestream for the last frame read
+		Length GetFrameSize(void) const { return FrameSize; }
+
+		//! Get the number of bytes read from the file for the last frame read
+		/*! This includes the bytes read while parsing the codestream headers */
+		Length GetBytesRead(void) const { return BytesRead; }
+
+	protected:
+		//! Locate the codestream of a given edit unit within the file
+		/*! \return true if found, with Start set to the file offset of the codestream and Size set to its length */
+		bool LocateFrame(Position EditUnit, Position &Start, Length &Size);
+
+		//! Read part of a codestream, holding only the packets needed for a given resolution and quality
+		/*! \return The truncated codestream, or NULL if it could not be truncated */
+		DataChunkPtr ReadPartial(Position Start, Length Size, int Reduce, int Layers);
+	};
+
+	//! A smart pointer to a JP2KFrameReader
+	typedef SmartPtr<JP2KFrameReader> JP2KFrameReaderPtr;
+}
+
+#endif // MXFLIB__JP2KREADER_H
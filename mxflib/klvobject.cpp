@@ -139,9 +139,6 @@ size_t KLVObject::Base_ReadDataFrom(DataChunk &Buffer, Position Offset, size_t S
 		return 0;
 	}
 
-	// Seek to the start of the requested data
-	Source.File->Seek(Source.Offset + Source.KLSize + Offset);
-
 	// Resize the chunk
 	// Discarding old data first (by setting Size to 0) prevents old data being 
 	// copied needlessly if the buffer is reallocated to increase its size
@@ -149,7 +146,8 @@ size_t KLVObject::Base_ReadDataFrom(DataChunk &Buffer, Position Offset, size_t S
 	Buffer.Resize(static_cast<size_t>(BytesToRead));
 
 	// Read into the buffer (only as big as the buffer is!)
-	size_t Bytes = Source.File->Read(Buffer.Data, Buffer.Size);
+	// DRAGONS: This is a positioned read that does not move the file pointer, so many threads may read values from one file
+	size_t Bytes = Source.File->ReadAt(Source.Offset + Source.KLSize + Offset, Buffer.Data, Buffer.Size);
 
 	// Resize the buffer if something odd happened (such as an early end-of-file)
 	if(Bytes != static_cast<size_t>(BytesToRead)) Buffer.Resize(Bytes);
@@ -376,7 +376,8 @@ namespace mxflib
 			Length BytesToWrite = Data.Size - Start;
 
 			// Write the requested size (if valid)
-			if((Size > 0) && ((Length)Size < BytesToWrite)) BytesToWrite = Size;
+			// DRAGONS: Compared as unsigned so that the default of -1 does not become a negative Length on 64-bit platforms
+			if((Size > 0) && (static_cast<UInt64>(Size) < static_cast<UInt64>(BytesToWrite))) BytesToWrite = Size;
 
 			// Sanity check the size of this chunk
 			if((sizeof(size_t) < 8) && (BytesToWrite > 0xffffffff))
@@ -0,0 +1,284 @@
+/*! \file	livesource.cpp
+ *	\brief	Implementation of an EssenceSource fed with frames by a capture thread
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#include "mxflib/mxflib.h"
+
+#include "mxflib/livesource.h"
+
+using namespace mxflib;
+
+
+//! Default number of frames the ring can hold
+const size_t LiveEssenceSource::DefaultCapacity = 16;
+
+
+//! Construct a live source with an empty ring
+LiveEssenceSource::LiveEssenceSource(Rational EditRate, UInt8 GCEssenceType, UInt8 GCElementType, size_t Capacity /*=DefaultCapacity*/)
+	: EditRate(EditRate), GCEssenceType(GCEssenceType), GCElementType(GCElementType), Capacity(Capacity)
+{
+	if(this->Capacity < 1) this->Capacity = 1;
+	Ring = new LiveFrame[this->Capacity];
+
+	Head = 0;
+	Tail = 0;
+	InputEnded = false;
+	ConsumerWaiting = false;
+
+	FramesPushed = 0;
+	FramesDropped = 0;
+	PeakFill = 0;
+	DropToKey = false;
+
+	CurrentOffset = 0;
+	FramePos = 0;
+	LastKeyFrame = -1;
+	AtEndOfItem = true;
+	LastEditPoint = true;
+}
+
+
+//! Release the ring and any frames not yet taken
+LiveEssenceSource::~LiveEssenceSource()
+{
+	delete[] Ring;
+}
+
+
+//! Add a frame to the ring, without waiting
+bool LiveEssenceSource::PushFrame(DataChunkPtr Data, bool KeyFrame /*=true*/, bool EditPoint /*=true*/)
+{
+	if(!Data)
+	{
+		error("NULL frame pushed to LiveEssenceSource::PushFrame()\n");
+		return false;
+	}
+
+	// After a drop, frames that depend on earlier frames can't be decoded until the next key frame
+	if(DropToKey)
+	{
+		if(!KeyFrame)
+		{
+			FramesDropped++;
+			return false;
+		}
+
+		DropToKey = false;
+	}
+
+	size_t Fill = Tail - Head;
+	if(Fill >= Capacity)
+	{
+		FramesDropped++;
+		DropToKey = true;
+		return false;
+	}
+
+	// Ensure the consumer has finished with the slot before it is filled
+	MemoryFence();
+
+	LiveFrame &Slot = Ring[Tail % Capacity];
+	Slot.Data = Data;
+	Slot.KeyFrame = KeyFrame;
+	Slot.EditPoint = EditPoint;
+
+	// Publish the frame before the new tail
+	MemoryFence();
+	Tail = Tail + 1;
+
+	FramesPushed++;
+	if(Fill >= PeakFill) PeakFill = Fill + 1;
+
+	WakeConsumer();
+
+	return true;
+}
+
+
+//! Add a copy of a frame to the ring, without waiting
+bool LiveEssenceSource::PushFrame(const UInt8 *Buffer, size_t Size, bool KeyFrame /*=true*/, bool EditPoint /*=true*/)
+{
+	// Check for space before copying, so that a full ring costs nothing (PushFrame() will repeat the checks)
+	if((DropToKey && !KeyFrame) || ((Tail - Head) >= Capacity))
+	{
+		FramesDropped++;
+		DropToKey = true;
+		return false;
+	}
+
+	return PushFrame(new DataChunk(Size, Buffer), KeyFrame, EditPoint);
+}
+
+
+//! Signal that capture has stopped and no more frames will be pushed
+void LiveEssenceSource::EndOfInput(void)
+{
+	// Publish all frames before the end flag
+	MemoryFence();
+	InputEnded = true;
+
+	WakeConsumer();
+}
+
+
+//! Wake the consumer if it is waiting for a frame
+void LiveEssenceSource::WakeConsumer(void)
+{
+	/* DRAGONS: The producer sets Tail (or InputEnded) then tests ConsumerWaiting, while the consumer sets ConsumerWaiting
+	 *          then tests Tail and InputEnded, each with a fence between. At least one of them must see the other's change,
+	 *          so either the consumer does not wait or it is signalled here. The mutex is held by the consumer until it waits,
+	 *          so the signal can't arrive before the wait. The producer only takes the mutex when the ring was empty.
+	 */
+	MemoryFence();
+	if(ConsumerWaiting)
+	{
+		MutexLock Locked(WaitLock);
+		FrameAdded.Signal();
+	}
+}
+
+
+//! Make the next frame the current frame, waiting for one to be pushed if required
+bool LiveEssenceSource::NextFrame(void)
+{
+	for(;;)
+	{
+		// Read the end flag first, so that all frames pushed before the end are seen
+		bool Ended = InputEnded;
+		MemoryFence();
+
+		if(Head != Tail) break;
+		if(Ended) return false;
+
+		WaitLock.Lock();
+		ConsumerWaiting = true;
+		MemoryFence();
+
+		if((Head == Tail) && !InputEnded) FrameAdded.Wait(WaitLock);
+
+		ConsumerWaiting = false;
+		WaitLock.Unlock();
+	}
+
+	// Read the slot only after seeing the new tail
+	MemoryFence();
+
+	LiveFrame &Slot = Ring[Head % Capacity];
+	Current = Slot;
+	Slot.Data = NULL;
+
+	// Release the slot to the producer
+	MemoryFence();
+	Head = Head + 1;
+
+	CurrentOffset = 0;
+	IndexFrame();
+
+	return true;
+}
+
+
+//! Offer the current frame to the index manager, if there is one
+void LiveEssenceSource::IndexFrame(void)
+{
+	if(Current.KeyFrame) LastKeyFrame = FramePos;
+
+	if(!IndexMan) return;
+
+	int KeyOffset = 0;
+	int Flags = 0x80;
+
+	// DRAGONS: Nothing is known about how a non-key frame is predicted, so it is simply flagged as forward predicted
+	if(!Current.KeyFrame)
+	{
+		Flags = 0x20;
+		if(LastKeyFrame >= 0) KeyOffset = static_cast<int>(LastKeyFrame - FramePos);
+
+		// As stated in 377M, an offset out of range is set to the maximum value that can be represented with bit 3 of the flags set
+		if(KeyOffset < -128)
+		{
+			KeyOffset = 127;
+			Flags |= 4;
+		}
+	}
+
+	IndexMan->OfferEditUnit(IndexStreamID, FramePos, KeyOffset, Flags);
+}
+
+
+//! Get the size of the next "installment" of essence data in bytes
+size_t LiveEssenceSource::GetEssenceDataSize(void)
+{
+	if(!Current.Data && !NextFrame()) return 0;
+
+	return Current.Data->Size - CurrentOffset;
+}
+
+
+//! Get the next "installment" of essence data
+DataChunkPtr LiveEssenceSource::GetEssenceData(size_t Size /*=0*/, size_t MaxSize /*=0*/)
+{
+	if(!Current.Data && !NextFrame())
+	{
+		AtEndOfItem = true;
+		return NULL;
+	}
+
+	if(CurrentOffset == 0) LastEditPoint = Current.EditPoint;
+
+	size_t Bytes = Current.Data->Size - CurrentOffset;
+	if(Size && (Bytes > Size)) Bytes = Size;
+	if(MaxSize && (Bytes > MaxSize)) Bytes = MaxSize;
+
+	// Return a whole frame as pushed, only copying when it is split
+	DataChunkPtr Ret;
+	if(Bytes == Current.Data->Size) Ret = Current.Data;
+	else Ret = new DataChunk(Bytes, &Current.Data->Data[CurrentOffset]);
+
+	CurrentOffset += Bytes;
+
+	if(CurrentOffset >= Current.Data->Size)
+	{
+		Current.Data = NULL;
+		FramePos++;
+		AtEndOfItem = true;
+	}
+	else AtEndOfItem = false;
+
+	return Ret;
+}
+
+
+//! Is all data exhasted?
+bool LiveEssenceSource::EndOfData(void)
+{
+	if(Current.Data) return false;
+
+	bool Ended = InputEnded;
+	MemoryFence();
+
+	return Ended && (Head == Tail);
+}
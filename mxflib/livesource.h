@@ -0,0 +1,222 @@
+/*! \file	livesource.h
+ *	\brief	Definition of an EssenceSource fed with frames by a capture thread
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#ifndef MXFLIB__LIVESOURCE_H
+#define MXFLIB__LIVESOURCE_H
+
+
+namespace mxflib
+{
+	//! Essence source for live capture, where frames are pushed by a producer thread rather than read from a file
+	/*! A single capture thread calls PushFrame() for each frame as it arrives and EndOfInput() when capture stops. A single
+	 *  consumer, normally the thread running the BodyWriter, reads the frames through the usual EssenceSource interface.
+	 *
+	 *  Frames pass through a fixed size ring that needs no lock, so the producer is never held up by the consumer. If the
+	 *  ring is full the frame is dropped and counted rather than waited for, and any following frames that are not key
+	 *  frames are also dropped as they could not be decoded. The consumer waits in GetEssenceData() and
+	 *  GetEssenceDataSize() while the ring is empty, as the BodyWriter has no way to be told to try again later.
+	 *
+	 *  Each frame is returned as one wrapping unit (split if larger than the MaxSize of a GetEssenceData() call), so this
+	 *  source is intended for frame wrapping. If an index manager is set, each frame is offered to it with its key frame
+	 *  offset and flags so that a VBR index table can be built.
+	 */
+	class LiveEssenceSource : public EssenceSource
+	{
+	public:
+		//! Default number of frames the ring can hold
+		static const size_t DefaultCapacity;
+
+	protected:
+		//! A frame held in the ring
+		struct LiveFrame
+		{
+			DataChunkPtr Data;					//!< The bytes of the frame, or NULL for an empty slot
+			bool KeyFrame;						//!< True if the frame can be decoded without reference to others
+			bool EditPoint;						//!< True if the frame may be used as an edit point
+		};
+
+		Rational EditRate;						//!< The edit rate of the frames
+		UInt8 GCEssenceType;					//!< The essence type byte for the Generic Container key
+		UInt8 GCElementType;					//!< The element type byte for the Generic Container key
+
+		LiveFrame *Ring;						//!< The ring of frames
+		size_t Capacity;						//!< Number of slots in the ring
+
+		/* DRAGONS: Head and Tail are counts of all frames taken and added, each written by only one thread. The slot used
+		 *          is the count modulo Capacity, and the fill level is their difference, which unsigned arithmetic keeps
+		 *          correct when the counts wrap.
+		 */
+		volatile size_t Head;					//!< Number of frames taken from the ring, written only by the consumer
+		volatile size_t Tail;					//!< Number of frames added to the ring, written only by the producer
+		volatile bool InputEnded;				//!< Set by the producer once no more frames will be pushed
+		volatile bool ConsumerWaiting;			//!< Set by the consumer while it waits for a frame
+
+		/* Counts written only by the producer */
+		volatile size_t FramesPushed;			//!< Number of frames accepted into the ring
+		volatile size_t FramesDropped;			//!< Number of frames dropped, including those dropped while waiting for a key frame
+		volatile size_t PeakFill;				//!< Largest number of frames held in the ring at once
+		bool DropToKey;							//!< True if frames are being dropped until the next key frame
+
+		/* State used only by the consumer */
+		LiveFrame Current;						//!< The frame being returned, if Current.Data is not NULL
+		size_t CurrentOffset;					//!< Number of bytes of the current frame already returned
+		Position FramePos;						//!< Number of whole frames returned, the position of the current frame
+		Position LastKeyFrame;					//!< Position of the most recent key frame, or -1 if none yet
+		bool AtEndOfItem;						//!< True if the last call to GetEssenceData() ended a frame
+		bool LastEditPoint;						//!< Edit point flag of the last frame returned
+
+		Mutex WaitLock;							//!< Lock used only to wait for, and signal, a frame when the ring is empty
+		Condition FrameAdded;					//!< Signalled when a frame is added, or the input ends, while the consumer waits
+
+	private:
+		//! Prevent default construction
+		LiveEssenceSource();
+
+		//! Prevent copy construction
+		LiveEssenceSource(const LiveEssenceSource &);
+
+	public:
+		//! Construct a live source with an empty ring
+		/*! \param EditRate The edit rate of the frames, one frame per edit unit
+		 *  \param GCEssenceType The essence type byte to use in the Generic Container key (e.g. 0x15 for GC picture)
+		 *  \param GCElementType The element type byte to use in the Generic Container key
+		 *  \param Capacity The number of frames the ring can hold, which sets the largest latency before frames are dropped
+		 */
+		LiveEssenceSource(Rational EditRate, UInt8 GCEssenceType, UInt8 GCElementType, size_t Capacity = DefaultCapacity);
+
+		//! Release the ring and any frames not yet taken
+		~LiveEssenceSource();
+
+
+		/* Producer methods - only to be called by the capture thread */
+
+		//! Add a frame to the ring, without waiting
+		/*! \param Data The bytes of the frame, which are not copied and must not be changed afterwards
+		 *  \param KeyFrame True if the frame can be decoded without reference to other frames
+		 *  \param EditPoint True if the frame may be used as an edit point
+		 *  \return true if the frame was added, false if it was dropped
+		 */
+		bool PushFrame(DataChunkPtr Data, bool KeyFrame = true, bool EditPoint = true);
+
+		//! Add a copy of a frame to the ring, without waiting
+		/*! \return true if the frame was added, false if it was dropped
+		 *  \note The buffer is only copied if the frame is added, so it costs nothing to push a frame that is dropped
+		 */
+		bool PushFrame(const UInt8 *Buffer, size_t Size, bool KeyFrame = true, bool EditPoint = true);
+
+		//! Signal that capture has stopped and no more frames will be pushed
+		/*! Frames already in the ring will still be returned before EndOfData() becomes true */
+		void EndOfInput(void);
+
+
+		/* Status methods - may be called from any thread */
+
+		//! Get the number of frames in the ring waiting to be taken
+		size_t GetFillLevel(void) const
+		{
+			// DRAGONS: Head must be read first, as either count may change between the reads and Tail is never behind Head
+			size_t Taken = Head;
+			return Tail - Taken;
+		}
+
+		//! Get the number of frames the ring can hold
+		size_t GetCapacity(void) const { return Capacity; }
+
+		//! Get the largest number of frames held in the ring at once
+		size_t GetPeakFill(void) const { return PeakFill; }
+
+		//! Get the number of frames accepted into the ring
+		size_t GetFramesPushed(void) const { return FramesPushed; }
+
+		//! Get the number of frames dropped because the ring was full, or while waiting for a key frame after a drop
+		size_t GetFramesDropped(void) const { return FramesDropped; }
+
+
+		/* EssenceSource methods - only to be called by the consumer thread */
+
+		//! Get the size of the next "installment" of essence data in bytes
+		/*! This is the remaining size of the next frame, waiting for one to be pushed if required
+		 *  \return The size, or zero once the input has ended and all frames have been returned
+		 */
+		virtual size_t GetEssenceDataSize(void);
+
+		//! Get the next "installment" of essence data
+		/*! This returns the next frame, waiting for one to be pushed if required. A frame larger than MaxSize is returned
+		 *  in MaxSize pieces. If Size is given, no more than this is returned. A whole frame is returned without copying.
+		 *  \return Pointer to a data chunk holding the next data or a NULL pointer once the input has ended and all frames have been returned
+		 */
+		virtual DataChunkPtr GetEssenceData(size_t Size = 0, size_t MaxSize = 0);
+
+		//! Did the last call to GetEssenceData() return the end of a wrapping item
+		virtual bool EndOfItem(void) { return AtEndOfItem; }
+
+		//! Is all data exhasted?
+		/*! \return true once the input has ended and all frames have been returned */
+		virtual bool EndOfData(void);
+
+		//! Get the GCEssenceType to use when wrapping this essence in a Generic Container
+		virtual UInt8 GetGCEssenceType(void) { return GCEssenceType; }
+
+		//! Get the GCEssenceType to use when wrapping this essence in a Generic Container
+		virtual UInt8 GetGCElementType(void) { return GCElementType; }
+
+		//! Is the last data read the start of an edit point?
+		virtual bool IsEditPoint(void) { return LastEditPoint; }
+
+		//! Get the edit rate of this wrapping of the essence
+		virtual Rational GetEditRate(void) { return EditRate; }
+
+		//! Get the current position in GetEditRate() sized edit units
+		/*! This is the number of whole frames returned so far, not counting any dropped frames */
+		virtual Position GetCurrentPosition(void) { return FramePos; }
+
+		//! Can this stream provide indexing
+		/*! Each frame is indexed as it is started, using the key frame flag given when it was pushed */
+		virtual bool CanIndex() { return true; }
+
+		//! Enable VBR indexing - each frame is always started by a fresh GetEssenceData() call
+		virtual bool EnableVBRIndexMode(void) { return true; }
+
+		//! Get the name of this essence source (used for error messeges)
+		virtual std::string Name(void) { return "Live capture essence"; }
+
+	protected:
+		//! Make the next frame the current frame, waiting for one to be pushed if required
+		/*! The frame is offered to the index manager as it becomes current
+		 *  \return false once the input has ended and all frames have been returned
+		 */
+		bool NextFrame(void);
+
+		//! Offer the current frame to the index manager, if there is one
+		void IndexFrame(void);
+
+		//! Wake the consumer if it is waiting for a frame
+		void WakeConsumer(void);
+	};
+}
+
+#endif // MXFLIB__LIVESOURCE_H
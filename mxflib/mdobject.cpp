@@ -55,6 +55,12 @@ MDObject::ULTranslator MDObject::UL2NameFunc = NULL;
 //! Translator function to translate unknown ULs to object names
 MDObject::ULTypeMaker MDObject::TypeMaker = NULL;
 
+namespace
+{
+	//! Lock to serialise calls to MDObject::TypeMaker, which may be called while parsing files in different threads
+	Mutex TypeMakerLock;
+}
+
 // Object to use for returning references from methods called when Object == NULL
 MDObject *ObjectInterface::NullObject = NULL;
 
@@ -69,8 +75,12 @@ PrimerPtr MDOType::MakeBuiltInPrimer(bool SetStatic /*=false*/)
 
 
 
-	// Replace existing StaticPrimer if requested
-	if(SetStatic) StaticPrimer = Ret;
+	// Replace existing StaticPrimer if requested - unless the dictionary is frozen as other threads may be using it
+	if(SetStatic)
+	{
+		if(Frozen) error("Attempted to replace the static primer of a frozen dictionary\n");
+		else StaticPrimer = Ret;
+	}
 
 	return Ret;
 }
@@ -106,8 +116,12 @@ PrimerPtr MDOType::MakePrimer(bool SetStatic /*=false*/)
 		it++;
 	}
 
-	// Replace existing StaticPrimer if requested
-	if(SetStatic) StaticPrimer = Ret;
+	// Replace existing StaticPrimer if requested - unless the dictionary is frozen as other threads may be using it
+	if(SetStatic)
+	{
+		if(Frozen) error("Attempted to replace the static primer of a frozen dictionary\n");
+		else StaticPrimer = Ret;
+	}
 
 	return Ret;
 }
@@ -216,13 +230,13 @@ MDOTypePtr MDOType::Find(Tag BaseTag, PrimerPtr BasePrimer)
 	if(!BasePrimer) BasePrimer = GetStaticPrimer();
 
 	// Search the primer
-	Primer::iterator it = BasePrimer->find(BaseTag);
+	UL ThisUL;
 
 	// Return NULL if not in the primer
-	if(it == BasePrimer->end()) return NULL;
+	if(!BasePrimer->FindUL(BaseTag, ThisUL)) return NULL;
 
 	// Now search on the located UL
-	return MDOType::Find((*it).second);
+	return MDOType::Find(ThisUL);
 }
 
 
@@ -485,7 +499,11 @@ void MDObject::UnknownCtor(void)
 		{
 			// FIXME: This doen not seem right here - to be checked!
 			if(TypeMaker)
+			{
+				// Serialise calls to the type maker as it is not expected to be thread-safe
+				MutexLock Locked(TypeMakerLock);
 				Type = TypeMaker(TheUL,NULL);
+			}
 			else
 			// If this feature is enabled, try to now find the type by name
 			Type = MDOType::Find(ObjectName);
@@ -553,10 +571,11 @@ MDObject::MDObject(Tag BaseTag, PrimerPtr BasePrimer, MDObject const *Parent /*=
 	// Try and find the tag in the primer
 	if(BasePrimer) 
 	{
-		Primer::iterator it = BasePrimer->find(BaseTag);
+		// DRAGONS: FindUL() is used as the primer may be the shared static primer of a frozen dictionary
+		UL PrimerUL;
 
 		// Didn't find it!!
-		if(it == BasePrimer->end())
+		if(!BasePrimer->FindUL(BaseTag, PrimerUL))
 		{
 			/* MJB 8-June-2007: DRAGONS: Don't complain about AAF built-in tags */
 			if(BaseTag >= 0x0100)
@@ -591,7 +610,7 @@ MDObject::MDObject(Tag BaseTag, PrimerPtr BasePrimer, MDObject const *Parent /*=
 		else
 		{
 			// It was found in the primer, so lookup the type from the UL
-			TheUL = new UL((*it).second);
+			TheUL = new UL(PrimerUL);
 			Type = MDOType::Find(TheUL);
 		}
 	}
@@ -3363,6 +3382,13 @@ MDOTypePtr MDOType::DefineClass(ClassRecordPtr &ThisClass, SymbolSpacePtr Defaul
 		DICT_LEN_UNDEFINED
 	};
 
+	// A frozen dictionary may be in use by other threads, so must not be modified
+	if(Frozen)
+	{
+		error("Cannot define class %s as the dictionary is frozen\n", ThisClass->Name.c_str());
+		return NULL;
+	}
+
 	// The symbol space to use for this class
 	SymbolSpacePtr ThisSymbolSpace;
 	if(ThisClass->SymSpace) ThisSymbolSpace = ThisClass->SymSpace; else ThisSymbolSpace = DefaultSymbolSpace;
@@ -3864,10 +3890,36 @@ MDOTypePtr MDOType::DefineClass(ClassRecordPtr &ThisClass, SymbolSpacePtr Defaul
 }
 
 
+//! Make all loaded classes permanent and mark the dictionary as frozen
+/*! Classes are shared by every MDObject of that type, so making them permanent removes the reference count locking
+ *  that would otherwise be contended when parsing files in different threads
+ */
+void MDOType::Freeze(void)
+{
+	MDOTypeList::iterator it = AllTypes.begin();
+	while(it != AllTypes.end())
+	{
+		(*it)->SetPermanent();
+		if((*it)->TypeUL) (*it)->TypeUL->SetPermanent();
+		it++;
+	}
+
+	if(StaticPrimer) StaticPrimer->SetPermanent();
+
+	Frozen = true;
+}
+
+
 //! Unload all classes from memory
 /*! \note Classes still in use will remain until they are no longer referenced */
 void MDOType::ClearClasses(void)
 {
+	if(Frozen)
+	{
+		error("Attempted to clear the classes of a frozen dictionary\n");
+		return;
+	}
+
 	StaticPrimer = NULL;
 	
 	ULLookup.clear();
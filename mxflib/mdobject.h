@@ -116,6 +116,26 @@ namespace mxflib
 			return NULL;
 		}
 
+		//! Make all symbol spaces, and the ULs they hold, permanent so they may be shared between threads
+		/*! \note No new symbol spaces or symbols may be added once frozen */
+		static void Freeze(void)
+		{
+			SymbolSpaceMap::iterator map_it = AllSymbolSpaces.begin();
+			while(map_it != AllSymbolSpaces.end())
+			{
+				(*map_it).second->SetPermanent();
+
+				iterator it = (*map_it).second->begin();
+				while(it != (*map_it).second->end())
+				{
+					if((*it).second) (*it).second->SetPermanent();
+					it++;
+				}
+
+				map_it++;
+			}
+		}
+
 		//! Get the name of this symbol space
 		const std::string &Name(void) const { return SymName; }
 
@@ -575,6 +595,9 @@ namespace mxflib
 		//! Flag to show when we have loaded types and classes required for internal use
 		static bool InternalsDefined;
 
+		//! Flag to show when the dictionary has been frozen, after which it is never modified
+		static bool Frozen;
+
 	public:
 		//! Bit masks for items that are to be set for this definition in BuildTypeFromDict
 		/*! This allows some values to be inherited from the base class,
@@ -605,10 +628,25 @@ namespace mxflib
 		//! Accessor for InternalsDefined
 		static bool GetInternalsDefined(void) { return InternalsDefined; }
 
+		//! Make all loaded classes permanent and mark the dictionary as frozen
+		/*! \note Use FreezeDictionary() rather than calling this directly as other shared state also needs preparing */
+		static void Freeze(void);
+
+		//! Has the dictionary been frozen?
+		static bool IsFrozen(void) { return Frozen; }
+
 		//! Clear any loaded dictionary data
-		/*! This can be used before loading a different dictionary, or to free allocated memory for debugging (such as memory leak detection) */
+		/*! This can be used before loading a different dictionary, or to free allocated memory for debugging (such as memory leak detection)
+		 *  \note A frozen dictionary cannot be cleared
+		 */
 		static void ClearDict(void)
 		{
+			if(Frozen)
+			{
+				error("Attempted to clear a frozen dictionary\n");
+				return;
+			}
+
 			AllTypes.clear();
 			TopTypes.clear();
 			ULLookup.clear();
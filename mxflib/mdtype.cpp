@@ -77,6 +77,55 @@ void MDType::AddType(MDTypePtr &Type, ULPtr &TypeUL)
 }
 
 
+namespace
+{
+	//! Make a type, its UL, its traits and any child types permanent
+	void MakeTypePermanent(MDTypePtr Type)
+	{
+		Type->SetPermanent();
+
+		ULPtr TypeUL = Type->GetTypeUL();
+		if(TypeUL) TypeUL->SetPermanent();
+
+		MDTraitsPtr Traits = Type->GetTraits();
+		if(Traits) Traits->SetPermanent();
+
+		MDTypeList::const_iterator it = Type->GetChildList().begin();
+		while(it != Type->GetChildList().end())
+		{
+			MakeTypePermanent(*it);
+			it++;
+		}
+	}
+}
+
+
+//! Make all loaded types, and their traits, permanent so they may be shared between threads
+void MDType::Freeze(void)
+{
+	MDTypeList::iterator it = Types.begin();
+	while(it != Types.end())
+	{
+		MakeTypePermanent(*it);
+		it++;
+	}
+
+	TraitsMapType::iterator Traits_it = TraitsMap.begin();
+	while(Traits_it != TraitsMap.end())
+	{
+		if((*Traits_it).second) (*Traits_it).second->SetPermanent();
+		Traits_it++;
+	}
+
+	TraitsULMapType::iterator TraitsUL_it = TraitsULMap.begin();
+	while(TraitsUL_it != TraitsULMap.end())
+	{
+		if((*TraitsUL_it).second) (*TraitsUL_it).second->SetPermanent();
+		TraitsUL_it++;
+	}
+}
+
+
 //! Add a definition for a basic type
 /*! DRAGONS: Currently doesn't check for duplicates
  */
@@ -503,6 +503,10 @@ namespace mxflib
 		static MDTypeMap NameLookup;
 
 	public:
+		//! Make all loaded types, and their traits, permanent so they may be shared between threads
+		/*! \note Use FreezeDictionary() rather than calling this directly */
+		static void Freeze(void);
+
 		//! Add a new basic type
 		static MDTypePtr AddBasic(std::string TypeName, std::string Detail, ULPtr &UL, int TypeSize);
 
@@ -33,6 +33,7 @@
 #include <errno.h>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 #include "mxflib/mxflib.h"
 
@@ -46,6 +47,7 @@ bool mxflib::MXFFile::Open(std::string FileName, bool ReadOnly /* = false */ )
 	// Set to be a normal file
 	isMemoryFile = false;
 	isHandleFile = false;
+	isReadOnly = ReadOnly;
 
 	// Record the name
 	Name = FileName;
@@ -63,6 +65,46 @@ bool mxflib::MXFFile::Open(std::string FileName, bool ReadOnly /* = false */ )
 
 	isOpen = true;
 
+	// A named pipe can be opened as a file, but can only be read forwards
+	Streaming = (FileTell(Handle) == static_cast<UInt64>(-1));
+	StreamReading = true;
+	StreamPos = 0;
+	StreamEnd = 0;
+	StreamRewindStart = 0;
+
+	return ReadRunIn();
+}
+
+
+//! Open the named MXF file read-only while it is still being written, following it as it grows
+bool mxflib::MXFFile::OpenFollow(std::string FileName, int Timeout /*=-1*/)
+{
+	if(isOpen) Close();
+
+	// Set to be a normal file
+	isMemoryFile = false;
+	isHandleFile = false;
+	isReadOnly = true;
+
+	// Record the name
+	Name = FileName;
+
+	Handle = FileOpenRead(FileName.c_str());
+
+	if(!FileValid(Handle)) return false;
+
+	isOpen = true;
+
+	// A named pipe can be opened as a file, but can only be read forwards, and its reads wait for the writer anyway
+	Streaming = (FileTell(Handle) == static_cast<UInt64>(-1));
+	StreamReading = true;
+	StreamPos = 0;
+	StreamEnd = 0;
+	StreamRewindStart = 0;
+
+	// Follow before the run-in is read, as Open() would fail if it has not yet been written
+	SetFollow(true, Timeout);
+
 	return ReadRunIn();
 }
 
@@ -75,6 +117,7 @@ bool mxflib::MXFFile::OpenNew(std::string FileName)
 	// Set to be a normal file
 	isMemoryFile = false;
 	isHandleFile = false;
+	isReadOnly = false;
 
 	// Record the name
 	Name = FileName;
@@ -88,6 +131,13 @@ bool mxflib::MXFFile::OpenNew(std::string FileName)
 	// No run-in yet
 	RunInSize = 0;
 
+	// A named pipe can be opened as a new file, but can only be written forwards
+	Streaming = (FileTell(Handle) == static_cast<UInt64>(-1));
+	StreamReading = false;
+	StreamPos = 0;
+	StreamEnd = 0;
+	StreamRewindStart = 0;
+
 	return true;
 }
 
@@ -99,6 +149,8 @@ bool mxflib::MXFFile::OpenMemory(DataChunkPtr Buff /*=NULL*/, Position Offset /*
 	// Set to be a memory file
 	isMemoryFile = true;
 	isHandleFile = false;
+	isReadOnly = false;
+	Streaming = false;
 	Name = "Memory File";
 
 	// No run-in currently allowed on memory files
@@ -122,7 +174,9 @@ bool mxflib::MXFFile::OpenMemory(DataChunkPtr Buff /*=NULL*/, Position Offset /*
 
 
 //! Open an MXFFile for an existing, open, file handle
-/*! DRAGONS: Once the file handle given here is closed by the caller, all further I/O will fail! */
+/*! If the handle is a pipe or socket the file is read as a stream, see SetStreaming().
+ *  DRAGONS: Once the file handle given here is closed by the caller, all further I/O will fail!
+ */
 bool mxflib::MXFFile::OpenFromHandle(FileHandle Handle)
 {
 	if(isOpen) Close();
@@ -130,6 +184,7 @@ bool mxflib::MXFFile::OpenFromHandle(FileHandle Handle)
 	// Set to be a normal file, but with external handle management
 	isMemoryFile = false;
 	isHandleFile = true;
+	isReadOnly = false;
 
 	// Record the name
 	Name = "Existing Open File";
@@ -141,10 +196,54 @@ bool mxflib::MXFFile::OpenFromHandle(FileHandle Handle)
 
 	isOpen = true;
 
+	// A named pipe can be opened as a file, but can only be read forwards
+	Streaming = (FileTell(Handle) == static_cast<UInt64>(-1));
+	StreamReading = true;
+	StreamPos = 0;
+	StreamEnd = 0;
+	StreamRewindStart = 0;
+
 	return ReadRunIn();
 }
 
 
+//! Open an MXFFile for writing a new file to an existing, open, file handle
+/*! If the handle is a pipe or socket the file is written as a stream, see SetStreaming().
+ *  DRAGONS: Once the file handle given here is closed by the caller, all further I/O will fail!
+ */
+bool mxflib::MXFFile::OpenNewFromHandle(FileHandle Handle)
+{
+	if(isOpen) Close();
+
+	// Set to be a normal file, but with external handle management
+	isMemoryFile = false;
+	isHandleFile = true;
+	isReadOnly = false;
+
+	// Record the name
+	Name = "Existing Open File";
+
+	// Set up our file handle
+	this->Handle = Handle;
+
+	if(!FileValid(Handle)) return false;
+
+	isOpen = true;
+
+	// No run-in yet
+	RunInSize = 0;
+
+	// If the system can't tell us where we are we can only write forwards, counting the bytes as we go
+	Streaming = (FileTell(Handle) == static_cast<UInt64>(-1));
+	StreamReading = false;
+	StreamPos = 0;
+	StreamEnd = 0;
+	StreamRewindStart = 0;
+
+	return true;
+}
+
+
 //! Read the files run-in (if it exists)
 /*! The run-in is placed in property run-in
  *	After this function the file pointer is at the start of the non-run in data
@@ -199,11 +298,40 @@ bool mxflib::MXFFile::ReadRunIn()
 }
 
 
+//! Smallest DataChunk written asynchronously when AsyncWrites is set
+const size_t MXFFile::AsyncWriteMinSize = 64 * 1024;
+
+//! Amount of data read when streaming before the pages behind it are dropped from the cache
+const UInt64 MXFFile::DropBehindSize = 8 * 1024 * 1024;
+
+//! Longest time between checks of the size of a file being followed, in milliseconds
+const int MXFFile::FollowPollTime = 100;
+
+//! Amount of the most recent data read from a stream that is held so that it may be read again
+const size_t MXFFile::StreamRewindSize = 1024 * 1024;
+
+
 //! Close the file
 bool mxflib::MXFFile::Close(void)
 {
+	bool Ret = true;
+
 	if(isOpen) 
 	{
+		if(AsyncWriteEnd) SyncWrites();
+
+		// The last of the direct writes are made here, so this is where any failure is reported
+		if(Direct)
+		{
+			if(!Direct->Sync())
+			{
+				error("Failed to complete direct writes to file \"%s\"\n", Name.c_str());
+				Ret = false;
+			}
+
+			SetDirectWrites(false);
+		}
+
 		if(isMemoryFile)
 		{
 			Buffer = NULL;
@@ -215,9 +343,13 @@ bool mxflib::MXFFile::Close(void)
 	}
 
 	isOpen = false;
+	Access = AccessNormal;
+	Following = false;
+	Watcher = NULL;
+	Streaming = false;
 
 
-	return true;
+	return Ret;
 }
 
 //! Crop the file to to a new size (or the current position)
@@ -229,8 +361,19 @@ bool mxflib::MXFFile::Crop(Position NewSize /*= -1 */)
 		{
 			return false;;
 		}
+		else if(Streaming)
+		{
+			// What has been sent can't be taken back
+			return false;
+		}
 		else
 		{
+			// Buffered data must be written first, or it could extend the file again after the truncate
+			if(!Flush()) return false;
+
+			// The handle is not moved by direct writes, so find the current position here
+			if(Direct && (NewSize < 0)) NewSize = static_cast<Position>(DirectPos);
+
 			if(!isHandleFile) FileTruncate(Handle, NewSize);
 		}
 	}
@@ -239,6 +382,15 @@ bool mxflib::MXFFile::Crop(Position NewSize /*= -1 */)
 }
 
 
+//! Reserve disk space for the file to grow to a given size
+bool mxflib::MXFFile::Preallocate(Length NewSize)
+{
+	if((!isOpen) || isMemoryFile || Streaming || (NewSize <= 0)) return false;
+
+	return FileAllocate(Handle, 0, static_cast<UInt64>(NewSize) + RunInSize);
+}
+
+
 
 //! Read data from the file into a DataChunk
 DataChunkPtr mxflib::MXFFile::Read(size_t Size)
@@ -249,13 +401,26 @@ DataChunkPtr mxflib::MXFFile::Read(size_t Size)
 	{
 		size_t Bytes;
 
+		if(AsyncWriteEnd) SyncWrites();
+
 		if(isMemoryFile)
 		{
 			Bytes = MemoryRead(Ret->Data, Size);
 		}
+		else if(Streaming)
+		{
+			Bytes = StreamRead(Ret->Data, Size);
+		}
+		else if(Direct)
+		{
+			Bytes = DirectRead(Ret->Data, Size);
+		}
 		else
 		{
 			Bytes = FileRead(Handle, Ret->Data, Size);
+			StatsCountRead(FileStats, Bytes);
+			if(Following && (Bytes < Size)) Bytes = FollowRead(Ret->Data, Size, Bytes);
+			if((Access == AccessStream) && (Bytes != static_cast<size_t>(-1))) DropBehind(FileTell(Handle));
 		}
 
 		// Handle errors
@@ -272,6 +437,516 @@ DataChunkPtr mxflib::MXFFile::Read(size_t Size)
 }
 
 
+//! Read data from a given position into a DataChunk, without using or moving the file pointer
+DataChunkPtr mxflib::MXFFile::ReadAt(Position Pos, size_t Size)
+{
+	DataChunkPtr Ret = new DataChunk(Size);
+
+	size_t Bytes = ReadAt(Pos, Ret->Data, Size);
+	if(Bytes != Size) Ret->Resize(Bytes);
+
+	return Ret;
+}
+
+
+//! Read data from a given position into a supplied buffer, without using or moving the file pointer
+size_t mxflib::MXFFile::ReadAt(Position Pos, UInt8 *Buffer, size_t Size)
+{
+	if(!Size) return 0;
+
+	size_t Ret;
+	if(isMemoryFile)
+	{
+		Ret = MemoryReadAt(Pos + RunInSize, Buffer, Size);
+	}
+	else if(Streaming)
+	{
+		// A stream is read at the file pointer, which is left after the data as it may not be possible to move back
+		if(StreamSeek(Pos) != 0) return 0;
+		return Read(Buffer, Size);
+	}
+	else if(isReadOnly)
+	{
+		Ret = FileReadAt(Handle, Pos + RunInSize, Buffer, Size);
+		StatsCountRead(FileStats, Ret);
+
+		// Wait for the rest of a short read if following, positioned reads don't use the file pointer so just read again
+		while(Following && (Ret < Size) && WaitForSize(Pos + RunInSize + Size))
+		{
+			size_t Bytes = FileReadAt(Handle, Pos + RunInSize + Ret, &Buffer[Ret], Size - Ret);
+			StatsCountRead(FileStats, Bytes);
+			if(Bytes == static_cast<size_t>(-1)) { Ret = Bytes; break; }
+			Ret += Bytes;
+		}
+
+		if((Access == AccessStream) && (Ret != static_cast<size_t>(-1))) DropBehind(Pos + RunInSize + Ret);
+	}
+	else
+	{
+		// DRAGONS: Files open for writing may hold unflushed data in the stdio buffer, so read through the buffer and restore the file pointer
+		Position OldPos = Tell();
+		Seek(Pos);
+		Ret = Read(Buffer, Size);
+		Seek(OldPos);
+
+		return Ret;
+	}
+
+	// Handle errors
+	if(Ret == static_cast<size_t>(-1))
+	{
+		error("Error reading file \"%s\" at 0x%s - %s\n", Name.c_str(), Int64toHexString(Pos, 8).c_str(), strerror(errno));
+		Ret = 0;
+	}
+
+	return Ret;
+}
+
+
+//! Read a batch of ranges from the file, returning once all have completed
+bool mxflib::MXFFile::ReadBatch(AsyncReadRequestList &Requests)
+{
+	bool Ret = true;
+
+	if(isReadOnly && !isMemoryFile && !Streaming)
+	{
+		if(!AsyncQueue) AsyncQueue = new AsyncIO();
+
+		if(AsyncQueue->IsAsync())
+		{
+			// Offset for the run-in, restored afterwards
+			AsyncReadRequestList::iterator it;
+			for(it = Requests.begin(); it != Requests.end(); it++) (*it).Pos += RunInSize;
+
+			bool Done = AsyncQueue->ReadBatch(FileDescriptor(Handle), Requests);
+
+			for(it = Requests.begin(); it != Requests.end(); it++)
+			{
+				(*it).Pos -= RunInSize;
+				if(Done) StatsCountRead(FileStats, (*it).Bytes);
+
+				if(Done && ((*it).Bytes != (*it).Size))
+				{
+					if((*it).Bytes == static_cast<size_t>(-1))
+					{
+						error("Error reading file \"%s\" at 0x%s - %s\n", Name.c_str(), Int64toHexString((*it).Pos, 8).c_str(), strerror(errno));
+						(*it).Bytes = 0;
+					}
+					Ret = false;
+				}
+			}
+
+			if(Done) return Ret;
+
+			// Drop through and read them one at a time
+			Ret = true;
+		}
+	}
+
+	AsyncReadRequestList::iterator it;
+	for(it = Requests.begin(); it != Requests.end(); it++)
+	{
+		(*it).Bytes = ReadAt((*it).Pos, (*it).Buffer, (*it).Size);
+		if((*it).Bytes != (*it).Size) Ret = false;
+	}
+
+	return Ret;
+}
+
+
+//! Enable or disable asynchronous writes of large DataChunks
+bool mxflib::MXFFile::SetAsyncWrites(bool Enable /*=true*/)
+{
+	if(!Enable)
+	{
+		SyncWrites();
+		AsyncWrites = false;
+		return false;
+	}
+
+	// Queued writes are placed by position, which a stream doesn't have, and would bypass the stage of direct writes
+	if(isMemoryFile || Streaming || Direct) return false;
+
+	if(!AsyncQueue) AsyncQueue = new AsyncIO();
+	AsyncWrites = AsyncQueue->IsAsync();
+
+	return AsyncWrites;
+}
+
+
+//! Wait for any asynchronous writes to complete
+bool mxflib::MXFFile::SyncWrites(void)
+{
+	AsyncWriteEnd = 0;
+
+	if(!AsyncQueue) return true;
+
+	return AsyncQueue->WaitWrites();
+}
+
+
+//! Queue an asynchronous write of a DataChunk at the current position, and move the file pointer past it
+size_t mxflib::MXFFile::QueueWrite(DataChunkPtr &Data)
+{
+	// Anything buffered by earlier writes must reach the file first, and this gives us the true file position
+	FileFlush(Handle);
+	UInt64 Pos = FileTell(Handle);
+
+	if(!AsyncQueue->QueueWrite(FileDescriptor(Handle), Pos, Data))
+	{
+		size_t Ret = static_cast<size_t>(FileWrite(Handle, Data->Data, Data->Size));
+		StatsCountWrite(FileStats, Ret);
+		return Ret;
+	}
+
+	// Count the write now, as its completion is not tracked individually
+	StatsCountWrite(FileStats, Data->Size);
+
+	// Move the file pointer on as if the data had been written
+	UInt64 End = Pos + Data->Size;
+	StatsCountSeek(FileStats);
+	FileSeek(Handle, End);
+	if(End > AsyncWriteEnd) AsyncWriteEnd = End;
+
+	return Data->Size;
+}
+
+
+//! Enable or disable direct writes, which bypass the page cache
+bool mxflib::MXFFile::SetDirectWrites(bool Enable /*=true*/, UInt32 Align /*=DirectWriter::DefaultAlign*/)
+{
+	if(!Enable)
+	{
+		if(Direct)
+		{
+			Direct = NULL;
+
+			// Move the handle to where the direct writes left the file pointer
+			StatsCountSeek(FileStats);
+			FileSeek(Handle, DirectPos);
+		}
+
+		return false;
+	}
+
+	if(Direct) return true;
+
+#ifdef O_DIRECT
+	// Direct writes are placed by position, and need the file name to open it again
+	if(!isOpen || isMemoryFile || isHandleFile || isReadOnly || Streaming) return false;
+
+	// Queued writes would bypass the stage, so wait for any outstanding
+	SetAsyncWrites(false);
+
+	// Anything buffered by earlier writes must reach the file first, and this gives us the true file position
+	FileFlush(Handle);
+	UInt64 Pos = FileTell(Handle);
+
+	DirectWriterPtr Writer = new DirectWriter(Name, FileDescriptor(Handle), Align);
+	if(!Writer->IsOpen()) return false;
+
+	Direct = Writer;
+	DirectPos = Pos;
+
+	return true;
+#else // O_DIRECT
+	// DRAGONS: There is no direct I/O on this system, and the handle may not have a descriptor that DirectWriter could use
+	return false;
+#endif // O_DIRECT
+}
+
+
+//! Write at the file pointer while direct writes are enabled, and move the file pointer past the data
+size_t mxflib::MXFFile::DirectWrite(const UInt8 *Buffer, size_t Size)
+{
+	size_t Ret = Direct->Write(DirectPos, Buffer, Size);
+	StatsCountWrite(FileStats, Ret);
+	if(Ret != static_cast<size_t>(-1)) DirectPos += Ret;
+
+	return Ret;
+}
+
+
+//! Read from the file pointer while direct writes are enabled, once any buffered writes are written
+size_t mxflib::MXFFile::DirectRead(UInt8 *Buffer, size_t Size)
+{
+	if(!Direct->Sync()) return static_cast<size_t>(-1);
+
+	// DRAGONS: Nothing is written through the handle while direct writes are enabled, so its buffer holds nothing to be seen
+	size_t Ret = FileReadAt(Handle, DirectPos, Buffer, Size);
+	StatsCountRead(FileStats, Ret);
+	if(Ret != static_cast<size_t>(-1)) DirectPos += Ret;
+
+	return Ret;
+}
+
+
+//! Set the expected pattern of access to the file
+void mxflib::MXFFile::SetAccessMode(AccessMode Mode)
+{
+	// The page cache plays no part in reading a stream
+	if(Streaming) Mode = AccessNormal;
+
+	Access = Mode;
+
+	if(!isOpen || isMemoryFile || Streaming) return;
+
+	switch(Mode)
+	{
+	case AccessRandom:
+		FileAdviseRandom(Handle);
+		break;
+
+	case AccessSequential:
+		FileAdviseSequential(Handle);
+		break;
+
+	case AccessStream:
+		FileAdviseSequential(Handle);
+
+		// Start dropping pages from the current position
+		DropBehindPos = FileTell(Handle);
+		break;
+
+	default:
+		FileAdviseNormal(Handle);
+		break;
+	}
+}
+
+
+//! Follow a file that is still being written, so that reads past the current end wait for it to grow
+bool mxflib::MXFFile::SetFollow(bool Enable /*=true*/, int Timeout /*=-1*/)
+{
+	// A stream already waits for more data on each read
+	if(!Enable || !isOpen || isMemoryFile || Streaming)
+	{
+		Following = false;
+		Watcher = NULL;
+		return false;
+	}
+
+	// DRAGONS: Files opened from a handle have no name to watch, so Watcher will poll
+	if(!Watcher) Watcher = new FileWatch(Name);
+
+	Following = true;
+	FollowTimeout = Timeout;
+	FollowStopped = false;
+
+	return true;
+}
+
+
+//! Wait for a file being followed to grow to at least the given physical size
+bool mxflib::MXFFile::WaitForSize(UInt64 End)
+{
+	if(!Following) return false;
+
+	// The timeout runs from the last time the file was seen to grow
+	Int64 LastSize = -1;
+	UInt64 IdleStart = 0;
+
+	for(;;)
+	{
+		if(FollowStopped) return false;
+
+		Int64 CurrentSize = FileSize(Handle);
+		if(CurrentSize < 0) return false;
+		if(static_cast<UInt64>(CurrentSize) >= End) return true;
+
+		UInt64 Now = GetMicroseconds();
+		if(CurrentSize != LastSize)
+		{
+			LastSize = CurrentSize;
+			IdleStart = Now;
+		}
+		else if((FollowTimeout >= 0) && ((Now - IdleStart) >= static_cast<UInt64>(FollowTimeout) * 1000))
+		{
+			// Take the writer to have finished, so that later reads don't each wait again
+			FollowStopped = true;
+			return false;
+		}
+
+		Watcher->Wait(FollowPollTime);
+	}
+}
+
+
+//! Complete a short read from the file pointer of a file being followed, waiting for the rest to be written
+size_t mxflib::MXFFile::FollowRead(UInt8 *Buffer, size_t Size, size_t Done)
+{
+	if(Done == static_cast<size_t>(-1)) return Done;
+
+	UInt64 Pos = FileTell(Handle);
+
+	while((Done < Size) && WaitForSize(Pos + (Size - Done)))
+	{
+		// Seeking to where we are clears the end-of-file state left by the short read, and any stale buffered data
+		StatsCountSeek(FileStats);
+		FileSeek(Handle, Pos);
+
+		size_t Bytes = FileRead(Handle, &Buffer[Done], Size - Done);
+		StatsCountRead(FileStats, Bytes);
+		if(Bytes == static_cast<size_t>(-1)) return Bytes;
+
+		Done += Bytes;
+		Pos += Bytes;
+	}
+
+	return Done;
+}
+
+
+//! Treat the file as a stream that can only be read or written forwards
+bool mxflib::MXFFile::SetStreaming(bool Enable /*=true*/)
+{
+	if(!isOpen || isMemoryFile) return false;
+
+	if(!Enable)
+	{
+		// A handle that can't report its position can't be used as a normal file
+		if(Streaming && (FileTell(Handle) == static_cast<UInt64>(-1))) return true;
+
+		// Move the handle back to any data held after a seek back
+		if(Streaming && (StreamPos != StreamEnd)) FileSeek(Handle, StreamPos);
+
+		Streaming = false;
+		return false;
+	}
+
+	if(!Streaming)
+	{
+		// Count on from the current position
+		UInt64 Pos = FileTell(Handle);
+		StreamPos = (Pos == static_cast<UInt64>(-1)) ? 0 : Pos;
+		StreamEnd = StreamPos;
+		StreamRewindStart = StreamPos;
+	}
+
+	// None of these can be done without seeking
+	SetAsyncWrites(false);
+	SetDirectWrites(false);
+	SetFollow(false);
+	SetAccessMode(AccessNormal);
+
+	Streaming = true;
+
+	return true;
+}
+
+
+//! Move the file pointer of a stream
+int mxflib::MXFFile::StreamSeek(Position Pos)
+{
+	UInt64 Target = static_cast<UInt64>(Pos + RunInSize);
+	if(Target == StreamPos) return 0;
+
+	// Move back over data still held from the stream
+	UInt64 HeldStart = StreamRewindStart;
+	if((StreamEnd - HeldStart) > StreamRewindSize) HeldStart = StreamEnd - StreamRewindSize;
+
+	if((Pos >= 0) && (Target >= HeldStart) && (Target <= StreamEnd))
+	{
+		StreamPos = Target;
+		return 0;
+	}
+
+	// Move forwards in a stream being read by reading and discarding the data
+	if(StreamReading && (Target > StreamEnd))
+	{
+		StreamPos = StreamEnd;
+
+		DataChunk Discard(static_cast<size_t>(std::min(Target - StreamPos, static_cast<UInt64>(StreamRewindSize))));
+		while(StreamPos < Target)
+		{
+			size_t Bytes = StreamRead(Discard.Data, static_cast<size_t>(std::min(Target - StreamPos, static_cast<UInt64>(Discard.Size))));
+
+			// The stream ended before the target, which is not an error until the missing data is read
+			if((Bytes == 0) || (Bytes == static_cast<size_t>(-1))) return -1;
+		}
+
+		return 0;
+	}
+
+	error("Cannot move from 0x%s to 0x%s in \"%s\" as it is a stream\n", Int64toHexString(StreamPos - RunInSize, 8).c_str(), Int64toHexString(Pos, 8).c_str(), Name.c_str());
+	return -1;
+}
+
+
+//! Read from the file pointer of a stream, serving any data held after a seek back before reading more
+size_t mxflib::MXFFile::StreamRead(UInt8 *Buffer, size_t Size)
+{
+	size_t Done = 0;
+
+	// Serve what we can from data held after a seek back
+	while((Done < Size) && (StreamPos < StreamEnd))
+	{
+		size_t Offset = static_cast<size_t>(StreamPos % StreamRewindSize);
+		size_t Count = static_cast<size_t>(std::min(StreamEnd - StreamPos, static_cast<UInt64>(Size - Done)));
+		if(Count > (StreamRewindSize - Offset)) Count = StreamRewindSize - Offset;
+
+		memcpy(&Buffer[Done], &StreamRewind.Data[Offset], Count);
+		StreamPos += Count;
+		Done += Count;
+	}
+
+	if(Done == Size) return Done;
+
+	size_t Bytes = FileRead(Handle, &Buffer[Done], Size - Done);
+	StatsCountRead(FileStats, Bytes);
+
+	if(Bytes == static_cast<size_t>(-1)) return Done ? Done : Bytes;
+
+	// Hold the end of the new data so that it may be read again, the ring is only allocated once it is needed
+	if(StreamRewind.Size != StreamRewindSize) StreamRewind.Resize(StreamRewindSize);
+
+	size_t Keep = Bytes;
+	const UInt8 *Source = &Buffer[Done];
+	if(Keep > StreamRewindSize)
+	{
+		Source += Keep - StreamRewindSize;
+		Keep = StreamRewindSize;
+	}
+
+	UInt64 KeepPos = StreamPos + (Bytes - Keep);
+	while(Keep)
+	{
+		size_t Offset = static_cast<size_t>(KeepPos % StreamRewindSize);
+		size_t Count = std::min(Keep, StreamRewindSize - Offset);
+
+		memcpy(&StreamRewind.Data[Offset], Source, Count);
+		Source += Count;
+		KeepPos += Count;
+		Keep -= Count;
+	}
+
+	StreamPos += Bytes;
+	StreamEnd = StreamPos;
+
+	return Done + Bytes;
+}
+
+
+//! Drop pages from the cache behind a read that ended at the given physical position, if streaming
+void mxflib::MXFFile::DropBehind(UInt64 EndPos)
+{
+	// A seek backwards, restart from here
+	if(EndPos < DropBehindPos)
+	{
+		DropBehindPos = EndPos;
+		return;
+	}
+
+	if((EndPos - DropBehindPos) < DropBehindSize) return;
+
+	// Drop whole blocks of DropBehindSize so that each call covers a large range
+	// DRAGONS: The system only drops whole pages, so part of a page may be left at each end
+	UInt64 DropEnd = EndPos - ((EndPos - DropBehindPos) % DropBehindSize);
+	FileDontNeed(Handle, DropBehindPos, DropEnd - DropBehindPos);
+	DropBehindPos = DropEnd;
+}
+
+
 //! Read data from the file into a supplied buffer
 size_t mxflib::MXFFile::Read(UInt8 *Buffer, size_t Size)
 {
@@ -279,13 +954,26 @@ size_t mxflib::MXFFile::Read(UInt8 *Buffer, size_t Size)
 
 	if(Size)
 	{
+		if(AsyncWriteEnd) SyncWrites();
+
 		if(isMemoryFile)
 		{
 			Ret = MemoryRead(Buffer, Size);
 		}
+		else if(Streaming)
+		{
+			Ret = StreamRead(Buffer, Size);
+		}
+		else if(Direct)
+		{
+			Ret = DirectRead(Buffer, Size);
+		}
 		else
 		{
 			Ret = FileRead(Handle, Buffer, Size);
+			StatsCountRead(FileStats, Ret);
+			if(Following && (Ret < Size)) Ret = FollowRead(Buffer, Size, Ret);
+			if((Access == AccessStream) && (Ret != static_cast<size_t>(-1))) DropBehind(FileTell(Handle));
 		}
 
 		// Handle errors
@@ -327,6 +1015,9 @@ bool mxflib::MXFFile::ReadRIP(void)
 
 	FileRIP.isGenerated = false;
 
+	// The end of a stream can't be reached without reading all of it
+	if(Streaming) return false;
+
 	SeekEnd();
 	UInt64 FileEnd = Tell();
 
@@ -438,6 +1129,9 @@ bool mxflib::MXFFile::ScanRIP(Length MaxScan /* = 1024*1024 */ )
 
 	FileRIP.isGenerated = true;
 
+	// The footer of a stream can't be reached without reading all of it
+	if(Streaming) return false;
+
 	// Read the header
 	Seek(0);
 	PartitionPtr Header = ReadPartition();
@@ -517,6 +1211,9 @@ Position MXFFile::FindFooter(Length MaxScan/*=1024*1024*/)
 	// If too small a scan range is given we can't scan!
 	if(MaxScan < 20) return 0;
 
+	// The end of a stream can't be reached without reading all of it
+	if(Streaming) return 0;
+
 	Length ScanLeft = MaxScan;			// Number of bytes left to scan
 	SeekEnd();
 	Position FileEnd = Tell();			// The file end
@@ -616,6 +1313,9 @@ bool mxflib::MXFFile::BuildRIP(void)
 
 	FileRIP.isGenerated = true;
 
+	// Building a RIP for a stream would read all of it, leaving nothing to be read
+	if(Streaming) return false;
+
 	Seek(0);
 
 	UInt64 Location = 0;
@@ -1146,6 +1846,14 @@ namespace
  */
 bool MXFFile::WritePartitionInternal(bool ReWrite, PartitionPtr ThisPartition, bool IncludeMetadata, DataChunkPtr IndexData, PrimerPtr UsePrimer, UInt32 Padding, UInt32 MinPartitionSize)
 {
+	StageTimer Timer(StageWrite);
+
+	if(ReWrite && Streaming)
+	{
+		error("Cannot re-write a partition in \"%s\" as it is a stream\n", Name.c_str());
+		return false;
+	}
+
 	//! Length of the partition pack for calculating block alignment
 	Length PartitionPackSize = 0;
 
@@ -1245,7 +1953,12 @@ bool MXFFile::WritePartitionInternal(bool ReWrite, PartitionPtr ThisPartition, b
 	
 	// DRAGONS if already pointing to {removed "a Footer"}{add "any"} PP, do not Align
 	// DRAGONS: We need to figure out what is going on here - if !ReWrite then the pointer should be at the end of the file!
-	if((!ReWrite) && (KAGSize > 1))
+	// DRAGONS: A stream is always at the end, and can't be read back
+	if((!ReWrite) && (KAGSize > 1) && Streaming)
+	{
+		Align(KAGSize);
+	}
+	else if((!ReWrite) && (KAGSize > 1))
 	{
 		Position WritePoint = Tell();
 		ULPtr Key = ReadKey();
@@ -1280,13 +1993,9 @@ bool MXFFile::WritePartitionInternal(bool ReWrite, PartitionPtr ThisPartition, b
 	// If we are going to be doing block alignment we will need to know the size of the partition pack
 	else if(BlockAlign)
 	{
-		// Write the (currently incomplete) partition pack to determine its size
-		Position CurrentPos = Tell();
-		WritePartitionPack(ThisPartition);
-		PartitionPackSize = (Length)(Tell() - CurrentPos);
-		
-		// Then move back so that we re-write it later
-		Seek(CurrentPos);
+		// Build the (currently incomplete) partition pack to determine its size
+		// DRAGONS: This is not written and re-written later so that block alignment works in streams
+		PartitionPackSize = static_cast<Length>(ThisPartition->WriteObject()->Size);
 
 		// Read the partition's body SID so we know if there is essence in this partition
 		BodySID = ThisPartition->GetUInt(BodySID_UL);
@@ -1648,6 +2357,27 @@ size_t MXFFile::MemoryRead(UInt8 *Data, size_t Size)
 
 
 
+//! Read from a given position in a memory file buffer, without moving the current position
+size_t MXFFile::MemoryReadAt(UInt64 Pos, UInt8 *Data, size_t Size)
+{
+	if((Pos < BufferOffset) || ((Pos - BufferOffset) >= Buffer->Size))
+	{
+		error("Cannot currently read outside a memory file buffer\n");
+		return 0;
+	}
+
+	// Limit our read to the max available
+	size_t MaxBytes = Buffer->Size - static_cast<size_t>(Pos - BufferOffset);
+	if(Size > MaxBytes) Size = MaxBytes;
+
+	if(Buffer->Data == 0) return 0;
+
+	memcpy(Data, &Buffer->Data[static_cast<size_t>(Pos - BufferOffset)], Size);
+
+	return Size;
+}
+
+
 //! Read a KLVObject from the file
 KLVObjectPtr MXFFile::ReadKLV(void)
 {
@@ -1682,6 +2412,9 @@ PartitionPtr MXFFile::ReadMasterPartition(Length MaxScan)
 	// If the header is closed return it
 	if(Ret->IsA(ClosedCompleteHeader_UL) || Ret->IsA(ClosedHeader_UL)) return Ret;
 
+	// The footer of a stream can't be reached without reading all of it
+	if(Streaming) return NULL;
+
 	/* The header is open - so we must locate the footer */
 	Position FooterPos = 0;
 
@@ -1739,6 +2472,9 @@ PartitionPtr MXFFile::ReadFooterPartition(Length MaxScan /*=1024*1024*/)
 {
 	PartitionPtr Ret;
 
+	// The footer of a stream can't be reached without reading all of it
+	if(Streaming) return Ret;
+
 	// Start by checking the FooterPosition value in the header
 	Seek(0);
 
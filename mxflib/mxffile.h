@@ -48,10 +48,21 @@ namespace mxflib
 	//! Holds data relating to an MXF file
 	class MXFFile : public RefCount<MXFFile>
 	{
+	public:
+		//! Expected pattern of access to the file, passed to the operating system as a hint
+		enum AccessMode
+		{
+			AccessNormal,				//!< No particular pattern, use the system defaults
+			AccessRandom,				//!< Small reads scattered through the file, such as scanning the headers, RIP and footer - readahead is disabled
+			AccessSequential,			//!< Large reads working forwards through the file, readahead is increased
+			AccessStream				//!< As AccessSequential, but data is dropped from the page cache once it has been read, so bulk reads do not evict other data
+		};
+
 	protected:
 		bool isOpen;					//!< True when the file is open
 		bool isMemoryFile;				//!< True is the file is a "memory file"
 		bool isHandleFile;				//!< True if the file handle is managed externally (we don't open or close it ourselves)
+		bool isReadOnly;				//!< True if the file was opened read-only, so positioned reads need not consider unflushed writes
 		bool TruncatedKnown;			//!< True if the state of "Truncated" has been determined
 		bool Truncated;					//!< True if we have determined that this file has been truncated
 		FileHandle Handle;				//!< File handle
@@ -65,6 +76,44 @@ namespace mxflib
 		Int32 BlockAlignEssenceOffset;	//!< Fixed distance from the block grid at which to align essence (+ve is after the grid, -ve before)
 		Int32 BlockAlignIndexOffset;	//!< Fixed distance from the block grid at which to align index (+ve is after the grid, -ve before)
 
+		AsyncIOPtr AsyncQueue;			//!< Queue for batched reads and asynchronous writes, built on first use
+		bool AsyncWrites;				//!< True if large DataChunk writes are queued asynchronously
+		UInt64 AsyncWriteEnd;			//!< Physical position of the end of the furthest asynchronous write not yet known to be complete, or 0 if none
+
+		//! Smallest DataChunk written asynchronously when AsyncWrites is set, smaller writes are not worth the overhead
+		static const size_t AsyncWriteMinSize;
+
+		AccessMode Access;				//!< The expected pattern of access to the file
+		UInt64 DropBehindPos;			//!< Physical position up to which pages have been dropped from the cache when streaming
+
+		IOStats FileStats;				//!< Counts of I/O calls made on this file
+
+		bool Following;					//!< True if reads past the end of the file wait for it to grow
+		int FollowTimeout;				//!< Time in milliseconds without the file growing before a following read gives up, or -1 to wait forever
+		volatile bool FollowStopped;	//!< Set by StopFollowing() to end any wait for the file to grow
+		FileWatchPtr Watcher;			//!< Watch on the file used to wait for it to grow, built on first use
+
+		bool Streaming;					//!< True if the file is a stream, such as a pipe or socket, that can only be read or written forwards
+		UInt64 StreamPos;				//!< Physical position in a stream, counted from the bytes read and written as it can't be asked
+		UInt64 StreamEnd;				//!< Physical position in a stream of the end of the data read or written so far
+		UInt64 StreamRewindStart;		//!< Physical position in a stream of the first byte that may be held in StreamRewind
+		bool StreamReading;				//!< True if the file was opened to read existing data, so a stream may be skipped forwards
+		DataChunk StreamRewind;			//!< The most recent data read from a stream, held in a ring so that a short Seek() back can be served
+
+		DirectWriterPtr Direct;			//!< Writer used for all writes while direct writes are enabled, else NULL
+		UInt64 DirectPos;				//!< Physical position of the file pointer while direct writes are enabled, as the handle is not moved
+
+		//! Longest time between checks of the size of a file being followed, in milliseconds
+		/*! This bounds the delay if a change notification is missed, or not available, and the delay in seeing StopFollowing() */
+		static const int FollowPollTime;
+
+		//! Amount of data read when streaming before the pages behind it are dropped from the cache
+		static const UInt64 DropBehindSize;
+
+		//! Amount of the most recent data read from a stream that is held so that it may be read again
+		/*! This must be enough for ReadRunIn() to read the run-in search area and then return to the start */
+		static const size_t StreamRewindSize;
+
 
 		//DRAGONS: There should probably be a property to say that in-memory values have changed?
 		//DRAGONS: Should we have a flush() function
@@ -74,13 +123,18 @@ namespace mxflib
 		std::string Name;
 
 	public:
-		MXFFile() : isOpen(false), isMemoryFile(false), TruncatedKnown(false), Truncated(false), BlockAlign(0) {};
+		MXFFile() : isOpen(false), isMemoryFile(false), isReadOnly(false), TruncatedKnown(false), Truncated(false), BlockAlign(0), AsyncWrites(false), AsyncWriteEnd(0), Access(AccessNormal), DropBehindPos(0), Following(false), FollowTimeout(-1), FollowStopped(false), Streaming(false), StreamPos(0), StreamEnd(0), StreamRewindStart(0), StreamReading(false), DirectPos(0) {};
 		virtual ~MXFFile() { if(isOpen) Close(); };
 
 		virtual bool Open(std::string FileName, bool ReadOnly = false );
 		virtual bool OpenNew(std::string FileName);
 		virtual bool OpenMemory(DataChunkPtr Buff = NULL, Position Offset = 0);
 		virtual bool OpenFromHandle(FileHandle Handle);
+		virtual bool OpenNewFromHandle(FileHandle Handle);
+
+		//! Open the named MXF file read-only while it is still being written, following it as it grows (see SetFollow())
+		/*! The file may still be empty, as reading the run-in waits for the writer in the same way as any other read */
+		virtual bool OpenFollow(std::string FileName, int Timeout = -1);
 		virtual bool Close(void);
 		virtual bool Crop(Position NewSize = -1);
 
@@ -107,6 +161,8 @@ namespace mxflib
 		{ 
 			if(!isOpen) return 0;
 			if(isMemoryFile) return BufferCurrentPos-RunInSize;
+			if(Streaming) return StreamPos-RunInSize;
+			if(Direct) return DirectPos-RunInSize;
 			return UInt64(mxflib::FileTell(Handle))-RunInSize;
 		}
 
@@ -128,6 +184,20 @@ namespace mxflib
 				return 0;
 			}
 
+			if(Streaming) return StreamSeek(Pos);
+
+			// Direct writes are placed by position, so the handle is left where it is
+			if(Direct)
+			{
+				StatsCountSeek(FileStats);
+				DirectPos = Pos+RunInSize;
+				return 0;
+			}
+
+			// Moving back over asynchronous writes may be to read or re-write them, so wait for them to land
+			if(AsyncWriteEnd && (static_cast<UInt64>(Pos+RunInSize) < AsyncWriteEnd)) SyncWrites();
+
+			StatsCountSeek(FileStats);
 			return mxflib::FileSeek(Handle, Pos+RunInSize);
 		}
 
@@ -143,6 +213,26 @@ namespace mxflib
 				return (int)Tell();
 			}
 
+			if(Streaming)
+			{
+				error("MXFFile::SeekEnd() not supported on streams\n");
+				return -1;
+			}
+
+			if(AsyncWriteEnd) SyncWrites();
+
+			StatsCountSeek(FileStats);
+			if(Direct)
+			{
+				if(!Direct->Sync()) return -1;
+
+				Int64 End = FileSize(Handle);
+				if(End < 0) return -1;
+
+				DirectPos = static_cast<UInt64>(End);
+				return 0;
+			}
+
 			return mxflib::FileSeekEnd(Handle);
 		}
 
@@ -158,6 +248,16 @@ namespace mxflib
 				// Return true if at the end of the current buffer
 				if((BufferCurrentPos - BufferOffset) <= Buffer->Size) return true; else return false;
 			}
+
+			// Data held from a stream after a seek back has still to be read
+			if(Streaming && (StreamPos < StreamEnd)) return false;
+
+			// DRAGONS: If the buffered writes fail the end can't be known, so report it to stop any reading
+			if(Direct)
+			{
+				if(!Direct->Sync()) return true;
+				return static_cast<Int64>(DirectPos) >= FileSize(Handle);
+			}
 		
 			return mxflib::FileEof(Handle) ? true : false; 
 		};
@@ -167,13 +267,138 @@ namespace mxflib
 		Length Size(void)
 		{
 			if(!isOpen) return -1;
-			if(isMemoryFile) return -1;
+			if(isMemoryFile || Streaming) return -1;
+			if(AsyncWriteEnd) SyncWrites();
+			if(Direct && !Direct->Sync()) return -1;
 			return FileSize(Handle);
 		}
 
 		DataChunkPtr Read(size_t Size);
 		size_t Read(UInt8 *Buffer, size_t Size);
 
+		//! Read data from a given position into a DataChunk, without using or moving the file pointer
+		DataChunkPtr ReadAt(Position Pos, size_t Size);
+
+		//! Read data from a given position into a supplied buffer, without using or moving the file pointer
+		/*! For files opened read-only this is safe to call from many threads at once, with no locking, as each read is
+		 *  a single positioned read (pread on POSIX systems). Files open for writing are read with a seek and restore
+		 *  of the file pointer so that data not yet flushed is seen, which is not safe for concurrent use. A stream is
+		 *  read at its file pointer, which must be able to move to Pos, and is left after the data read.
+		 *  \return The number of bytes read, which is only less than Size at the end of the file or on error
+		 */
+		size_t ReadAt(Position Pos, UInt8 *Buffer, size_t Size);
+
+		//! Read a batch of ranges from the file, returning once all have completed
+		/*! If the library is built with io_uring support, and the file was opened read-only, all the reads are in flight
+		 *  at once; otherwise each is read in turn with ReadAt(). Positions are relative to the start of the MXF data,
+		 *  as with Seek(), and the file pointer is not used or moved.
+		 *  \return true if every request read its full size
+		 */
+		bool ReadBatch(AsyncReadRequestList &Requests);
+
+		//! Enable or disable asynchronous writes of large DataChunks
+		/*! When enabled, Write(DataChunkPtr) queues chunks of at least AsyncWriteMinSize bytes with io_uring and returns
+		 *  without waiting, holding a reference to the chunk until it is written. The chunk must not be modified after
+		 *  being written. Any read, or seek back over queued data, waits for outstanding writes first.
+		 *  \return true if asynchronous writes are now in use, false if disabled or not available
+		 */
+		bool SetAsyncWrites(bool Enable = true);
+
+		//! Wait for any asynchronous writes to complete
+		/*! \return false if any asynchronous write has failed */
+		bool SyncWrites(void);
+
+		//! Was the file opened read-only?
+		bool IsReadOnly(void) const { return isReadOnly; }
+
+		//! Get the counts of I/O calls made on this file since it was created or the counts were reset
+		/*! \note The counts are also added to the process-wide counts, see GetLibraryStats() */
+		const IOStats &GetIOStats(void) const { return FileStats; }
+
+		//! Set the counts of I/O calls made on this file to zero
+		void ResetIOStats(void) { FileStats.Clear(); }
+
+		//! Follow a file that is still being written, so that reads past the current end wait for it to grow
+		/*! While following, a read that would be short waits until the writer has supplied all the bytes requested, so
+		 *  KLVs are never seen part-written. The wait uses change notifications where available (inotify on Linux) and
+		 *  otherwise polls the size of the file every FollowPollTime milliseconds.
+		 *  \param Enable true to follow the file, false to return to normal reads
+		 *  \param Timeout Time in milliseconds without the file growing after which a read gives up and returns what it
+		 *                 has, as it would at the end of a normal file, or -1 to wait until StopFollowing() is called.
+		 *                 Once this happens later reads don't wait, as if StopFollowing() had been called
+		 *  \return true if the file is now being followed, false if disabled or not possible (such as for memory files)
+		 */
+		bool SetFollow(bool Enable = true, int Timeout = -1);
+
+		//! Is the file being followed as it is written?
+		bool IsFollowing(void) const { return Following; }
+
+		//! End any current or future wait for the file to grow, making reads past the end return short as normal
+		/*! This is safe to call from another thread while a read is waiting, which will return within FollowPollTime */
+		void StopFollowing(void) { FollowStopped = true; }
+
+		//! Treat the file as a stream that can only be read or written forwards
+		/*! This is set automatically when a file or handle is opened and the system can't report a position in it, as
+		 *  for a pipe or socket, but may be set for other files, such as sockets on systems that do report one.
+		 *  In a stream Tell() reports the number of bytes read or written and Size() is unknown. A Seek() may only move
+		 *  back over the last StreamRewindSize bytes read, or forwards when reading, which skips over the data, so the
+		 *  RIP and footer can't be found. Partitions can't be re-written, so a header must be left open and incomplete,
+		 *  and asynchronous writes and following are disabled.
+		 *  \return true if the file is now treated as a stream, which can't be undone if the system can't seek in it
+		 */
+		bool SetStreaming(bool Enable = true);
+
+		//! Is the file a stream that can only be read or written forwards?
+		bool IsStreaming(void) const { return Streaming; }
+
+		//! Set the expected pattern of access to the file
+		/*! This only gives hints to the operating system, and has no effect where these are not supported or for memory files.
+		 *  \note AccessStream is intended for a single reader working through the file, such as when extracting essence
+		 */
+		void SetAccessMode(AccessMode Mode);
+
+		//! Get the expected pattern of access to the file
+		AccessMode GetAccessMode(void) const { return Access; }
+
+		//! Hint that a range of the file will be read soon, so that the system may start reading it in the background
+		void WillNeed(Position Pos, Length Size)
+		{
+			if(isOpen && !isMemoryFile && (Size > 0)) FileWillNeed(Handle, Pos + RunInSize, Size);
+		}
+
+		//! Hint that a range of the file will not be read again soon, so that the system may drop it from the page cache
+		void DontNeed(Position Pos, Length Size)
+		{
+			if(isOpen && !isMemoryFile && (Size > 0)) FileDontNeed(Handle, Pos + RunInSize, Size);
+		}
+
+		//! Reserve disk space for the file to grow to a given size, so that the file system can lay it out in a few large extents
+		/*! The size of the file is not changed, so Size() and readers following the file still see only what has been written.
+		 *  Reserved space beyond the end of the file is released by Crop().
+		 *  \param NewSize The size of the MXF data to reserve space for, from the start of the file
+		 *  \return true if the space was reserved, false if not possible (such as for memory files and streams, or where the
+		 *          system or file system does not support it)
+		 */
+		bool Preallocate(Length NewSize);
+
+		//! Enable or disable direct writes, which bypass the page cache so that writing a large file does not evict other data
+		/*! While enabled, data written is gathered in an aligned buffer and sent to disk with direct I/O (O_DIRECT on Linux)
+		 *  in large blocks. Writes that don't follow on from the last, such as re-writing the header, are handled by reading
+		 *  back the start of the first block and writing any part block at the end through the page cache, so they may be
+		 *  made at any position and of any size. Reads, Size() and Flush() first write everything buffered, and they or
+		 *  Close() report any write that has failed.
+		 *  Essence only lands on block boundaries if the KAG is a multiple of Align. Asynchronous writes are disabled.
+		 *  \param Enable true to use direct writes, false to return to normal writes
+		 *  \param Align The block size that direct writes are aligned to, which must be a power of two and at least the
+		 *                logical block size of the device
+		 *  \return true if direct writes are now in use, false if disabled or not possible (such as for memory files, streams,
+		 *          files opened from a handle, or where the system or file system does not support it)
+		 */
+		bool SetDirectWrites(bool Enable = true, UInt32 Align = DirectWriter::DefaultAlign);
+
+		//! Are direct writes in use?
+		bool IsDirectWrites(void) const { return Direct ? true : false; }
+
 //		MDObjectPtr ReadObject(void);
 //		template<class TP, class T> TP ReadObjectBase(void) { TP x; return x; };
 //		template<> MDObjectPtr ReadObjectBase<MDObjectPtr, MDObject>(void) { MDObjectPtr x; return x; };
@@ -277,29 +502,50 @@ namespace mxflib
 		size_t Write(const UInt8 *Buffer, size_t Size) 
 		{ 
 			if(isMemoryFile) return MemoryWrite(Buffer, Size);
+			if(Direct) return DirectWrite(Buffer, Size);
 
-			return FileWrite(Handle, Buffer, Size); 
+			size_t Ret = FileWrite(Handle, Buffer, Size);
+			StatsCountWrite(FileStats, Ret);
+			if(Streaming && (Ret != static_cast<size_t>(-1))) StreamWritten(Ret);
+			return Ret;
 		};
 
 		//! Write the contents of a DataChunk by reference
 		size_t Write(const DataChunk &Data) 
 		{ 
 			if(isMemoryFile) return MemoryWrite(Data.Data, Data.Size);
+			if(Direct) return DirectWrite(Data.Data, Data.Size);
 
-			return FileWrite(Handle, Data.Data, Data.Size); 
+			size_t Ret = FileWrite(Handle, Data.Data, Data.Size);
+			StatsCountWrite(FileStats, Ret);
+			if(Streaming && (Ret != static_cast<size_t>(-1))) StreamWritten(Ret);
+			return Ret;
 		};
 
-		void Flush()
+		//! Write everything buffered to the file
+		/*! \return false if any buffered asynchronous or direct write has failed */
+		bool Flush()
 		{
+			bool Ret = true;
+			if(AsyncWriteEnd && !SyncWrites()) Ret = false;
+			if(Direct && !Direct->Sync()) Ret = false;
 			FileFlush(Handle);
+			return Ret;
 		}
 
 		//! Write the contents of a DataChunk by SmartPtr
+		/*! \note This may be an asynchronous write if enabled with SetAsyncWrites() */
 		size_t Write(DataChunkPtr Data)
 		{ 
 			if(isMemoryFile) return MemoryWrite(Data->Data, Data->Size);
+			if(Direct) return DirectWrite(Data->Data, Data->Size);
+
+			if(AsyncWrites && (Data->Size >= AsyncWriteMinSize)) return QueueWrite(Data);
 
-			return static_cast<size_t>(FileWrite(Handle, Data->Data, Data->Size)); 
+			size_t Ret = static_cast<size_t>(FileWrite(Handle, Data->Data, Data->Size));
+			StatsCountWrite(FileStats, Ret);
+			if(Streaming && (Ret != static_cast<size_t>(-1))) StreamWritten(Ret);
+			return Ret;
 		};
 
 		//! Write 8-bit unsigned integer
@@ -421,6 +667,55 @@ namespace mxflib
 		//! Read from a memory file buffer
 		/*! \note This can be overridden in classes derived from MXFFile to give different memory read behaviour */
 		virtual size_t MemoryRead(UInt8 *Data, size_t Size);
+
+		//! Read from a given position in a memory file buffer, without moving the current position
+		/*! \note This can be overridden in classes derived from MXFFile to give different memory read behaviour */
+		virtual size_t MemoryReadAt(UInt64 Pos, UInt8 *Data, size_t Size);
+
+		//! Queue an asynchronous write of a DataChunk at the current position, and move the file pointer past it
+		size_t QueueWrite(DataChunkPtr &Data);
+
+		//! Wait for a file being followed to grow to at least the given physical size
+		/*! \return true once the file is large enough, false if not following, stopped or the timeout has passed */
+		bool WaitForSize(UInt64 End);
+
+		//! Complete a short read from the file pointer of a file being followed, waiting for the rest to be written
+		/*! \param Buffer The buffer passed to the read
+		 *  \param Size The number of bytes requested
+		 *  \param Done The number of bytes already read, with the file pointer just after them
+		 *  \return The total number of bytes read, which is only less than Size if the wait ended, or -1 on error
+		 */
+		size_t FollowRead(UInt8 *Buffer, size_t Size, size_t Done);
+
+		//! Drop pages from the cache behind a read that ended at the given physical position, if streaming
+		void DropBehind(UInt64 EndPos);
+
+		//! Move the file pointer of a stream
+		/*! A stream being read may be moved back over the last StreamRewindSize bytes read, or forwards by reading and
+		 *  discarding data. Otherwise this is only possible if the pointer is already there.
+		 *  \return 0 if no error, else non-zero
+		 */
+		int StreamSeek(Position Pos);
+
+		//! Read from the file pointer of a stream, serving any data held after a seek back before reading more
+		/*! \return The number of bytes read, or -1 on error */
+		size_t StreamRead(UInt8 *Buffer, size_t Size);
+
+		//! Count bytes written to a stream, which can't then be read back
+		void StreamWritten(size_t Bytes)
+		{
+			StreamPos += Bytes;
+			StreamEnd = StreamPos;
+			StreamRewindStart = StreamPos;
+		}
+
+		//! Write at the file pointer while direct writes are enabled, and move the file pointer past the data
+		/*! \return The number of bytes written, or -1 on error */
+		size_t DirectWrite(const UInt8 *Buffer, size_t Size);
+
+		//! Read from the file pointer while direct writes are enabled, once any buffered writes are written
+		/*! \return The number of bytes read, or -1 on error */
+		size_t DirectRead(UInt8 *Buffer, size_t Size);
 	};
 }
 
@@ -100,6 +100,10 @@ namespace mxflib
 
 #include "mxflib/smartptr.h"
 
+#include "mxflib/thread.h"
+
+#include "mxflib/stats.h"
+
 #include "mxflib/endian.h"
 
 #include "mxflib/forward.h"
@@ -125,6 +129,12 @@ namespace mxflib
 
 #include "mxflib/rip.h"
 
+#include "mxflib/asyncio.h"
+
+#include "mxflib/filewatch.h"
+
+#include "mxflib/directio.h"
+
 #include "mxflib/mxffile.h"
 
 #include "mxflib/index.h"
@@ -134,6 +144,14 @@ namespace mxflib
 
 #include "mxflib/klvobject.h"
 
+#include "mxflib/jp2kreader.h"
+
+#include "mxflib/frameprefetch.h"
+
+#include "mxflib/livesource.h"
+
+#include "mxflib/parseahead.h"
+
 #include "mxflib/crypto.h"
 
 #include "mxflib/metadata.h"
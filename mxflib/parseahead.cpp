@@ -0,0 +1,297 @@
+/*! \file	parseahead.cpp
+ *	\brief	Implementation of an EssenceSource that parses another source ahead of the writer on its own thread
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#include "mxflib/mxflib.h"
+
+#include "mxflib/parseahead.h"
+
+using namespace mxflib;
+
+
+//! Make a list of recorded calls to the target manager, in the order they were recorded
+void IndexOfferRecorder::Replay(const OfferList &List)
+{
+	OfferList::const_iterator it = List.begin();
+	while(it != List.end())
+	{
+		switch((*it).Type)
+		{
+		case OfferAddEditUnit:
+			Target->AddEditUnit((*it).SubStream, (*it).EditUnit, (*it).KeyOffset, (*it).Flags); break;
+		case OfferOfferEditUnit:
+			Target->OfferEditUnit((*it).SubStream, (*it).EditUnit, (*it).KeyOffset, (*it).Flags); break;
+		case OfferSetTemporalOffset:
+			Target->SetTemporalOffset((*it).EditUnit, (*it).Offset); break;
+		case OfferOfferTemporalOffset:
+			Target->OfferTemporalOffset((*it).EditUnit, (*it).Offset); break;
+		case OfferSetKeyOffset:
+			Target->SetKeyOffset((*it).EditUnit, (*it).Offset); break;
+		case OfferOfferKeyOffset:
+			Target->OfferKeyOffset((*it).EditUnit, (*it).Offset); break;
+		}
+
+		it++;
+	}
+}
+
+
+//! Default number of wrapping units to queue ahead of the writer
+const size_t ParseAheadSource::DefaultDepth = 8;
+
+
+//! Construct a filter to read a given source ahead of the writer
+ParseAheadSource::ParseAheadSource(EssenceSourcePtr Base, size_t Depth /*=DefaultDepth*/)
+	: EssenceSource(), Base(Base), Depth(Depth)
+{
+	if(this->Depth < 1) this->Depth = 1;
+
+	Recorder = NULL;
+	Stopping = false;
+
+	Started = false;
+	Inline = false;
+	Finished = false;
+	CurrentOffset = 0;
+	AtEndOfItem = true;
+	LastEditPoint = true;
+	CurrentPos = 0;
+	PrechargeSize = 0;
+}
+
+
+//! Stop the parser thread and discard any unread items
+ParseAheadSource::~ParseAheadSource()
+{
+	{
+		MutexLock Locked(QueueLock);
+		Stopping = true;
+		SpaceFree.Broadcast();
+	}
+
+	// DRAGONS: This must be done here, not in the Thread destructor, as Run() uses our members
+	Join();
+}
+
+
+//! Set the index manager to use for building index tables for this essence
+void ParseAheadSource::SetIndexManager(IndexManagerPtr &Manager, int StreamID)
+{
+	if(Started)
+	{
+		error("Index manager set for %s after reading has started\n", Name().c_str());
+		return;
+	}
+
+	EssenceSource::SetIndexManager(Manager, StreamID);
+
+	if(Manager)
+	{
+		Recorder = new IndexOfferRecorder(Manager);
+		RecorderPtr = Recorder;
+		Base->SetIndexManager(RecorderPtr, StreamID);
+	}
+	else
+	{
+		Recorder = NULL;
+		RecorderPtr = NULL;
+		Base->SetIndexManager(Manager, StreamID);
+	}
+}
+
+
+//! Start reading ahead, if not already started
+void ParseAheadSource::StartReading(void)
+{
+	if(Started) return;
+
+	// Read these while the base source is only used by this thread
+	PrechargeSize = Base->GetPrechargeSize();
+	CurrentPos = Base->GetCurrentPosition();
+
+	Started = true;
+
+	if(!Start())
+	{
+		warning("Unable to start parser thread for %s - reading without parsing ahead\n", Name().c_str());
+		Inline = true;
+	}
+}
+
+
+//! The body of the parser thread
+void ParseAheadSource::Run(void)
+{
+	for(;;)
+	{
+		{
+			MutexLock Locked(QueueLock);
+			while((Queue.size() >= Depth) && !Stopping) SpaceFree.Wait(QueueLock);
+			if(Stopping) return;
+		}
+
+		if(!ReadItem()) return;
+	}
+}
+
+
+//! Read the next wrapping unit from the base source and add it to the queue
+bool ParseAheadSource::ReadItem(void)
+{
+	ParsedItem Item;
+
+	if(!Base->EndOfData()) Item.Data = Base->GetEssenceData();
+
+	if(Item.Data)
+	{
+		Item.EndOfItem = Base->EndOfItem();
+		Item.EditPoint = Base->IsEditPoint();
+	}
+	else
+	{
+		Item.EndOfItem = true;
+		Item.EditPoint = true;
+	}
+
+	Item.Pos = Base->GetCurrentPosition();
+	if(Recorder) Recorder->TakeOffers(Item.Offers);
+
+	MutexLock Locked(QueueLock);
+	Queue.push_back(Item);
+	ItemReady.Signal();
+
+	return Item.Data ? true : false;
+}
+
+
+//! Wait until the queue is not empty
+void ParseAheadSource::WaitForItem(void)
+{
+	while(Queue.empty())
+	{
+		if(Inline)
+		{
+			QueueLock.Unlock();
+			ReadItem();
+			QueueLock.Lock();
+		}
+		else ItemReady.Wait(QueueLock);
+	}
+}
+
+
+//! Make the next queued item the current item, waiting for it to be read if required
+bool ParseAheadSource::NextItem(void)
+{
+	if(Finished) return false;
+
+	StartReading();
+
+	{
+		MutexLock Locked(QueueLock);
+		WaitForItem();
+
+		Current = Queue.front();
+		Queue.pop_front();
+		SpaceFree.Signal();
+	}
+
+	CurrentOffset = 0;
+
+	// Make any index offers on this thread, now that the writer has reached this item
+	if(Recorder && !Current.Offers.empty()) Recorder->Replay(Current.Offers);
+	Current.Offers.clear();
+
+	if(!Current.Data)
+	{
+		Finished = true;
+		CurrentPos = Current.Pos;
+
+		// The parser thread stops after queuing the end, so it is safe to wait for it
+		Join();
+		return false;
+	}
+
+	return true;
+}
+
+
+//! Get the size of the essence data in bytes
+size_t ParseAheadSource::GetEssenceDataSize(void)
+{
+	if(!Current.Data && !NextItem()) return 0;
+
+	return Current.Data->Size - CurrentOffset;
+}
+
+
+//! Get the next "installment" of essence data
+DataChunkPtr ParseAheadSource::GetEssenceData(size_t Size /*=0*/, size_t MaxSize /*=0*/)
+{
+	if(!Current.Data && !NextItem())
+	{
+		AtEndOfItem = true;
+		return NULL;
+	}
+
+	if(CurrentOffset == 0) LastEditPoint = Current.EditPoint;
+
+	size_t Bytes = Current.Data->Size - CurrentOffset;
+	if(Size && (Bytes > Size)) Bytes = Size;
+	if(MaxSize && (Bytes > MaxSize)) Bytes = MaxSize;
+
+	// Return a whole item as read, only copying when it is split
+	DataChunkPtr Ret;
+	if(Bytes == Current.Data->Size) Ret = Current.Data;
+	else Ret = new DataChunk(Bytes, &Current.Data->Data[CurrentOffset]);
+
+	CurrentOffset += Bytes;
+
+	if(CurrentOffset >= Current.Data->Size)
+	{
+		AtEndOfItem = Current.EndOfItem;
+		CurrentPos = Current.Pos;
+		Current.Data = NULL;
+	}
+	else AtEndOfItem = false;
+
+	return Ret;
+}
+
+
+//! Is all data exhasted?
+bool ParseAheadSource::EndOfData(void)
+{
+	if(Finished) return true;
+	if(Current.Data) return false;
+
+	StartReading();
+
+	MutexLock Locked(QueueLock);
+	WaitForItem();
+
+	return !Queue.front().Data;
+}
@@ -0,0 +1,372 @@
+/*! \file	parseahead.h
+ *	\brief	Definition of an EssenceSource that parses another source ahead of the writer on its own thread
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#ifndef MXFLIB__PARSEAHEAD_H
+#define MXFLIB__PARSEAHEAD_H
+
+#include <deque>
+
+
+namespace mxflib
+{
+	//! Index manager that records the index data offered by an essence parser so that it can be offered to another manager later
+	/*! Only the methods called by essence parsers while reading essence are recorded. Any other use of this manager is
+	 *  not supported, as its own index data is never built.
+	 */
+	class IndexOfferRecorder : public IndexManager
+	{
+	public:
+		//! Type of a recorded call
+		enum OfferType
+		{
+			OfferAddEditUnit,						//!< AddEditUnit()
+			OfferOfferEditUnit,						//!< OfferEditUnit()
+			OfferSetTemporalOffset,					//!< SetTemporalOffset()
+			OfferOfferTemporalOffset,				//!< OfferTemporalOffset()
+			OfferSetKeyOffset,						//!< SetKeyOffset()
+			OfferOfferKeyOffset						//!< OfferKeyOffset()
+		};
+
+		//! A single recorded call
+		struct Offer
+		{
+			OfferType Type;							//!< The method that was called
+			int SubStream;							//!< The sub-stream, if used by this method
+			Position EditUnit;						//!< The edit unit
+			int KeyOffset;							//!< The key frame offset, if used by this method
+			int Flags;								//!< The flags, if used by this method
+			int Offset;								//!< The temporal or key frame offset for Set/Offer TemporalOffset/KeyOffset
+		};
+
+		//! List of recorded calls, in the order they were made
+		typedef std::list<Offer> OfferList;
+
+	protected:
+		IndexManagerPtr Target;						//!< The manager that will receive the recorded offers
+		OfferList Offers;							//!< Calls recorded since the last TakeOffers()
+
+	private:
+		//! Prevent default construction
+		IndexOfferRecorder();
+
+		//! Prevent copy construction
+		IndexOfferRecorder(const IndexOfferRecorder &);
+
+	public:
+		//! Construct a recorder for offers to be made later to a given manager
+		IndexOfferRecorder(IndexManagerPtr &Target) : IndexManager(0, 0), Target(Target) {}
+
+		//! Update the PosTableIndex for a given stream
+		/*! This is set while the parser is configured, rather than while reading, so is passed straight to the target */
+		virtual void SetPosTableIndex(int StreamID, int PosTableIndex) { Target->SetPosTableIndex(StreamID, PosTableIndex); }
+
+		//! Record the addition of an edit unit
+		virtual void AddEditUnit(int SubStream, Position EditUnit, int KeyOffset = 0, int Flags = -1)
+		{
+			Record(OfferAddEditUnit, SubStream, EditUnit, KeyOffset, Flags, 0);
+		}
+
+		//! Record an offered edit unit
+		/*! \return true, as the offer can't be accepted or declined until it is made to the target */
+		virtual bool OfferEditUnit(int SubStream, Position EditUnit, int KeyOffset = 0, int Flags = -1)
+		{
+			Record(OfferOfferEditUnit, SubStream, EditUnit, KeyOffset, Flags, 0);
+			return true;
+		}
+
+		//! Record the setting of a temporal offset
+		virtual void SetTemporalOffset(Position EditUnit, int Offset)
+		{
+			Record(OfferSetTemporalOffset, 0, EditUnit, 0, 0, Offset);
+		}
+
+		//! Record an offered temporal offset
+		/*! \return true, as the offer can't be accepted or declined until it is made to the target */
+		virtual bool OfferTemporalOffset(Position EditUnit, int Offset)
+		{
+			Record(OfferOfferTemporalOffset, 0, EditUnit, 0, 0, Offset);
+			return true;
+		}
+
+		//! Record the setting of a key-frame offset
+		virtual void SetKeyOffset(Position EditUnit, int Offset)
+		{
+			Record(OfferSetKeyOffset, 0, EditUnit, 0, 0, Offset);
+		}
+
+		//! Record an offered key-frame offset
+		/*! \return true, as the offer can't be accepted or declined until it is made to the target */
+		virtual bool OfferKeyOffset(Position EditUnit, int Offset)
+		{
+			Record(OfferOfferKeyOffset, 0, EditUnit, 0, 0, Offset);
+			return true;
+		}
+
+		//! Move all calls recorded so far to a given list, leaving none recorded
+		void TakeOffers(OfferList &List)
+		{
+			List.clear();
+			List.swap(Offers);
+		}
+
+		//! Make a list of recorded calls to the target manager, in the order they were recorded
+		void Replay(const OfferList &List);
+
+	protected:
+		//! Record a call
+		void Record(OfferType Type, int SubStream, Position EditUnit, int KeyOffset, int Flags, int Offset)
+		{
+			Offer This;
+			This.Type = Type;
+			This.SubStream = SubStream;
+			This.EditUnit = EditUnit;
+			This.KeyOffset = KeyOffset;
+			This.Flags = Flags;
+			This.Offset = Offset;
+
+			Offers.push_back(This);
+		}
+	};
+
+
+	//! Filter-style source that parses another EssenceSource ahead of the writer on its own thread
+	/*! The base source is read by a parser thread, which keeps up to Depth wrapping units queued ahead of the writer. Any
+	 *  index data offered by the base source while a unit is read is recorded with that unit and offered to the real index
+	 *  manager on the writer's thread as the unit is taken, so the index manager is only ever used by one thread and sees
+	 *  the offers in the same order, relative to the writer's own, as when the source is read directly.
+	 *
+	 *  The thread is started by the first call to GetEssenceData(), GetEssenceDataSize() or EndOfData(), so the source may
+	 *  be configured through this filter as normal until then.
+	 *
+	 *  DRAGONS: This source owns its source, so will keep it alive while we exist.
+	 *  DRAGONS: The base source must not share state with any other source being read, such as another sub-stream of the
+	 *           same parser, as that source will be read on a different thread.
+	 *  \note This filter is intended for frame wrapping, where each call to the base source's GetEssenceData() returns one
+	 *        wrapping unit
+	 */
+	class ParseAheadSource : public EssenceSource, protected Thread
+	{
+	public:
+		//! Default number of wrapping units to queue ahead of the writer
+		static const size_t DefaultDepth;
+
+	protected:
+		//! A wrapping unit read by the parser thread
+		struct ParsedItem
+		{
+			DataChunkPtr Data;							//!< The data read, or NULL if the end of the base source has been reached
+			bool EndOfItem;								//!< Value of EndOfItem() after this data was read
+			bool EditPoint;								//!< Value of IsEditPoint() after this data was read
+			Position Pos;								//!< Value of GetCurrentPosition() after this data was read
+			IndexOfferRecorder::OfferList Offers;		//!< Index data offered while this data was read
+		};
+
+		EssenceSourcePtr Base;							//!< The source being read ahead
+		size_t Depth;									//!< The maximum number of wrapping units to queue
+
+		IndexManagerPtr RecorderPtr;					//!< Recorder given to the base source in place of our index manager, if indexing
+		IndexOfferRecorder *Recorder;					//!< The recorder held by RecorderPtr, or NULL if not indexing
+
+		/* State shared between the threads, protected by QueueLock */
+		Mutex QueueLock;								//!< Lock for the queue and the flags shared with the parser thread
+		Condition ItemReady;							//!< Signalled when an item is added to the queue
+		Condition SpaceFree;							//!< Signalled when an item is taken from the queue, or the parser thread is to stop
+		std::deque<ParsedItem> Queue;					//!< Items read by the parser thread but not yet taken
+		bool Stopping;									//!< Set to ask the parser thread to stop early
+
+		/* State used only by the writer's thread */
+		bool Started;									//!< True once reading ahead has started
+		bool Inline;									//!< True if the parser thread could not be started, so the base source is read when required
+		bool Finished;									//!< True once the end of the base source has been taken from the queue
+		ParsedItem Current;								//!< The item being returned, if Current.Data is not NULL
+		size_t CurrentOffset;							//!< Number of bytes of the current item already returned
+		bool AtEndOfItem;								//!< Value to return from EndOfItem()
+		bool LastEditPoint;								//!< Value to return from IsEditPoint()
+		Position CurrentPos;							//!< Value to return from GetCurrentPosition()
+		Length PrechargeSize;							//!< Pre-charge size of the base source, read before starting
+
+	private:
+		//! Prevent a default constructor
+		ParseAheadSource();
+
+		//! Prevent copy construction
+		ParseAheadSource(const ParseAheadSource &);
+
+	public:
+		//! Construct a filter to read a given source ahead of the writer
+		/*! \param Base The source to read
+		 *  \param Depth The maximum number of wrapping units to hold in the queue
+		 */
+		ParseAheadSource(EssenceSourcePtr Base, size_t Depth = DefaultDepth);
+
+		//! Stop the parser thread and discard any unread items
+		virtual ~ParseAheadSource();
+
+		//! Get the size of the essence data in bytes
+		/*! This is the remaining size of the next wrapping unit, waiting for it to be read if required */
+		virtual size_t GetEssenceDataSize(void);
+
+		//! Get the next "installment" of essence data
+		/*! This returns the next wrapping unit as read by the parser thread, waiting for it to be read if required. A unit
+		 *  larger than MaxSize is returned in MaxSize pieces. If Size is given, no more than this is returned.
+		 *  \return Pointer to a data chunk holding the next data or a NULL pointer when no more remains
+		 */
+		virtual DataChunkPtr GetEssenceData(size_t Size = 0, size_t MaxSize = 0);
+
+		//! Did the last call to GetEssenceData() return the end of a wrapping item
+		virtual bool EndOfItem(void) { return AtEndOfItem; }
+
+		//! Is all data exhasted?
+		virtual bool EndOfData(void);
+
+		//! Is the last data read the start of an edit point?
+		virtual bool IsEditPoint(void) { return LastEditPoint; }
+
+		//! Get the current position in GetEditRate() sized edit units
+		/*! This is the position of the base source after the last whole wrapping unit returned by this filter, not the
+		 *  position the parser thread has reached
+		 */
+		virtual Position GetCurrentPosition(void)
+		{
+			if(!Started) return Base->GetCurrentPosition();
+			return CurrentPos;
+		}
+
+		//! Get the origin value to use for this essence specifically to take account of pre-charge
+		virtual Length GetPrechargeSize(void)
+		{
+			if(!Started) return Base->GetPrechargeSize();
+			return PrechargeSize;
+		}
+
+		//! Set the index manager to use for building index tables for this essence
+		/*! The base source is given a recorder, so that its offers can be made to this manager on the writer's thread */
+		virtual void SetIndexManager(IndexManagerPtr &Manager, int StreamID);
+
+		/* DRAGONS: The following are passed straight to the base source. They are used to configure the source, or only
+		 *          return values that do not change while reading, so it is safe to call them while the parser thread runs.
+		 */
+
+		//! Get data to write as padding after all real essence data has been processed
+		virtual DataChunk *GetPadding(void) { return Base->GetPadding(); }
+
+		//! Get the GCEssenceType to use when wrapping this essence in a Generic Container
+		virtual UInt8 GetGCEssenceType(void) { return Base->GetGCEssenceType(); }
+
+		//! Get the GCEssenceType to use when wrapping this essence in a Generic Container
+		virtual UInt8 GetGCElementType(void) { return Base->GetGCElementType(); }
+
+		//! Get the edit rate of this wrapping of the essence
+		virtual Rational GetEditRate(void) { return Base->GetEditRate(); }
+
+		//! Get the preferred BER length size for essence KLVs written from this source, 0 for auto
+		virtual int GetBERSize(void) { return Base->GetBERSize(); }
+
+		//! Set a non-native edit rate
+		virtual bool SetEditRate(Rational EditRate) { return Base->SetEditRate(EditRate); }
+
+		//! Set a source type or parser specific option
+		virtual bool SetOption(std::string Option, Int64 Param = 0) { return Base->SetOption(Option, Param); }
+
+		//! Get BytesPerEditUnit if Constant, else 0
+		virtual UInt32 GetBytesPerEditUnit(UInt32 KAGSize = 1) { return Base->GetBytesPerEditUnit(KAGSize); }
+
+		//! Can this stream provide indexing
+		virtual bool CanIndex() { return Base->CanIndex(); }
+
+		//! Override the default essence key
+		virtual void SetKey(DataChunkPtr &Key, bool NonGC = false) { Base->SetKey(Key, NonGC); }
+
+		//! Get the current overridden essence key
+		virtual DataChunkPtr &GetKey(void) { return Base->GetKey(); }
+
+		//! Get true if the default essence key has been overriden with  a key that does not use GC track number mechanism
+		virtual bool GetNonGC(void) { return Base->GetNonGC(); }
+
+		//! Is this picture essence?
+		virtual bool IsPictureEssence(void) { return Base->IsPictureEssence(); }
+
+		//! Is this sound essence?
+		virtual bool IsSoundEssence(void) { return Base->IsSoundEssence(); }
+
+		//! Is this data essence?
+		virtual bool IsDataEssence(void) { return Base->IsDataEssence(); }
+
+		//! Is this compound essence?
+		virtual bool IsCompoundEssence(void) { return Base->IsCompoundEssence(); }
+
+		//! An indication of the relative write order to use for this stream
+		virtual Int32 RelativeWriteOrder(void) { return Base->RelativeWriteOrder(); }
+
+		//! The type for relative write-order positioning if RelativeWriteOrder() != 0
+		virtual int RelativeWriteOrderType(void) { return Base->RelativeWriteOrderType(); }
+
+		//! Get the range start position
+		virtual Position GetRangeStart(void) { return Base->GetRangeStart(); }
+
+		//! Get the range end position
+		virtual Position GetRangeEnd(void) { return Base->GetRangeEnd(); }
+
+		//! Get the range duration
+		virtual Length GetRangeDuration(void) { return Base->GetRangeDuration(); }
+
+		//! Get the name of this essence source (used for error messeges)
+		virtual std::string Name(void) { return "ParseAheadSource based on " + Base->Name(); }
+
+		//! Enable VBR indexing, even in clip-wrap mode, by allowing each edit unit to be returned individually
+		virtual bool EnableVBRIndexMode(void) { return Base->EnableVBRIndexMode(); }
+
+		//! Set the essence descriptor
+		virtual void SetDescriptor(MDObjectPtr Descriptor) { Base->SetDescriptor(Descriptor); }
+
+		//! Get a pointer to the essence descriptor for this source (if known) otherwise NULL
+		virtual MDObjectPtr GetDescriptor(void) { return Base->GetDescriptor(); }
+
+	protected:
+		//! The body of the parser thread
+		virtual void Run(void);
+
+		//! Read the next wrapping unit from the base source and add it to the queue
+		/*! \return false once the end of the base source has been queued */
+		bool ReadItem(void);
+
+		//! Start reading ahead, if not already started
+		void StartReading(void);
+
+		//! Make the next queued item the current item, waiting for it to be read if required
+		/*! Any index data offered while the item was read is offered to our index manager
+		 *  \return false if the end of the base source has been reached
+		 */
+		bool NextItem(void);
+
+		//! Wait until the queue is not empty
+		/*! QueueLock must be held by the caller */
+		void WaitForItem(void);
+	};
+}
+
+#endif // MXFLIB__PARSEAHEAD_H
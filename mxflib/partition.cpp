@@ -340,6 +340,9 @@ Length mxflib::Partition::ReadMetadata(void)
 		return 0;
 	}
 
+	// Note where the metadata starts, so that the index table and essence can later be found without reading back over it
+	LocateData();
+
 	// Find the start of the metadata 
 	// DRAGONS: not the most efficient way - we could store a pointer to the end of the pack
 	ParentFile->Seek(Object->GetLocation() + 16);
@@ -596,7 +599,7 @@ MDObjectListPtr mxflib::Partition::ReadIndex(void)
 	}
 
 	MDOTypePtr FirstType = MDOType::Find(FirstUL);
-	if(FirstType->IsA(KLVFill_UL))
+	if(FirstType && FirstType->IsA(KLVFill_UL))
 	{
 		// Skip over the filler
 		Len = ParentFile->ReadBER();
@@ -711,16 +714,12 @@ bool mxflib::Partition::SeekEssence(void)
 	MXFFilePtr File = Object->GetParentFile();
 	if(!File) { error("Call to Partition::SeekEssence() on a non-file partition\n"); return false; }
 
-	Position BodyLocation = 0;
-
 	Length MetadataSize = GetInt64(HeaderByteCount_UL);
 	Length IndexSize = GetInt64(IndexByteCount_UL);
 
 	// Skip over Partition Pack (and any trailing filler)
-	File->Seek( GetUInt64(ThisPartition_UL) + 16 );
-	Length Len = File->ReadBER();
-	BodyLocation = SkipFill( File->Tell() + Len );
-	if(!BodyLocation) return false;
+	Position BodyLocation = LocateData();
+	if(BodyLocation < 0) return false;
 
 	// Skip over Metadata (and any trailing filler)
 	BodyLocation += MetadataSize;
@@ -754,41 +753,68 @@ bool mxflib::Partition::SeekIndex(void)
 
 	Int64 MetadataSize = GetInt64(HeaderByteCount_UL);
 
-	// Find the start of the index table
-	// DRAGONS: not the most efficient way - we could store a pointer to the end of the metadata
-	ParentFile->Seek(Object->GetLocation() + 16);
-	Length Len = ParentFile->ReadBER();
-	Position Location = ParentFile->Tell() + Len;
+	// Find the start of the index table, which follows any metadata
+	Position Location = LocateData();
+	if(Location < 0)
+	{
+		error("Error reading first KLV after %s at 0x%s in %s\n", FullName().c_str(), 
+			  Int64toHexString(GetLocation(),8).c_str(), GetSource().c_str());
+		return false;
+	}
 
 	if((sizeof(size_t) < 8) && IndexSize > 0xffffffff)
 	{
 		error("Maximum read size on this platform is 4Gbytes - However, requested to read index data at 0x%s which has size of 0x%s\n",
-			   Int64toHexString(Location,8).c_str(), Int64toHexString(IndexSize,8).c_str());
+			   Int64toHexString(Location + MetadataSize,8).c_str(), Int64toHexString(IndexSize,8).c_str());
 
 		return false;
 	}
 
-	ParentFile->Seek(Location);
-	ULPtr FirstUL = ParentFile->ReadKey();
-	if(!FirstUL)
+	// Move to the start of the index table segments
+	ParentFile->Seek(Location + MetadataSize);
+
+	return true;
+}
+
+
+//! Locate the start of the header metadata, or of the index table data if there is no metadata, in this partition
+/*! The position found is after the partition pack and any filler that follows it. It is remembered, so that the index
+ *  table and essence can later be found without reading back over the metadata, which may not be possible in a stream.
+ *  \return The position in the parent file, or -1 on error
+ */
+Position mxflib::Partition::LocateData(void)
+{
+	if(DataStart >= 0) return DataStart;
+
+	MXFFilePtr ParentFile = Object->GetParentFile();
+
+	if(!ParentFile)
 	{
-		error("Error reading first KLV after %s at 0x%s in %s\n", FullName().c_str(), 
-			  Int64toHexString(GetLocation(),8).c_str(), GetSource().c_str());
-		return false;
+		error("Call to Partition::LocateData() on a partition that is not read from a file\n");
+		return -1;
 	}
 
+	// Skip over the partition pack
+	ParentFile->Seek(Object->GetLocation() + 16);
+	Length Len = ParentFile->ReadBER();
+	Position Location = ParentFile->Tell() + Len;
+
+	// DRAGONS: This is not an error in itself, as there may be nothing after the last partition pack
+	ParentFile->Seek(Location);
+	ULPtr FirstUL = ParentFile->ReadKey();
+	if(!FirstUL) return -1;
+
 	MDOTypePtr FirstType = MDOType::Find(FirstUL);
-	if(FirstType->IsA(KLVFill_UL))
+	if(FirstType && FirstType->IsA(KLVFill_UL))
 	{
 		// Skip over the filler
 		Len = ParentFile->ReadBER();
 		Location = ParentFile->Tell() + Len;
 	}
 
-	// Move to the start of the index table segments
-	ParentFile->Seek(Location + MetadataSize);
+	DataStart = Location;
 
-	return true;
+	return Location;
 }
 
 
@@ -809,13 +835,11 @@ bool mxflib::Partition::StartElements()
 	UInt64 IndexSize = GetInt64(IndexByteCount_UL);
 
 	// skip over Partition Pack (and any leading Fill on Header)
-	PF->Seek( Object->GetLocation() + 16 );
-	Length Len = PF->ReadBER();
-	_NextBodyLocation = SkipFill( PF->Tell() + Len );
-	if( !_NextBodyLocation ) return false;
+	Position DataLocation = LocateData();
+	if( DataLocation < 0 ) return false;
 
 	// skip over Metadata (and any leading Fill on Index)
-	_NextBodyLocation = SkipFill( _NextBodyLocation + MetadataSize );
+	_NextBodyLocation = SkipFill( DataLocation + MetadataSize );
 	if( !_NextBodyLocation ) return false;
 
 	// skip over Index (and any leading Fill on Body)
@@ -827,13 +851,12 @@ bool mxflib::Partition::StartElements()
 // goto _NextBodyLocation
 KLVObjectPtr mxflib::Partition::NextElement()
 {
-	_BodyLocation = _NextBodyLocation;
-
-	// skip the present Object
-	_NextBodyLocation = Skip( _NextBodyLocation );
+	// skip the Object returned last time, and any trailing KLVFill
+	// DRAGONS: This is done now, rather than when that Object was returned, so that its value can be read by the caller
+	//          before the file is read beyond it - a stream can't be read back over a large value
+	if( _BodyLocation ) _NextBodyLocation = SkipFill( _BodyEnd );
 
-	// skip any trailing KLVFill
-	_NextBodyLocation = SkipFill( _NextBodyLocation );
+	_BodyLocation = _NextBodyLocation;
 
 	if(!Object->GetParentFile()) { error("Call to Partition::StartElements() on a non-file partition\n"); return NULL; }
 
@@ -847,6 +870,9 @@ KLVObjectPtr mxflib::Partition::NextElement()
 		
 		KLVObjectPtr pObj = PF->ReadKLV();
 
+		if( pObj ) _BodyEnd = _BodyLocation + pObj->GetKLSize() + pObj->GetLength();
+		else _BodyLocation = 0;
+
 		return pObj; 
 	}
 }
@@ -912,10 +938,11 @@ UInt64 mxflib::Partition::SkipFill( UInt64 start )
 	if(IsPartitionKey(NextUL->GetValue()))
 	{
 		UInt8 byte14 = (NextUL->GetValue())[13];
-		if( byte14 == 2 || byte14 == 3 || byte14 == 4 )	return 0;
+		// Leave the file pointer at the pack, so that it can be read next without reading back
+		if( byte14 == 2 || byte14 == 3 || byte14 == 4 )	{ PF->Seek( ret ); return 0; }
 		// we've found a Partition Pack - end of Body -- DRAGONS:?? Not true!!
 
-		if( byte14 == 0x11 )	return 0;
+		if( byte14 == 0x11 )	{ PF->Seek( ret ); return 0; }
 		// we've found a RIP - end of Body
 	}
 
@@ -64,6 +64,7 @@ namespace mxflib
 		//! Common construction
 		void Init(void)
 		{
+			DataStart = -1;
 			if(MXFVersion() == 2009) SetInt(MinorVersion_UL, 3);
 		}
 
@@ -153,6 +154,9 @@ namespace mxflib
 		//! Locate start of Index Table data in this partition
 		bool SeekIndex(void);
 
+		//! Locate the start of the header metadata, or of the index table data if there is no metadata, in this partition
+		Position LocateData(void);
+
 		//! Locate the set that refers to the given set (with a strong reference)
 		MDObjectParent FindLinkParent(MDObjectPtr &Child);
 
@@ -169,6 +173,7 @@ namespace mxflib
 		// goto start of body...set the member variables _BodyLocation, _NextBodyLocation
 		bool StartElements();
 		// goto _NextBodyLocation
+		// DRAGONS: When there are no more elements the file pointer is left at the following partition pack, if there is one
 		KLVObjectPtr NextElement();
 		// skip over a KLV packet
 
@@ -190,6 +195,8 @@ namespace mxflib
 	private:
 		UInt64 _BodyLocation;				// file position for current Element
 		UInt64 _NextBodyLocation;		// file position for Element after this
+		UInt64 _BodyEnd;					// file position of the end of the current Element
+		Position DataStart;					//!< Position of the metadata, or index if no metadata, after the pack and any filler, or -1 if not yet known
 	};
 }
 
@@ -110,12 +110,47 @@ Tag Primer::StaticLookup(ULPtr ItemUL, Tag TryTag /*=0*/)
 }
 
 
+//! Lock serialising access to permanent primers
+Mutex Primer::SharedLock;
+
+
 //! Determine the tag to use for a given UL
 /*! If the UL has not yet been used the correct static or dynamic tag will 
  *	be determined and added to the primer
  *	\return The tag to use, or 0 if no more dynamic tags available
  */
 Tag Primer::Lookup(ULPtr ItemUL, Tag TryTag /*=0*/)
+{
+	// DRAGONS: A permanent primer is shared between threads and may gain new dynamic tags, so lookups must be serialised
+	if(IsPermanent())
+	{
+		MutexLock Locked(SharedLock);
+		return LocalLookup(ItemUL, TryTag);
+	}
+
+	return LocalLookup(ItemUL, TryTag);
+}
+
+
+//! Locate the UL for a given tag
+/*! \return true if found, with Ret set to the UL */
+bool Primer::FindUL(Tag ThisTag, UL &Ret)
+{
+	bool Shared = IsPermanent();
+	if(Shared) SharedLock.Lock();
+
+	Primer::iterator it = find(ThisTag);
+	bool Found = (it != end());
+	if(Found) Ret = (*it).second;
+
+	if(Shared) SharedLock.Unlock();
+
+	return Found;
+}
+
+
+//! Determine the tag to use for a given UL, without locking
+Tag Primer::LocalLookup(ULPtr ItemUL, Tag TryTag)
 {
 	// If a tag has been suggested then try that
 	if(TryTag != 0)
@@ -59,6 +59,10 @@ namespace mxflib
 		Tag NextDynamic;						//! Next dynamic tag to try
 		std::map<UL, Tag> TagLookup;			//! Reverse lookup for locating a tag for a given UL
 
+		//! Lock serialising access to permanent primers
+		/*! A permanent primer, such as the static primer of a frozen dictionary, is shared between threads but may still gain dynamic tags */
+		static Mutex SharedLock;
+
 	public:
 		Primer() { NextDynamic = 0xffff; };
 		UInt32 ReadValue(const UInt8 *Buffer, UInt32 Size);
@@ -69,6 +73,10 @@ namespace mxflib
 		//! Determine the tag to use for a given UL
 		Tag Lookup(ULPtr ItemUL, Tag TryTag = 0);
 
+		//! Locate the UL for a given tag
+		/*! \return true if found, with Ret set to the UL */
+		bool FindUL(Tag ThisTag, UL &Ret);
+
 		//! Determine the tag to use for a given UL - when no primer is availabe
 		static Tag StaticLookup(ULPtr ItemUL, Tag TryTag = 0);
 
@@ -78,6 +86,10 @@ namespace mxflib
 			TagLookup.insert(std::map<UL, Tag>::value_type(Val.second, Val.first));
 			return Primer_Root::insert(Val);
 		}
+
+	protected:
+		//! Determine the tag to use for a given UL, without locking
+		Tag LocalLookup(ULPtr ItemUL, Tag TryTag);
 	};
 }
 
@@ -130,6 +130,10 @@ namespace mxflib
 															/*!< This means that when a smart pointer to this object is called, rather than setting the pointer
 															 *   to reference this object, the value is copied from this object into the existing referenced target */
 
+		bool Permanent;										//!< If set true, reference counts are no longer kept and this object is never deleted by smart pointers
+															/*!< This allows objects that are shared between threads and live until program exit, such as
+															 *   frozen dictionary entries, to be referenced without taking the mutex */
+
 #ifndef NO_SP_MUTEX
 #ifdef _WIN32
 		CRITICAL_SECTION mutex; 
@@ -142,6 +146,9 @@ namespace mxflib
 		//! Increment the number of references
 		virtual void __IncRefCount()
 		{
+			// DRAGONS: Permanent is only set before an object is shared, so it is safe to test without locking
+			if(Permanent) return;
+
 #ifndef NO_SP_MUTEX
 #ifdef _WIN32
 			EnterCriticalSection(& mutex);
@@ -164,6 +171,8 @@ namespace mxflib
 		//! Decrement the number of references, if none left delete the object
 		virtual void __DecRefCount()
 		{
+			if(Permanent) return;
+
 #ifndef NO_SP_MUTEX
 #ifdef _WIN32
 			EnterCriticalSection(& mutex);
@@ -313,6 +322,16 @@ namespace mxflib
 		virtual void SetTransient(bool Val = true) { Transient = Val; }			//!< Set the transient value flag
 		virtual bool IsTransient(void) { return Transient; }					//!< Is this a transient value?
 
+		//! Make this object permanent
+		/*! Once permanent, an object's reference count is no longer maintained so copying smart pointers to it costs no locking.
+		 *  \note The object will never be deleted, so this must only be used for objects that live until program exit
+		 *  \note This must be called before the object is shared between threads
+		 */
+		void SetPermanent(void) { Permanent = true; }
+
+		//! Is this a permanent object?
+		bool IsPermanent(void) const { return Permanent; }
+
 	protected:
 		//! Constructor for the RefCount class
 		RefCount()
@@ -338,6 +357,9 @@ namespace mxflib
 			// Not a transient object
 			Transient = false;
 
+			// Not a permanent object
+			Permanent = false;
+
 			PTRDEBUG( debug("%p Build new (zero) count\n", this); )
 		}
 
@@ -366,6 +388,9 @@ namespace mxflib
 			// TODO: Is there any case where we should copy the existing value?
 			Transient = false;
 
+			// Not a permanent object
+			Permanent = false;
+
 			PTRDEBUG( debug("%p Copy Construct new (zero) count\n", this); )
 		}
 
@@ -0,0 +1,117 @@
+/*! \file	stats.cpp
+ *	\brief	Counters of I/O, allocations and time spent in the library's hot paths
+ *
+ *	\version $Id$
+ *
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#include "mxflib/mxflib.h"
+
+using namespace mxflib;
+
+// Define the process-wide counters
+LibraryStats mxflib::GlobalStats;
+
+
+//! Set all counts to zero
+void LibraryStats::Clear(void)
+{
+	IO.Clear();
+	ChunkAllocs = 0;
+	ChunkAllocBytes = 0;
+	KLVsDispatched = 0;
+	IndexLookups = 0;
+
+	for(int i = 0; i < StageCount; i++)
+	{
+		StageCalls[i] = 0;
+		StageTime[i] = 0;
+	}
+}
+
+
+//! Get the name of a stage as used in reports
+std::string mxflib::StageName(StatsStage Stage)
+{
+	switch(Stage)
+	{
+	case StageParse: return "Parse";
+	case StageIndex: return "Index";
+	case StageWrite: return "Write";
+	default: return "Unknown";
+	}
+}
+
+
+//! Get a copy of the process-wide counters
+LibraryStats mxflib::GetLibraryStats(void)
+{
+	// DRAGONS: Counters may be updated by other threads while they are copied, so the copy is not a single snapshot
+	return GlobalStats;
+}
+
+
+//! Set all process-wide counters to zero
+void mxflib::ResetLibraryStats(void)
+{
+	GlobalStats.Clear();
+}
+
+
+//! Format a set of I/O counts as a single line of text
+std::string mxflib::StatsToString(const IOStats &Stats)
+{
+	return UInt64toString(Stats.Reads) + " reads (" + UInt64toString(Stats.ReadBytes) + " bytes), "
+		 + UInt64toString(Stats.Writes) + " writes (" + UInt64toString(Stats.WriteBytes) + " bytes), "
+		 + UInt64toString(Stats.Seeks) + " seeks";
+}
+
+
+//! Format the process-wide counters as lines of text, one per counter or stage
+std::string mxflib::StatsToString(const LibraryStats &Stats, std::string Prefix /*=""*/)
+{
+#ifdef MXFLIB_NO_STATS
+	return Prefix + "Statistics not available - library built with MXFLIB_NO_STATS\n";
+#else
+	std::string Ret;
+
+	Ret += Prefix + "File I/O:         " + StatsToString(Stats.IO) + "\n";
+	Ret += Prefix + "DataChunk allocs: " + UInt64toString(Stats.ChunkAllocs) + " (" + UInt64toString(Stats.ChunkAllocBytes) + " bytes)\n";
+	Ret += Prefix + "KLVs dispatched:  " + UInt64toString(Stats.KLVsDispatched) + "\n";
+	Ret += Prefix + "Index lookups:    " + UInt64toString(Stats.IndexLookups) + "\n";
+
+	for(int i = 0; i < StageCount; i++)
+	{
+		// Show milliseconds to 3 decimal places
+		char Buffer[32];
+		snprintf(Buffer, sizeof(Buffer), "%.3f", static_cast<double>(static_cast<Int64>(Stats.StageTime[i])) / 1000.0);
+
+		std::string Name = StageName(static_cast<StatsStage>(i)) + " time:";
+		Name.resize(18, ' ');
+
+		Ret += Prefix + Name + Buffer + " ms in " + UInt64toString(Stats.StageCalls[i]) + " calls\n";
+	}
+
+	return Ret;
+#endif // MXFLIB_NO_STATS
+}
@@ -0,0 +1,220 @@
+/*! \file	stats.h
+ *	\brief	Counters of I/O, allocations and time spent in the library's hot paths
+ *
+ *	\version $Id$
+ *
+ *  \detail
+ *  The library keeps a count of the reads, writes and seeks made on each MXFFile, and process-wide counts of these
+ *  along with DataChunk allocations, KLVs dispatched by GCReaders, index table lookups and the time spent parsing
+ *  essence, building index tables and writing in the BodyWriter and GCWriter.
+ *
+ *  Counting may be removed entirely by defining MXFLIB_NO_STATS on the compiler command-line, in which case the
+ *  functions below remain available but all counts stay at zero.
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#ifndef MXFLIB__STATS_H
+#define MXFLIB__STATS_H
+
+#include <string>
+
+
+namespace mxflib
+{
+	//! Counts of the I/O calls made on a file, or on all files
+	/*! Only calls that reach the operating system are counted, so memory files are not included */
+	struct IOStats
+	{
+		UInt64 Reads;						//!< Number of read calls, with each request of a batched read counted separately
+		UInt64 ReadBytes;					//!< Number of bytes read
+		UInt64 Writes;						//!< Number of write calls, including queued asynchronous writes
+		UInt64 WriteBytes;					//!< Number of bytes written
+		UInt64 Seeks;						//!< Number of seeks
+
+		IOStats() { Clear(); }
+
+		//! Set all counts to zero
+		void Clear(void) { Reads = 0; ReadBytes = 0; Writes = 0; WriteBytes = 0; Seeks = 0; }
+
+		//! Add the counts from another set
+		IOStats &operator+=(const IOStats &Other)
+		{
+			Reads += Other.Reads;
+			ReadBytes += Other.ReadBytes;
+			Writes += Other.Writes;
+			WriteBytes += Other.WriteBytes;
+			Seeks += Other.Seeks;
+			return *this;
+		}
+	};
+
+	//! Stages of processing that are timed
+	enum StatsStage
+	{
+		StageParse = 0,						//!< Reading and parsing essence from an EssenceSource for writing
+		StageIndex,							//!< Building and formatting index tables
+		StageWrite,							//!< Writing partitions, metadata and essence (not including time parsing the essence)
+		StageCount							//!< Number of stages, not a stage itself
+	};
+
+	//! Process-wide counters for the library
+	struct LibraryStats
+	{
+		IOStats IO;							//!< Counts for all files
+		UInt64 ChunkAllocs;					//!< Number of DataChunk buffers allocated, including those for DataChunkPools
+		UInt64 ChunkAllocBytes;				//!< Total size of DataChunk buffers allocated
+		UInt64 KLVsDispatched;				//!< Number of KLVs passed to handlers by all GCReaders
+		UInt64 IndexLookups;				//!< Number of index table lookups, including any second lookup to undo reordering
+		UInt64 StageCalls[StageCount];		//!< Number of times each stage has been entered
+		UInt64 StageTime[StageCount];		//!< Total time spent in each stage, in microseconds
+
+		LibraryStats() { Clear(); }
+
+		//! Set all counts to zero
+		void Clear(void);
+	};
+
+	//! The process-wide counters
+	/*! \note Use GetLibraryStats() to take a copy of the counters rather than reading these directly */
+	extern LibraryStats GlobalStats;
+
+	//! Get the name of a stage as used in reports
+	std::string StageName(StatsStage Stage);
+
+	//! Get a copy of the process-wide counters
+	LibraryStats GetLibraryStats(void);
+
+	//! Set all process-wide counters to zero
+	/*! \note This should only be called when no other thread is using the library, or the counts will be inaccurate */
+	void ResetLibraryStats(void);
+
+	//! Format a set of I/O counts as a single line of text
+	std::string StatsToString(const IOStats &Stats);
+
+	//! Format the process-wide counters as lines of text, one per counter or stage
+	/*! \param Stats The counters to format, normally from GetLibraryStats()
+	 *  \param Prefix Text added to the start of each line
+	 */
+	std::string StatsToString(const LibraryStats &Stats, std::string Prefix = "");
+
+#ifndef MXFLIB_NO_STATS
+
+	//! Add a value to a counter, safe to use on counters shared between threads
+	inline void StatsAdd(UInt64 &Counter, UInt64 Value)
+	{
+#if defined(_WIN32)
+		InterlockedExchangeAdd64(reinterpret_cast<volatile LONGLONG *>(&Counter), static_cast<LONGLONG>(Value));
+#elif defined(__GNUC__)
+		__sync_fetch_and_add(&Counter, Value);
+#else
+		// DRAGONS: Without an atomic add the counts may be a little low when several threads use the library at once
+		Counter += Value;
+#endif
+	}
+
+	//! Count a read call of a file, with the number of bytes read or -1 on error
+	inline void StatsCountRead(IOStats &File, size_t Bytes)
+	{
+		StatsAdd(File.Reads, 1);
+		StatsAdd(GlobalStats.IO.Reads, 1);
+		if(Bytes != static_cast<size_t>(-1))
+		{
+			StatsAdd(File.ReadBytes, Bytes);
+			StatsAdd(GlobalStats.IO.ReadBytes, Bytes);
+		}
+	}
+
+	//! Count a write call of a file, with the number of bytes written or -1 on error
+	inline void StatsCountWrite(IOStats &File, size_t Bytes)
+	{
+		StatsAdd(File.Writes, 1);
+		StatsAdd(GlobalStats.IO.Writes, 1);
+		if(Bytes != static_cast<size_t>(-1))
+		{
+			StatsAdd(File.WriteBytes, Bytes);
+			StatsAdd(GlobalStats.IO.WriteBytes, Bytes);
+		}
+	}
+
+	//! Count a seek of a file
+	inline void StatsCountSeek(IOStats &File)
+	{
+		StatsAdd(File.Seeks, 1);
+		StatsAdd(GlobalStats.IO.Seeks, 1);
+	}
+
+	//! Count the allocation of a DataChunk buffer
+	inline void StatsCountAlloc(size_t Bytes)
+	{
+		StatsAdd(GlobalStats.ChunkAllocs, 1);
+		StatsAdd(GlobalStats.ChunkAllocBytes, Bytes);
+	}
+
+	//! Time spent in a stage from construction to destruction
+	/*! A timer may be given a parent timer, running for an enclosing stage, from which its time is removed so that
+	 *  the same time is not counted in both stages.
+	 */
+	class StageTimer
+	{
+	protected:
+		StatsStage Stage;					//!< The stage being timed
+		StageTimer *Parent;					//!< Timer for the enclosing stage, or NULL
+		UInt64 Start;						//!< Time at construction, in microseconds
+		UInt64 Excluded;					//!< Time taken by child timers, in microseconds
+
+	private:
+		//! Prevent copy construction
+		StageTimer(const StageTimer &);
+
+	public:
+		//! Start timing a stage
+		StageTimer(StatsStage Stage, StageTimer *Parent = NULL) : Stage(Stage), Parent(Parent), Excluded(0) { Start = GetMicroseconds(); }
+
+		//! Stop timing and add the time to the process-wide counters
+		~StageTimer()
+		{
+			UInt64 Elapsed = GetMicroseconds() - Start;
+			if(Parent) Parent->Excluded += Elapsed;
+
+			StatsAdd(GlobalStats.StageCalls[Stage], 1);
+			if(Elapsed > Excluded) StatsAdd(GlobalStats.StageTime[Stage], Elapsed - Excluded);
+		}
+	};
+
+#else // MXFLIB_NO_STATS
+
+	inline void StatsAdd(UInt64 &, UInt64) {}
+	inline void StatsCountRead(IOStats &, size_t) {}
+	inline void StatsCountWrite(IOStats &, size_t) {}
+	inline void StatsCountSeek(IOStats &) {}
+	inline void StatsCountAlloc(size_t) {}
+
+	class StageTimer
+	{
+	public:
+		StageTimer(StatsStage, StageTimer * = NULL) {}
+	};
+
+#endif // MXFLIB_NO_STATS
+}
+
+#endif // MXFLIB__STATS_H
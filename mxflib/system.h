@@ -261,10 +261,29 @@ namespace mxflib
 		int Ret = _write(file, source, (unsigned int)size); 
 		return (Ret < 0) ? static_cast<size_t>(-1) : Ret; 
 	}
+	//! Read from a given offset without using the shared file position, so that many threads may read from one handle
+	inline size_t FileReadAt(FileHandle file, UInt64 offset, unsigned char *dest, size_t size)
+	{
+		OVERLAPPED Overlapped;
+		ZeroMemory(&Overlapped, sizeof(Overlapped));
+		Overlapped.Offset = static_cast<DWORD>(offset);
+		Overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+		DWORD Bytes;
+		if(!ReadFile(reinterpret_cast<HANDLE>(_get_osfhandle(file)), dest, (DWORD)size, &Bytes, &Overlapped))
+		{
+			// Reading at or beyond the end of the file is not an error
+			return (GetLastError() == ERROR_HANDLE_EOF) ? 0 : static_cast<size_t>(-1);
+		}
+		return Bytes;
+	}
+	// DRAGONS: The handle is already a C runtime descriptor, which is what is wanted by the asynchronous I/O code (even though it has no asynchronous support on Windows)
+	inline int FileDescriptor(FileHandle file) { return file; }
 	inline int FileGetc(FileHandle file) { UInt8 c; return (FileRead(file, &c, 1) == 1) ? (int)c : EOF; }
 	inline FileHandle FileOpen(const char *filename) { return _open(filename, _O_BINARY | _O_RDWR ); }
 	inline FileHandle FileOpenRead(const char *filename) { return _open(filename, _O_BINARY | _O_RDONLY ); }
 	inline FileHandle FileOpenNew(const char *filename) { return _open(filename, _O_BINARY | _O_RDWR | _O_CREAT | _O_TRUNC, _S_IREAD | _S_IWRITE); }
+	inline FileHandle FileStdIn(void) { _setmode(0, _O_BINARY); return 0; }
 	inline bool FileValid(FileHandle file) { return (file >= 0); }
 	inline bool FileEof(FileHandle file) { return _eof(file) ? true : false; }
 	inline UInt64 FileTell(FileHandle file) { return _telli64(file); }
@@ -276,6 +295,16 @@ namespace mxflib
 	inline int FileDelete(const char *filename) { return _unlink(filename); }
 	inline Int64 FileSize(FileHandle file) { struct _stat64 buf; return _fstat64(file, &buf) != 0 ? -1 : buf.st_size; } 
 
+	// DRAGONS: Windows only takes access hints when a file is opened, so these are ignored
+	inline void FileAdviseNormal(FileHandle file) {}
+	inline void FileAdviseRandom(FileHandle file) {}
+	inline void FileAdviseSequential(FileHandle file) {}
+	inline void FileWillNeed(FileHandle file, UInt64 offset, UInt64 size) {}
+	inline void FileDontNeed(FileHandle file, UInt64 offset, UInt64 size) {}
+
+	// DRAGONS: Space is not reserved on Windows, as the only way to do so without changing the file size is not portable to older versions
+	inline bool FileAllocate(FileHandle file, UInt64 offset, UInt64 size) { return false; }
+
 	// List all files that match the given spec (returned list is filenames excluding path)
 	inline StringList FileList(std::string FileSpec)
 	{
@@ -309,6 +338,14 @@ namespace mxflib
 		return Ret;
 	}
 
+	//! Get a monotonic time in microseconds, for measuring intervals rather than the time of day
+	inline UInt64 GetMicroseconds(void)
+	{
+		LARGE_INTEGER Freq, Count;
+		if(!QueryPerformanceFrequency(&Freq) || !QueryPerformanceCounter(&Count)) return 0;
+		return static_cast<UInt64>((Count.QuadPart / Freq.QuadPart) * 1000000 + ((Count.QuadPart % Freq.QuadPart) * 1000000) / Freq.QuadPart);
+	}
+
 	/******** UUID Generation ********/
 	inline void MakeUUID(UInt8 *Buffer)
 	{
@@ -463,6 +500,8 @@ namespace mxflib
 #include <sys/stat.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
 
 #ifdef HAVE_STDINT_H
 #include <stdint.h>
@@ -566,6 +605,25 @@ namespace mxflib
 
 	/******** 64-bit file-I/O ********/
 #ifndef MXFLIB_NO_FILE_IO
+	//! Read from a given offset of a file descriptor without using the shared file position
+	/*! Short reads are retried so that the only short return is at the end of the file */
+	inline size_t FileDescriptorReadAt(int fd, UInt64 offset, unsigned char *dest, size_t size)
+	{
+		size_t Total = 0;
+		while(Total < size)
+		{
+			ssize_t Bytes = pread(fd, dest + Total, size - Total, static_cast<off_t>(offset + Total));
+			if(Bytes < 0)
+			{
+				if(errno == EINTR) continue;
+				return static_cast<size_t>(-1);
+			}
+			if(Bytes == 0) break;
+			Total += static_cast<size_t>(Bytes);
+		}
+		return Total;
+	}
+
 #ifdef MXFLIB_LOWLEVEL_FILEIO
 	typedef int FileHandle;
 	const FileHandle FileInvalid = -1;
@@ -573,10 +631,13 @@ namespace mxflib
 	inline int FileSeekEnd(FileHandle file) { return lseek64(file, 0, SEEK_END); }
 	inline size_t FileRead(FileHandle file, unsigned char *dest, size_t size) { return read(dest, 1, size, file); }
 	inline size_t FileWrite(FileHandle file, const unsigned char *source, size_t size) { return write(source, 1, size, file); }
+	inline size_t FileReadAt(FileHandle file, UInt64 offset, unsigned char *dest, size_t size) { return FileDescriptorReadAt(file, offset, dest, size); }
+	inline int FileDescriptor(FileHandle file) { return file; }
 	inline int FileGetc(FileHandle file) { UInt8 c; return (FileRead(file, &c, 1) == 1) ? (int)c : EOF; }
 	inline FileHandle FileOpen(const char *filename) { return open(filename, _O_BINARY | _O_RDWR  ); }
 	inline FileHandle FileOpenRead(const char *filename) { return fopen(filename, _O_BINARY | _O_RDONLY ); }
 	inline FileHandle FileOpenNew(const char *filename) { return fopen(filename, _O_BINARY | _O_RDWR | _O_CREAT | _O_TRUNC, _S_IREAD | _S_IWRITE); }
+	inline FileHandle FileStdIn(void) { return 0; }
 	inline bool FileValid(FileHandle file) { return (file >= 0); }
 	inline bool FileEof(FileHandle file) { return eof(file); }
 	inline UInt64 FileTell(FileHandle file) { return ftello(file); }
@@ -591,10 +652,14 @@ namespace mxflib
 	inline int FileSeekEnd(FileHandle file) { return fseeko(file, 0, SEEK_END); }
 	inline size_t FileRead(FileHandle file, unsigned char *dest, size_t size) { return fread(dest, 1, size, file); }
 	inline size_t FileWrite(FileHandle file, const unsigned char *source, size_t size) { return fwrite(source, 1, size, file); }
+	// DRAGONS: This reads the underlying descriptor so it bypasses the stdio buffer - data written but not yet flushed will not be seen
+	inline size_t FileReadAt(FileHandle file, UInt64 offset, unsigned char *dest, size_t size) { return FileDescriptorReadAt(fileno(file), offset, dest, size); }
+	inline int FileDescriptor(FileHandle file) { return fileno(file); }
 	inline int FileGetc(FileHandle file) { UInt8 c; return (FileRead(file, &c, 1) == 1) ? (int)c : EOF; }
 	inline FileHandle FileOpen(const char *filename) { return fopen(filename, "r+b" ); }
 	inline FileHandle FileOpenRead(const char *filename) { return fopen(filename, "rb" ); }
 	inline FileHandle FileOpenNew(const char *filename) { return fopen(filename, "w+b"); }
+	inline FileHandle FileStdIn(void) { return stdin; }
 	inline bool FileValid(FileHandle file) { return (file != NULL); }
 	inline bool FileEof(FileHandle file) { return feof(file); }
 	inline UInt64 FileTell(FileHandle file) { return ftello(file); }
@@ -604,6 +669,42 @@ namespace mxflib
 	inline Int64 FileSize(FileHandle file) { struct stat buf; return fstat(fileno(file), &buf) != 0 ? -1 : buf.st_size; } 
 #endif // MXFLIB_LOWLEVEL_FILEIO
 
+	//! Give the system a hint about how a range of a file will be accessed (a size of zero means to the end of the file)
+	/*! This is only a hint, so failure is ignored, as are all hints where posix_fadvise() is not available */
+	inline void FileDescriptorAdvise(int fd, UInt64 offset, UInt64 size, int advice)
+	{
+#ifdef POSIX_FADV_NORMAL
+		posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(size), advice);
+#endif // POSIX_FADV_NORMAL
+	}
+
+#ifdef POSIX_FADV_NORMAL
+	inline void FileAdviseNormal(FileHandle file) { FileDescriptorAdvise(FileDescriptor(file), 0, 0, POSIX_FADV_NORMAL); }
+	inline void FileAdviseRandom(FileHandle file) { FileDescriptorAdvise(FileDescriptor(file), 0, 0, POSIX_FADV_RANDOM); }
+	inline void FileAdviseSequential(FileHandle file) { FileDescriptorAdvise(FileDescriptor(file), 0, 0, POSIX_FADV_SEQUENTIAL); }
+	inline void FileWillNeed(FileHandle file, UInt64 offset, UInt64 size) { FileDescriptorAdvise(FileDescriptor(file), offset, size, POSIX_FADV_WILLNEED); }
+	inline void FileDontNeed(FileHandle file, UInt64 offset, UInt64 size) { FileDescriptorAdvise(FileDescriptor(file), offset, size, POSIX_FADV_DONTNEED); }
+#else // POSIX_FADV_NORMAL
+	inline void FileAdviseNormal(FileHandle file) {}
+	inline void FileAdviseRandom(FileHandle file) {}
+	inline void FileAdviseSequential(FileHandle file) {}
+	inline void FileWillNeed(FileHandle file, UInt64 offset, UInt64 size) {}
+	inline void FileDontNeed(FileHandle file, UInt64 offset, UInt64 size) {}
+#endif // POSIX_FADV_NORMAL
+
+	//! Reserve disk space for a range of a file without changing its size, so that later writes need not allocate blocks
+	/*! \return false if the space could not be reserved, or this is not supported by the system or file system */
+	inline bool FileDescriptorAllocate(int fd, UInt64 offset, UInt64 size)
+	{
+#ifdef FALLOC_FL_KEEP_SIZE
+		return fallocate(fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset), static_cast<off_t>(size)) == 0;
+#else // FALLOC_FL_KEEP_SIZE
+		return false;
+#endif // FALLOC_FL_KEEP_SIZE
+	}
+
+	inline bool FileAllocate(FileHandle file, UInt64 offset, UInt64 size) { return FileDescriptorAllocate(FileDescriptor(file), offset, size); }
+
 	inline bool FileExists(const char *filename) { struct stat buf; return stat(filename, &buf) == 0; }
 	inline bool DirectoryExists(const char *filename) { struct stat buf; return (stat(filename, &buf) == 0) ? ((buf.st_mode & S_IFDIR) != 0) : false; }
 	inline int FileDelete(const char *filename) { return unlink(filename); }
@@ -643,6 +744,18 @@ namespace mxflib
 		return Ret;
 	}
 
+	//! Get a monotonic time in microseconds, for measuring intervals rather than the time of day
+	inline UInt64 GetMicroseconds(void)
+	{
+#ifdef CLOCK_MONOTONIC
+		struct timespec ts;
+		if(clock_gettime(CLOCK_MONOTONIC, &ts) == 0) return static_cast<UInt64>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#endif
+		struct timeval	tv;
+		gettimeofday(&tv, NULL);
+		return static_cast<UInt64>(tv.tv_sec) * 1000000 + tv.tv_usec;
+	}
+
 	/******** UUID Generation ********/
 #ifdef HAVE_UUID_GENERATE
 #include <uuid/uuid.h>
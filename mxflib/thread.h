@@ -0,0 +1,283 @@
+/*! \file	thread.h
+ *	\brief	Minimal portable threading primitives used inside the library
+ *
+ *	\version $Id$
+ *
+ *  \detail
+ *  These classes wrap just enough of the native threading API (pthreads or Win32) to allow background
+ *  workers, such as file prefetchers, to be written once for all platforms. They are deliberately simple
+ *  and are not intended as a general purpose threading library.
+ */
+/*
+ *  This software is provided 'as-is', without any express or implied warranty.
+ *  In no event will the authors be held liable for any damages arising from
+ *  the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must
+ *      not claim that you wrote the original software. If you use this
+ *      software in a product, you must include an acknowledgment of the
+ *      authorship in the product documentation.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must
+ *      not be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+
+#ifndef MXFLIB__THREAD_H
+#define MXFLIB__THREAD_H
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace mxflib
+{
+	//! Simple non-recursive mutex
+	class Mutex
+	{
+	protected:
+#ifdef _WIN32
+		CRITICAL_SECTION mutex;
+#else
+		pthread_mutex_t mutex;
+#endif
+
+		friend class Condition;
+
+	private:
+		//! Prevent copy construction
+		Mutex(const Mutex &);
+
+		//! Prevent assignment
+		Mutex &operator=(const Mutex &);
+
+	public:
+		Mutex()
+		{
+#ifdef _WIN32
+			InitializeCriticalSection(&mutex);
+#else
+			pthread_mutex_init(&mutex, NULL);
+#endif
+		}
+
+		~Mutex()
+		{
+#ifdef _WIN32
+			DeleteCriticalSection(&mutex);
+#else
+			pthread_mutex_destroy(&mutex);
+#endif
+		}
+
+		//! Acquire the mutex, blocking until it is available
+		void Lock(void)
+		{
+#ifdef _WIN32
+			EnterCriticalSection(&mutex);
+#else
+			pthread_mutex_lock(&mutex);
+#endif
+		}
+
+		//! Release the mutex
+		void Unlock(void)
+		{
+#ifdef _WIN32
+			LeaveCriticalSection(&mutex);
+#else
+			pthread_mutex_unlock(&mutex);
+#endif
+		}
+	};
+
+
+	//! Hold a Mutex for the lifetime of this object
+	class MutexLock
+	{
+	protected:
+		Mutex &Locked;					//!< The mutex we are holding
+
+	private:
+		//! Prevent copy construction
+		MutexLock(const MutexLock &);
+
+		//! Prevent assignment
+		MutexLock &operator=(const MutexLock &);
+
+	public:
+		MutexLock(Mutex &ToLock) : Locked(ToLock) { Locked.Lock(); }
+		~MutexLock() { Locked.Unlock(); }
+	};
+
+
+	//! Condition variable for use with a Mutex
+	class Condition
+	{
+	protected:
+#ifdef _WIN32
+		CONDITION_VARIABLE cond;
+#else
+		pthread_cond_t cond;
+#endif
+
+	private:
+		//! Prevent copy construction
+		Condition(const Condition &);
+
+		//! Prevent assignment
+		Condition &operator=(const Condition &);
+
+	public:
+		Condition()
+		{
+#ifdef _WIN32
+			InitializeConditionVariable(&cond);
+#else
+			pthread_cond_init(&cond, NULL);
+#endif
+		}
+
+		~Condition()
+		{
+#ifndef _WIN32
+			pthread_cond_destroy(&cond);
+#endif
+		}
+
+		//! Wait for this condition to be signalled
+		/*! The mutex must be held by the caller, it is released while waiting and re-acquired before returning.
+		 *  \note As with all condition variables spurious wake-ups are possible so the caller must re-test its predicate
+		 */
+		void Wait(Mutex &Locked)
+		{
+#ifdef _WIN32
+			SleepConditionVariableCS(&cond, &Locked.mutex, INFINITE);
+#else
+			pthread_cond_wait(&cond, &Locked.mutex);
+#endif
+		}
+
+		//! Wake one waiting thread
+		void Signal(void)
+		{
+#ifdef _WIN32
+			WakeConditionVariable(&cond);
+#else
+			pthread_cond_signal(&cond);
+#endif
+		}
+
+		//! Wake all waiting threads
+		void Broadcast(void)
+		{
+#ifdef _WIN32
+			WakeAllConditionVariable(&cond);
+#else
+			pthread_cond_broadcast(&cond);
+#endif
+		}
+	};
+
+
+	//! Full memory barrier: no load or store is moved across this call by the compiler or the processor
+	/*! Used to publish data between threads without a mutex, such as in a single-producer, single-consumer queue */
+	inline void MemoryFence(void)
+	{
+#if defined(_WIN32)
+		MemoryBarrier();
+#elif defined(__GNUC__)
+		__sync_synchronize();
+#else
+#error "No memory barrier available for this compiler"
+#endif
+	}
+
+
+	//! Base class for a worker thread
+	/*! Derived classes supply Run(), which is executed on a new thread once Start() is called.
+	 *  DRAGONS: The owner must call Join() before destroying the object, the destructor will not do it
+	 *           because by then the derived part of the object (used by Run()) has already been destroyed
+	 */
+	class Thread
+	{
+	protected:
+		bool Running;					//!< True once started and until joined
+#ifdef _WIN32
+		HANDLE Handle;					//!< The native thread handle
+#else
+		pthread_t Handle;				//!< The native thread handle
+#endif
+
+	private:
+		//! Prevent copy construction
+		Thread(const Thread &);
+
+		//! Prevent assignment
+		Thread &operator=(const Thread &);
+
+	public:
+		Thread() : Running(false) {}
+		virtual ~Thread() {}
+
+		//! Start running Run() on a new thread
+		/*! \return true if the thread was started */
+		bool Start(void)
+		{
+			if(Running) return false;
+
+#ifdef _WIN32
+			Handle = CreateThread(NULL, 0, &Thread::Entry, this, 0, NULL);
+			Running = (Handle != NULL);
+#else
+			Running = (pthread_create(&Handle, NULL, &Thread::Entry, this) == 0);
+#endif
+			return Running;
+		}
+
+		//! Wait for the thread to finish
+		void Join(void)
+		{
+			if(!Running) return;
+
+#ifdef _WIN32
+			WaitForSingleObject(Handle, INFINITE);
+			CloseHandle(Handle);
+#else
+			pthread_join(Handle, NULL);
+#endif
+			Running = false;
+		}
+
+		//! Has this thread been started and not yet joined?
+		bool IsRunning(void) const { return Running; }
+
+	protected:
+		//! The body of the thread, supplied by the derived class
+		virtual void Run(void) = 0;
+
+	private:
+		//! Native entry point that calls Run()
+#ifdef _WIN32
+		static DWORD WINAPI Entry(LPVOID This)
+		{
+			static_cast<Thread*>(This)->Run();
+			return 0;
+		}
+#else
+		static void *Entry(void *This)
+		{
+			static_cast<Thread*>(This)->Run();
+			return NULL;
+		}
+#endif
+	};
+}
+
+#endif // MXFLIB__THREAD_H
@@ -101,6 +101,9 @@ static bool SplitStereo = false;	// -s
 static bool SplitParts = false;		// -p
 static bool FullIndex = false;		// -f dump full index
 static bool DumpExtraneous = false;		// -x dump extraneous body elements
+static bool BatchReads = false;			// -b read essence values in batches
+static bool Follow = false;				// -l follow a file that is still being written
+static int FollowTimeout = -1;			// -l=<secs> stop following after this many seconds without growth, or -1 for none
 
 
 //values for partial restore
@@ -139,12 +142,15 @@ int GeneralNumber = 0;					//!< The video file number, used for tokens #g and #G
 
 
 // forward references
+bool OpenInput(MXFFilePtr &File, const char *Filename);
+PartitionPtr ReadNextPartition( MXFFilePtr &File, PartitionPtr &ThisPartition );
 PartitionPtr FindLatestClosedPartitionHeaderMetadata( MXFFile* File );
 static void DumpObject(MDObjectPtr Object, std::string Prefix);
 static void DumpHeader(PartitionPtr ThisPartition);
 static void DumpIndex(PartitionPtr ThisPartition);
 
 static void DumpBody(PartitionPtr ThisPartition, ContainerInfoPtr &EssenceLookup, StreamFileManager &StreamManager);
+static bool CopyElementBatched(MXFFilePtr File, KLVObjectPtr Element, EssenceSinkPtr Sink);
 
 //! Build a filename from a pattern
 std::string BuildFilename(std::string Pattern, UInt32 BodySID, UInt32 TrackNumber, std::string Extension);
@@ -228,7 +234,8 @@ int main_process(int argc, char *argv[])
 	OPdir[0]='\0';
 	for(int i=1; i<argc; i++)
 	{
-		if(argv[i][0] == '-')
+		// A lone '-' is the filename for standard input, not an option
+		if((argv[i][0] == '-') && (argv[i][1] != '\0'))
 		{
 			num_options++;
 			char *p = &argv[i][1];					// The option less the '-' or '/'
@@ -371,17 +378,27 @@ int main_process(int argc, char *argv[])
 				PauseBeforeExit = true;
 			}
 			else if(Opt == 'x') DumpExtraneous = true;
+			else if(Opt == 'b') BatchReads = true;
+			else if(Opt == 'l')
+			{
+				Follow = true;
+				if((p[1] == '=') || (p[1] == ':')) FollowTimeout = atoi(&p[2]);
+			}
 		}
 	}
 
 	if((argc-num_options) < 2)
 	{
 		fprintf( stderr,"\nUsage:  mxfsplit [options] <filename> \n" );
+		fprintf( stderr,"                       (use '-' as the filename to read from standard input)\n");
 		fprintf( stderr,"                      [-pX] Enable Processor-based splitting and choose kind of Sink (d,e,r)\n");
 		fprintf( stderr,"                       [-q] Quiet (default is Terse) \n" );
 		fprintf( stderr,"                       [-v] Verbose (Debug) \n" );
 		fprintf( stderr,"                       [-a] Dump all header metadata (and start of index)\n" );
 		fprintf( stderr,"                       [-f] Dump Full Index \n" );
+		fprintf( stderr,"                       [-b] Read essence in batches (asynchronously if built with IO_URING=1)\n" );
+		fprintf( stderr,"              [-l[=<secs>]] Follow a file that is still being written, until its footer is read\n");
+		fprintf( stderr,"                            (or until it has not grown for <secs> seconds)\n");
 		fprintf( stderr,"              [-d=template] Divide each edit unit into its own file\n");
 		fprintf( stderr,"                            (where template is the framefile name template)\n");
 		fprintf( stderr,"                            (templates are file paths that must include one '%%d' field)\n");
@@ -423,11 +440,65 @@ int main_process(int argc, char *argv[])
 	else
 	{
 		MXFFilePtr TestFile = new MXFFile;
-		if (! TestFile->Open(argv[num_options+1], true))
+		if (! OpenInput(TestFile, argv[num_options+1]))
 		{
 			perror(argv[num_options+1]);
 			return 1;
 		}
+
+		// A stream, such as a pipe, or a file still being written, is read once from start to end, taking each partition as it arrives
+		if(TestFile->IsStreaming() || TestFile->IsFollowing())
+		{
+			MXFFileLen = 0;
+			ContainerInfoPtr EssenceLookup = ContainerInfo::CreateAndBuild(TestFile);
+			if(!EssenceLookup || !EssenceLookup->HMeta)
+			{
+				error("Could not read header metadata from %s\n", TestFile->Name.c_str());
+				return 1;
+			}
+
+			// The header has been read for its metadata, and can't be read again
+			PartitionPtr ThisPartition = EssenceLookup->HMeta->Partition;
+			UInt32 iPart = 0;
+			while(ThisPartition)
+			{
+				iPart++;
+
+				if( !Quiet ) printf("\nPartition %4d at 0x%s for BodySID 0x%04x\n\n",
+									iPart,
+									Int64toHexString(ThisPartition->GetLocation(),8).c_str(),
+									ThisPartition->GetUInt(BodySID_UL) );
+
+				if(DumpAllHeader)
+				{
+					// Dump Partition Pack
+					if( !Quiet )
+					{
+						printf( "Partition Pack:\n" );
+						DumpObject(ThisPartition->Object,"");
+						printf("\n");
+					}
+
+					// Header Metadata
+					DumpHeader( ThisPartition );
+
+					// Index Segments
+					DumpIndex( ThisPartition );
+				}
+
+				// Body Elements
+				DumpBody( ThisPartition, EssenceLookup, StreamManager );
+
+				ThisPartition = ReadNextPartition( TestFile, ThisPartition );
+			}
+
+			TestFile->Close();
+			StreamManager.Close();
+
+			printf("DONE!\n");
+			return Ret;
+		}
+
 		TestFile->SeekEnd();
 		MXFFileLen=TestFile->Tell();
 		TestFile->Seek(0);
@@ -437,6 +508,9 @@ int main_process(int argc, char *argv[])
 		// If we don't already have one, get a RIP (however possible)
 		if(TestFile->FileRIP.empty()) TestFile->GetRIP();
 
+		// The rest of the file is read once from start to end, so don't let it push other data out of the page cache
+		TestFile->SetAccessMode(MXFFile::AccessStream);
+
 		// Iterate over Partitions
 		RIP::iterator it = TestFile->FileRIP.begin();
 		UInt32 iPart = 0;
@@ -488,6 +562,50 @@ int main_process(int argc, char *argv[])
 
 
 
+//! Open the input file, following it as it is written if requested, or standard input if the name is "-"
+bool OpenInput(MXFFilePtr &File, const char *Filename)
+{
+	if(strcmp(Filename, "-") != 0)
+	{
+		if(Follow) return File->OpenFollow(Filename, (FollowTimeout < 0) ? -1 : (FollowTimeout * 1000));
+		return File->Open(Filename, true);
+	}
+
+	if(!File->OpenFromHandle(FileStdIn())) return false;
+	File->Name = "standard input";
+
+	return true;
+}
+
+
+//! Read the partition pack that follows one that has been dumped, reading forwards only so that a stream can be split
+/*! \return NULL if there are no more partitions
+ */
+PartitionPtr ReadNextPartition( MXFFilePtr &File, PartitionPtr &ThisPartition )
+{
+	// The body of an essence partition has been walked by DumpBody(), leaving the file at the following partition pack,
+	// otherwise walk over the metadata and index (and anything else) to get there
+	if(ThisPartition->GetUInt( BodySID_UL ) == 0)
+	{
+		if(ThisPartition->StartElements()) while(ThisPartition->NextElement()) {};
+	}
+
+	Position Location = File->Tell();
+	ULPtr Key = File->ReadKey();
+
+	// Stop at the RIP or the end of the file
+	if(!Key || !IsPartitionKey(Key->GetValue())) return NULL;
+
+	File->Seek(Location);
+	PartitionPtr NextPartition = File->ReadPartition();
+
+	// Nothing in or after the footer is essence, and there may be no RIP to end it, so stop waiting for a file being followed to grow
+	if(NextPartition && File->IsFollowing() && (NextPartition->IsA(CompleteFooter_UL) || NextPartition->IsA(Footer_UL))) File->SetFollow(false);
+
+	return NextPartition;
+}
+
+
 // find the most last Partition that is marked Closed
 PartitionPtr FindLatestClosedPartitionHeaderMetadata( MXFFile* File )
 {
@@ -630,7 +748,8 @@ void DumpObject(MDObjectPtr Object, std::string Prefix)
 
 void DumpHeader( PartitionPtr ThisPartition )
 {
-	if(ThisPartition->ReadMetadata() == 0)
+	// The metadata may already have been read, such as from the header of a stream, which can't be read again
+	if(ThisPartition->AllMetadata.empty() && (ThisPartition->ReadMetadata() == 0))
 	{
 		if( !Quiet ) printf("No Header Metadata in this Partition\n\n");
 	}
@@ -954,25 +1073,34 @@ void DumpBody(PartitionPtr ThisPartition, ContainerInfoPtr &EssenceLookup, Strea
 				}
 
 				/* Copy the essence KLV to the output file in manageable chunks */
-	
-				// Limit chunk size to 32Mb
-				const Length MaxSize = 32 * 1024 * 1024;
 
-				Position Offset = 0;
-				for(;;)
+				// Batched reads need random access, so a stream is copied chunk by chunk as it arrives
+				MXFFilePtr ThisFile = ThisPartition->GetParentFile();
+				if(BatchReads && ThisFile && !ThisFile->IsStreaming())
 				{
-					// Work out the chunk-size
-					Length CurrentSize = anElement->GetLength() - (Length)Offset;
-					if(CurrentSize <= 0) break;
-					if(CurrentSize > MaxSize) CurrentSize = MaxSize;
-
-					size_t Bytes = anElement->ReadDataFrom(Offset, static_cast<size_t>(CurrentSize));
-					if(!Bytes) break;
-					Offset += Bytes;
-
-					//if(FileValid(ThisFile)) FileWrite(ThisFile, anElement->GetData().Data, anElement->GetData().Size);
-					// FIXME: Need to add end-of-element
-					if(ThisSink) ThisSink->PutEssenceData(anElement->GetData());
+					CopyElementBatched(ThisFile, anElement, ThisSink);
+				}
+				else
+				{
+					// Limit chunk size to 32Mb
+					const Length MaxSize = 32 * 1024 * 1024;
+
+					Position Offset = 0;
+					for(;;)
+					{
+						// Work out the chunk-size
+						Length CurrentSize = anElement->GetLength() - (Length)Offset;
+						if(CurrentSize <= 0) break;
+						if(CurrentSize > MaxSize) CurrentSize = MaxSize;
+
+						size_t Bytes = anElement->ReadDataFrom(Offset, static_cast<size_t>(CurrentSize));
+						if(!Bytes) break;
+						Offset += Bytes;
+
+						//if(FileValid(ThisFile)) FileWrite(ThisFile, anElement->GetData().Data, anElement->GetData().Size);
+						// FIXME: Need to add end-of-element
+						if(ThisSink) ThisSink->PutEssenceData(anElement->GetData());
+					}
 				}
 
 				// If we are dividing into multiple files then we are done with this one
@@ -997,6 +1125,63 @@ void DumpBody(PartitionPtr ThisPartition, ContainerInfoPtr &EssenceLookup, Strea
 
 
 
+//! Copy the value of an essence KLV to a sink, with the chunks of each batch read together
+/*! The value is read in 1Mb chunks, up to 32 at a time, with MXFFile::ReadBatch() - which queues them all at
+ *  once where asynchronous I/O is available and reads them one at a time otherwise. The chunks are passed to the
+ *  sink in file order so the output is the same as copying with KLVObject::ReadDataFrom()
+ *  \return false if the whole value could not be read
+ */
+static bool CopyElementBatched(MXFFilePtr File, KLVObjectPtr Element, EssenceSinkPtr Sink)
+{
+	const size_t ChunkSize = 1024 * 1024;
+	const int MaxBatch = 32;
+
+	Position ValueStart = Element->GetLocation() + Element->GetKLSize();
+	Length ValueLength = Element->GetLength();
+
+	DataChunk Buffer;
+	Position Offset = 0;
+	while(Offset < ValueLength)
+	{
+		Length BatchSize = ValueLength - Offset;
+		if(BatchSize > (Length)(ChunkSize * MaxBatch)) BatchSize = (Length)(ChunkSize * MaxBatch);
+
+		Buffer.ResizeBuffer(static_cast<size_t>(BatchSize), false);
+
+		AsyncReadRequestList Reads;
+		Length Queued = 0;
+		while(Queued < BatchSize)
+		{
+			size_t Size = ChunkSize;
+			if((BatchSize - Queued) < (Length)Size) Size = static_cast<size_t>(BatchSize - Queued);
+
+			Reads.push_back(AsyncReadRequest(ValueStart + Offset + Queued, &Buffer.Data[Queued], Size));
+			Queued += Size;
+		}
+
+		bool Complete = File->ReadBatch(Reads);
+
+		AsyncReadRequestList::iterator it;
+		for(it = Reads.begin(); it != Reads.end(); it++)
+		{
+			if(Sink && (*it).Bytes) Sink->PutEssenceData((*it).Buffer, (*it).Bytes);
+			if((*it).Bytes != (*it).Size) break;
+		}
+
+		if(!Complete)
+		{
+			error("Unable to read all of the essence value at 0x%s in %s\n", Int64toHexString(Element->GetLocation(), 8).c_str(), File->Name.c_str());
+			return false;
+		}
+
+		Offset += BatchSize;
+	}
+
+	return true;
+}
+
+
+
 //! Build a filename from a pattern
 /*! Pattern Tokens:
  *
@@ -250,6 +250,7 @@ int main_process(int argc, char *argv[])
 	for(i=0; i< InCount; i++)
 	{
 		FileParserPtr FParser = new FileParser(Opt.InFilename[i]);
+		if(Opt.PrefetchFiles > 0) FParser->SetPrefetch(Opt.PrefetchFiles);
 
 
 		// Wrapping config to use (Optionally listing the available options);
@@ -311,167 +312,174 @@ int main_process(int argc, char *argv[])
 		}
 
 		/* Audio Demultiplexing */
-		if(Opt.AudioLimit && WCP->EssenceDescriptor->IsA(WaveAudioDescriptor_UL) && (!WCP->EssenceDescriptor->IsA(AES3PCMDescriptor_UL)))
+		// DRAGONS: Note that we "demux" if the number of bits need to be changed, even if the number of channels is OK
+		//          audio that needs neither is wrapped as normal below
+		if(Opt.AudioLimit && WCP->EssenceDescriptor->IsA(WaveAudioDescriptor_UL) && (!WCP->EssenceDescriptor->IsA(AES3PCMDescriptor_UL))
+		   && ((WCP->EssenceDescriptor->GetUInt("ChannelCount") > Opt.AudioLimit) || (Opt.AudioBits != 0)))
 		{
 			unsigned int Count = WCP->EssenceDescriptor->GetUInt("ChannelCount");
 
-			// DRAGONS: Note that we "demux" if the number of bits need to be changed, even if the number of channels is OK
-			if((Count > Opt.AudioLimit) || (Opt.AudioBits != 0))
+			MDObjectPtr OriginalDescriptor = WCP->EssenceDescriptor;
+
+			// Inform the user of the demultiplexed wrapping
+			printf("\nAudio demultiplexing of file \"%s\" :\n", Opt.InFilename[i]);
+
+			if(WCP->WrapOpt->ThisWrapType == WrappingOption::Frame)
 			{
-				MDObjectPtr OriginalDescriptor = WCP->EssenceDescriptor;
+				// Frame-wrapping can use a single demux for all channels as the buffers will get freed after each frame
+				int DemuxIndex = OutNum;
+				AudioDemuxer[OutNum] = new AudioDemux(FParser->GetEssenceSource(WCP->Stream), Count, (unsigned int) WCP->EssenceDescriptor->GetInt("QuantizationBits"),0);
+				if(Opt.AudioBits != 0) AudioDemuxer[OutNum]->SetOutputBitSize(Opt.AudioBits);
+
+				unsigned int j;
+				for(j=0; j<Count; j += Opt.AudioLimit)
+				{
+					// Work out how many channels this source
+					unsigned int ChanCount = Opt.AudioLimit;
+					if((j + ChanCount) > Count) ChanCount = Count - j;
+
+					// Build some descriptive text to add to the format details
+					char Buffer[128];
+					if(Opt.AudioBits == 0)
+					{
+						if(ChanCount == 1)
+							sprintf(Buffer, " (Channel %u)", j + 1);
+						else
+							sprintf(Buffer, " (Channels %u to %u)", j + 1, j + ChanCount);
+					}
+					else
+					{
+						if(ChanCount == 1)
+							sprintf(Buffer, " (Channel %u, %u-bit)", j + 1, Opt.AudioBits);
+						else
+							sprintf(Buffer, " (Channels %u to %u, %u-bit)", j + 1, j + ChanCount, Opt.AudioBits);
+					}
+
+					// Add this wrapping option for each channel (with a single-channel copy of the essence descriptor)
+					EssenceParser::WrappingConfigPtr WrapCfg = new EssenceParser::WrappingConfig;
+
+					// Copy the contents (into a duplicate WrappingConfig, also making a duplicate WrappingOption)
+					*WrapCfg = *WCP;
+					WrapCfg->WrapOpt = new WrappingOption;
+					*(WrapCfg->WrapOpt) = *(WCP->WrapOpt);
+
+					WrapCfg->EssenceDescriptor = OriginalDescriptor->MakeCopy();
+					WrapCfg->EssenceDescriptor->SetInt(ChannelCount_UL, ChanCount);
+					
+					WrapCfg->EssenceDescriptor->SetInt(BlockAlign_UL, (OriginalDescriptor->GetInt(BlockAlign_UL) * ChanCount) / OriginalDescriptor->GetInt(ChannelCount_UL));
+					WrapCfg->EssenceDescriptor->SetUInt(AvgBps_UL, (OriginalDescriptor->GetUInt(AvgBps_UL) * ChanCount) / OriginalDescriptor->GetInt(ChannelCount_UL));
+					
+					// Install this new essence descriptor in the source
+					FParser->SetDescriptor(WrapCfg->EssenceDescriptor);
+	
+					// Update the descriptor with the new quantization bits
+					if(Opt.AudioBits) WrapCfg->EssenceDescriptor->SetInt("QuantizationBits", Opt.AudioBits);
+
+					WrapCfg->WrapOpt->Description += Buffer;
+					WrappingList.push_back(WrapCfg);
 
-				// Inform the user of the demultiplexed wrapping
-				printf("\nAudio demultiplexing of file \"%s\" :\n", Opt.InFilename[i]);
+					// Increase the apparent number of input files as it now looks like one file per demux-source
+					// DRAGONS: In OP-Atom each demux-source is written to its own file, so it needs its own file package
+					InFileSource[OutNum].first = iFilePackage;
+					InFileSource[OutNum].second = AudioDemuxer[DemuxIndex]->GetSource(j, ChanCount);
+					OutNum++;
+					Opt.InFileGangSize++;
+					if(Opt.OPAtom) iFilePackage++;
+		
+					printf("    %s\n", WrapCfg->WrapOpt->Description.c_str());
+				}
+			}
+			else
+			{
+				/* Clip-wrapping (and possibly other wrappings) will need one demux object per channel to prevent "live" buffers filling memory */
 
-				if(WCP->WrapOpt->ThisWrapType == WrappingOption::Frame)
+				unsigned int j;
+				for(j=0; j<Count; j += Opt.AudioLimit)
 				{
-					// Frame-wrapping can use a single demux for all channels as the buffers will get freed after each frame
-					int DemuxIndex = OutNum;
-					AudioDemuxer[OutNum] = new AudioDemux(FParser->GetEssenceSource(WCP->Stream), Count, (unsigned int) WCP->EssenceDescriptor->GetInt("QuantizationBits"),0);
-					if(Opt.AudioBits != 0) AudioDemuxer[OutNum]->SetOutputBitSize(Opt.AudioBits);
+					// Work out how many channels this source
+					unsigned int ChanCount = Opt.AudioLimit;
+					if((j + ChanCount) > Count) ChanCount = Count - j;
 
-					unsigned int j;
-					for(j=0; j<Count; j += Opt.AudioLimit)
+					// Build some descriptive text to add to the format details
+					char Buffer[128];
+					if(Opt.AudioBits == 0)
 					{
-						// Work out how many channels this source
-						unsigned int ChanCount = Opt.AudioLimit;
-						if((j + ChanCount) > Count) ChanCount = Count - j;
-
-						// Build some descriptive text to add to the format details
-						char Buffer[128];
-						if(Opt.AudioBits == 0)
-						{
-							if(ChanCount == 1)
-								sprintf(Buffer, " (Channel %u)", j + 1);
-							else
-								sprintf(Buffer, " (Channels %u to %u)", j + 1, j + ChanCount);
-						}
+						if(ChanCount == 1)
+							sprintf(Buffer, " (Channel %u)", j + 1);
 						else
-						{
-							if(ChanCount == 1)
-								sprintf(Buffer, " (Channel %u, %u-bit)", j + 1, Opt.AudioBits);
-							else
-								sprintf(Buffer, " (Channels %u to %u, %u-bit)", j + 1, j + ChanCount, Opt.AudioBits);
-						}
+							sprintf(Buffer, " (Channels %u to %u)", j + 1, j + ChanCount);
+					}
+					else
+					{
+						if(ChanCount == 1)
+							sprintf(Buffer, " (Channel %u, %u-bit)", j + 1, Opt.AudioBits);
+						else
+							sprintf(Buffer, " (Channels %u to %u, %u-bit)", j + 1, j + ChanCount, Opt.AudioBits);
+					}
 
+					FileParserPtr ThisFParser;
+					EssenceParser::WrappingConfigPtr WrapCfg;
+					if(j==0)
+					{
+						ThisFParser = FParser;
 						// Add this wrapping option for each channel (with a single-channel copy of the essence descriptor)
-						EssenceParser::WrappingConfigPtr WrapCfg = new EssenceParser::WrappingConfig;
-
+						WrapCfg = new EssenceParser::WrappingConfig;
+						
 						// Copy the contents (into a duplicate WrappingConfig, also making a duplicate WrappingOption)
 						*WrapCfg = *WCP;
 						WrapCfg->WrapOpt = new WrappingOption;
 						*(WrapCfg->WrapOpt) = *(WCP->WrapOpt);
 
 						WrapCfg->EssenceDescriptor = OriginalDescriptor->MakeCopy();
-						WrapCfg->EssenceDescriptor->SetInt(ChannelCount_UL, ChanCount);
-						
-						WrapCfg->EssenceDescriptor->SetInt(BlockAlign_UL, (OriginalDescriptor->GetInt(BlockAlign_UL) * ChanCount) / OriginalDescriptor->GetInt(ChannelCount_UL));
-						WrapCfg->EssenceDescriptor->SetUInt(AvgBps_UL, (OriginalDescriptor->GetUInt(AvgBps_UL) * ChanCount) / OriginalDescriptor->GetInt(ChannelCount_UL));
-						
+						WrapCfg->EssenceDescriptor->SetInt("ChannelCount", ChanCount);
+
 						// Install this new essence descriptor in the source
 						FParser->SetDescriptor(WrapCfg->EssenceDescriptor);
-		
-						// Update the descriptor with the new quantization bits
-						if(Opt.AudioBits) WrapCfg->EssenceDescriptor->SetInt("QuantizationBits", Opt.AudioBits);
-
-						WrapCfg->WrapOpt->Description += Buffer;
-						WrappingList.push_back(WrapCfg);
-
-						// Increase the apparent number of input files as it now looks like one file per demux-source
-						InFileSource[OutNum].first = iFilePackage;
-						InFileSource[OutNum].second = AudioDemuxer[DemuxIndex]->GetSource(j, ChanCount);
-						OutNum++;
-						Opt.InFileGangSize++;
-			
-						printf("    %s\n", WrapCfg->WrapOpt->Description.c_str());
 					}
-				}
-				else
-				{
-					/* Clip-wrapping (and possibly other wrappings) will need one demux object per channel to prevent "live" buffers filling memory */
-
-					unsigned int j;
-					for(j=0; j<Count; j += Opt.AudioLimit)
+					else
 					{
-						// Work out how many channels this source
-						unsigned int ChanCount = Opt.AudioLimit;
-						if((j + ChanCount) > Count) ChanCount = Count - j;
-
-						// Build some descriptive text to add to the format details
-						char Buffer[128];
-						if(Opt.AudioBits == 0)
-						{
-							if(ChanCount == 1)
-								sprintf(Buffer, " (Channel %u)", j + 1);
-							else
-								sprintf(Buffer, " (Channels %u to %u)", j + 1, j + ChanCount);
-						}
-						else
-						{
-							if(ChanCount == 1)
-								sprintf(Buffer, " (Channel %u, %u-bit)", j + 1, Opt.AudioBits);
-							else
-								sprintf(Buffer, " (Channels %u to %u, %u-bit)", j + 1, j + ChanCount, Opt.AudioBits);
-						}
-
-						FileParserPtr ThisFParser;
-						EssenceParser::WrappingConfigPtr WrapCfg;
-						if(j==0)
-						{
-							ThisFParser = FParser;
-							// Add this wrapping option for each channel (with a single-channel copy of the essence descriptor)
-							WrapCfg = new EssenceParser::WrappingConfig;
-							
-							// Copy the contents (into a duplicate WrappingConfig, also making a duplicate WrappingOption)
-							*WrapCfg = *WCP;
-							WrapCfg->WrapOpt = new WrappingOption;
-							*(WrapCfg->WrapOpt) = *(WCP->WrapOpt);
-
-							WrapCfg->EssenceDescriptor = OriginalDescriptor->MakeCopy();
-							WrapCfg->EssenceDescriptor->SetInt("ChannelCount", ChanCount);
-
-							// Install this new essence descriptor in the source
-							FParser->SetDescriptor(WrapCfg->EssenceDescriptor);
-						}
-						else
-						{
-							ThisFParser = new FileParser(Opt.InFilename[i]);
-							WrapCfg = ChooseWrapping(ThisFParser, Opt);
+						ThisFParser = new FileParser(Opt.InFilename[i]);
+						if(Opt.PrefetchFiles > 0) ThisFParser->SetPrefetch(Opt.PrefetchFiles);
+						WrapCfg = ChooseWrapping(ThisFParser, Opt);
 
-							// Set the wrapping options
-							ThisFParser->Use(WrapCfg->Stream, WrapCfg->WrapOpt);
+						// Set the wrapping options
+						ThisFParser->Use(WrapCfg->Stream, WrapCfg->WrapOpt);
 
-							// Ensure the essence descriptor reflects the new wrapping
-							// Will be overridden for Avid
-							WrapCfg->EssenceDescriptor->SetValue(EssenceContainer_UL, DataChunk(16,WrapCfg->WrapOpt->WrappingUL->GetValue()));
+						// Ensure the essence descriptor reflects the new wrapping
+						// Will be overridden for Avid
+						WrapCfg->EssenceDescriptor->SetValue(EssenceContainer_UL, DataChunk(16,WrapCfg->WrapOpt->WrappingUL->GetValue()));
 
-							WrapCfg->EssenceDescriptor->SetInt("ChannelCount", ChanCount);
+						WrapCfg->EssenceDescriptor->SetInt("ChannelCount", ChanCount);
 
-							// Install the essence descriptor in the new source
-							ThisFParser->SetDescriptor(WrapCfg->EssenceDescriptor);
-						}
+						// Install the essence descriptor in the new source
+						ThisFParser->SetDescriptor(WrapCfg->EssenceDescriptor);
+					}
 
-						// Make a demux object with a single output
-						AudioDemuxer[OutNum] = new AudioDemux(ThisFParser->GetEssenceSource(WrapCfg->Stream), Count, WrapCfg->EssenceDescriptor->GetInt("QuantizationBits"),0);
-						if(Opt.AudioBits != 0) AudioDemuxer[OutNum]->SetOutputBitSize(Opt.AudioBits);
+					// Make a demux object with a single output
+					AudioDemuxer[OutNum] = new AudioDemux(ThisFParser->GetEssenceSource(WrapCfg->Stream), Count, WrapCfg->EssenceDescriptor->GetInt("QuantizationBits"),0);
+					if(Opt.AudioBits != 0) AudioDemuxer[OutNum]->SetOutputBitSize(Opt.AudioBits);
 
-						// Increase the apparent number of input files as it now looks like one file per demux-source
-						InFileSource[OutNum].first = iFilePackage;
-						InFileSource[OutNum].second = AudioDemuxer[OutNum]->GetSource(j, ChanCount);
-						OutNum++;
-						Opt.InFileGangSize++;
+					// Increase the apparent number of input files as it now looks like one file per demux-source
+					// DRAGONS: In OP-Atom each demux-source is written to its own file, so it needs its own file package
+					InFileSource[OutNum].first = iFilePackage;
+					InFileSource[OutNum].second = AudioDemuxer[OutNum]->GetSource(j, ChanCount);
+					OutNum++;
+					Opt.InFileGangSize++;
+					if(Opt.OPAtom) iFilePackage++;
 
-						// Update the descriptor with the new quantization bits (after using the old value to build the demux!)
-						if(Opt.AudioBits) WrapCfg->EssenceDescriptor->SetInt("QuantizationBits", Opt.AudioBits);
+					// Update the descriptor with the new quantization bits (after using the old value to build the demux!)
+					if(Opt.AudioBits) WrapCfg->EssenceDescriptor->SetInt("QuantizationBits", Opt.AudioBits);
 
-						// Add this wrapping
-						WrapCfg->WrapOpt->Description += Buffer;
-						WrappingList.push_back(WrapCfg);
+					// Add this wrapping
+					WrapCfg->WrapOpt->Description += Buffer;
+					WrappingList.push_back(WrapCfg);
 
-						printf("    %s\n", WrapCfg->WrapOpt->Description.c_str());
-					}
+					printf("    %s\n", WrapCfg->WrapOpt->Description.c_str());
 				}
 			}
+
+			// Up the file package index for the next input file (unless already done for each OP-Atom demux-source, or frame grouping)
+			if(!Opt.OPAtom && !Opt.FrameGroup) iFilePackage++;
 		}
 		else
 		{
@@ -589,7 +597,56 @@ int main_process(int argc, char *argv[])
 	// FIXME: if we ever start building multiple nonOP-Atom files at one time, need to modify the UMID each time
 
 	int OutFileNum;
-	for(OutFileNum=0; OutFileNum < Opt.OutFileCount ; OutFileNum++)
+
+	// Write all files of an OP-Atom set at once if requested
+	if(Opt.OPAtom && Opt.OPAtomConcurrent && (Opt.OutFileCount > 1))
+	{
+		MXFFilePtr Out[ProcessOptions::MaxOutFiles];
+		Length Durations[ProcessOptions::MaxOutFiles];
+
+		for(OutFileNum=0; OutFileNum < Opt.OutFileCount ; OutFileNum++)
+		{
+			Out[OutFileNum] = new MXFFile;
+			if(!Out[OutFileNum]->OpenNew(Opt.OutFilename[OutFileNum]))
+			{
+				error("Can't open output file \"%s\"\n", Opt.OutFilename[OutFileNum]);
+				return 5;
+			}
+
+			if(Opt.DirectWrites && !Out[OutFileNum]->SetDirectWrites(true, Opt.DirectWrites))
+				warning("Unable to use direct I/O for output file \"%s\" - writing through the page cache\n", Opt.OutFilename[OutFileNum]);
+
+			if(Opt.AsyncWrites && !Out[OutFileNum]->SetAsyncWrites())
+				debug("Asynchronous writes not available for output file \"%s\"\n", Opt.OutFilename[OutFileNum]);
+		}
+
+		printf( "\nProcessing %d output files at once\n", Opt.OutFileCount);
+
+		// The dictionary will be shared by the threads writing each file
+		FreezeDictionary();
+
+		ProcessAtomSet(Opt.OutFileCount, Out, &Opt, WrappingList, InFileSource, EditRate, MPUMID, FPUMID, NULL, Durations);
+
+		for(OutFileNum=0; OutFileNum < Opt.OutFileCount ; OutFileNum++)
+		{
+			printf( "\nOutput file \"%s\"\n", Opt.OutFilename[OutFileNum]);
+			printf( "Duration = %s edit units\n", UInt64toString( Durations[OutFileNum] ).c_str() );
+
+			// output Duration to log file
+			if( Opt.Stats ) fprintf(stderr,"%s\n",UInt64toString( Durations[OutFileNum] ).c_str());
+
+			// Close the file - all done!
+			Out[OutFileNum]->Close();
+
+			if(Opt.ShowIOStats) printf("File I/O: %s\n", StatsToString(Out[OutFileNum]->GetIOStats()).c_str());
+		}
+
+		// Skip the one-at-a-time loop
+		OutFileNum = Opt.OutFileCount;
+	}
+	else OutFileNum = 0;
+
+	for(; OutFileNum < Opt.OutFileCount ; OutFileNum++)
 	{
 		// Open the output file
 		MXFFilePtr Out = new MXFFile;
@@ -599,6 +656,12 @@ int main_process(int argc, char *argv[])
 			return 5;
 		}
 
+		if(Opt.DirectWrites && !Out->SetDirectWrites(true, Opt.DirectWrites))
+			warning("Unable to use direct I/O for output file \"%s\" - writing through the page cache\n", Opt.OutFilename[OutFileNum]);
+
+		if(Opt.AsyncWrites && !Out->SetAsyncWrites())
+			debug("Asynchronous writes not available for output file \"%s\"\n", Opt.OutFilename[OutFileNum]);
+
 		printf( "\nProcessing output file \"%s\"\n", Opt.OutFilename[OutFileNum]);
 
 		if(InitialFile.size()) printf("    Essence File: %s\n", InitialFile.c_str());
@@ -624,6 +687,13 @@ int main_process(int argc, char *argv[])
 		// Close the file - all done!
 		Out->Close();
 
+		if(Opt.ShowIOStats) printf("File I/O: %s\n", StatsToString(Out->GetIOStats()).c_str());
+	}
+
+	if(Opt.ShowIOStats)
+	{
+		printf("\nStatistics:\n");
+		printf("%s", StatsToString(GetLibraryStats(), "  ").c_str());
 	}
 
 
@@ -79,7 +79,8 @@ void HelpText()
 		printf("    -1         = Use a version 1 KLVFill item key\n");
 
 
-		printf("    -a[2]      = Force OP-Atom (optionally with only 2 partitions if VBR)\n");
+		printf("    -a[2][c]   = Force OP-Atom (optionally with only 2 partitions if VBR)\n");
+		printf("                 (c = write all atom files at once, each on its own thread)\n");
 
 
 		printf("    -c=<file>  = Read commandline from file (incomplete - MUCH TODO)\n");
@@ -133,6 +134,16 @@ void HelpText()
 		printf("    -pd=<dur>  = Body partition every <dur> frames\n");
 		printf("    -ps=<size> = Body partition roughly every <size> bytes\n");
 		printf("                 (early rather than late)\n");
+		printf("    -pf=<num>  = Open <num> files of a numbered input sequence ahead in the background\n");
+		printf("    -pp=<num>  = Parse up to <num> frames of each frame-wrapped input ahead on its own thread\n");
+		printf("    -pa[=<size>] = Reserve <size> bytes of disk space for each output file (or an estimate)\n");
+		printf("    -px=<size> = Start body partitions on multiples of <size> bytes (file system extent size)\n");
+		printf("                 Each partition is padded to a whole extent, so this is skipped (with a\n");
+		printf("                 warning) if -ps, or -pd with constant bit rate essence, gives partitions\n");
+		printf("                 under a quarter of <size> bytes\n");
+		printf("    -pw[=<size>] = Write output files with direct I/O in <size> byte blocks (default 4096),\n");
+		printf("                 bypassing the page cache - the KAG is raised to <size> if required\n");
+		printf("    -pq        = Queue large essence writes asynchronously (if built with IO_URING=1)\n");
 		printf("    -fr=<n>/<d> = Force edit rate (if possible) (-r deprecated, but allowed for legacy\n");
 
 
@@ -150,12 +161,30 @@ void HelpText()
 
 		printf("    -z         = Pause for input before final exit\n");
 		printf("    -zz        = send basic stats to stderr upon final exit\n");
+		printf("    --stats    = Show I/O and allocation counts for each output file and the whole run\n");
 
 }
 
 int EvaluateConfigurationfromFile( const char * filename , int &argc, char **argv, int curarg, ProcessOptions *pOpt);
 
 
+//! Determine if the value of a -c option is an audio channel limit, <num> or <num>/<bits>, rather than a filename
+static bool IsAudioLimit(const char *Val)
+{
+	if(!isdigit(*Val)) return false;
+	while(isdigit(*Val)) Val++;
+
+	if(*Val == '\0') return true;
+	if((*Val != '/') && (*Val != ':')) return false;
+
+	Val++;
+	if(!isdigit(*Val)) return false;
+	while(isdigit(*Val)) Val++;
+
+	return *Val == '\0';
+}
+
+
 //! Parse the command line options
 /*!	\return true if all parsed ok, false if an error or none supplied */
 int ParseOptions(int &argc, char **argv, ProcessOptions *pOpt)
@@ -180,12 +209,9 @@ int ParseOptions(int &argc, char **argv, ProcessOptions *pOpt)
 
 			// deal with -c=filename to get config from file
 			// DRAGONS: exclude filenames that might be like "1/16", to allow legacy use of -c=N/W for channel-splitting
-			if( Opt == 'c' )
+			//          these fall through to the audio demultiplexing option below
+			if( Opt == 'c' && !IsAudioLimit(Val) )
 			{
-				if( strlen(Val)>4
-				||	!isdigit(Val[0])
-				||	( Val[1]!=':' && Val[1]!='/' )
-				||	!isdigit(Val[2]) )
 				return EvaluateConfigurationfromFile( Val, argc, argv, i, pOpt );
 			}
 
@@ -221,7 +247,15 @@ int ParseOptions(int &argc, char **argv, ProcessOptions *pOpt)
 				pOpt->OPAtom = true;
 
 				// See if the user has requested for a 2-partition OP-Atom file
-				if(p[1] == '2') pOpt->OPAtom2Part = true;
+				const char *Mode = &p[1];
+				if(*Mode == '2')
+				{
+					pOpt->OPAtom2Part = true;
+					Mode++;
+				}
+
+				// See if the user has requested all files to be written at once
+				if(tolower(*Mode) == 'c') pOpt->OPAtomConcurrent = true;
 			}
 			else if(Opt == '0') 
 			{
@@ -247,6 +281,42 @@ int ParseOptions(int &argc, char **argv, ProcessOptions *pOpt)
 					pOpt->BodyMode = Body_Size;
 					pOpt->BodyRate = (UInt32)strtoul(Val, &temp, 0);
 				}
+				else if(tolower(p[1]) == 'f')
+				{
+					pOpt->PrefetchFiles = atoi(Val);
+				}
+				else if(tolower(p[1]) == 'p')
+				{
+					pOpt->ParseAhead = atoi(Val);
+				}
+				else if(tolower(p[1]) == 'a')
+				{
+					// -pa alone estimates the size to reserve
+					if(p[2]) pOpt->Preallocate = ato_Int64(Val);
+					else pOpt->Preallocate = -1;
+				}
+				else if(tolower(p[1]) == 'x')
+				{
+					char *temp;
+					pOpt->ExtentSize = (UInt32)strtoul(Val, &temp, 0);
+				}
+				else if(tolower(p[1]) == 'q')
+				{
+					pOpt->AsyncWrites = true;
+				}
+				else if(tolower(p[1]) == 'w')
+				{
+					char *temp;
+					if(p[2]) pOpt->DirectWrites = (UInt32)strtoul(Val, &temp, 0);
+					else pOpt->DirectWrites = DirectWriter::DefaultAlign;
+
+					// Reject a bad block size here, before it is used to raise the KAG
+					if((pOpt->DirectWrites == 0) || (pOpt->DirectWrites & (pOpt->DirectWrites - 1)))
+					{
+						error("Direct write block size \"%s\" is not a power of two - direct writes will not be used\n", Val);
+						pOpt->DirectWrites = 0;
+					}
+				}
 				else error("Unknown body partition mode '%c'\n", p[1]);
 			}
 			else if(Opt == 'e') pOpt->EditAlign = true;
@@ -301,6 +371,10 @@ int ParseOptions(int &argc, char **argv, ProcessOptions *pOpt)
 					pOpt->AudioLimit = Limit;
 					pOpt->AudioBits = Bits;
 				}
+				else if( sscanf(Val, "%u", &Limit) == 1)
+				{
+					pOpt->AudioLimit = Limit;
+				}
 			}
 			else if(Opt == 'h') 
 			{
@@ -404,6 +478,7 @@ int ParseOptions(int &argc, char **argv, ProcessOptions *pOpt)
 				}
 			}
 			else if(Opt == 'v') pOpt->DebugMode = true;
+			else if(strcmp(p, "-stats") == 0) pOpt->ShowIOStats = true;
 			else if(Opt == 'z') 
 			{
 				if( tolower(p[1])=='z' ) pOpt->Stats = true;
@@ -515,6 +590,18 @@ int ParseOptions(int &argc, char **argv, ProcessOptions *pOpt)
 	}
 
 
+	// Direct writes are made in whole blocks, so the KAG must be a multiple of the block size for essence to start on one
+	if(pOpt->DirectWrites && ((pOpt->KAGSize <= 1) || (pOpt->KAGSize % pOpt->DirectWrites)))
+	{
+		if((pOpt->KAGSize <= 1) || ((pOpt->DirectWrites % pOpt->KAGSize) == 0))
+		{
+			if(pOpt->KAGSize > 1) printf("KAG raised from %u to %u to align essence for direct writes\n", pOpt->KAGSize, pOpt->DirectWrites);
+			pOpt->KAGSize = pOpt->DirectWrites;
+		}
+		else warning("KAG of %u is not a multiple of the direct write block size of %u - essence will not be block aligned\n", pOpt->KAGSize, pOpt->DirectWrites);
+	}
+
+
 	// Detail the options
 
 	debug("** Verbose Mode **\n\n");
@@ -588,6 +675,8 @@ int ParseOptions(int &argc, char **argv, ProcessOptions *pOpt)
 		if(pOpt->OPAtom2Part)	printf("Output OP = OP-Atom (with only 2 partitions if VBR)\n");
 		else printf("Output OP = OP-Atom\n");
 
+		if(pOpt->OPAtomConcurrent) printf("All OP-Atom files will be written at once\n");
+
 		// We will need to update the header
 		pOpt->UpdateHeader = true;
 
@@ -714,6 +803,12 @@ int ParseOptions(int &argc, char **argv, ProcessOptions *pOpt)
 			printf("Partitions will be limited to %d byte%s (if possible)\n", pOpt->BodyRate, pOpt->BodyRate==1 ? "" : "s");
 	}
 
+	if(pOpt->Preallocate > 0) printf("%s bytes of disk space will be reserved for each output file\n", Int64toString(pOpt->Preallocate).c_str());
+	else if(pOpt->Preallocate < 0) printf("Disk space will be reserved for the estimated size of each output file\n");
+	if(pOpt->ExtentSize) printf("Body partitions will start on multiples of %u bytes\n", (unsigned int)pOpt->ExtentSize);
+	if(pOpt->DirectWrites) printf("Output files will be written with direct I/O in %u byte blocks\n", (unsigned int)pOpt->DirectWrites);
+	if(pOpt->AsyncWrites) printf("Large essence writes will be queued asynchronously where supported\n");
+
 	if(pOpt->UseIndex) printf("Index tables will be written for each frame wrapped essence container\n");
 	if(pOpt->SprinkledIndex) 
 	{
@@ -28,6 +28,147 @@ function runtest ()
 	rm -f out.temp
 }
 
+# Wrap small.wav with the given options then split the result, checking that both run cleanly
+function runwrapsplit ()
+{
+	echo Testing mxfwrap $1 then mxfsplit in $2
+
+	# Run in a scratch directory as mxfsplit writes the essence to the current directory
+	bindir=`cd $2 && pwd`
+	datadir=`cd $MXFLIB_DATA_DIR && pwd`
+	rm -rf wrapsplit.temp
+	mkdir wrapsplit.temp
+	cd wrapsplit.temp
+
+	MXFLIB_DATA_DIR=$datadir $bindir/mxfwrap $1 ../small.wav wrapped.mxf > /dev/null 2>&1 && MXFLIB_DATA_DIR=$datadir $bindir/mxfsplit wrapped.mxf > /dev/null 2>&1
+	result=$?
+
+	cd ..
+	rm -rf wrapsplit.temp
+
+	if [ $result -eq 0 ]
+	then
+	    echo Test Passed
+	    echo "    wrap+split $1 Passed" >> dotest.txt
+	else
+	    echo *Test FAILED*
+	    echo "    wrap+split $1 *FAILED* (exit status $result)" >> dotest.txt
+	fi
+}
+
+# Run mxfbench scenarios on small generated files, checking that they run cleanly (each scenario checks its own results)
+function runbench ()
+{
+	echo Testing mxfbench $1 in $3
+
+	# Only run if mxfbench was built alongside the other tools
+	if [ ! -x $3/mxfbench ]
+	then
+	    echo Test Skipped
+	    echo "    $1 Skipped (no mxfbench)" >> dotest.txt
+	    return
+	fi
+
+	bindir=`cd $3 && pwd`
+	datadir=`cd $MXFLIB_DATA_DIR && pwd`
+	rm -rf bench.temp
+	mkdir bench.temp
+	cd bench.temp
+
+	MXFLIB_DATA_DIR=$datadir $bindir/mxfbench $2 . > /dev/null 2>&1
+	result=$?
+
+	cd ..
+	rm -rf bench.temp
+
+	if [ $result -eq 0 ]
+	then
+	    echo Test Passed
+	    echo "    $1 Passed" >> dotest.txt
+	else
+	    echo *Test FAILED*
+	    echo "    $1 *FAILED* (exit status $result)" >> dotest.txt
+	fi
+}
+
+# Write a little-endian 16 or 32-bit value as printf escapes
+function le16 ()
+{
+	printf '\\x%02x\\x%02x' $(( $1 & 255 )) $(( ($1 >> 8) & 255 ))
+}
+
+function le32 ()
+{
+	printf '\\x%02x\\x%02x\\x%02x\\x%02x' $(( $1 & 255 )) $(( ($1 >> 8) & 255 )) $(( ($1 >> 16) & 255 )) $(( ($1 >> 24) & 255 ))
+}
+
+# Write a 48kHz PCM wave file <file> with <channels> channels of <bits> bits lasting <seconds>, with counting text as the samples
+function makewave ()
+{
+	blockalign=$(( $2 * $3 / 8 ))
+	datasize=$(( 48000 * $4 * blockalign ))
+	{
+	    printf "RIFF$(le32 $(( datasize + 36 )))WAVEfmt $(le32 16)$(le16 1)$(le16 $2)$(le32 48000)$(le32 $(( 48000 * blockalign )))$(le16 $blockalign)$(le16 $3)data$(le32 $datasize)"
+	    seq 1 100000000 | head -c $datasize
+	} > $1
+}
+
+# Copy standard input to <file> in 64k pieces with a pause before each, as a slow writer would
+function trickle ()
+{
+	while dd bs=65536 count=1 iflag=fullblock of=trickle.tmp 2> /dev/null && [ -s trickle.tmp ]
+	do
+	    sleep 0.05
+	    cat trickle.tmp >> $1
+	done
+	rm -f trickle.tmp
+}
+
+# Run two sets of commands, each in its own scratch directory, and check that they write the same files (other than MXF files)
+# The commands are run with $bin set to the executable path and may use $testdir for the tests directory
+function runcompare ()
+{
+	echo Testing $1 in $4
+
+	bin=`cd $4 && pwd`
+	testdir=`pwd`
+	datadir=`cd $MXFLIB_DATA_DIR && pwd`
+	rm -rf compare.temp
+	mkdir -p compare.temp/a compare.temp/b
+
+	cd compare.temp/a
+	( export MXFLIB_DATA_DIR=$datadir; eval "$2" ) > /dev/null 2>&1
+	result=$?
+	cd ../b
+	if [ $result -eq 0 ]
+	then
+	    ( export MXFLIB_DATA_DIR=$datadir; eval "$3" ) > /dev/null 2>&1
+	    result=$?
+	fi
+	cd ..
+
+	# Both sides must have written something, and the same things
+	if [ $result -eq 0 ]
+	then
+	    if [ -z "`ls -A a`" ] || ! diff -r -x '*.mxf' a b > /dev/null
+	    then
+		result=compare
+	    fi
+	fi
+
+	cd ..
+	rm -rf compare.temp
+
+	if [ "$result" = "0" ]
+	then
+	    echo Test Passed
+	    echo "    $1 Passed" >> dotest.txt
+	else
+	    echo *Test FAILED*
+	    echo "    $1 *FAILED* ($result)" >> dotest.txt
+	fi
+}
+
 # Clear the summary
 rm -f dotest.txt
 
@@ -42,6 +183,66 @@ do
     fi
 done
 
+# Body partitions whose first KLV is essence, rather than metadata or fill
+runwrapsplit "-a -r25/1" $exepath
+
+# Body partitions started on extent boundaries, so the previous partition ends with filler
+runwrapsplit "-a -r25/1 -px=1048576" $exepath
+
+# Hundreds of files opened and parsed in parallel, 16 threads each opening and parsing every file 20 times
+runbench parallel "-s=1 -f=20000 -j=16 -r=20 -t=parallel -l=op1a-cbr-frame-sprinkled,op1a-vbr-frame-footer,opatom-vbr-clip-footer" $exepath
+
+# Frames read with read-ahead hints, or by a FramePrefetcher, during jog, shuttle and scrub playback match those read directly
+runbench seek "-s=20 -f=20000 -p=50 -t=seek" $exepath
+
+# JPEG 2000 frames read by JP2KFrameReader in full, and at reduced resolution or with fewer layers, hold the expected codestream
+runbench jp2k "-s=20 -f=20000 -t=jp2k -l=op1a-jp2k-frame-sprinkled" $exepath
+
+# Frames pushed by a capture thread through a LiveEssenceSource ring arrive whole and in order, and EndOfData() is only set after the last
+runbench live "-s=20 -f=20000 -t=live" $exepath
+
+# Large writes queued and essence read in batches give the same essence as blocking writes and reads
+# (these use io_uring when the tools are built with "make IO_URING=1")
+makewave stereo.wav 2 24 5
+runcompare "queued writes and batched reads" \
+    '$bin/mxfwrap -a -r25/1 $testdir/stereo.wav wrapped.mxf && $bin/mxfsplit wrapped.mxf' \
+    '$bin/mxfwrap -pq -a -r25/1 $testdir/stereo.wav wrapped.mxf && $bin/mxfsplit -b wrapped.mxf' $exepath
+
+# A file written by mxfwrap to a pipe, and so written forwards only, holds the same essence as one written directly
+runcompare "write to a pipe" \
+    'mkfifo pipe.mxf && { $bin/mxfwrap -f -pd=5 -r25/1 $testdir/stereo.wav pipe.mxf & wrap=$!; cat pipe.mxf > piped.mxf && wait $wrap; } && $bin/mxfsplit piped.mxf' \
+    '$bin/mxfwrap -f -pd=5 -r25/1 $testdir/stereo.wav wrapped.mxf && $bin/mxfsplit wrapped.mxf' $exepath
+
+# A file read by mxfsplit from standard input, and so read forwards only, gives the same essence as reading it directly
+runcompare "read from standard input" \
+    '$bin/mxfwrap -f -pd=5 -r25/1 $testdir/stereo.wav wrapped.mxf && cat wrapped.mxf | $bin/mxfsplit -' \
+    '$bin/mxfsplit ../a/wrapped.mxf' $exepath
+
+# A file split while it is still being written, following it with mxfsplit -l, gives the same essence as splitting the
+# completed file. mxfwrap writes through a pipe, and the file is built up from the pipe a piece at a time
+runcompare "follow a file being written" \
+    'mkfifo pipe.mxf && : > growing.mxf && { $bin/mxfwrap -f -pd=5 -r25/1 $testdir/stereo.wav pipe.mxf & wrap=$!; trickle growing.mxf < pipe.mxf & $bin/mxfsplit -l=10 growing.mxf && wait $wrap; }' \
+    '$bin/mxfsplit ../a/growing.mxf' $exepath
+
+# Multi-channel audio demultiplexed to one OP-Atom file per channel gives the same essence whether the files are
+# written in turn or all at once
+makewave quad.wav 4 24 2
+runcompare "demux -a and -ac" \
+    '$bin/mxfwrap -a -c=1/24 $testdir/quad.wav o1.mxf,o2.mxf,o3.mxf,o4.mxf && for n in 1 2 3 4; do $bin/mxfsplit o$n.mxf || exit 1; done' \
+    '$bin/mxfwrap -ac -c=1/24 $testdir/quad.wav o1.mxf,o2.mxf,o3.mxf,o4.mxf && for n in 1 2 3 4; do $bin/mxfsplit o$n.mxf || exit 1; done' $exepath
+
+# A numbered sequence of files opened ahead, and taken in step, gives the same essence in the same order as opening
+# each file only when it is reached. The files are of different lengths so that any misordering shows
+for n in 0 1 2 3
+do
+    makewave seq$n.wav 2 16 $((n+1))
+done
+runcompare "prefetch" \
+    '$bin/mxfwrap -pf=2 -a -r25/1 "$testdir/seq%d.wav[0:3]" wrapped.mxf && $bin/mxfsplit wrapped.mxf' \
+    '$bin/mxfwrap -pf=0 -a -r25/1 "$testdir/seq%d.wav[0:3]" wrapped.mxf && $bin/mxfsplit wrapped.mxf' $exepath
+
+rm -f stereo.wav quad.wav seq0.wav seq1.wav seq2.wav seq3.wav
+
 # Print a summary report
 if [ -e dotest.txt ]
 then